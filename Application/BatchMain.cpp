@@ -0,0 +1,379 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVariant>
+
+// QtPropertyBrowser includes
+#include <QtVariantPropertyManager>
+
+// Visomics includes
+#include "voAnalysis.h"
+#include "voAnalysisDriver.h"
+#include "voAnalysisFactory.h"
+#include "voAnalysisPipeline.h"
+#include "voApplication.h"
+#include "voConfigure.h" // For Visomics_VERSION
+#include "voDataModel.h"
+#include "voDataModelItem.h"
+#include "voDataObject.h"
+#include "voDelimitedTextImportSettings.h"
+#include "voIOManager.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+typedef QPair<QString, QHash<QString, QVariant> > AnalysisRequest;
+
+//----------------------------------------------------------------------------
+void printUsage(const char* executable)
+{
+  std::cout << "Visomics " << Visomics_VERSION << " - Run analyses without user interface\n\n"
+            << "Usage:\n\n"
+            << "  " << executable << " [options] <file.csv> --analysis <name> [--parameter <id>=<value> ...] ...\n"
+            << "  " << executable << " [options] --pipeline <pipeline.json>\n"
+            << "  " << executable << " --list-analyses\n"
+            << "\nAnalyses:\n"
+            << "\n  --analysis <name>              Analysis to run, by class or menu name (e.g. voPCAStatistics or PCA)"
+            << "\n  --parameter <id>=<value>       Parameter of the previous analysis. Enumerations"
+            << "\n                                 are given by the name of their choice"
+            << "\n  --pipeline <pipeline.json>     Chain of analyses to run, see voAnalysisPipeline. Nodes"
+            << "\n                                 whose inputs and parameters didn't change since the"
+            << "\n                                 last run are restored from the result cache"
+            << "\n  --list-analyses                Print the analyses along with their parameters"
+            << "\n\nImport settings:\n"
+            << "\n  --delimiter <characters>       Field delimiter characters (default: ,)"
+            << "\n  --merge-consecutive-delimiters"
+            << "\n  --no-string-delimiter          Don't handle double quoted fields"
+            << "\n  --transpose                    Analytes are listed in the columns"
+            << "\n  --column-metadata-types <n>    Number of column metadata types (default: 1)"
+            << "\n  --column-metadata-of-interest <n>"
+            << "\n  --row-metadata-types <n>       Number of row metadata types (default: 1)"
+            << "\n  --row-metadata-of-interest <n>"
+            << "\n  --normalization <method>[,<method>...]"
+            << "\n                                 Normalization applied in order (e.g. Log2,Quantile)"
+            << "\n\nExecution:\n"
+            << "\n  --output-directory <directory> Directory where the outputs are written (default: .)"
+            << "\n  --jobs <n>                     Number of analyses run at the same time (default: 1)"
+            << "\n  --no-result-cache              Always compute the outputs"
+            << "\n  --help" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+QString analysisClassName(voAnalysisFactory* factory, const QString& name)
+{
+  if (factory->registeredAnalysisNames().contains(name))
+    {
+    return name;
+    }
+  return factory->analysisNameFromPrettyName(name);
+}
+
+//----------------------------------------------------------------------------
+QList<QtVariantProperty*> analysisParameters(voAnalysis* analysis)
+{
+  QList<QtVariantProperty*> parameters;
+  foreach(QtProperty* property, analysis->propertyManager()->properties())
+    {
+    QtVariantProperty * variantProperty = dynamic_cast<QtVariantProperty*>(property);
+    if (variantProperty && !variantProperty->propertyId().isEmpty() &&
+        variantProperty->propertyType() != QtVariantPropertyManager::groupTypeId())
+      {
+      parameters << variantProperty;
+      }
+    }
+  return parameters;
+}
+
+//----------------------------------------------------------------------------
+void listAnalyses(voAnalysisFactory* factory)
+{
+  QStringList prettyNames = factory->registeredAnalysisPrettyNames();
+  prettyNames.sort();
+  foreach(const QString& prettyName, prettyNames)
+    {
+    QString className = factory->analysisNameFromPrettyName(prettyName);
+    voAnalysis * analysis = factory->createAnalysis(className);
+    if (!analysis)
+      {
+      continue;
+      }
+    analysis->initializeParameterInformation();
+    std::cout << qPrintable(prettyName) << " (" << qPrintable(className) << ")" << std::endl;
+    foreach(QtVariantProperty* parameter, analysisParameters(analysis))
+      {
+      QString value = parameter->valueText();
+      if (parameter->propertyType() == QtVariantPropertyManager::enumTypeId())
+        {
+        value = parameter->attributeValue("enumNames").toStringList().join("|");
+        }
+      std::cout << "  " << qPrintable(parameter->propertyId()) << "=" << qPrintable(value)
+                << "\t" << qPrintable(parameter->propertyName()) << std::endl;
+      }
+    delete analysis;
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  voApplication app(argc, argv, /* guiEnabled= */ false);
+
+  bool exitWhenDone = false;
+  app.initialize(exitWhenDone);
+  if (exitWhenDone)
+    {
+    return EXIT_SUCCESS;
+    }
+
+  // Parse arguments
+  QStringList arguments = app.arguments();
+  arguments.removeFirst();
+
+  QString fileName;
+  QString pipelineFileName;
+  QString outputDirectory(".");
+  int jobs = 1;
+  bool resultCacheEnabled = true;
+  voDelimitedTextImportSettings settings;
+  QList<AnalysisRequest> requests;
+  bool listAnalysesRequested = false;
+  bool validArguments = true;
+  while (!arguments.isEmpty() && validArguments)
+    {
+    QString argument = arguments.takeFirst();
+    // Options without value
+    if (argument == "--help")
+      {
+      printUsage(argv[0]);
+      return EXIT_SUCCESS;
+      }
+    else if (argument == "--list-analyses")
+      {
+      listAnalysesRequested = true;
+      }
+    else if (argument == "--merge-consecutive-delimiters")
+      {
+      settings.insert(voDelimitedTextImportSettings::MergeConsecutiveDelimiters, true);
+      }
+    else if (argument == "--no-string-delimiter")
+      {
+      settings.insert(voDelimitedTextImportSettings::UseStringDelimiter, false);
+      }
+    else if (argument == "--transpose")
+      {
+      settings.insert(voDelimitedTextImportSettings::Transpose, true);
+      }
+    else if (argument == "--no-result-cache")
+      {
+      resultCacheEnabled = false;
+      }
+    else if (!argument.startsWith("--"))
+      {
+      if (!fileName.isEmpty())
+        {
+        qCritical() << "Unexpected argument" << argument;
+        validArguments = false;
+        }
+      fileName = argument;
+      }
+    // Options with a value
+    else if (arguments.isEmpty())
+      {
+      qCritical() << "Missing value for" << argument;
+      validArguments = false;
+      }
+    else
+      {
+      QString value = arguments.takeFirst();
+      bool validInteger = true;
+      if (argument == "--analysis")
+        {
+        requests << AnalysisRequest(value, QHash<QString, QVariant>());
+        }
+      else if (argument == "--parameter")
+        {
+        int separator = value.indexOf('=');
+        validArguments = !requests.isEmpty() && separator > 0;
+        if (validArguments)
+          {
+          requests.last().second.insert(value.left(separator), value.mid(separator + 1));
+          }
+        }
+      else if (argument == "--pipeline")
+        {
+        pipelineFileName = value;
+        }
+      else if (argument == "--output-directory")
+        {
+        outputDirectory = value;
+        }
+      else if (argument == "--jobs")
+        {
+        jobs = value.toInt(&validInteger);
+        }
+      else if (argument == "--delimiter")
+        {
+        settings.insert(voDelimitedTextImportSettings::FieldDelimiterCharacters, value);
+        }
+      else if (argument == "--column-metadata-types")
+        {
+        settings.insert(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, value.toInt(&validInteger));
+        }
+      else if (argument == "--column-metadata-of-interest")
+        {
+        settings.insert(voDelimitedTextImportSettings::ColumnMetaDataTypeOfInterest, value.toInt(&validInteger));
+        }
+      else if (argument == "--row-metadata-types")
+        {
+        settings.insert(voDelimitedTextImportSettings::NumberOfRowMetaDataTypes, value.toInt(&validInteger));
+        }
+      else if (argument == "--row-metadata-of-interest")
+        {
+        settings.insert(voDelimitedTextImportSettings::RowMetaDataTypeOfInterest, value.toInt(&validInteger));
+        }
+      else if (argument == "--normalization")
+        {
+        settings.insert(voDelimitedTextImportSettings::NormalizationPipeline,
+                        value.split(',', QString::SkipEmptyParts));
+        }
+      else
+        {
+        qCritical() << "Unknown option" << argument;
+        validArguments = false;
+        }
+      if (!validInteger)
+        {
+        qCritical() << "Invalid value" << value << "for" << argument;
+        validArguments = false;
+        }
+      }
+    }
+
+  voAnalysisFactory * factory = app.analysisFactory();
+  if (listAnalysesRequested && validArguments)
+    {
+    listAnalyses(factory);
+    return EXIT_SUCCESS;
+    }
+  bool validRequest = pipelineFileName.isEmpty() ? !fileName.isEmpty() && !requests.isEmpty() :
+                                                   fileName.isEmpty() && requests.isEmpty();
+  if (!validArguments || !validRequest)
+    {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+    }
+  if (!QFile::exists(app.rHome()))
+    {
+    qWarning() << "R_HOME is not set to an existing directory, analyses computed using R will fail";
+    }
+  if (!QDir().mkpath(outputDirectory))
+    {
+    qCritical() << "Failed to create output directory" << outputDirectory;
+    return EXIT_FAILURE;
+    }
+
+  if (!pipelineFileName.isEmpty())
+    {
+    voAnalysisPipeline pipeline;
+    pipeline.setResultCacheEnabled(resultCacheEnabled);
+    pipeline.setMaximumRunningNodeCount(jobs);
+    pipeline.setOutputDirectory(outputDirectory);
+    if (!pipeline.load(pipelineFileName))
+      {
+      return EXIT_FAILURE;
+      }
+    bool success = pipeline.run();
+    std::cout << qPrintable(pipeline.report()) << std::endl;
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+  // Import
+  voDataModel * model = app.dataModel();
+  app.ioManager()->openCSVFile(fileName, settings);
+  voDataModelItem * inputTarget = model->selectedInputObject();
+  if (!inputTarget || !inputTarget->dataObject())
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Configure analyses
+  QList<voAnalysis*> analyses;
+  foreach(const AnalysisRequest& request, requests)
+    {
+    voAnalysis * analysis = 0;
+    QString className = analysisClassName(factory, request.first);
+    if (!className.isEmpty())
+      {
+      analysis = factory->createAnalysis(className);
+      }
+    if (!analysis)
+      {
+      qCritical() << "Unknown analysis" << request.first;
+      qDeleteAll(analyses);
+      return EXIT_FAILURE;
+      }
+    analyses << analysis;
+
+    analysis->initializeInputInformation();
+    QString inputType = analysis->inputType(analysis->inputNames().value(0));
+    if (analysis->numberOfInput() != 1 || inputType != inputTarget->dataObject()->type())
+      {
+      qCritical() << "Analysis" << className << "can't be run on a table";
+      qDeleteAll(analyses);
+      return EXIT_FAILURE;
+      }
+
+    analysis->initializeParameterInformation();
+    QHash<QString, QVariant> parameters;
+    if (!analysis->convertParameterValues(request.second, parameters))
+      {
+      qDeleteAll(analyses);
+      return EXIT_FAILURE;
+      }
+    analysis->setParameterValues(parameters);
+    analysis->setAcceptDefaultParameterValues(true);
+    analysis->setOutputDirectory(outputDirectory);
+    analysis->setWriteOutputsToFilesEnabled(true);
+    }
+
+  // Run
+  voAnalysisDriver * driver = app.analysisDriver();
+  driver->setResultCacheEnabled(resultCacheEnabled);
+  driver->setAsynchronousExecutionEnabled(jobs > 1);
+  driver->setMaximumRunningAnalysisCount(jobs);
+  driver->runAnalyses(analyses, inputTarget);
+  driver->waitForAnalyses();
+
+  std::cout << qPrintable(driver->batchReport()) << std::endl;
+  return driver->numberOfFailedBatchAnalyses() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -112,6 +112,15 @@ voMainWindow::voMainWindow(QWidget * newParent)
     }
   d->menuAnalysis->addActions(analysisActions);
 
+  d->menuAnalysis->addSeparator();
+  QAction * abortAnalysesAction = new QAction(tr("Abort Running Analyses"), this);
+  connect(abortAnalysesAction, SIGNAL(triggered()),
+          voApplication::application()->analysisDriver(), SLOT(abortAllAnalyses()));
+  d->menuAnalysis->addAction(abortAnalysesAction);
+
+  // Keep the interface responsive while analyses are running
+  voApplication::application()->analysisDriver()->setAsynchronousExecutionEnabled(true);
+
   connect(&d->AnalysisActionMapper, SIGNAL(mapped(QString)),
           voApplication::application()->analysisDriver(), SLOT(runAnalysisForAllInputs(QString)));
 
@@ -155,6 +164,18 @@ voMainWindow::voMainWindow(QWidget * newParent)
           d->DataBrowserWidget,
           SLOT(setActiveAnalysis(voAnalysis*)));
 
+  connect(voApplication::application()->analysisDriver(),
+          SIGNAL(analysisProgressChanged(voAnalysis*, double)),
+          SLOT(onAnalysisProgressChanged(voAnalysis*, double)));
+
+  connect(voApplication::application()->analysisDriver(),
+          SIGNAL(analysisFinished(voAnalysis*, bool)),
+          SLOT(onAnalysisFinished(voAnalysis*, bool)));
+
+  connect(voApplication::application()->analysisDriver(),
+          SIGNAL(batchFinished()),
+          SLOT(onBatchFinished()));
+
   // Initialize status bar
   this->statusBar()->showMessage(tr(""), 2000);
 }
@@ -278,6 +299,38 @@ void voMainWindow::onAboutToRunAnalysis(voAnalysis* analysis)
     }
 }
 
+// --------------------------------------------------------------------------
+void voMainWindow::onAnalysisProgressChanged(voAnalysis* analysis, double progress)
+{
+  this->statusBar()->showMessage(
+        tr("Running %1: %2%").arg(analysis->objectName()).arg(qRound(progress * 100.)));
+}
+
+// --------------------------------------------------------------------------
+void voMainWindow::onAnalysisFinished(voAnalysis* analysis, bool success)
+{
+  if (success)
+    {
+    this->statusBar()->showMessage(tr("%1 done").arg(analysis->objectName()), 2000);
+    }
+  else if (analysis->abortExecution())
+    {
+    this->statusBar()->showMessage(tr("%1 aborted").arg(analysis->objectName()), 2000);
+    }
+  else
+    {
+    this->statusBar()->showMessage(tr("%1 failed").arg(analysis->objectName()), 2000);
+    }
+}
+
+// --------------------------------------------------------------------------
+void voMainWindow::onBatchFinished()
+{
+  // The detailed report is available in the error log
+  QString report = voApplication::application()->analysisDriver()->batchReport();
+  this->statusBar()->showMessage(report.section('\n', 0, 0), 5000);
+}
+
 // --------------------------------------------------------------------------
 void voMainWindow::setViewActions(const QString& objectUuid, voView* newView)
 {
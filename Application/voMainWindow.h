@@ -55,6 +55,9 @@ protected slots:
   void onAnalysisSelected(voAnalysis* analysis);
   void onActiveAnalysisChanged(voAnalysis* analysis);
   void onAboutToRunAnalysis(voAnalysis* analysis);
+  void onAnalysisProgressChanged(voAnalysis* analysis, double progress);
+  void onAnalysisFinished(voAnalysis* analysis, bool success);
+  void onBatchFinished();
 
   void setViewActions(const QString& objectUuid, voView* newView);
 
@@ -108,7 +108,9 @@ voNormalizationWidget::voNormalizationWidget(QWidget* newParent) :
 
   d->registerNormalizationWidget("No");
   d->registerNormalizationWidget("Log2");
+  d->registerNormalizationWidget("Median Center");
   d->registerNormalizationWidget("Quantile");
+  d->registerNormalizationWidget("Z-Score");
 
   // Set default - should be re-set by voDelimitedTextImportDialogPrivate
   setSelectedNormalizationMethod("No");
@@ -20,12 +20,16 @@
 
 // Qt includes
 #include <QDebug>
+#include <QMutexLocker>
+#include <QStringList>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voANOVAStatistics.h"
+#include "voRSession.h"
+#include "voStatisticsUtils.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
@@ -33,11 +37,14 @@
 // VTK includes
 #include <vtkArrayData.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 // --------------------------------------------------------------------------
 // voANOVAStatisticsPrivate methods
 
@@ -45,9 +52,153 @@
 class voANOVAStatisticsPrivate
 {
 public:
-  vtkSmartPointer<vtkRCalculatorFilter> RCalc;
 };
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+// errorValue is set to the "RerrValue" reported by the R script:
+// 0: no error, 2: invalid fold change
+// The native backend also reports 1: constant data, 3: invalid data, like voTTest
+bool computeANOVAWithR(vtkTable* inputDataTable, voDataObject* input, const QList<QList<int> >& groupRangeLists,
+                       vtkArrayData* outputArrayData, int& errorValue)
+{
+  // All the groups are transferred as a single matrix
+  QList<int> sampleRangeList;
+  QStringList groupSizes;
+  foreach(const QList<int>& groupRangeList, groupRangeLists)
+    {
+    sampleRangeList << groupRangeList;
+    groupSizes << QString::number(groupRangeList.size());
+    }
+
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Build array for the sample groups, unless it is already resident in R
+  QString sampleCacheKey = voRSession::cacheKey(input, sampleRangeList);
+  if (!session->assignCachedArray("sampleArray", sampleCacheKey))
+    {
+    vtkSmartPointer<vtkArray> sampleArray;
+    if (!voUtils::tableToArray(inputDataTable, sampleArray, sampleRangeList))
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Sample Groups");
+      return false;
+      }
+    session->putArray("sampleArray", sampleArray, sampleCacheKey);
+    }
+
+  // Run R code
+  bool scriptResult = session->evalScript(QString(
+  "RerrValue<-0\n"
+  "groupSizes <- c(%1)\n"
+  "groups <- factor(rep(seq(along=groupSizes), groupSizes))\n"
+  "sample1Array <- sampleArray[, seq(length=groupSizes[1]), drop=FALSE]\n"
+  "sample2Array <- sampleArray[, groupSizes[1] + seq(length=groupSizes[2]), drop=FALSE]\n"
+  "pValue <- sapply( seq(length=nrow(sampleArray)), "
+                    "function(x) {summary(aov(sampleArray[x,] ~ groups))[[1]][[1,\"Pr(>F)\"]] })\n"
+  "log2FC<-log2(rowMeans(sample1Array))-log2(rowMeans(sample2Array))\n"
+  "FCFun <- function(x){"
+    "if(!is.finite(x)){RerrValue <<- 2; return(-NaN)}\n"
+    "if (x<0) {return(-1/(2^x))} else {return(2^x)}}\n"
+  "foldChange<-sapply(log2FC, FCFun)\n"
+  ).arg(groupSizes.join(",")));
+
+  vtkNew<vtkArrayData> RErrorArrayData;
+  if (!scriptResult ||
+      !session->getArray("pValue", "P-Value", outputArrayData) ||
+      !session->getArray("foldChange", "Fold Change (Sample 1 -> Sample 2)", outputArrayData) ||
+      !session->getArray("RerrValue", "RerrValue", RErrorArrayData.GetPointer()))
+    {
+    return false;
+    }
+  errorValue = RErrorArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt();
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool computeANOVANatively(voAnalysis* analysis, vtkExtendedTable* extendedTable,
+                          const QList<QList<int> >& groupRangeLists,
+                          vtkArrayData* outputArrayData, int& errorValue)
+{
+  vtkIdType numberOfRows = extendedTable->GetNumberOfRows();
+  vtkIdType numberOfColumns = extendedTable->GetNumberOfColumns();
+  if (numberOfRows == 0 || numberOfColumns == 0)
+    {
+    return false;
+    }
+
+  std::vector<std::vector<vtkIdType> > groups;
+  foreach(const QList<int>& groupRangeList, groupRangeLists)
+    {
+    groups.push_back(std::vector<vtkIdType>(groupRangeList.begin(), groupRangeList.end()));
+    }
+
+  std::vector<double> pValues(numberOfRows);
+  std::vector<double> foldChanges(numberOfRows);
+  int anovaDiagnostics = voStatisticsUtils::NoDiagnostic;
+  int foldChangeDiagnostics = voStatisticsUtils::NoDiagnostic;
+
+  // Rows are tested independently, out-of-core data are processed one tile at a time
+  std::vector<double> tileBuffer;
+  vtkIdType tileNumberOfRows = extendedTable->GetDataTileNumberOfRows();
+  for (vtkIdType firstRow = 0; firstRow < numberOfRows; firstRow += tileNumberOfRows)
+    {
+    if (analysis->abortExecution())
+      {
+      return false;
+      }
+    analysis->setProgress(static_cast<double>(firstRow) / numberOfRows);
+    vtkIdType tileRows = std::min(tileNumberOfRows, numberOfRows - firstRow);
+    const double * tile = extendedTable->GetDataTile(firstRow, tileRows, tileBuffer);
+    if (!tile)
+      {
+      return false;
+      }
+    int tileANOVADiagnostics = voStatisticsUtils::NoDiagnostic;
+    int tileFoldChangeDiagnostics = voStatisticsUtils::NoDiagnostic;
+    if (!voStatisticsUtils::oneWayANOVA(tile, tileRows, numberOfColumns, groups, &pValues[firstRow],
+                                        &tileANOVADiagnostics))
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Sample Groups");
+      return false;
+      }
+    voStatisticsUtils::foldChange(tile, tileRows, numberOfColumns, groups[0], groups[1],
+                                  &foldChanges[firstRow], &tileFoldChangeDiagnostics);
+    anovaDiagnostics |= tileANOVADiagnostics;
+    foldChangeDiagnostics |= tileFoldChangeDiagnostics;
+    }
+
+  // Same priorities as voTTest
+  if (anovaDiagnostics & voStatisticsUtils::InvalidData)
+    {
+    errorValue = 3;
+    }
+  else if (foldChangeDiagnostics & voStatisticsUtils::InvalidFoldChange)
+    {
+    errorValue = 2;
+    }
+  else if (anovaDiagnostics & voStatisticsUtils::ConstantData)
+    {
+    errorValue = 1;
+    }
+  else
+    {
+    errorValue = 0;
+    }
+
+  voUtils::addValuesToArrayData(outputArrayData, "P-Value",
+                                pValues.empty() ? 0 : &pValues[0], numberOfRows);
+  voUtils::addValuesToArrayData(outputArrayData, "Fold Change (Sample 1 -> Sample 2)",
+                                foldChanges.empty() ? 0 : &foldChanges[0], numberOfRows);
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voANOVAStatistics methods
 
@@ -55,9 +206,6 @@ public:
 voANOVAStatistics::voANOVAStatistics():
     Superclass(), d_ptr(new voANOVAStatisticsPrivate)
 {
-  Q_D(voANOVAStatistics);
-  
-  d->RCalc = vtkSmartPointer<vtkRCalculatorFilter>::New();
 }
 
 // --------------------------------------------------------------------------
@@ -90,6 +238,15 @@ void voANOVAStatistics::setParameterInformation()
 
   ANOVA_parameters << this->addStringParameter("sample1_range", QObject::tr("Sample Group 1"), "A-C,F");
   ANOVA_parameters << this->addStringParameter("sample2_range", QObject::tr("Sample Group 2"), "D,G-I");
+  ANOVA_parameters << this->addStringParameter("other_ranges", QObject::tr("Other Sample Groups"), "");
+
+  QStringList ANOVA_backends;
+  ANOVA_backends << "Native" << "R";
+  ANOVA_parameters << this->addEnumParameter("backend", QObject::tr("Backend"), ANOVA_backends, "Native");
+
+  QStringList ANOVA_adjustments;
+  ANOVA_adjustments << "None" << "Bonferroni" << "Holm" << "Benjamini-Hochberg";
+  ANOVA_parameters << this->addEnumParameter("p_adjust", QObject::tr("P-Value Adjustment"), ANOVA_adjustments, "None");
 
   this->addParameterGroup("ANOVA parameters", ANOVA_parameters);
 }
@@ -99,17 +256,33 @@ QString voANOVAStatistics::parameterDescription()const
 {
   return QString("<dl>"
                  "<dt><b>Sample Group 1 / 2</b>:</dt>"
-                 "<dd>A group of Experiments, specified by a range and/or list of column letters.<br>"
-                 "<u>The groups MUST both be the same size</u>, as only a balanced test is performed</dd>"
+                 "<dd>A group of Experiments, specified by a range and/or list of column letters. "
+                 "Groups may have different sizes. Fold changes are computed from group 1 to group 2.</dd>"
+                 "<dt><b>Other Sample Groups</b>:</dt>"
+                 "<dd>Optional additional groups of Experiments, separated by semicolons (e.g. <i>J-K;L,M</i>).</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the one-way analyses of variance are computed:<br>"
+                 "- <i>Native</i>: Multi-threaded implementation<br>"
+                 "- <i>R</i>: Embedded R interpreter, kept as a reference</dd>"
+                 "<dt><b>P-Value Adjustment</b>:</dt>"
+                 "<dd>Correction for multiple testing added next to the p-values:<br>"
+                 "- <i>Bonferroni</i> and <i>Holm</i> control the family-wise error rate<br>"
+                 "- <i>Benjamini-Hochberg</i> controls the false discovery rate</dd>"
                  "</dl>");
 }
 
 // --------------------------------------------------------------------------
-bool voANOVAStatistics::execute()
+bool voANOVAStatistics::mainThreadOnly()const
 {
-  Q_D(voANOVAStatistics);
+  return this->enumParameter("backend") == QLatin1String("R");
+}
 
+// --------------------------------------------------------------------------
+bool voANOVAStatistics::execute()
+{
   // Get and parse parameters
+  QString ANOVA_backend = this->enumParameter("backend");
+
   bool result;
 
   QList<int> sample1RangeList;
@@ -128,10 +301,18 @@ bool voANOVAStatistics::execute()
     return false;
     }
 
-  if(sample1RangeList.size() != sample2RangeList.size())
+  QList<QList<int> > groupRangeLists;
+  groupRangeLists << sample1RangeList << sample2RangeList;
+  foreach(const QString& otherRange, this->stringParameter("other_ranges").split(";", QString::SkipEmptyParts))
     {
-    qWarning() << QObject::tr("Invalid paramaters, Sample Groups must be the same size (balanced)");
-    return false;
+    QList<int> otherRangeList;
+    result = voUtils::parseRangeString(otherRange.trimmed(), otherRangeList, true);
+    if(!result || otherRangeList.isEmpty())
+      {
+      qWarning() << QObject::tr("Invalid paramater, could not parse range list: Other Sample Groups");
+      return false;
+      }
+    groupRangeLists << otherRangeList;
     }
 
   // Import data table locally
@@ -144,61 +325,39 @@ bool voANOVAStatistics::execute()
 
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build array for sample 1 data range
-  vtkSmartPointer<vtkArray> sample1Array;
-  result = voUtils::tableToArray(inputDataTable.GetPointer(), sample1Array, sample1RangeList);
-  if (!result)
+  // Compute p-values and fold changes
+  vtkNew<vtkArrayData> outputArrayData;
+  int errorValue = 0;
+  if (ANOVA_backend == QLatin1String("R"))
     {
-    qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 1");
-    return false;
+    result = computeANOVAWithR(inputDataTable, this->input(), groupRangeLists,
+                               outputArrayData.GetPointer(), errorValue);
+    }
+  else
+    {
+    result = computeANOVANatively(this, extendedTable, groupRangeLists, outputArrayData.GetPointer(), errorValue);
     }
-
-  // Build array for sample 2 data range
-  vtkSmartPointer<vtkArray> sample2Array;
-  result = voUtils::tableToArray(inputDataTable.GetPointer(), sample2Array, sample2RangeList);
   if (!result)
     {
-    qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 2");
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(ANOVA_backend);
     return false;
     }
 
-  // Combine sample 1 and 2 array groups
-  vtkNew<vtkArrayData> RInputArrayData;
-  RInputArrayData->AddArray(sample1Array);
-  RInputArrayData->AddArray(sample2Array);
-
-  // Run R code
-  d->RCalc->SetRoutput(0);
-  d->RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  d->RCalc->PutArray("0", "sample1Array");
-  d->RCalc->PutArray("1", "sample2Array");
-  d->RCalc->GetArray("P-Value","pValue");
-  d->RCalc->GetArray("Fold Change (Sample 1 -> Sample 2)","foldChange");
-  d->RCalc->GetArray("RerrValue","RerrValue");
-  d->RCalc->SetRscript(
-  "RerrValue<-0\n"
-  "pValue <- sapply( seq(length=nrow(sample1Array)), "
-                    "function(x) {summary(aov(sample1Array[x,] ~ sample2Array[x,]))[[1]][[1,\"Pr(>F)\"]] })\n"
-  "log2FC<-log2(rowMeans(sample1Array))-log2(rowMeans(sample2Array))\n"
-  "FCFun <- function(x){"
-    "if(!is.finite(x)){RerrValue <<- 2; return(-NaN)}\n"
-    "if (x<0) {return(-1/(2^x))} else {return(2^x)}}\n"
-  "foldChange<-sapply(log2FC, FCFun)\n"
-  );
-  d->RCalc->Update();
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(d->RCalc->GetOutput());
-  if(!outputArrayData)
+  // Check for errors "thrown" by the backend
+  if(errorValue == 1)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
-    return false;
+    qWarning() << QObject::tr("ANOVA warning: data are essentially constant");
     }
-  // Check for errors "thrown" by R script
-  if(outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() > 1)
+  else if(errorValue == 2)
     {
     qWarning() << QObject::tr("ANOVA warning: cannot calculate fold change from zero or negative input");
     }
+  else if(errorValue > 2)
+    {
+    qCritical() << QObject::tr("Fatal error in ANOVA %1 backend - "
+                               "Some rows have not enough observations or infinite values").arg(ANOVA_backend);
+    return false;
+    }
 
   // Get analyte names with row labels
   vtkNew<vtkStringArray> analyteNames;
@@ -210,6 +369,7 @@ bool voANOVAStatistics::execute()
     {
     voUtils::arrayToTable(outputArrayData->GetArrayByName("P-Value"), outputDataTable.GetPointer());
     voUtils::insertColumnIntoTable(outputDataTable.GetPointer(), 0, analyteNames.GetPointer());
+    voUtils::insertAdjustedPValueColumn(outputDataTable.GetPointer(), "P-Value", this->enumParameter("p_adjust"));
     }
 
   // Build table with additional fold change column for volcano
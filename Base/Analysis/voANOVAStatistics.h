@@ -37,6 +37,8 @@ public:
   voANOVAStatistics();
   virtual ~voANOVAStatistics();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
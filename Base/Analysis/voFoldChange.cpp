@@ -21,24 +21,31 @@
 // Qt includes
 #include <QDebug>
 #include <QList>
+#include <QMutexLocker>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voFoldChange.h"
+#include "voRSession.h"
+#include "voStatisticsUtils.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkArrayData.h>
+#include <vtkDoubleArray.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 // --------------------------------------------------------------------------
 // voFoldChangePrivate methods
 
@@ -46,9 +53,147 @@
 class voFoldChangePrivate
 {
 public:
-  vtkSmartPointer<vtkRCalculatorFilter> RCalc;
 };
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+// errorValue is set to the "RerrValue" reported by the R script:
+// 0: no error, 2: invalid fold change
+bool computeFoldChangeWithR(vtkTable* inputDataTable, voDataObject* input,
+                            const QList<int>& sample1RangeList, const QList<int>& sample2RangeList,
+                            voStatisticsUtils::MeanMethod meanMethod,
+                            vtkArrayData* outputArrayData, int& errorValue)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Build array for sample 1 data range, unless it is already resident in R
+  QString sample1CacheKey = voRSession::cacheKey(input, sample1RangeList);
+  if (!session->assignCachedArray("sample1Array", sample1CacheKey))
+    {
+    vtkSmartPointer<vtkArray> sample1Array;
+    bool result = voUtils::tableToArray(inputDataTable, sample1Array, sample1RangeList);
+    if (!result)
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Initial Sample(s)");
+      return false;
+      }
+    session->putArray("sample1Array", sample1Array, sample1CacheKey);
+    }
+
+  // Build array for sample 2 data range, unless it is already resident in R
+  QString sample2CacheKey = voRSession::cacheKey(input, sample2RangeList);
+  if (!session->assignCachedArray("sample2Array", sample2CacheKey))
+    {
+    vtkSmartPointer<vtkArray> sample2Array;
+    bool result = voUtils::tableToArray(inputDataTable, sample2Array, sample2RangeList);
+    if (!result)
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Final Sample(s)");
+      return false;
+      }
+    session->putArray("sample2Array", sample2Array, sample2CacheKey);
+    }
+
+  // Run R code
+  bool scriptResult = session->evalScript(QString(
+  "RerrValue<-0; meanMethod<- %1 \n" // 0 for geo, 1 for arith
+  "if(meanMethod == 0) {"
+    "avgInit<-2^rowMeans(log2(sample1Array))\n"
+    "avgFinal<-2^rowMeans(log2(sample2Array))\n"
+  "}else{"
+    "avgInit<-rowMeans(sample1Array)\n"
+    "avgFinal<-rowMeans(sample2Array) }\n"
+  "log2FC<-(log2(avgFinal)-log2(avgInit))\n"
+  "FCFun <- function(x){"
+    "if(!is.finite(x)){RerrValue <<- 2; return(-NaN)}\n"
+    "if (x<0) {return(-1/(2^x))} else {return(2^x)}}\n"
+  "foldChange<-sapply(log2FC, FCFun)"
+  ).arg(meanMethod == voStatisticsUtils::GeometricMean ? 0 : 1));
+
+  vtkNew<vtkArrayData> RErrorArrayData;
+  if (!scriptResult ||
+      !session->getArray("avgInit", "Average Initial", outputArrayData) ||
+      !session->getArray("avgFinal", "Average Final", outputArrayData) ||
+      !session->getArray("foldChange", "Fold Change", outputArrayData) ||
+      !session->getArray("RerrValue", "RerrValue", RErrorArrayData.GetPointer()))
+    {
+    return false;
+    }
+  errorValue = RErrorArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt();
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool computeFoldChangeNatively(voAnalysis* analysis, vtkExtendedTable* extendedTable,
+                               const QList<int>& sample1RangeList, const QList<int>& sample2RangeList,
+                               voStatisticsUtils::MeanMethod meanMethod,
+                               vtkArrayData* outputArrayData, int& errorValue)
+{
+  vtkIdType numberOfRows = extendedTable->GetNumberOfRows();
+  vtkIdType numberOfColumns = extendedTable->GetNumberOfColumns();
+  if (numberOfRows == 0 || numberOfColumns == 0)
+    {
+    return false;
+    }
+
+  std::vector<vtkIdType> sample1Columns(sample1RangeList.begin(), sample1RangeList.end());
+  std::vector<vtkIdType> sample2Columns(sample2RangeList.begin(), sample2RangeList.end());
+
+  std::vector<double> averageInitial(numberOfRows);
+  std::vector<double> averageFinal(numberOfRows);
+  std::vector<double> foldChanges(numberOfRows);
+
+  // Rows are averaged independently, out-of-core data are processed one tile at a time
+  std::vector<double> tileBuffer;
+  vtkIdType tileNumberOfRows = extendedTable->GetDataTileNumberOfRows();
+  for (vtkIdType firstRow = 0; firstRow < numberOfRows; firstRow += tileNumberOfRows)
+    {
+    if (analysis->abortExecution())
+      {
+      return false;
+      }
+    analysis->setProgress(static_cast<double>(firstRow) / numberOfRows);
+    vtkIdType tileRows = std::min(tileNumberOfRows, numberOfRows - firstRow);
+    const double * tile = extendedTable->GetDataTile(firstRow, tileRows, tileBuffer);
+    if (!tile)
+      {
+      return false;
+      }
+    if (!voStatisticsUtils::rowMeans(tile, tileRows, numberOfColumns, sample1Columns,
+                                     meanMethod, &averageInitial[firstRow]))
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Initial Sample(s)");
+      return false;
+      }
+    if (!voStatisticsUtils::rowMeans(tile, tileRows, numberOfColumns, sample2Columns,
+                                     meanMethod, &averageFinal[firstRow]))
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Final Sample(s)");
+      return false;
+      }
+    }
+
+  int diagnostics = voStatisticsUtils::NoDiagnostic;
+  voStatisticsUtils::foldChangeFromMeans(&averageFinal[0], &averageInitial[0], numberOfRows,
+                                         &foldChanges[0], &diagnostics);
+  errorValue = (diagnostics & voStatisticsUtils::InvalidFoldChange) ? 2 : 0;
+
+  voUtils::addValuesToArrayData(outputArrayData, "Average Initial",
+                                averageInitial.empty() ? 0 : &averageInitial[0], numberOfRows);
+  voUtils::addValuesToArrayData(outputArrayData, "Average Final",
+                                averageFinal.empty() ? 0 : &averageFinal[0], numberOfRows);
+  voUtils::addValuesToArrayData(outputArrayData, "Fold Change",
+                                foldChanges.empty() ? 0 : &foldChanges[0], numberOfRows);
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voFoldChange methods
 
@@ -56,9 +201,6 @@ public:
 voFoldChange::voFoldChange():
     Superclass(), d_ptr(new voFoldChangePrivate)
 {
-  Q_D(voFoldChange);
-  
-  d->RCalc = vtkSmartPointer<vtkRCalculatorFilter>::New();
 }
 
 // --------------------------------------------------------------------------
@@ -94,6 +236,14 @@ void voFoldChange::setParameterInformation()
   fold_change_parameters << this->addStringParameter("sample1_range", QObject::tr("Initial Sample(s)"), "A-C,F");
   fold_change_parameters << this->addStringParameter("sample2_range", QObject::tr("Final Sample(s)"), "D,E,G-J");
 
+  QStringList fold_change_backends;
+  fold_change_backends << "Native" << "R";
+  fold_change_parameters << this->addEnumParameter("backend", QObject::tr("Backend"), fold_change_backends, "Native");
+
+  QStringList fold_change_adjustments;
+  fold_change_adjustments << "None" << "Bonferroni" << "Holm" << "Benjamini-Hochberg";
+  fold_change_parameters << this->addEnumParameter("p_adjust", QObject::tr("P-Value Adjustment"), fold_change_adjustments, "None");
+
   this->addParameterGroup("Fold Change parameters", fold_change_parameters);
 }
 
@@ -105,18 +255,34 @@ QString voFoldChange::parameterDescription()const
                  "<dd>The type of average used to form each sample group.</dd>"
                  "<dt><b>Initial / Final Sample(s)</b>:</dt>"
                  "<dd>A group of Experiments, specified by a range and/or list of column letters.</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the averages and fold changes are computed:<br>"
+                 "- <i>Native</i>: Multi-threaded implementation<br>"
+                 "- <i>R</i>: Embedded R interpreter, kept as a reference</dd>"
+                 "<dt><b>P-Value Adjustment</b>:</dt>"
+                 "<dd>Unless <i>None</i>, the p-values of Welch's t-tests between the initial and final "
+                 "samples are added to the table, next to their correction for multiple testing:<br>"
+                 "- <i>Bonferroni</i> and <i>Holm</i> control the family-wise error rate<br>"
+                 "- <i>Benjamini-Hochberg</i> controls the false discovery rate</dd>"
                  "</dl>");
 }
 
 // --------------------------------------------------------------------------
-bool voFoldChange::execute()
+bool voFoldChange::mainThreadOnly()const
 {
-  Q_D(voFoldChange);
+  return this->enumParameter("backend") == QLatin1String("R");
+}
 
+// --------------------------------------------------------------------------
+bool voFoldChange::execute()
+{
   // Get and parse parameters
   bool result;
 
-  int meanMethod = (this->enumParameter("mean_method") == QString("Geometric")) ? 0 : 1; // 0 for geo, 1 for arith
+  QString fold_change_backend = this->enumParameter("backend");
+  voStatisticsUtils::MeanMethod meanMethod = (this->enumParameter("mean_method") == QString("Geometric")) ?
+        voStatisticsUtils::GeometricMean : voStatisticsUtils::ArithmeticMean;
+
   QList<int> sample1RangeList;
   result = voUtils::parseRangeString(this->stringParameter("sample1_range"), sample1RangeList, true);
   if(!result || sample1RangeList.isEmpty())
@@ -143,63 +309,27 @@ bool voFoldChange::execute()
 
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build array for sample 1 data range
-  vtkSmartPointer<vtkArray> sample1Array;
-  result = voUtils::tableToArray(inputDataTable.GetPointer(), sample1Array, sample1RangeList);
-  if (!result)
+  // Compute averages and fold changes
+  vtkNew<vtkArrayData> outputArrayData;
+  int errorValue = 0;
+  if (fold_change_backend == QLatin1String("R"))
     {
-    qWarning() << QObject::tr("Invalid paramater, out of range: Initial Sample(s)");
-    return false;
+    result = computeFoldChangeWithR(inputDataTable, this->input(), sample1RangeList, sample2RangeList,
+                                    meanMethod, outputArrayData.GetPointer(), errorValue);
     }
-
-  // Build array for sample 2 data range
-  vtkSmartPointer<vtkArray> sample2Array;
-  result = voUtils::tableToArray(inputDataTable.GetPointer(), sample2Array, sample2RangeList);
-  if (!result)
+  else
     {
-    qWarning() << QObject::tr("Invalid paramater, out of range: Final Sample(s)");
-    return false;
+    result = computeFoldChangeNatively(this, extendedTable, sample1RangeList, sample2RangeList,
+                                       meanMethod, outputArrayData.GetPointer(), errorValue);
     }
-
-  // Combine sample 1 and 2 array groups
-  vtkNew<vtkArrayData> RInputArrayData;
-  RInputArrayData->AddArray(sample1Array);
-  RInputArrayData->AddArray(sample2Array);
-
-  // Run R code
-  d->RCalc->SetRoutput(0);
-  d->RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  d->RCalc->PutArray("0", "sample1Array");
-  d->RCalc->PutArray("1", "sample2Array");
-  d->RCalc->GetArray("Average Initial","avgInit");
-  d->RCalc->GetArray("Average Final","avgFinal");
-  d->RCalc->GetArray("Fold Change","foldChange");
-  d->RCalc->GetArray("RerrValue","RerrValue");
-  d->RCalc->SetRscript(QString(
-  "RerrValue<-0; meanMethod<- %1 \n"
-  "if(meanMethod == 0) {"
-    "avgInit<-2^rowMeans(log2(sample1Array))\n"
-    "avgFinal<-2^rowMeans(log2(sample2Array))\n"
-  "}else{"
-    "avgInit<-rowMeans(sample1Array)\n"
-    "avgFinal<-rowMeans(sample2Array) }\n"
-  "log2FC<-(log2(avgFinal)-log2(avgInit))\n"
-  "FCFun <- function(x){"
-    "if(!is.finite(x)){RerrValue <<- 2; return(-NaN)}\n"
-    "if (x<0) {return(-1/(2^x))} else {return(2^x)}}\n"
-  "foldChange<-sapply(log2FC, FCFun)"
-  ).arg(meanMethod).toLatin1());
-  d->RCalc->Update();
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(d->RCalc->GetOutput());
-  if(!outputArrayData)
+  if (!result)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(fold_change_backend);
     return false;
     }
-  // Check for errors "thrown" by R script
-  if(outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() > 1)
+
+  // Check for errors "thrown" by the backend
+  if(errorValue > 1)
     {
     qWarning() << QObject::tr("Fold change warning: cannot calculate fold change from zero or negative input");
     }
@@ -229,6 +359,38 @@ bool voFoldChange::execute()
     voUtils::insertColumnIntoTable(outputDataTable.GetPointer(), 2, tempAvgFinalTable->GetColumn(0));
     }
 
+  // Significance of the changes
+  QString p_adjust = this->enumParameter("p_adjust");
+  if (p_adjust != QLatin1String("None"))
+    {
+    vtkIdType numberOfRows = extendedTable->GetNumberOfRows();
+    std::vector<vtkIdType> sample1Columns(sample1RangeList.begin(), sample1RangeList.end());
+    std::vector<vtkIdType> sample2Columns(sample2RangeList.begin(), sample2RangeList.end());
+    vtkNew<vtkDoubleArray> pValues;
+    pValues->SetName("P-Value");
+    pValues->SetNumberOfValues(numberOfRows);
+    std::vector<double> tileBuffer;
+    vtkIdType tileNumberOfRows = extendedTable->GetDataTileNumberOfRows();
+    for (vtkIdType firstRow = 0; firstRow < numberOfRows; firstRow += tileNumberOfRows)
+      {
+      if (this->abortExecution())
+        {
+        return false;
+        }
+      vtkIdType tileRows = std::min(tileNumberOfRows, numberOfRows - firstRow);
+      const double * tile = extendedTable->GetDataTile(firstRow, tileRows, tileBuffer);
+      if (!tile || !voStatisticsUtils::tTest(tile, tileRows, extendedTable->GetNumberOfColumns(),
+                                             sample1Columns, sample2Columns, /* equalVariance= */ false,
+                                             pValues->GetPointer(firstRow)))
+        {
+        qCritical() << QObject::tr("Fatal error in %1 t-test").arg(this->objectName());
+        return false;
+        }
+      }
+    outputDataTable->AddColumn(pValues.GetPointer());
+    voUtils::insertAdjustedPValueColumn(outputDataTable.GetPointer(), "P-Value", p_adjust);
+    }
+
   this->setOutput("foldChange",
                   new voTableDataObject("foldChange", outputDataTable.GetPointer(), /* sortable= */ true));
   this->setOutput("foldChangePlot",
@@ -37,6 +37,8 @@ public:
   voFoldChange();
   virtual ~voFoldChange();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
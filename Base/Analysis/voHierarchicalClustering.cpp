@@ -20,13 +20,16 @@
 
 // Qt includes
 #include <QDebug>
+#include <QMutexLocker>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voHierarchicalClustering.h"
+#include "voClustering.h"
 #include "voDataObject.h"
+#include "voRSession.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
@@ -36,16 +39,143 @@
 #include <vtkDenseArray.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
 #include <vtkIntArray.h>
 #include <vtkMutableDirectedGraph.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 #include <vtkTree.h>
 #include <vtkTreeBFSIterator.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+bool computeClusteringWithR(vtkTable* inputDataTable, voDataObject* input, const QString& method,
+                            vtkArrayData* outputArrayData)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Transfer the input matrix unless it is already resident in R
+  QString inputCacheKey = voRSession::cacheKey(input);
+  if (!session->assignCachedArray("metabData", inputCacheKey))
+    {
+    vtkSmartPointer<vtkArray> RInputArray;
+    voUtils::tableToArray(inputDataTable, RInputArray);
+    session->putArray("metabData", RInputArray, inputCacheKey);
+    }
+
+  // Run R
+  bool scriptResult = session->evalScript(QString(
+                     "dEuc<-dist(t(metabData))\n"
+                     "cluster<-hclust(dEuc,method=\"%1\")\n"
+                     "height<-cluster$height\n"
+//                     "order<-cluster$order\n"
+                     "merge<-cluster$merge\n"
+                     ).arg(method));
+
+  /*
+   * hclust class in R has the following attributes
+   *
+   * labels: labels for each of the objects being clustered.
+   *
+   * merge: an n-1 by 2 matrix.  Row i of merge describes the
+   *       merging of clusters at step i of the clustering.  If an
+   *       element j in the row is negative, then observation -j was
+   *       merged at this stage.  If j is positive then the merge was
+   *      with the cluster formed at the (earlier) stage j of the
+   *      algorithm.  Thus negative entries in merge indicate
+   *       agglomerations of singletons, and positive entries indicate
+   *       agglomerations of non-singletons.
+   *
+   *
+   * height: a set of n-1 non-decreasing real values.  The clustering
+   *       _height_: that is, the value of the criterion associated with
+   *       the clustering method for the particular agglomeration.
+   *
+   * order: a vector giving the permutation of the original observations
+   *       suitable for plotting, in the sense that a cluster plot using
+   *       this ordering and matrix merge will not have crossings
+   *       of the branches.
+   *
+   *
+   * labels : labels for each of the objects being clustered.
+   *
+   */
+
+  // Get R output
+  return scriptResult &&
+      session->getArray("height", "height", outputArrayData) &&
+      session->getArray("merge", "merge", outputArrayData);
+}
+
+// --------------------------------------------------------------------------
+// Condensed matrix of the distances between the experiments
+bool computeExperimentDistances(vtkExtendedTable* extendedTable, vtkFloatArray* distanceArray)
+{
+  const double * data = extendedTable->GetDataBuffer();
+  if (!data)
+    {
+    return false;
+    }
+  std::vector<float> distances;
+  voClustering::columnDistances(data, extendedTable->GetNumberOfRows(),
+                                extendedTable->GetNumberOfColumns(), distances);
+  distanceArray->SetNumberOfValues(static_cast<vtkIdType>(distances.size()));
+  std::copy(distances.begin(), distances.end(), distanceArray->GetPointer(0));
+  return true;
+}
+
+// --------------------------------------------------------------------------
+// Fill the "height" and "merge" arrays the same way the R backend does
+bool computeClusteringNatively(vtkFloatArray* distanceArray, vtkIdType numberOfExperiments,
+                               const QString& method, vtkArrayData* outputArrayData)
+{
+  voClustering::Linkage linkage;
+  if (!voClustering::linkageFromString(method, linkage))
+    {
+    qWarning() << QObject::tr("Invalid paramater, unsupported method: %1").arg(method);
+    return false;
+    }
+
+  // The clustering uses the distances as workspace
+  const float * distanceBuffer = distanceArray->GetPointer(0);
+  std::vector<float> distances(distanceBuffer, distanceBuffer + distanceArray->GetNumberOfTuples());
+  std::vector<voClustering::Merge> merges;
+  if (!voClustering::hierarchicalClustering(distances, numberOfExperiments, linkage, merges))
+    {
+    return false;
+    }
+
+  vtkIdType numberOfMerges = static_cast<vtkIdType>(merges.size());
+  vtkNew<vtkDenseArray<double> > heightArray;
+  heightArray->SetName("height");
+  heightArray->Resize(numberOfMerges);
+  vtkNew<vtkDenseArray<double> > mergeArray;
+  mergeArray->SetName("merge");
+  mergeArray->Resize(numberOfMerges, 2);
+  for (vtkIdType i = 0; i < numberOfMerges; ++i)
+    {
+    heightArray->SetValue(i, merges[i].Height);
+    mergeArray->SetValue(i, 0, merges[i].First);
+    mergeArray->SetValue(i, 1, merges[i].Second);
+    }
+  outputArrayData->AddArray(heightArray.GetPointer());
+  outputArrayData->AddArray(mergeArray.GetPointer());
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voHierarchicalClustering methods
 
@@ -89,9 +219,14 @@ void voHierarchicalClustering::setParameterInformation()
   // HClust / Method
   QStringList hclust_methods;
   // Note: R supports additional methods not provided here
-  hclust_methods << "complete" << "average" << "mcquitty" << "median" << "centroid";
+  hclust_methods << "single" << "complete" << "average" << "mcquitty" << "median" << "centroid" << "ward.D2";
   hclust_parameters << this->addEnumParameter("method", tr("Method"), hclust_methods, "average");
 
+  // HClust / Backend
+  QStringList hclust_backends;
+  hclust_backends << "Native" << "R";
+  hclust_parameters << this->addEnumParameter("backend", tr("Backend"), hclust_backends, "Native");
+
   this->addParameterGroup("Hierarchical Clustering parameters", hclust_parameters);
 }
 
@@ -101,14 +236,26 @@ QString voHierarchicalClustering::parameterDescription()const
   return QString("<dl>"
                  "<dt><b>Method</b>:</dt>"
                  "<dd>The agglomeration method to be used.</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the clustering is computed:<br>"
+                 "- <i>Native</i>: Nearest-neighbor chain, minimum spanning tree (single) "
+                 "or nearest-neighbor list (median, centroid) algorithms<br>"
+                 "- <i>R</i>: Embedded R interpreter, kept as a reference</dd>"
                  "</dl>");
 }
 
+// --------------------------------------------------------------------------
+bool voHierarchicalClustering::mainThreadOnly()const
+{
+  return this->enumParameter("backend") == QLatin1String("R");
+}
+
 // --------------------------------------------------------------------------
 bool voHierarchicalClustering::execute()
 {
   // Parameters
   QString hclust_method = this->enumParameter("method");
+  QString hclust_backend = this->enumParameter("backend");
 
   // Import data table
   vtkExtendedTable* extendedTable =  vtkExtendedTable::SafeDownCast(this->input()->dataAsVTKDataObject());
@@ -120,65 +267,34 @@ bool voHierarchicalClustering::execute()
 
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build ArrayData for input to R
-  vtkNew<vtkArrayData> RInputArrayData;
+  // Cluster the experiments
+  vtkNew<vtkArrayData> outputArrayData;
+  bool result;
+  if (hclust_backend == QLatin1String("R"))
     {
-    vtkSmartPointer<vtkArray> RInputArray;
-    voUtils::tableToArray(inputDataTable.GetPointer(), RInputArray);
-    RInputArrayData->AddArray(RInputArray.GetPointer());
+    result = computeClusteringWithR(inputDataTable, this->input(), hclust_method, outputArrayData.GetPointer());
     }
-
-  // Run R
-  vtkNew <vtkRCalculatorFilter> RCalc;
-  RCalc->SetRoutput(0);
-  RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  RCalc->PutArray("0", "metabData");
-  RCalc->GetArray("height","height");
-//  RCalc->GetArray("order","order");
-  RCalc->GetArray("merge","merge");
-  RCalc->SetRscript(QString(
-                     "dEuc<-dist(t(metabData))\n"
-                     "cluster<-hclust(dEuc,method=\"%1\")\n"
-                     "height<-cluster$height\n"
-//                     "order<-cluster$order\n"
-                     "merge<-cluster$merge\n"
-                     ).arg(hclust_method).toLatin1());
-  RCalc->Update();
-
-  /*
-   * hclust class in R has the following attributes
-   *
-   * labels: labels for each of the objects being clustered.
-   *
-   * merge: an n-1 by 2 matrix.  Row i of merge describes the
-   *       merging of clusters at step i of the clustering.  If an
-   *       element j in the row is negative, then observation -j was
-   *       merged at this stage.  If j is positive then the merge was
-   *      with the cluster formed at the (earlier) stage j of the
-   *      algorithm.  Thus negative entries in merge indicate
-   *       agglomerations of singletons, and positive entries indicate
-   *       agglomerations of non-singletons.
-   *
-   *
-   * height: a set of n-1 non-decreasing real values.  The clustering
-   *       _height_: that is, the value of the criterion associated with
-   *       the clustering method for the particular agglomeration.
-   *
-   * order: a vector giving the permutation of the original observations
-   *       suitable for plotting, in the sense that a cluster plot using
-   *       this ordering and matrix merge will not have crossings
-   *       of the branches.
-   *
-   *
-   * labels : labels for each of the objects being clustered.
-   *
-   */
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(RCalc->GetOutput());
-  if(!outputArrayData || !outputArrayData->GetArrayByName("merge"))
+  else
+    {
+    // The distances don't depend on the method, they are kept for the next executions
+    vtkSmartPointer<vtkFloatArray> distanceArray =
+        vtkFloatArray::SafeDownCast(this->intermediateData("distances"));
+    result = true;
+    if (!distanceArray)
+      {
+      distanceArray = vtkSmartPointer<vtkFloatArray>::New();
+      result = computeExperimentDistances(extendedTable, distanceArray);
+      if (result)
+        {
+        this->setIntermediateData("distances", distanceArray, QStringList());
+        }
+      }
+    result = result && computeClusteringNatively(distanceArray, extendedTable->GetNumberOfColumns(),
+                                                 hclust_method, outputArrayData.GetPointer());
+    }
+  if (!result)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(hclust_backend);
     return false;
     }
 
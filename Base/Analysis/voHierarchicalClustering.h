@@ -35,6 +35,8 @@ public:
   voHierarchicalClustering();
   virtual ~voHierarchicalClustering();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
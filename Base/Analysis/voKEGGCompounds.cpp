@@ -123,6 +123,18 @@ void voKEGGCompounds::setOutputInformation()
                       "voKEGGTableView", "Ranking - Pathways");
 }
 
+// --------------------------------------------------------------------------
+bool voKEGGCompounds::mainThreadOnly()const
+{
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voKEGGCompounds::resultCacheable()const
+{
+  return false;
+}
+
 // --------------------------------------------------------------------------
 bool voKEGGCompounds::execute()
 {
@@ -37,6 +37,9 @@ public:
   voKEGGCompounds();
   virtual ~voKEGGCompounds();
 
+  virtual bool mainThreadOnly()const;
+  virtual bool resultCacheable()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
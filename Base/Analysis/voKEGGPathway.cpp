@@ -112,6 +112,18 @@ QString voKEGGPathway::parameterDescription()const
                  "</dl>");
 }
 
+// --------------------------------------------------------------------------
+bool voKEGGPathway::mainThreadOnly()const
+{
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voKEGGPathway::resultCacheable()const
+{
+  return false;
+}
+
 // --------------------------------------------------------------------------
 bool voKEGGPathway::execute()
 {
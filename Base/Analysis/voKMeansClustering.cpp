@@ -21,21 +21,25 @@
 // Qt includes
 #include <QDebug>
 #include <QList>
+#include <QMutexLocker>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voKMeansClustering.h"
+#include "voClustering.h"
+#include "voDataObject.h"
+#include "voRSession.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkArrayData.h>
+#include <vtkDenseArray.h>
 #include <vtkIntArray.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
@@ -88,6 +92,11 @@ void voKMeansClustering::setParameterInformation()
    // KMeans / number of random start 
   kmeans_parameters << this->addIntegerParameter("nstart", QObject::tr("Number of random start"), 1, 50, 10);
 
+  // KMeans / Backend
+  QStringList kmeans_backends;
+  kmeans_backends << "Native" << "R";
+  kmeans_parameters << this->addEnumParameter("backend", QObject::tr("Backend"), kmeans_backends, "Native");
+
   this->addParameterGroup("KMeans parameters", kmeans_parameters);
 }
 
@@ -101,12 +110,19 @@ QString voKMeansClustering::parameterDescription()const
                  "<dd>A larger number of iterations will take longer, "
                  "but be more likely to converge on a better solution.</dd>"
                  "<dt><b>Algorithm</b>:</dt>"
-                 "<dd>The specific algorithm for the k-means method.</dd>"
+                 "<dd>The specific algorithm for the k-means method, "
+                 "see the R function <i>kmeans</i>.</dd>"
                  "<dt><b>Number of random start</b>:</dt>"
                  "<dd>Number of initially random cluster sets that the "
                  "algorithm will attempt to refine. "
                  "A larger number will take longer, "
                  "but be more likely to converge on a better solution.</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the clustering is computed:<br>"
+                 "- <i>Native</i>: Random starts seeded using k-means++ and run concurrently. "
+                 "R picks the initial centers at random instead, so both backends "
+                 "may find different clusters<br>"
+                 "- <i>R</i>: Embedded R interpreter, kept as a reference</dd>"
                  "</dl>");
 }
 
@@ -158,8 +174,118 @@ void displayClustedIds(const char* description, vtkTable* table)
   qDebug() << description << columndIdsToDisplay;
 }
 
+// --------------------------------------------------------------------------
+bool computeKMeansWithR(vtkTable* inputDataTable, voDataObject* input, int centers, int maximumIterations,
+                        int numberOfStarts, const QString& algorithm, vtkArrayData* outputArrayData)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Transfer the input matrix unless it is already resident in R
+  QString inputCacheKey = voRSession::cacheKey(input);
+  if (!session->assignCachedArray("metabData", inputCacheKey))
+    {
+    vtkSmartPointer<vtkArray> RInputArray;
+    voUtils::tableToArray(inputDataTable, RInputArray);
+    session->putArray("metabData", RInputArray, inputCacheKey);
+    }
+
+  // Run R
+  bool scriptResult = session->evalScript(QString(
+                     "metabDatat <- t(metabData)\n"
+                     "km<-kmeans(metabDatat, %1, iter.max = %2, nstart = %3, algorithm = \"%4\")\n"
+                     "kmCenters<-km$centers \n"
+                     "kmCluster<-km$cluster\n"
+                     "kmWithinss<-km$withinss\n"
+                     "kmSize<-km$size\n"
+                     ).arg(centers).arg(maximumIterations).arg(numberOfStarts).arg(algorithm));
+
+  // Get R output
+  return scriptResult &&
+      session->getArray("kmCenters", "kmCenters", outputArrayData) &&
+      session->getArray("kmCluster", "kmCluster", outputArrayData) &&
+      session->getArray("kmWithinss", "kmWithinss", outputArrayData) &&
+      session->getArray("kmSize", "kmSize", outputArrayData);
+}
+
+// --------------------------------------------------------------------------
+// Fill the "kmCenters", "kmCluster", "kmWithinss" and "kmSize" arrays the same way the R backend does
+bool computeKMeansNatively(vtkExtendedTable* extendedTable, int centers, int maximumIterations,
+                           int numberOfStarts, const QString& algorithm, vtkArrayData* outputArrayData)
+{
+  voClustering::KMeansAlgorithm kMeansAlgorithm;
+  if (!voClustering::kMeansAlgorithmFromString(algorithm, kMeansAlgorithm))
+    {
+    qWarning() << QObject::tr("Invalid paramater, unsupported algorithm: %1").arg(algorithm);
+    return false;
+    }
+  const double * data = extendedTable->GetDataBuffer();
+  if (!data)
+    {
+    return false;
+    }
+  vtkIdType numberOfAnalytes = extendedTable->GetNumberOfRows();
+  vtkIdType numberOfExperiments = extendedTable->GetNumberOfColumns();
+  if (centers > numberOfExperiments)
+    {
+    qWarning() << QObject::tr("Invalid paramater, more clusters than experiments: %1").arg(centers);
+    return false;
+    }
+
+  voClustering::KMeansResult result;
+  if (!voClustering::kMeans(data, numberOfAnalytes, numberOfExperiments, centers, maximumIterations,
+                            numberOfStarts, kMeansAlgorithm, /* seed= */ 1, result))
+    {
+    return false;
+    }
+  if (!result.Converged)
+    {
+    qWarning() << QObject::tr("KMeans warning: did not converge in %1 iterations").arg(maximumIterations);
+    }
+
+  vtkNew<vtkDenseArray<double> > centersArray;
+  centersArray->SetName("kmCenters");
+  centersArray->Resize(centers, numberOfAnalytes);
+  vtkNew<vtkDenseArray<double> > withinssArray;
+  withinssArray->SetName("kmWithinss");
+  withinssArray->Resize(centers);
+  vtkNew<vtkDenseArray<double> > sizeArray;
+  sizeArray->SetName("kmSize");
+  sizeArray->Resize(centers);
+  for (int c = 0; c < centers; ++c)
+    {
+    for (vtkIdType r = 0; r < numberOfAnalytes; ++r)
+      {
+      centersArray->SetValue(c, r, result.Centers[c * numberOfAnalytes + r]);
+      }
+    withinssArray->SetValue(c, result.WithinSumOfSquares[c]);
+    sizeArray->SetValue(c, result.Sizes[c]);
+    }
+
+  // R cluster numbers start from 1
+  vtkNew<vtkDenseArray<double> > clusterArray;
+  clusterArray->SetName("kmCluster");
+  clusterArray->Resize(numberOfExperiments);
+  for (vtkIdType i = 0; i < numberOfExperiments; ++i)
+    {
+    clusterArray->SetValue(i, result.Clusters[i] + 1);
+    }
+
+  outputArrayData->AddArray(centersArray.GetPointer());
+  outputArrayData->AddArray(clusterArray.GetPointer());
+  outputArrayData->AddArray(withinssArray.GetPointer());
+  outputArrayData->AddArray(sizeArray.GetPointer());
+  return true;
+}
+
 } // end of anonymous namespace
 
+// --------------------------------------------------------------------------
+bool voKMeansClustering::mainThreadOnly()const
+{
+  return this->enumParameter("backend") == QLatin1String("R");
+}
+
 // --------------------------------------------------------------------------
 bool voKMeansClustering::execute()
 {
@@ -168,6 +294,7 @@ bool voKMeansClustering::execute()
   int kmeans_iter_max = this->integerParameter("iter.max");
   int kmeans_number_of_random_start = this->integerParameter("nstart");
   QString kmeans_algorithm = this->enumParameter("algorithm");
+  QString kmeans_backend = this->enumParameter("backend");
 
   // Import data table
   vtkExtendedTable* extendedTable =  vtkExtendedTable::SafeDownCast(this->input()->dataAsVTKDataObject());
@@ -179,38 +306,22 @@ bool voKMeansClustering::execute()
 
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build ArrayData for input to R
-  vtkNew<vtkArrayData> RInputArrayData;
+  // Partition the experiments
+  vtkNew<vtkArrayData> outputArrayData;
+  bool result;
+  if (kmeans_backend == QLatin1String("R"))
     {
-    vtkSmartPointer<vtkArray> RInputArray;
-    voUtils::tableToArray(inputDataTable.GetPointer(), RInputArray);
-    RInputArrayData->AddArray(RInputArray.GetPointer());
+    result = computeKMeansWithR(inputDataTable, this->input(), kmeans_centers, kmeans_iter_max,
+                                kmeans_number_of_random_start, kmeans_algorithm, outputArrayData.GetPointer());
     }
-
-  // Run R
-  vtkNew<vtkRCalculatorFilter> RCalc;
-  RCalc->SetRoutput(0);
-  RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  RCalc->PutArray("0", "metabData");
-  RCalc->GetArray("kmCenters", "kmCenters");
-  RCalc->GetArray("kmCluster", "kmCluster");
-  RCalc->GetArray("kmWithinss", "kmWithinss");
-  RCalc->GetArray("kmSize", "kmSize");
-  RCalc->SetRscript(QString(
-                     "metabDatat <- t(metabData)\n"
-                     "km<-kmeans(metabDatat, %1, iter.max = %2, nstart = %3, algorithm = \"%4\")\n"
-                     "kmCenters<-km$centers \n"
-                     "kmCluster<-km$cluster\n"
-                     "kmWithinss<-km$withinss\n"
-                     "kmSize<-km$size\n"
-                     ).arg(kmeans_centers).arg(kmeans_iter_max).arg(kmeans_number_of_random_start).arg(kmeans_algorithm).toLatin1());
-  RCalc->Update();
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(RCalc->GetOutput());
-  if(!outputArrayData || !outputArrayData->GetArrayByName("kmCluster"))
+  else
+    {
+    result = computeKMeansNatively(extendedTable, kmeans_centers, kmeans_iter_max,
+                                   kmeans_number_of_random_start, kmeans_algorithm, outputArrayData.GetPointer());
+    }
+  if (!result)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(kmeans_backend);
     return false;
     }
 
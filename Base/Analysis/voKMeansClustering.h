@@ -37,6 +37,8 @@ public:
   voKMeansClustering();
   virtual ~voKMeansClustering();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
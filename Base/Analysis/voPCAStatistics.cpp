@@ -20,22 +20,33 @@
 
 // Qt includes
 #include <QDebug>
+#include <QMutexLocker>
+
+// QtPropertyBrowser includes
+#include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voPCAStatistics.h"
+#include "voDataObject.h"
+#include "voLinearAlgebra.h"
+#include "voRSession.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkArrayData.h>
+#include <vtkDenseArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <cmath>
+#include <vector>
+
 // --------------------------------------------------------------------------
 // voPCAStatisticsPrivate methods
 
@@ -43,9 +54,129 @@
 class voPCAStatisticsPrivate
 {
 public:
-  vtkSmartPointer<vtkRCalculatorFilter> RCalc;
 };
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+bool computePCAWithR(vtkTable* inputDataTable, voDataObject* input, int numberOfComponents,
+                     vtkArrayData* outputArrayData)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Transfer the input matrix unless it is already resident in R
+  QString inputCacheKey = voRSession::cacheKey(input);
+  if (!session->assignCachedArray("PCAData", inputCacheKey))
+    {
+    vtkSmartPointer<vtkArray> RInputArray;
+    voUtils::tableToArray(inputDataTable, RInputArray);
+    session->putArray("PCAData", RInputArray, inputCacheKey);
+    }
+
+  // Run R, the importance of the components is computed before truncating them
+  bool scriptResult = session->evalScript(QString(
+                     "pc1<-prcomp(t(PCAData), scale.=F, center=T, retx=T)\n"
+                     "numcomp=min(%1, ncol(pc1$rot))\n"
+                     "pcaRot<-pc1$rot[,1:numcomp,drop=FALSE]\n"
+                     "pcaSdev<-pc1$sdev[1:numcomp]\n"
+                     "data<-summary(pc1)\n"
+                     "OutputData<-unlist(data[6],use.names=FALSE)\n"
+                     "stddev=OutputData[((1:numcomp)*3)-2]\n"
+                     "perload=OutputData[((1:numcomp)*3)-1]\n"
+                     "sumperload=OutputData[((1:numcomp)*3)] \n"
+                     "projection<-pc1$x[,1:numcomp,drop=FALSE]").arg(numberOfComponents));
+
+  // Get R output
+  return scriptResult &&
+      session->getArray("pcaRot", "pcaRot", outputArrayData) &&
+      session->getArray("pcaSdev", "pcaSdev", outputArrayData) &&
+      session->getArray("sumperload", "sumperload", outputArrayData) &&
+      session->getArray("perload", "perload", outputArrayData) &&
+      session->getArray("stddev", "stddev", outputArrayData) &&
+      session->getArray("projection", "projection", outputArrayData);
+}
+
+// --------------------------------------------------------------------------
+// Proportion of variance rounded like the R function "summary.prcomp" does
+double roundedProportion(double value)
+{
+  return std::floor(value * 1e5 + 0.5) / 1e5;
+}
+
+// --------------------------------------------------------------------------
+// Fill the arrays the same way the R backend does
+bool computePCANatively(vtkExtendedTable* extendedTable, int numberOfComponents,
+                        vtkArrayData* outputArrayData)
+{
+  const double * data = extendedTable->GetDataBuffer();
+  if (!data)
+    {
+    return false;
+    }
+  vtkIdType numberOfAnalytes = extendedTable->GetNumberOfRows();
+  vtkIdType numberOfExperiments = extendedTable->GetNumberOfColumns();
+
+  voLinearAlgebra::PCAResult result;
+  if (!voLinearAlgebra::truncatedPCA(data, numberOfAnalytes, numberOfExperiments, numberOfComponents, result))
+    {
+    return false;
+    }
+  vtkIdType components = static_cast<vtkIdType>(result.StandardDeviations.size());
+
+  vtkNew<vtkDenseArray<double> > rotationArray;
+  rotationArray->SetName("pcaRot");
+  rotationArray->Resize(numberOfAnalytes, components);
+  vtkNew<vtkDenseArray<double> > projectionArray;
+  projectionArray->SetName("projection");
+  projectionArray->Resize(numberOfExperiments, components);
+  vtkNew<vtkDenseArray<double> > sdevArray;
+  sdevArray->SetName("pcaSdev");
+  sdevArray->Resize(components);
+  vtkNew<vtkDenseArray<double> > stddevArray;
+  stddevArray->SetName("stddev");
+  stddevArray->Resize(components);
+  vtkNew<vtkDenseArray<double> > perloadArray;
+  perloadArray->SetName("perload");
+  perloadArray->Resize(components);
+  vtkNew<vtkDenseArray<double> > sumperloadArray;
+  sumperloadArray->SetName("sumperload");
+  sumperloadArray->Resize(components);
+
+  double cumulativeVariance = 0.;
+  for (vtkIdType c = 0; c < components; ++c)
+    {
+    for (vtkIdType r = 0; r < numberOfAnalytes; ++r)
+      {
+      rotationArray->SetValue(r, c, result.Rotation[c * numberOfAnalytes + r]);
+      }
+    for (vtkIdType j = 0; j < numberOfExperiments; ++j)
+      {
+      projectionArray->SetValue(j, c, result.Projection[c * numberOfExperiments + j]);
+      }
+    double sdev = result.StandardDeviations[c];
+    double variance = result.TotalVariance > 0. ? sdev * sdev / result.TotalVariance : 0.;
+    cumulativeVariance += variance;
+    sdevArray->SetValue(c, sdev);
+    stddevArray->SetValue(c, sdev);
+    perloadArray->SetValue(c, roundedProportion(variance));
+    sumperloadArray->SetValue(c, roundedProportion(cumulativeVariance));
+    }
+
+  outputArrayData->AddArray(rotationArray.GetPointer());
+  outputArrayData->AddArray(sdevArray.GetPointer());
+  outputArrayData->AddArray(sumperloadArray.GetPointer());
+  outputArrayData->AddArray(perloadArray.GetPointer());
+  outputArrayData->AddArray(stddevArray.GetPointer());
+  outputArrayData->AddArray(projectionArray.GetPointer());
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voPCAStatistics methods
 
@@ -53,9 +184,6 @@ public:
 voPCAStatistics::voPCAStatistics():
     Superclass(), d_ptr(new voPCAStatisticsPrivate)
 {
-  Q_D(voPCAStatistics);
-  
-  d->RCalc = vtkSmartPointer<vtkRCalculatorFilter>::New();
 }
 
 // --------------------------------------------------------------------------
@@ -97,10 +225,47 @@ void voPCAStatistics::setOutputInformation()
                       "voTableView", "Cumulative Percent Loading (Table)");
 }
 
+// --------------------------------------------------------------------------
+void voPCAStatistics::setParameterInformation()
+{
+  QList<QtProperty*> pca_parameters;
+
+  pca_parameters << this->addIntegerParameter("components", QObject::tr("Number of components"), 2, 1000, 10);
+
+  QStringList pca_backends;
+  pca_backends << "Native" << "R";
+  pca_parameters << this->addEnumParameter("backend", QObject::tr("Backend"), pca_backends, "Native");
+
+  this->addParameterGroup("PCA parameters", pca_parameters);
+}
+
+// --------------------------------------------------------------------------
+QString voPCAStatistics::parameterDescription()const
+{
+  return QString("<dl>"
+                 "<dt><b>Number of components</b>:</dt>"
+                 "<dd>Number of principal components computed and reported, at most the "
+                 "number of Analytes or Experiments.</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the components are computed:<br>"
+                 "- <i>Native</i>: Truncated randomized SVD, memory is proportional "
+                 "to the number of components<br>"
+                 "- <i>R</i>: Full decomposition using the embedded R interpreter, kept as a reference</dd>"
+                 "</dl>");
+}
+
+// --------------------------------------------------------------------------
+bool voPCAStatistics::mainThreadOnly()const
+{
+  return this->enumParameter("backend") == QLatin1String("R");
+}
+
 // --------------------------------------------------------------------------
 bool voPCAStatistics::execute()
 {
-  Q_D(voPCAStatistics);
+  // Parameters
+  int pca_components = this->integerParameter("components");
+  QString pca_backend = this->enumParameter("backend");
 
   // Import data table locally
   vtkExtendedTable* extendedTable =  vtkExtendedTable::SafeDownCast(this->input()->dataAsVTKDataObject());
@@ -113,40 +278,20 @@ bool voPCAStatistics::execute()
   //vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::Take(extendedTable->GetDataWithRowHeader());
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build ArrayData for input to R
-  vtkNew<vtkArrayData> RInputArrayData;
+  // Compute the principal components
+  vtkNew<vtkArrayData> outputArrayData;
+  bool result;
+  if (pca_backend == QLatin1String("R"))
     {
-    vtkSmartPointer<vtkArray> RInputArray;
-    voUtils::tableToArray(inputDataTable.GetPointer(), RInputArray);
-    RInputArrayData->AddArray(RInputArray.GetPointer());
+    result = computePCAWithR(inputDataTable, this->input(), pca_components, outputArrayData.GetPointer());
     }
-
-  d->RCalc->SetRoutput(0);
-  d->RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  d->RCalc->PutArray("0", "PCAData");
-  d->RCalc->GetArray("pcaRot", "pcaRot");
-  d->RCalc->GetArray("pcaSdev", "pcaSdev");
-  d->RCalc->GetArray("sumperload", "sumperload");
-  d->RCalc->GetArray("perload", "perload");
-  d->RCalc->GetArray("stddev", "stddev");
-  d->RCalc->GetArray("projection", "projection");
-  d->RCalc->SetRscript("pc1<-prcomp(t(PCAData), scale.=F, center=T, retx=T)\n"
-                     "pcaRot<-pc1$rot\n"
-                     "pcaSdev<-pc1$sdev\n"
-                     "data<-summary(pc1)\n"
-                     "numcol=ncol(data$importance)\n"
-                     "OutputData<-unlist(data[6],use.names=FALSE)\n"
-                     "stddev=OutputData[((1:numcol)*3)-2]\n"
-                     "perload=OutputData[((1:numcol)*3)-1]\n"
-                     "sumperload=OutputData[((1:numcol)*3)] \n"
-                     "projection<-pc1$x");
-  d->RCalc->Update();
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(d->RCalc->GetOutput());
-  if(!outputArrayData || !outputArrayData->GetArrayByName("stddev"))
+  else
+    {
+    result = computePCANatively(extendedTable, pca_components, outputArrayData.GetPointer());
+    }
+  if (!result)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(pca_backend);
     return false;
     }
 
@@ -37,9 +37,13 @@ public:
   voPCAStatistics();
   virtual ~voPCAStatistics();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
+  virtual void setParameterInformation();
+  virtual QString parameterDescription()const;
 
   virtual bool execute();
 
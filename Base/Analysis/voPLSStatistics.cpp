@@ -20,25 +20,32 @@
 
 // Qt includes
 #include <QDebug>
+#include <QMutexLocker>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voPLSStatistics.h"
+#include "voDataObject.h"
+#include "voLinearAlgebra.h"
+#include "voRSession.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkArrayData.h>
+#include <vtkDenseArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <vector>
+
 // --------------------------------------------------------------------------
 // voPLSStatisticsPrivate methods
 
@@ -46,9 +53,182 @@
 class voPLSStatisticsPrivate
 {
 public:
-  vtkSmartPointer<vtkRCalculatorFilter> RCalc;
 };
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+bool computePLSWithR(vtkExtendedTable* extendedTable, voDataObject* input,
+                     const QString& predictorRange, const QList<int>& predictorRangeList,
+                     const QString& responseRange, const QList<int>& responseRangeList,
+                     const QString& algorithmString, int numberOfComponents, int numberOfSegments,
+                     vtkArrayData* outputArrayData)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+  if (!session->requirePackage("pls"))
+    {
+    return false;
+    }
+
+  // Transfer the predictor and response matrices unless they are already resident in R
+  QString predictorCacheKey = voRSession::cacheKey(input, QString("transposed:%1").arg(predictorRange));
+  QString responseCacheKey = voRSession::cacheKey(input, QString("transposed:%1").arg(responseRange));
+  if (!session->assignCachedArray("predictorArray", predictorCacheKey) ||
+      !session->assignCachedArray("responseArray", responseCacheKey))
+    {
+    vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
+    // PLS expects each measure (analyte) as a column, and each sample (experiment) as a row, so we must transpose
+    vtkNew<vtkTable> inputDataTableTransposed;
+    bool transposeResult = voUtils::transposeTable(inputDataTable.GetPointer(), inputDataTableTransposed.GetPointer());
+    if (!transposeResult)
+      {
+      qWarning() << QObject::tr("Error: could not transpose input table");
+      return false;
+      }
+
+    // Build arrays for predictor and response measure ranges
+    vtkSmartPointer<vtkArray> predictorArray;
+    vtkSmartPointer<vtkArray> responseArray;
+    if (!voUtils::tableToArray(inputDataTableTransposed.GetPointer(), predictorArray, predictorRangeList) ||
+        !voUtils::tableToArray(inputDataTableTransposed.GetPointer(), responseArray, responseRangeList))
+      {
+      return false;
+      }
+
+    session->putArray("predictorArray", predictorArray, predictorCacheKey);
+    session->putArray("responseArray", responseArray, responseCacheKey);
+    }
+
+  // Run R code
+  QString validation("validation=\"none\"");
+  QString estimate("train");
+  if (numberOfSegments >= 2)
+    {
+    validation = QString("validation=\"CV\", segments=min(%1, nrow(predictorArray)), "
+                         "segment.type=\"interleaved\"").arg(numberOfSegments);
+    estimate = "CV";
+    }
+  bool scriptResult = session->evalScript(QString(
+  "PLSdata <- data.frame(response=I(responseArray), predictor=I(predictorArray) )\n"
+  "PLSncomp <- min(%2, nrow(predictorArray) - 1, ncol(predictorArray))\n"
+  "PLSresult <- plsr(response ~ predictor, ncomp = PLSncomp, data = PLSdata, method = \"%1\", %3)\n"
+  "if(exists(\"PLSresult\")) {"
+    "RerrValue<-1"
+  "}else{"
+    "RerrValue<-0"
+  "}\n"
+  "scoresArray <- t(PLSresult$scores)\n"
+  "yScoresArray <- t(PLSresult$Yscores)\n"
+  "loadingsArray <- PLSresult$loadings[,]\n"
+  "loadingWeightsArray <- PLSresult$loading.weights[,]\n"
+  "yLoadingsArray <- PLSresult$Yloadings[,]\n"
+  "rmsepArray <- matrix(RMSEP(PLSresult, estimate = \"%4\")$val[1,,], nrow = ncol(responseArray))\n"
+  ).arg(algorithmString).arg(numberOfComponents).arg(validation).arg(estimate));
+
+  // Get R output and check for errors "thrown" by R script
+  return scriptResult &&
+      session->getArray("scoresArray", "scoresArray", outputArrayData) &&
+      session->getArray("yScoresArray", "yScoresArray", outputArrayData) &&
+      session->getArray("loadingsArray", "loadingsArray", outputArrayData) &&
+      session->getArray("loadingWeightsArray", "loadingWeightsArray", outputArrayData) &&
+      session->getArray("yLoadingsArray", "yLoadingsArray", outputArrayData) &&
+      session->getArray("rmsepArray", "rmsepArray", outputArrayData) &&
+      session->getArray("RerrValue", "RerrValue", outputArrayData) &&
+      outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() <= 1;
+}
+
+// --------------------------------------------------------------------------
+// Copy a column-major matrix (rows x columns) into a new array of outputArrayData
+void addMatrixToArrayData(vtkArrayData* outputArrayData, const char* name, const std::vector<double>& values,
+                          vtkIdType numberOfRows, vtkIdType numberOfColumns, bool transpose)
+{
+  vtkNew<vtkDenseArray<double> > array;
+  array->SetName(name);
+  if (transpose)
+    {
+    array->Resize(numberOfColumns, numberOfRows);
+    }
+  else
+    {
+    array->Resize(numberOfRows, numberOfColumns);
+    }
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      double value = values[c * numberOfRows + r];
+      if (transpose)
+        {
+        array->SetValue(c, r, value);
+        }
+      else
+        {
+        array->SetValue(r, c, value);
+        }
+      }
+    }
+  outputArrayData->AddArray(array.GetPointer());
+}
+
+// --------------------------------------------------------------------------
+// Fill the arrays the same way the R backend does. Experiments are the observations:
+// the row-major data buffer is the observations x analytes matrix, no transpose is needed.
+bool computePLSNatively(vtkExtendedTable* extendedTable,
+                        const QList<int>& predictorRangeList, const QList<int>& responseRangeList,
+                        const QString& algorithmString, int numberOfComponents, int numberOfSegments,
+                        vtkArrayData* outputArrayData)
+{
+  voLinearAlgebra::PLSAlgorithm algorithm;
+  if (!voLinearAlgebra::plsAlgorithmFromString(algorithmString, algorithm))
+    {
+    return false;
+    }
+  const double * data = extendedTable->GetDataBuffer(vtkExtendedTable::RowMajor);
+  if (!data)
+    {
+    return false;
+    }
+  vtkIdType numberOfExperiments = extendedTable->GetNumberOfColumns();
+  vtkIdType numberOfAnalytes = extendedTable->GetNumberOfRows();
+
+  std::vector<vtkIdType> predictors;
+  foreach(int r, predictorRangeList)
+    {
+    predictors.push_back(r);
+    }
+  std::vector<vtkIdType> responses;
+  foreach(int r, responseRangeList)
+    {
+    responses.push_back(r);
+    }
+
+  voLinearAlgebra::PLSResult result;
+  if (!voLinearAlgebra::partialLeastSquares(data, numberOfExperiments, numberOfAnalytes, predictors, responses,
+                                            numberOfComponents, algorithm, numberOfSegments, result))
+    {
+    return false;
+    }
+  vtkIdType components = result.NumberOfComponents;
+  vtkIdType numberOfPredictors = static_cast<vtkIdType>(predictors.size());
+  vtkIdType numberOfResponses = static_cast<vtkIdType>(responses.size());
+
+  // Scores are reported with one row per component
+  addMatrixToArrayData(outputArrayData, "scoresArray", result.Scores, numberOfExperiments, components, true);
+  addMatrixToArrayData(outputArrayData, "yScoresArray", result.YScores, numberOfExperiments, components, true);
+  addMatrixToArrayData(outputArrayData, "loadingsArray", result.Loadings, numberOfPredictors, components, false);
+  addMatrixToArrayData(outputArrayData, "loadingWeightsArray", result.LoadingWeights,
+                       numberOfPredictors, components, false);
+  addMatrixToArrayData(outputArrayData, "yLoadingsArray", result.YLoadings, numberOfResponses, components, false);
+  addMatrixToArrayData(outputArrayData, "rmsepArray", result.RMSEP, components + 1, numberOfResponses, true);
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voPLSStatistics methods
 
@@ -56,9 +236,6 @@ public:
 voPLSStatistics::voPLSStatistics():
     Superclass(), d_ptr(new voPLSStatisticsPrivate)
 {
-  Q_D(voPLSStatistics);
-  
-  d->RCalc = vtkSmartPointer<vtkRCalculatorFilter>::New();
 }
 
 // --------------------------------------------------------------------------
@@ -106,6 +283,10 @@ void voPLSStatistics::setOutputInformation()
   this->addOutputType("yLoadings_transposed", "vtkTable" ,
                       "voPCAProjectionView", "Y-Loadings (Plot)",
                       "", "");
+
+  this->addOutputType("rmsep", "vtkTable" ,
+                      "", "",
+                      "voTableView", "RMSEP (Table)");
 }
 
 // --------------------------------------------------------------------------
@@ -118,6 +299,12 @@ void voPLSStatistics::setParameterInformation()
   pls_parameters << this->addEnumParameter("algorithm", tr("Algorithm"), 
                             (QStringList() << "Kernel" << "Wide Kernel" << "SIMPLS" << "Orthogonal Scores"), 
                             "Kernel");
+  pls_parameters << this->addIntegerParameter("components", QObject::tr("Number of components"), 1, 1000, 10);
+  pls_parameters << this->addIntegerParameter("segments", QObject::tr("Cross-validation segments"), 0, 1000, 0);
+
+  QStringList pls_backends;
+  pls_backends << "Native" << "R";
+  pls_parameters << this->addEnumParameter("backend", QObject::tr("Backend"), pls_backends, "Native");
 
   this->addParameterGroup("PLS parameters", pls_parameters);
 }
@@ -130,14 +317,30 @@ QString voPLSStatistics::parameterDescription()const
                  "<dd>A group of Analytes, specified by a range and/or list of row numbers.</dd>"
                  "<dt><b>Algorithm</b>:</dt>"
                  "<dd>The multivariante regression method.</dd>"
+                 "<dt><b>Number of components</b>:</dt>"
+                 "<dd>Number of components extracted, at most the number of Predictor Analytes "
+                 "and the number of Experiments minus one.</dd>"
+                 "<dt><b>Cross-validation segments</b>:</dt>"
+                 "<dd>Number of interleaved groups of Experiments used to estimate the root mean "
+                 "squared error of prediction (RMSEP), each group being predicted by the model of "
+                 "the other ones. With less than 2 segments, the RMSEP is the training error.</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the regression is computed:<br>"
+                 "- <i>Native</i>: Works directly on the input data, cross-validation segments "
+                 "are fitted concurrently<br>"
+                 "- <i>R</i>: Package \"pls\" of the embedded R interpreter, kept as a reference</dd>"
                  "</dl>");
 }
 
 // --------------------------------------------------------------------------
-bool voPLSStatistics::execute()
+bool voPLSStatistics::mainThreadOnly()const
 {
-  Q_D(voPLSStatistics);
+  return this->enumParameter("backend") == QLatin1String("R");
+}
 
+// --------------------------------------------------------------------------
+bool voPLSStatistics::execute()
+{
   // Get and parse parameters
   QString algorithmString;
   if (this->enumParameter("algorithm") == QLatin1String("Kernel"))
@@ -156,6 +359,9 @@ bool voPLSStatistics::execute()
     {
     algorithmString = "oscorespls";
     }
+  int pls_components = this->integerParameter("components");
+  int pls_segments = this->integerParameter("segments");
+  QString pls_backend = this->enumParameter("backend");
 
   bool result;
 
@@ -182,73 +388,35 @@ bool voPLSStatistics::execute()
     qCritical() << "Input is Null";
     return false;
     }
-  vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
-  // PLS expects each measure (analyte) as a column, and each sample (experiment) as a row, so we must transpose
-  vtkNew<vtkTable> inputDataTableTransposed;
-  bool transposeResult = voUtils::transposeTable(inputDataTable.GetPointer(), inputDataTableTransposed.GetPointer());
-  if (!transposeResult)
-    {
-    qWarning() << QObject::tr("Error: could not transpose input table");
-    return false;
-    }
 
-  // Build array for predictor measure range
-  vtkSmartPointer<vtkArray> predictorArray;
-  bool tabToArrResult = voUtils::tableToArray(inputDataTableTransposed.GetPointer(), predictorArray, predictorRangeList);
-  if (!tabToArrResult)
+  if (predictorRangeList.first() < 0 || predictorRangeList.last() >= extendedTable->GetNumberOfRows())
     {
     qWarning() << QObject::tr("Invalid paramater, out of range: Predictor Measure(s)");
     return false;
     }
-
-  // Build array for response measure
-  vtkSmartPointer<vtkArray> responseArray;
-  tabToArrResult = voUtils::tableToArray(inputDataTableTransposed.GetPointer(), responseArray, responseRangeList);
-  if (!tabToArrResult)
+  if (responseRangeList.first() < 0 || responseRangeList.last() >= extendedTable->GetNumberOfRows())
     {
     qWarning() << QObject::tr("Invalid paramater, out of range: Response Measure(s)");
     return false;
     }
 
-  // Combine sample 1 and 2 array groups
-  vtkNew<vtkArrayData> RInputArrayData;
-  RInputArrayData->AddArray(predictorArray.GetPointer());
-  RInputArrayData->AddArray(responseArray.GetPointer());
-
-  // Run R code
-  d->RCalc->SetRoutput(0);
-  d->RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  d->RCalc->PutArray("0", "predictorArray");
-  d->RCalc->PutArray("1", "responseArray");
-  d->RCalc->GetArray("scoresArray","scoresArray");
-  d->RCalc->GetArray("yScoresArray","yScoresArray");
-  d->RCalc->GetArray("loadingsArray","loadingsArray");
-  d->RCalc->GetArray("loadingWeightsArray","loadingWeightsArray");
-  d->RCalc->GetArray("yLoadingsArray","yLoadingsArray");
-  d->RCalc->GetArray("RerrValue","RerrValue");
-  d->RCalc->SetRscript(QString(
-  "library(\"pls\", warn.conflicts=FALSE)\n"
-  "PLSdata <- data.frame(response=I(responseArray), predictor=I(predictorArray) )\n"
-  "PLSresult <- plsr(response ~ predictor, data = PLSdata, method = \"%1\")\n"
-  "if(exists(\"PLSresult\")) {"
-    "RerrValue<-1"
-  "}else{"
-    "RerrValue<-0"
-  "}\n"
-  "scoresArray <- t(PLSresult$scores)\n"
-  "yScoresArray <- t(PLSresult$Yscores)\n"
-  "loadingsArray <- PLSresult$loadings[,]\n"
-  "loadingWeightsArray <- PLSresult$loading.weights[,]\n"
-  "yLoadingsArray <- PLSresult$Yloadings[,]\n"
-  ).arg(algorithmString).toLatin1());
-  d->RCalc->Update();
-
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(d->RCalc->GetOutput());
-
-  // Get R output and check for errors "thrown" by R script
-  if(!outputArrayData || outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() > 1)
+  // Fit the model
+  vtkNew<vtkArrayData> outputArrayData;
+  if (pls_backend == QLatin1String("R"))
+    {
+    result = computePLSWithR(extendedTable, this->input(),
+                             this->stringParameter("predictor_range"), predictorRangeList,
+                             this->stringParameter("response_range"), responseRangeList,
+                             algorithmString, pls_components, pls_segments, outputArrayData.GetPointer());
+    }
+  else
+    {
+    result = computePLSNatively(extendedTable, predictorRangeList, responseRangeList,
+                                algorithmString, pls_components, pls_segments, outputArrayData.GetPointer());
+    }
+  if (!result)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(pls_backend);
     return false;
     }
 
@@ -327,7 +495,7 @@ bool voPLSStatistics::execute()
   vtkNew<vtkTable> yLoadingsTable;
     {
     voUtils::arrayToTable(outputArrayData->GetArrayByName("yLoadingsArray"), yLoadingsTable.GetPointer());
-    if(responseRangeList.size() == 1)
+    if(outputArrayData->GetArrayByName("yLoadingsArray")->GetDimensions() == 1)
       {
       // arrayToTable is unable to determine the proper orientation of a 1-by-n array
       voUtils::transposeTable(yLoadingsTable.GetPointer());
@@ -352,5 +520,27 @@ bool voPLSStatistics::execute()
   voUtils::transposeTable(yLoadingsTable.GetPointer(), yLoadingsTableTransposed.GetPointer(), voUtils::Headers);
   this->setOutput("yLoadings_transposed", new voTableDataObject("yLoadings_transposed", yLoadingsTableTransposed.GetPointer()));
 
+  // ------------------------------------------------
+  // Extract table for the root mean squared error of prediction
+  vtkNew<vtkTable> rmsepTable;
+    {
+    voUtils::arrayToTable(outputArrayData->GetArrayByName("rmsepArray"), rmsepTable.GetPointer());
+
+    // Add column labels (number of components, the first column is the intercept only model)
+    for(vtkIdType c = 0; c < rmsepTable->GetNumberOfColumns(); ++c)
+      {
+      rmsepTable->GetColumn(c)->SetName(c == 0 ? QByteArray("(Intercept)") : QString("%1 comps").arg(c).toLatin1());
+      }
+
+    // Add row labels (response analytes)
+    vtkNew<vtkStringArray> headerArr;
+    foreach(int r, responseRangeList)
+      {
+      headerArr->InsertNextValue(analyteNames->GetValue(r));
+      }
+    voUtils::insertColumnIntoTable(rmsepTable.GetPointer(), 0, headerArr.GetPointer());
+    }
+  this->setOutput("rmsep", new voTableDataObject("rmsep", rmsepTable.GetPointer()));
+
   return true;
 }
@@ -37,6 +37,8 @@ public:
   voPLSStatistics();
   virtual ~voPLSStatistics();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
@@ -20,12 +20,15 @@
 
 // Qt includes
 #include <QDebug>
+#include <QMutexLocker>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voTTest.h"
+#include "voRSession.h"
+#include "voStatisticsUtils.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
@@ -33,11 +36,14 @@
 // VTK includes
 #include <vtkArrayData.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 // --------------------------------------------------------------------------
 // voTTestPrivate methods
 
@@ -45,9 +51,169 @@
 class voTTestPrivate
 {
 public:
-  vtkSmartPointer<vtkRCalculatorFilter> RCalc;
 };
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+// errorValue is set to the "RerrValue" reported by the R script:
+// 0: no error, 1: constant data, 2: invalid fold change, 3: t.test failure
+bool computeTTestWithR(vtkTable* inputDataTable, voDataObject* input,
+                       const QList<int>& sample1RangeList, const QList<int>& sample2RangeList,
+                       vtkArrayData* outputArrayData, int& errorValue)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Build array for sample 1 data range, unless it is already resident in R
+  QString sample1CacheKey = voRSession::cacheKey(input, sample1RangeList);
+  if (!session->assignCachedArray("sample1Array", sample1CacheKey))
+    {
+    vtkSmartPointer<vtkArray> sample1Array;
+    bool result = voUtils::tableToArray(inputDataTable, sample1Array, sample1RangeList);
+    if (!result)
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 1");
+      return false;
+      }
+    session->putArray("sample1Array", sample1Array, sample1CacheKey);
+    }
+
+  // Build array for sample 2 data range, unless it is already resident in R
+  QString sample2CacheKey = voRSession::cacheKey(input, sample2RangeList);
+  if (!session->assignCachedArray("sample2Array", sample2CacheKey))
+    {
+    vtkSmartPointer<vtkArray> sample2Array;
+    bool result = voUtils::tableToArray(inputDataTable, sample2Array, sample2RangeList);
+    if (!result)
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 2");
+      return false;
+      }
+    session->putArray("sample2Array", sample2Array, sample2CacheKey);
+    }
+
+  // Run R code
+  bool scriptResult = session->evalScript(
+  "constErrFlag <- 0; genErrFlag <- 0; FCErrFlag <- 0\n"
+  "my.t.test<-function(...){"
+    "obj<-try(t.test(...), silent=TRUE) \n"
+    "if( ! is(obj, \"try-error\") ){"
+      "return(obj$p.value)"
+    "}else if ( length(grep(\"data are essentially constant\", geterrmessage(), fixed=TRUE)) > 0 ){"
+      "constErrFlag <<- 1\n"
+      "return(1.0)\n"
+    "}else{"
+      "genErrFlag <<- 1}\n"
+      "return(-NaN)}\n"
+  "pValue <- sapply( seq(length=nrow(sample1Array)), "
+                    "function(x) {my.t.test(sample1Array[x,], sample2Array[x,], \"two.sided\")})\n"
+  "log2FC<-log2(rowMeans(sample1Array))-log2(rowMeans(sample2Array))\n"
+  "FCFun <- function(x){"
+    "if(!is.finite(x)){FCErrFlag <<- 1; return(-NaN)}\n"
+    "if (x<0) {return(-1/(2^x))} else {return(2^x)}}\n"
+  "foldChange<-sapply(log2FC, FCFun)\n"
+  "if(genErrFlag){"
+    "RerrValue <- 3"
+  "}else if(FCErrFlag){"
+    "RerrValue <- 2"
+  "}else if(constErrFlag){"
+    "RerrValue <- 1"
+  "}else{"
+    "RerrValue <- 0}\n");
+
+  vtkNew<vtkArrayData> RErrorArrayData;
+  if (!scriptResult ||
+      !session->getArray("pValue", "P-Value", outputArrayData) ||
+      !session->getArray("foldChange", "Fold Change (Sample 1 -> Sample 2)", outputArrayData) ||
+      !session->getArray("RerrValue", "RerrValue", RErrorArrayData.GetPointer()))
+    {
+    return false;
+    }
+  errorValue = RErrorArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt();
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool computeTTestNatively(voAnalysis* analysis, vtkExtendedTable* extendedTable,
+                          const QList<int>& sample1RangeList, const QList<int>& sample2RangeList,
+                          vtkArrayData* outputArrayData, int& errorValue)
+{
+  vtkIdType numberOfRows = extendedTable->GetNumberOfRows();
+  vtkIdType numberOfColumns = extendedTable->GetNumberOfColumns();
+  if (numberOfRows == 0 || numberOfColumns == 0)
+    {
+    return false;
+    }
+
+  std::vector<vtkIdType> sample1Columns(sample1RangeList.begin(), sample1RangeList.end());
+  std::vector<vtkIdType> sample2Columns(sample2RangeList.begin(), sample2RangeList.end());
+
+  std::vector<double> pValues(numberOfRows);
+  std::vector<double> foldChanges(numberOfRows);
+  int tTestDiagnostics = voStatisticsUtils::NoDiagnostic;
+  int foldChangeDiagnostics = voStatisticsUtils::NoDiagnostic;
+
+  // Rows are tested independently, out-of-core data are processed one tile at a time
+  std::vector<double> tileBuffer;
+  vtkIdType tileNumberOfRows = extendedTable->GetDataTileNumberOfRows();
+  for (vtkIdType firstRow = 0; firstRow < numberOfRows; firstRow += tileNumberOfRows)
+    {
+    if (analysis->abortExecution())
+      {
+      return false;
+      }
+    analysis->setProgress(static_cast<double>(firstRow) / numberOfRows);
+    vtkIdType tileRows = std::min(tileNumberOfRows, numberOfRows - firstRow);
+    const double * tile = extendedTable->GetDataTile(firstRow, tileRows, tileBuffer);
+    if (!tile)
+      {
+      return false;
+      }
+    int tileTTestDiagnostics = voStatisticsUtils::NoDiagnostic;
+    int tileFoldChangeDiagnostics = voStatisticsUtils::NoDiagnostic;
+    if (!voStatisticsUtils::tTest(tile, tileRows, numberOfColumns, sample1Columns, sample2Columns,
+                                  /* equalVariance= */ false, &pValues[firstRow], &tileTTestDiagnostics))
+      {
+      qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 1 or 2");
+      return false;
+      }
+    voStatisticsUtils::foldChange(tile, tileRows, numberOfColumns, sample1Columns, sample2Columns,
+                                  &foldChanges[firstRow], &tileFoldChangeDiagnostics);
+    tTestDiagnostics |= tileTTestDiagnostics;
+    foldChangeDiagnostics |= tileFoldChangeDiagnostics;
+    }
+
+  // Same priorities as the R script
+  if (tTestDiagnostics & voStatisticsUtils::InvalidData)
+    {
+    errorValue = 3;
+    }
+  else if (foldChangeDiagnostics & voStatisticsUtils::InvalidFoldChange)
+    {
+    errorValue = 2;
+    }
+  else if (tTestDiagnostics & voStatisticsUtils::ConstantData)
+    {
+    errorValue = 1;
+    }
+  else
+    {
+    errorValue = 0;
+    }
+
+  voUtils::addValuesToArrayData(outputArrayData, "P-Value",
+                                pValues.empty() ? 0 : &pValues[0], numberOfRows);
+  voUtils::addValuesToArrayData(outputArrayData, "Fold Change (Sample 1 -> Sample 2)",
+                                foldChanges.empty() ? 0 : &foldChanges[0], numberOfRows);
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voTTest methods
 
@@ -55,9 +221,6 @@ public:
 voTTest::voTTest():
     Superclass(), d_ptr(new voTTestPrivate)
 {
-  Q_D(voTTest);
-
-  d->RCalc = vtkSmartPointer<vtkRCalculatorFilter>::New();
 }
 
 // --------------------------------------------------------------------------
@@ -91,6 +254,14 @@ void voTTest::setParameterInformation()
   ttest_parameters << this->addStringParameter("sample1_range", QObject::tr("Sample Group 1"), "A-C,F");
   ttest_parameters << this->addStringParameter("sample2_range", QObject::tr("Sample Group 2"), "D,E,G-J");
 
+  QStringList ttest_backends;
+  ttest_backends << "Native" << "R";
+  ttest_parameters << this->addEnumParameter("backend", QObject::tr("Backend"), ttest_backends, "Native");
+
+  QStringList ttest_adjustments;
+  ttest_adjustments << "None" << "Bonferroni" << "Holm" << "Benjamini-Hochberg";
+  ttest_parameters << this->addEnumParameter("p_adjust", QObject::tr("P-Value Adjustment"), ttest_adjustments, "None");
+
   this->addParameterGroup("T-Test parameters", ttest_parameters);
 }
 
@@ -100,15 +271,29 @@ QString voTTest::parameterDescription()const
   return QString("<dl>"
                  "<dt><b>Sample Group 1 / 2</b>:</dt>"
                  "<dd>A group of Experiments, specified by a range and/or list of column letters.</dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where Welch's t-tests are computed:<br>"
+                 "- <i>Native</i>: Multi-threaded implementation<br>"
+                 "- <i>R</i>: Embedded R interpreter, kept as a reference</dd>"
+                 "<dt><b>P-Value Adjustment</b>:</dt>"
+                 "<dd>Correction for multiple testing added next to the p-values:<br>"
+                 "- <i>Bonferroni</i> and <i>Holm</i> control the family-wise error rate<br>"
+                 "- <i>Benjamini-Hochberg</i> controls the false discovery rate</dd>"
                  "</dl>");
 }
 
 // --------------------------------------------------------------------------
-bool voTTest::execute()
+bool voTTest::mainThreadOnly()const
 {
-  Q_D(voTTest);
+  return this->enumParameter("backend") == QLatin1String("R");
+}
 
+// --------------------------------------------------------------------------
+bool voTTest::execute()
+{
   // Get and parse parameters
+  QString ttest_backend = this->enumParameter("backend");
+
   bool result;
 
   QList<int> sample1RangeList;
@@ -137,86 +322,37 @@ bool voTTest::execute()
 
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build array for sample 1 data range
-  vtkSmartPointer<vtkArray> sample1Array;
-  result = voUtils::tableToArray(inputDataTable.GetPointer(), sample1Array, sample1RangeList);
-  if (!result)
+  // Compute p-values and fold changes
+  vtkNew<vtkArrayData> outputArrayData;
+  int errorValue = 0;
+  if (ttest_backend == QLatin1String("R"))
     {
-    qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 1");
-    return false;
+    result = computeTTestWithR(inputDataTable, this->input(), sample1RangeList, sample2RangeList,
+                               outputArrayData.GetPointer(), errorValue);
     }
-
-  // Build array for sample 2 data range
-  vtkSmartPointer<vtkArray> sample2Array;
-  result = voUtils::tableToArray(inputDataTable.GetPointer(), sample2Array, sample2RangeList);
-  if (!result)
+  else
     {
-    qWarning() << QObject::tr("Invalid paramater, out of range: Sample Group 2");
-    return false;
+    result = computeTTestNatively(this, extendedTable, sample1RangeList, sample2RangeList,
+                                  outputArrayData.GetPointer(), errorValue);
     }
-
-  // Combine sample 1 and 2 array groups
-  vtkNew<vtkArrayData> RInputArrayData;
-  RInputArrayData->AddArray(sample1Array);
-  RInputArrayData->AddArray(sample2Array);
-
-  // Run R code
-  d->RCalc->SetRoutput(0);
-  d->RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  d->RCalc->PutArray("0", "sample1Array");
-  d->RCalc->PutArray("1", "sample2Array");
-  d->RCalc->GetArray("P-Value","pValue");
-  d->RCalc->GetArray("Fold Change (Sample 1 -> Sample 2)","foldChange");
-  d->RCalc->GetArray("RerrValue","RerrValue");
-  d->RCalc->SetRscript(
-  "constErrFlag <- 0; genErrFlag <- 0; FCErrFlag <- 0\n"
-  "my.t.test<-function(...){"
-    "obj<-try(t.test(...), silent=TRUE) \n"
-    "if( ! is(obj, \"try-error\") ){"
-      "return(obj$p.value)"
-    "}else if ( length(grep(\"data are essentially constant\", geterrmessage(), fixed=TRUE)) > 0 ){"
-      "constErrFlag <<- 1\n"
-      "return(1.0)\n"
-    "}else{"
-      "genErrFlag <<- 1}\n"
-      "return(-NaN)}\n"
-  "pValue <- sapply( seq(length=nrow(sample1Array)), "
-                    "function(x) {my.t.test(sample1Array[x,], sample2Array[x,], \"two.sided\")})\n"
-  "log2FC<-log2(rowMeans(sample1Array))-log2(rowMeans(sample2Array))\n"
-  "FCFun <- function(x){"
-    "if(!is.finite(x)){FCErrFlag <<- 1; return(-NaN)}\n"
-    "if (x<0) {return(-1/(2^x))} else {return(2^x)}}\n"
-  "foldChange<-sapply(log2FC, FCFun)\n"
-  "if(genErrFlag){"
-    "RerrValue <- 3"
-  "}else if(FCErrFlag){"
-    "RerrValue <- 2"
-  "}else if(constErrFlag){"
-    "RerrValue <- 1"
-  "}else{"
-    "RerrValue <- 0}\n");
-  d->RCalc->Update();
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(d->RCalc->GetOutput());
-  if(!outputArrayData)
+  if (!result)
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(ttest_backend);
     return false;
     }
 
-  // Check for errors "thrown" by R script
-  if(outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() == 1)
+  // Check for errors "thrown" by the backend
+  if(errorValue == 1)
     {
     qWarning() << QObject::tr("T-Test warning: data are essentially constant");
     }
-  else if(outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() == 2)
+  else if(errorValue == 2)
     {
     qWarning() << QObject::tr("T-Test warning: cannot calculate fold change from zero or negative input");
     }
-  else if(outputArrayData->GetArrayByName("RerrValue")->GetVariantValue(0).ToInt() > 2)
+  else if(errorValue > 2)
     {
-    qCritical() << QObject::tr("Fatal error in T-Test R script");
+    qCritical() << QObject::tr("Fatal error in T-Test %1 backend").arg(ttest_backend);
     return false;
     }
 
@@ -230,6 +366,7 @@ bool voTTest::execute()
     {
     voUtils::arrayToTable(outputArrayData->GetArrayByName("P-Value"), outputDataTable.GetPointer());
     voUtils::insertColumnIntoTable(outputDataTable.GetPointer(), 0, analyteNames.GetPointer());
+    voUtils::insertAdjustedPValueColumn(outputDataTable.GetPointer(), "P-Value", this->enumParameter("p_adjust"));
     }
 
   // Build table with additional fold change column for volcano
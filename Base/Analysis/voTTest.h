@@ -37,6 +37,8 @@ public:
   voTTest();
   virtual ~voTTest();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
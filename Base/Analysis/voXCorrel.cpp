@@ -20,28 +20,37 @@
 
 // Qt includes
 #include <QDebug>
+#include <QMutexLocker>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
 
 // Visomics includes
 #include "voXCorrel.h"
+#include "voCorrelation.h"
 #include "voDataObject.h"
+#include "voRSession.h"
 #include "voTableDataObject.h"
 #include "voUtils.h"
 #include "vtkExtendedTable.h"
 
 // VTK includes
+#include <vtkAbstractArray.h>
 #include <vtkArrayData.h>
+#include <vtkDataArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkGraph.h>
+#include <vtkInformation.h>
 #include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 #include <vtkTableToGraph.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 // --------------------------------------------------------------------------
 // voXCorrelPrivate methods
 
@@ -49,9 +58,117 @@
 class voXCorrelPrivate
 {
 public:
-  vtkSmartPointer<vtkRCalculatorFilter> RCalc;
 };
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+// --------------------------------------------------------------------------
+bool computeCorrelationWithR(vtkTable* inputDataTable, const QString& inputCacheKey,
+                             const QString& corMethod, vtkTable* corrTable)
+{
+  voRSession * session = voRSession::instance();
+  QMutexLocker locker(session->mutex());
+
+  // Transfer the input matrix unless it is already resident in R
+  if (!session->assignCachedArray("metabData", inputCacheKey))
+    {
+    vtkSmartPointer<vtkArray> RInputArray;
+    voUtils::tableToArray(inputDataTable, RInputArray);
+    session->putArray("metabData", RInputArray, inputCacheKey);
+    }
+
+  vtkNew<vtkArrayData> outputArrayData;
+  if (!session->evalScript(QString("correl<-cor(t(metabData), method=\"%1\")").arg(corMethod)) ||
+      !session->getArray("correl", "correl", outputArrayData.GetPointer()))
+    {
+    return false;
+    }
+  voUtils::arrayToTable(outputArrayData->GetArrayByName("correl"), corrTable);
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool computeCorrelationNatively(vtkExtendedTable* extendedTable, const QString& corMethod, vtkTable* corrTable)
+{
+  // Analytes (rows) are contiguous in the row-major buffer
+  voCorrelation::Method method;
+  const double * data = extendedTable->GetDataBuffer(vtkExtendedTable::RowMajor);
+  if (!voCorrelation::methodFromString(corMethod, method) || !data)
+    {
+    return false;
+    }
+
+  // The tiles are written directly into the columns of the table
+  vtkIdType numberOfAnalytes = extendedTable->GetNumberOfRows();
+  std::vector<double*> columns(numberOfAnalytes);
+  for (vtkIdType c = 0; c < numberOfAnalytes; ++c)
+    {
+    vtkNew<vtkDoubleArray> column;
+    column->SetNumberOfValues(numberOfAnalytes);
+    columns[c] = column->GetPointer(0);
+    corrTable->AddColumn(column.GetPointer());
+    }
+  if (numberOfAnalytes == 0 ||
+      !voCorrelation::correlationMatrix(data, numberOfAnalytes, extendedTable->GetNumberOfColumns(),
+                                        method, &columns[0]))
+    {
+    corrTable->Initialize();
+    return false;
+    }
+  return true;
+}
+
+// --------------------------------------------------------------------------
+// Compute the correlations above the threshold without building the correlation matrix
+bool computeThresholdedCorrelationNatively(vtkExtendedTable* extendedTable, const QString& corMethod,
+                                           double threshold, std::vector<voCorrelation::Edge>& edges)
+{
+  voCorrelation::Method method;
+  const double * data = extendedTable->GetDataBuffer(vtkExtendedTable::RowMajor);
+  if (!voCorrelation::methodFromString(corMethod, method) || !data)
+    {
+    return false;
+    }
+  return voCorrelation::thresholdedCorrelation(data, extendedTable->GetNumberOfRows(),
+                                               extendedTable->GetNumberOfColumns(),
+                                               method, threshold, edges);
+}
+
+// --------------------------------------------------------------------------
+// Extract the correlations above the threshold from the upper triangle of the correlation matrix.
+// The matrix is symmetric: column r holds row r, its values below the diagonal are read contiguously.
+bool thresholdCorrelationTable(vtkTable* corrTable, double threshold, std::vector<voCorrelation::Edge>& edges)
+{
+  edges.clear();
+  vtkIdType corrMatrixNumberOfRows = corrTable->GetNumberOfRows();
+  for (vtkIdType r = 0; r < corrMatrixNumberOfRows; ++r)
+    {
+    vtkDoubleArray * column = vtkDoubleArray::SafeDownCast(corrTable->GetColumn(r));
+    if (!column)
+      {
+      return false;
+      }
+    const double * values = column->GetPointer(0);
+    for (vtkIdType c = r + 1; c < corrMatrixNumberOfRows; ++c)
+      {
+      if (qAbs(values[c]) > threshold)
+        {
+        voCorrelation::Edge edge;
+        edge.First = r;
+        edge.Second = c;
+        edge.Value = values[c];
+        edges.push_back(edge);
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voXCorrel methods
 
@@ -59,8 +176,6 @@ public:
 voXCorrel::voXCorrel():
     Superclass(), d_ptr(new voXCorrelPrivate)
 {
-  Q_D(voXCorrel);
-  d->RCalc = vtkSmartPointer<vtkRCalculatorFilter>::New();
 }
 
 // --------------------------------------------------------------------------
@@ -83,6 +198,10 @@ void voXCorrel::setOutputInformation()
 
   this->addOutputType("correlation_graph", "vtkGraph",
                       "voCorrelationGraphView", "Correlation (Graph)");
+
+  // Changing the threshold only rebuilds the graph
+  this->setOutputParameters("corr", QStringList() << "method" << "backend" << "graph_only");
+  this->setOutputParameters("correlation_graph", QStringList() << "method" << "backend" << "threshold");
 }
 
 // --------------------------------------------------------------------------
@@ -95,7 +214,22 @@ void voXCorrel::setParameterInformation()
   cor_methods << "pearson" << "kendall" << "spearman";
   cor_parameters << this->addEnumParameter("method", tr("Method"), cor_methods);
 
+  // Cor / Backend
+  QStringList cor_backends;
+  cor_backends << "Native" << "R";
+  cor_parameters << this->addEnumParameter("backend", tr("Backend"), cor_backends, "Native");
+
   this->addParameterGroup("Correlation parameters", cor_parameters);
+
+  QList<QtProperty*> graph_parameters;
+
+  // Graph / Threshold
+  graph_parameters << this->addDoubleParameter("threshold", tr("Threshold"), 0, 1, 0.5);
+
+  // Graph / Graph only
+  graph_parameters << this->addBooleanParameter("graph_only", tr("Graph only"), false);
+
+  this->addParameterGroup("Graph parameters", graph_parameters);
 }
 
 // --------------------------------------------------------------------------
@@ -107,16 +241,34 @@ QString voXCorrel::parameterDescription()const
                  "- <i>Pearson's r</i><br>"
                  "- <i>Kendall's %1</i><br>"
                  "- <i>Spearman's %2</i></dd>"
+                 "<dt><b>Backend</b>:</dt>"
+                 "<dd>Where the correlation matrix is computed:<br>"
+                 "- <i>Native</i>: Multi-threaded implementation<br>"
+                 "- <i>R</i>: Embedded R interpreter, kept as a reference</dd>"
+                 "<dt><b>Threshold</b>:</dt>"
+                 "<dd>Pairs of analytes whose absolute correlation is greater than "
+                 "this value are linked in the correlation graph.</dd>"
+                 "<dt><b>Graph only</b>:</dt>"
+                 "<dd>Skip the correlation table. With the <i>Native</i> backend, only the "
+                 "correlations above the threshold are kept in memory, allowing "
+                 "large number of analytes.</dd>"
                  "</dl>").arg(QChar(964)).arg(QChar(961));
 }
 
 // --------------------------------------------------------------------------
-bool voXCorrel::execute()
+bool voXCorrel::mainThreadOnly()const
 {
-  Q_D(voXCorrel);
+  return this->enumParameter("backend") == QLatin1String("R");
+}
 
+// --------------------------------------------------------------------------
+bool voXCorrel::execute()
+{
   // Parameters
   QString cor_method = this->enumParameter("method");
+  QString cor_backend = this->enumParameter("backend");
+  double threshold = this->doubleParameter("threshold");
+  bool graph_only = this->booleanParameter("graph_only");
 
   // Import data table locally
   vtkExtendedTable* extendedTable =  vtkExtendedTable::SafeDownCast(this->input()->dataAsVTKDataObject());
@@ -128,27 +280,58 @@ bool voXCorrel::execute()
 
   vtkSmartPointer<vtkTable> inputDataTable = extendedTable->GetData();
 
-  // Build ArrayData for input to R
-  vtkNew<vtkArrayData> RInputArrayData;
+  // Outputs kept from the previous execution aren't computed again
+  bool corrOutdated = !graph_only && this->isOutputOutdated("corr");
+  bool graphOutdated = this->isOutputOutdated("correlation_graph");
+
+  // Compute correlations, unless the correlation matrix of a previous execution can be reused.
+  // The dense matrix isn't kept in graph only mode.
+  vtkSmartPointer<vtkTable> corrTable;
+  if (graph_only)
     {
-    vtkSmartPointer<vtkArray> RInputArray;
-    voUtils::tableToArray(inputDataTable.GetPointer(), RInputArray);
-    RInputArrayData->AddArray(RInputArray.GetPointer());
+    this->setIntermediateData("correlation_matrix", 0, QStringList());
+    }
+  else
+    {
+    corrTable = vtkTable::SafeDownCast(this->intermediateData("correlation_matrix"));
+    }
+  std::vector<voCorrelation::Edge> edges;
+  bool result = true;
+  if (!corrTable && graph_only && cor_backend != QLatin1String("R"))
+    {
+    if (graphOutdated)
+      {
+      result = computeThresholdedCorrelationNatively(extendedTable, cor_method, threshold, edges);
+      }
+    }
+  else if (!corrTable && (corrOutdated || graphOutdated))
+    {
+    corrTable = vtkSmartPointer<vtkTable>::New();
+    if (cor_backend == QLatin1String("R"))
+      {
+      result = computeCorrelationWithR(inputDataTable, voRSession::cacheKey(this->input()),
+                                       cor_method, corrTable);
+      }
+    else
+      {
+      result = computeCorrelationNatively(extendedTable, cor_method, corrTable);
+      }
+    if (result && !graph_only)
+      {
+      this->setIntermediateData("correlation_matrix", corrTable, QStringList() << "method" << "backend");
+      }
+    }
+  if (!result)
+    {
+    qCritical() << QObject::tr("Fatal error in %1 %2 backend").arg(this->objectName()).arg(cor_backend);
+    return false;
     }
 
-  d->RCalc->SetRoutput(0);
-  d->RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  d->RCalc->PutArray("0", "metabData");
-  d->RCalc->GetArray("correl","correl");
-  d->RCalc->SetRscript(
-        QString("correl<-cor(t(metabData), method=\"%1\")").arg(cor_method).toLatin1());
-  d->RCalc->Update();
-
-  // Get R output
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(d->RCalc->GetOutput());
-  if (!outputArrayData || !outputArrayData->GetArrayByName("correl"))
+  // Find high correlations to put in graph
+  if (corrTable && graphOutdated && !thresholdCorrelationTable(corrTable, threshold, edges))
     {
-    qCritical() << QObject::tr("Fatal error in %1 R script").arg(this->objectName());
+    qCritical() << QObject::tr("Fatal error in %1 - Correlation matrix is expected to hold doubles")
+                   .arg(this->objectName());
     return false;
     }
 
@@ -157,45 +340,66 @@ bool voXCorrel::execute()
   voUtils::addCounterLabels(extendedTable->GetRowMetaDataOfInterestAsString(),
                             analyteNames.GetPointer(), false);
 
-  // Extract correlation table
-  vtkNew<vtkTable> corrTable;
+  if (graph_only)
     {
-    voUtils::arrayToTable(outputArrayData->GetArrayByName("correl"), corrTable.GetPointer());
-    for (vtkIdType c = 0;c < corrTable->GetNumberOfColumns(); ++c)
+    this->removeOutput("corr");
+    }
+  else if (corrOutdated)
+    {
+    // The columns of the output are views of the columns of the correlation matrix kept
+    // for the next executions, no copy is made. Analyte names come first, followed by the
+    // correlations in reverse order so that the diagonal of the heat map goes from the
+    // bottom-left corner to the top-right one.
+    vtkNew<vtkTable> labeledCorrTable;
+    labeledCorrTable->AddColumn(analyteNames.GetPointer());
+    for (vtkIdType c = corrTable->GetNumberOfColumns() - 1; c >= 0; --c)
       {
-      corrTable->GetColumn(c)->SetName(analyteNames->GetValue(c));
+      vtkDoubleArray * column = vtkDoubleArray::SafeDownCast(corrTable->GetColumn(c));
+      vtkSmartPointer<vtkAbstractArray> outputColumn;
+      if (column)
+        {
+        vtkSmartPointer<vtkDoubleArray> view = vtkSmartPointer<vtkDoubleArray>::New();
+        view->SetArray(column->GetPointer(0), column->GetNumberOfTuples(), /* save= */ 1);
+        // The view keeps the values alive once the correlation matrix is released
+        view->GetInformation()->Set(vtkExtendedTable::DATA_STORAGE(), column);
+        outputColumn = view;
+        }
+      else
+        {
+        outputColumn.TakeReference(corrTable->GetColumn(c)->NewInstance());
+        outputColumn->DeepCopy(corrTable->GetColumn(c));
+        }
+      outputColumn->SetName(analyteNames->GetValue(c));
+      labeledCorrTable->AddColumn(outputColumn);
       }
-    voUtils::insertColumnIntoTable(corrTable.GetPointer(), 0, analyteNames.GetPointer());
+    this->setOutput("corr",
+                    new voTableDataObject("corr", labeledCorrTable.GetPointer(), /* sortable= */ true));
     }
 
-  vtkNew<vtkTable> flippedCorrTable;
-  voUtils::flipTable(corrTable.GetPointer(), flippedCorrTable.GetPointer(), voUtils::FlipHorizontalAxis, 1, 0);
-  this->setOutput("corr",
-                  new voTableDataObject("corr", flippedCorrTable.GetPointer(), /* sortable= */ true));
- 
-  // Find high correlations to put in graph
+  if (!graphOutdated)
+    {
+    return true;
+    }
+
+  // Build the list of edges
   vtkNew<vtkTable> sparseCorr;
     {
+    vtkIdType numberOfEdges = static_cast<vtkIdType>(edges.size());
     vtkNew<vtkStringArray> col1;
     col1->SetName("Column 1");
+    col1->SetNumberOfValues(numberOfEdges);
     vtkNew<vtkStringArray> col2;
     col2->SetName("Column 2");
+    col2->SetNumberOfValues(numberOfEdges);
     vtkNew<vtkDoubleArray> valueArr;
     valueArr->SetName("Correlation");
+    valueArr->SetNumberOfValues(numberOfEdges);
 
-    vtkIdType corrMatrixNumberOfRows = corrTable->GetNumberOfRows();
-    for (vtkIdType r = 0; r < corrMatrixNumberOfRows; ++r)
+    for (vtkIdType e = 0; e < numberOfEdges; ++e)
       {
-      for (vtkIdType c = r+1; c < corrMatrixNumberOfRows; ++c)
-        {
-        double val = corrTable->GetValue(r, c + 1).ToDouble();
-        if (qAbs(val) > 0.5)
-          {
-          col1->InsertNextValue(analyteNames->GetValue(r));
-          col2->InsertNextValue(analyteNames->GetValue(c));
-          valueArr->InsertNextValue(val);
-          }
-        }
+      col1->SetValue(e, analyteNames->GetValue(edges[e].First));
+      col2->SetValue(e, analyteNames->GetValue(edges[e].Second));
+      valueArr->SetValue(e, edges[e].Value);
       }
     sparseCorr->AddColumn(col1.GetPointer());
     sparseCorr->AddColumn(col2.GetPointer());
@@ -37,6 +37,8 @@ public:
   voXCorrel();
   virtual ~voXCorrel();
 
+  virtual bool mainThreadOnly()const;
+
 protected:
   virtual void setInputInformation();
   virtual void setOutputInformation();
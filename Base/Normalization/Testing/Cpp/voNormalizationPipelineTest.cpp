@@ -0,0 +1,151 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QStringList>
+
+// Visomics includes
+#include "voNormalization.h"
+#include "voRegistry.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+bool checkValue(int line, const char* function, double current, double expected)
+{
+  if (std::fabs(current - expected) <= 1e-12 ||
+      (vtkMath::IsNan(current) && vtkMath::IsNan(expected)))
+    {
+    return true;
+    }
+  std::cerr << "Line " << line << " - Problem with " << function << "\n"
+            << "\tCurrent: " << current << "\n"
+            << "\tExpected: " << expected << std::endl;
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+void fillTable(vtkTable * table)
+{
+  for (int c = 0; c < 3; ++c)
+    {
+    vtkNew<vtkDoubleArray> column;
+    for (int r = 0; r < 6; ++r)
+      {
+      column->InsertNextValue(1. + ((r * 7 + c * 3) % 11) * (c + 1));
+      }
+    table->AddColumn(column.GetPointer());
+    }
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voNormalizationPipelineTest(int /*argc*/, char * /*argv*/ [])
+{
+  QHash<int, QVariant> settings;
+
+  // Median of the values that aren't missing
+  double values[] = {3., 1., vtkMath::Nan(), 2., 10.};
+  Normalization::medianCenterColumn(values, 5, settings);
+  if (!checkValue(__LINE__, "medianCenterColumn()", values[0], 0.5) ||
+      !checkValue(__LINE__, "medianCenterColumn()", values[1], -1.5) ||
+      !checkValue(__LINE__, "medianCenterColumn()", values[2], vtkMath::Nan()) ||
+      !checkValue(__LINE__, "medianCenterColumn()", values[4], 7.5))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Sample standard deviation
+  double zValues[] = {1., 2., 3.};
+  Normalization::zScoreColumn(zValues, 3, settings);
+  if (!checkValue(__LINE__, "zScoreColumn()", zValues[0], -1.) ||
+      !checkValue(__LINE__, "zScoreColumn()", zValues[1], 0.) ||
+      !checkValue(__LINE__, "zScoreColumn()", zValues[2], 1.))
+    {
+    return EXIT_FAILURE;
+    }
+
+  voRegistry registry;
+  registry.registerColumnMethod("Log2", Normalization::log2Column);
+  registry.registerColumnMethod("Median Center", Normalization::medianCenterColumn);
+  registry.registerMethod("Quantile", Normalization::applyQuantile);
+  registry.registerColumnMethod("Z-Score", Normalization::zScoreColumn);
+
+  // The table isn't modified if a method isn't registered
+  vtkNew<vtkTable> pipelineTable;
+  fillTable(pipelineTable.GetPointer());
+  if (registry.applyPipeline(QStringList() << "Log2" << "Unknown", pipelineTable.GetPointer(), settings) ||
+      !checkValue(__LINE__, "applyPipeline()", pipelineTable->GetValue(0, 0).ToDouble(), 1.))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with applyPipeline()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Fused pipeline and methods applied one after the other give the same result
+  QStringList pipeline;
+  pipeline << "Log2" << "Median Center" << "Quantile" << "Z-Score";
+  vtkNew<vtkTable> sequentialTable;
+  fillTable(sequentialTable.GetPointer());
+  if (!registry.applyPipeline(pipeline, pipelineTable.GetPointer(), settings))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with applyPipeline()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  foreach(const QString& methodName, pipeline)
+    {
+    if (!registry.apply(methodName, sequentialTable.GetPointer(), settings))
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with apply()" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  for (vtkIdType c = 0; c < 3; ++c)
+    {
+    double sum = 0.;
+    for (vtkIdType r = 0; r < 6; ++r)
+      {
+      double value = pipelineTable->GetValue(r, c).ToDouble();
+      sum += value;
+      if (!checkValue(__LINE__, "applyPipeline()", value, sequentialTable->GetValue(r, c).ToDouble()))
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    // Z-scores are centered
+    if (!checkValue(__LINE__, "applyPipeline()", sum, 0.))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -195,6 +195,80 @@ int voQuantileTest(int /*argc*/, char * /*argv*/ [])
     return EXIT_FAILURE;
     }
 
+
+  //-----------------------------------------------------------------------------
+  // Tied values share the average of their ranks
+  //-----------------------------------------------------------------------------
+  const double tiesInput[2][3] = {{1., 1., 3.}, {2., 4., 6.}};
+  const double tiesExpectedOutput[2][3] = {{2., 2., 4.5}, {1.5, 2.5, 4.5}};
+  vtkNew<vtkTable> tiesNormalizationInput;
+  vtkNew<vtkTable> tiesNormalizationExpectedOutput;
+  for (int c = 0; c < 2; ++c)
+    {
+    vtkNew<vtkDoubleArray> inputArray;
+    vtkNew<vtkDoubleArray> expectedOutputArray;
+    for (int r = 0; r < 3; ++r)
+      {
+      inputArray->InsertNextValue(tiesInput[c][r]);
+      expectedOutputArray->InsertNextValue(tiesExpectedOutput[c][r]);
+      }
+    tiesNormalizationInput->AddColumn(inputArray.GetPointer());
+    tiesNormalizationExpectedOutput->AddColumn(expectedOutputArray.GetPointer());
+    }
+  /* tiesNormalizationInput:      tiesNormalizationExpectedOutput:
+  +------+------+                 +------+------+
+  | 1    | 2    |                 | 2    | 1.5  |
+  | 1    | 4    |                 | 2    | 2.5  |
+  | 3    | 6    |                 | 4.5  | 4.5  |
+  +------+------+                 +------+------+
+  */
+
+  Normalization::applyQuantile(tiesNormalizationInput.GetPointer(), QHash<int, QVariant>());
+
+  if (!compareTable(tiesNormalizationInput.GetPointer(), tiesNormalizationExpectedOutput.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - "
+              << "Problem with quantileNormalization()" << std::endl;
+
+    std::cerr << "Updated tiesNormalizationInput:" << std::endl;
+    tiesNormalizationInput->Dump();
+
+    std::cerr << "tiesNormalizationExpectedOutput:" << std::endl;
+    tiesNormalizationExpectedOutput->Dump();
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Missing values are left in place, the other values of their column are
+  // mapped to the reference distribution by interpolation
+  //-----------------------------------------------------------------------------
+  const double missingInput[3][3] = {{1., vtkMath::Nan(), 3.}, {2., 4., 6.}, {3., 5., 7.}};
+  vtkNew<vtkTable> missingNormalizationInput;
+  for (int c = 0; c < 3; ++c)
+    {
+    vtkNew<vtkDoubleArray> inputArray;
+    for (int r = 0; r < 3; ++r)
+      {
+      inputArray->InsertNextValue(missingInput[c][r]);
+      }
+    missingNormalizationInput->AddColumn(inputArray.GetPointer());
+    }
+
+  Normalization::applyQuantile(missingNormalizationInput.GetPointer(), QHash<int, QVariant>());
+
+  // Reference distribution: (2, 11/3, 16/3)
+  vtkDoubleArray * missingColumn = vtkDoubleArray::SafeDownCast(missingNormalizationInput->GetColumn(0));
+  vtkDoubleArray * completeColumn = vtkDoubleArray::SafeDownCast(missingNormalizationInput->GetColumn(1));
+  if (!qFuzzyCompare(missingColumn->GetValue(0), 2.) ||
+      !vtkMath::IsNan(missingColumn->GetValue(1)) ||
+      !qFuzzyCompare(missingColumn->GetValue(2), 16. / 3.) ||
+      !qFuzzyCompare(completeColumn->GetValue(1), 11. / 3.))
+    {
+    std::cerr << "Line " << __LINE__ << " - "
+              << "Problem with quantileNormalization()" << std::endl;
+    missingNormalizationInput->Dump();
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
-
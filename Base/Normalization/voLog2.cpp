@@ -24,6 +24,7 @@
 
 // Visomics includes
 #include "voNormalization.h"
+#include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkDoubleArray.h>
@@ -37,14 +38,34 @@ namespace Normalization
 {
 
 //------------------------------------------------------------------------------
-bool applyLog2(vtkTable * dataTable, const QHash<int, QVariant>& settings)
+void log2Column(double * values, vtkIdType count, const QHash<int, QVariant>& settings)
 {
   Q_UNUSED(settings);
+  const double inverseLog2 = 1. / std::log(2.0);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    values[i] = std::log(values[i]) * inverseLog2;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool applyLog2(vtkTable * dataTable, const QHash<int, QVariant>& settings)
+{
   if (!dataTable)
     {
     return false;
     }
 
+  // Transform the buffer shared by the columns at once when possible
+  vtkExtendedTable * extendedTable = vtkExtendedTable::SafeDownCast(dataTable);
+  double * data = extendedTable ? extendedTable->GetContiguousDataBuffer() : 0;
+  if (data)
+    {
+    log2Column(data, extendedTable->GetNumberOfRows() * extendedTable->GetNumberOfColumns(), settings);
+    dataTable->Modified();
+    return true;
+    }
+
   for (int cid = 0; cid < dataTable->GetNumberOfColumns(); ++cid)
     {
     vtkDoubleArray * column = vtkDoubleArray::SafeDownCast(dataTable->GetColumn(cid));
@@ -52,10 +73,8 @@ bool applyLog2(vtkTable * dataTable, const QHash<int, QVariant>& settings)
       {
       continue;
       }
-    for (int rid = 0; rid < column->GetNumberOfTuples() * column->GetNumberOfComponents(); ++rid)
-      {
-      column->SetValue(rid, std::log(column->GetValue(rid)) / log(2.0));
-      }
+    log2Column(column->GetPointer(0), column->GetNumberOfTuples() * column->GetNumberOfComponents(), settings);
+    column->Modified();
     }
   dataTable->Modified();
 
@@ -0,0 +1,67 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Visomics includes
+#include "voNormalization.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace Normalization
+{
+
+//------------------------------------------------------------------------------
+void medianCenterColumn(double * values, vtkIdType count, const QHash<int, QVariant>& settings)
+{
+  Q_UNUSED(settings);
+
+  // Median of the values that aren't missing
+  std::vector<double> sorted;
+  sorted.reserve(count);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    if (!vtkMath::IsNan(values[i]))
+      {
+      sorted.push_back(values[i]);
+      }
+    }
+  if (sorted.empty())
+    {
+    return;
+    }
+  size_t middle = sorted.size() / 2;
+  std::nth_element(sorted.begin(), sorted.begin() + middle, sorted.end());
+  double median = sorted[middle];
+  if (sorted.size() % 2 == 0)
+    {
+    median = 0.5 * (median + *std::max_element(sorted.begin(), sorted.begin() + middle));
+    }
+
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    values[i] -= median;
+    }
+}
+
+} // end of Normalization namespace
@@ -25,6 +25,8 @@
 #include <QHash>
 #include <QVariant>
 
+// VTK includes
+#include <vtkType.h>
 
 class vtkTable;
 //template <class Key, class T> class QHash
@@ -37,6 +39,14 @@ namespace Normalization
 
   bool applyQuantile(vtkTable * dataTable, const QHash<int, QVariant>& settings);
 
+  // Column kernels normalizing in place the count values of a column, voRegistry
+  // chains them into a single pass over each column.
+  void log2Column(double * values, vtkIdType count, const QHash<int, QVariant>& settings);
+
+  void medianCenterColumn(double * values, vtkIdType count, const QHash<int, QVariant>& settings);
+
+  void zScoreColumn(double * values, vtkIdType count, const QHash<int, QVariant>& settings);
+
 } // end of Normalization namespace
 
 #endif
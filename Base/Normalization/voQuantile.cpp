@@ -18,21 +18,223 @@
 
 =========================================================================*/
 
-// Qt includes
-//#include <QHash>
-//#include <QVariant>
-
 // Visomics includes
+#include "voConcurrentUtils.h"
 #include "voNormalization.h"
-#include "voUtils.h"
+#include "vtkExtendedTable.h"
 
 // VTK includes
-#include <vtkArrayData.h>
-#include <vtkNew.h>
-#include <vtkRCalculatorFilter.h>
-#include <vtkSmartPointer.h>
+#include <vtkDataArray.h>
+#include <vtkMath.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Value of the reference distribution at the 1-based fractional position index
+double interpolate(const std::vector<double>& values, double index)
+{
+  vtkIdType count = static_cast<vtkIdType>(values.size());
+  vtkIdType lower = static_cast<vtkIdType>(std::floor(index));
+  double delta = index - lower;
+  if (lower < 1)
+    {
+    return values[0];
+    }
+  if (lower >= count)
+    {
+    return values[count - 1];
+    }
+  return (1. - delta) * values[lower - 1] + delta * values[lower];
+}
+
+//------------------------------------------------------------------------------
+// Sort the finite values of the columns [begin, end): Order receives the row indices
+// sorted by value, Counts the number of finite values of each column.
+class SortFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  int* Order;
+  vtkIdType* Counts;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    std::vector<std::pair<double, int> > column;
+    column.reserve(this->NumberOfRows);
+    for (vtkIdType c = begin; c < end; ++c)
+      {
+      const double* values = this->Data + c * this->NumberOfRows;
+      column.clear();
+      for (vtkIdType r = 0; r < this->NumberOfRows; ++r)
+        {
+        if (!vtkMath::IsNan(values[r]))
+          {
+          column.push_back(std::make_pair(values[r], static_cast<int>(r)));
+          }
+        }
+      std::sort(column.begin(), column.end());
+      int* order = this->Order + c * this->NumberOfRows;
+      for (size_t i = 0; i < column.size(); ++i)
+        {
+        order[i] = column[i].second;
+        }
+      this->Counts[c] = static_cast<vtkIdType>(column.size());
+      }
+    }
+};
+
+//------------------------------------------------------------------------------
+// Sum over the columns of the sorted values of the rows [begin, end). Columns having
+// missing values are resampled to NumberOfRows quantiles.
+class ReferenceFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  const int* Order;
+  const vtkIdType* Counts;
+  double* Sums;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType c = 0; c < this->NumberOfColumns; ++c)
+      {
+      const double* values = this->Data + c * this->NumberOfRows;
+      const int* order = this->Order + c * this->NumberOfRows;
+      vtkIdType count = this->Counts[c];
+      if (count == this->NumberOfRows)
+        {
+        for (vtkIdType i = begin; i < end; ++i)
+          {
+          this->Sums[i] += values[order[i]];
+          }
+        continue;
+        }
+      if (count == 0)
+        {
+        continue;
+        }
+      for (vtkIdType i = begin; i < end; ++i)
+        {
+        double percentile = this->NumberOfRows > 1 ? static_cast<double>(i) / (this->NumberOfRows - 1) : 0.;
+        double index = 1. + (count - 1) * percentile;
+        vtkIdType lower = static_cast<vtkIdType>(std::floor(index));
+        double delta = index - lower;
+        double value = values[order[lower - 1]];
+        if (lower < count)
+          {
+          value = (1. - delta) * value + delta * values[order[lower]];
+          }
+        this->Sums[i] += value;
+        }
+      }
+    }
+};
+
+//------------------------------------------------------------------------------
+// Replace the values of the columns [begin, end) by the reference value of their rank.
+// Tied values get the average of their ranks, a half rank being the mean of the two
+// neighboring reference values.
+class AssignFunctor
+{
+public:
+  double* Data;
+  vtkIdType NumberOfRows;
+  const int* Order;
+  const vtkIdType* Counts;
+  const std::vector<double>* Reference;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType c = begin; c < end; ++c)
+      {
+      double* values = this->Data + c * this->NumberOfRows;
+      const int* order = this->Order + c * this->NumberOfRows;
+      vtkIdType count = this->Counts[c];
+      vtkIdType first = 0;
+      while (first < count)
+        {
+        // Tied values share the average rank
+        vtkIdType last = first;
+        double value = values[order[first]];
+        while (last + 1 < count && values[order[last + 1]] == value)
+          {
+          ++last;
+          }
+        double rank = (first + last) / 2. + 1.;
+        double normalized;
+        if (count == this->NumberOfRows)
+          {
+          vtkIdType lower = static_cast<vtkIdType>(std::floor(rank));
+          normalized = rank - lower > 0.4 ?
+            0.5 * ((*this->Reference)[lower - 1] + (*this->Reference)[lower]) :
+            (*this->Reference)[lower - 1];
+          }
+        else
+          {
+          double percentile = count > 1 ? (rank - 1.) / (count - 1) : 0.5;
+          normalized = interpolate(*this->Reference, 1. + (this->NumberOfRows - 1) * percentile);
+          }
+        for (vtkIdType i = first; i <= last; ++i)
+          {
+          values[order[i]] = normalized;
+          }
+        first = last + 1;
+        }
+      }
+    }
+};
+
+//------------------------------------------------------------------------------
+// Quantile normalization of the columns of the column-major matrix data, like the R function
+// "normalize.quantiles" of the package "preprocessCore". NaN values are left in place.
+void quantileNormalize(double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  std::vector<int> order(numberOfRows * numberOfColumns);
+  std::vector<vtkIdType> counts(numberOfColumns);
+  SortFunctor sortFunctor;
+  sortFunctor.Data = data;
+  sortFunctor.NumberOfRows = numberOfRows;
+  sortFunctor.Order = &order[0];
+  sortFunctor.Counts = &counts[0];
+  voConcurrentUtils::parallelFor(numberOfColumns, sortFunctor, 1);
+
+  // Reference distribution: mean of the sorted columns
+  std::vector<double> reference(numberOfRows, 0.);
+  ReferenceFunctor referenceFunctor;
+  referenceFunctor.Data = data;
+  referenceFunctor.NumberOfRows = numberOfRows;
+  referenceFunctor.NumberOfColumns = numberOfColumns;
+  referenceFunctor.Order = &order[0];
+  referenceFunctor.Counts = &counts[0];
+  referenceFunctor.Sums = &reference[0];
+  voConcurrentUtils::parallelFor(numberOfRows, referenceFunctor);
+  for (vtkIdType i = 0; i < numberOfRows; ++i)
+    {
+    reference[i] /= numberOfColumns;
+    }
+
+  AssignFunctor assignFunctor;
+  assignFunctor.Data = data;
+  assignFunctor.NumberOfRows = numberOfRows;
+  assignFunctor.Order = &order[0];
+  assignFunctor.Counts = &counts[0];
+  assignFunctor.Reference = &reference;
+  voConcurrentUtils::parallelFor(numberOfColumns, assignFunctor, 1);
+}
+
+} // end of anonymous namespace
+
 namespace Normalization
 {
 
@@ -44,34 +246,46 @@ bool applyQuantile(vtkTable * dataTable, const QHash<int, QVariant>& settings)
     {
     return false;
     }
+  vtkIdType numberOfRows = dataTable->GetNumberOfRows();
+  vtkIdType numberOfColumns = dataTable->GetNumberOfColumns();
+  if (numberOfRows == 0 || numberOfColumns == 0)
+    {
+    return true;
+    }
 
-  vtkSmartPointer<vtkArray> inputDataArray;
-  bool result = voUtils::tableToArray(dataTable, inputDataArray);
-  if (!result)
+  // Normalize the buffer shared by the columns in place when possible
+  vtkExtendedTable * extendedTable = vtkExtendedTable::SafeDownCast(dataTable);
+  double * data = extendedTable ? extendedTable->GetContiguousDataBuffer() : 0;
+  if (data)
     {
-    return false;
+    quantileNormalize(data, numberOfRows, numberOfColumns);
+    dataTable->Modified();
+    return true;
     }
 
-  vtkNew<vtkArrayData> RInputArrayData;
-  RInputArrayData->AddArray(inputDataArray);
-
-  // Run R code
-  vtkNew<vtkRCalculatorFilter> RCalc;
-  RCalc->SetRoutput(0);
-  RCalc->SetInputConnection(RInputArrayData->GetProducerPort());
-  RCalc->PutArray("0", "inputData");
-  RCalc->GetArray("outputData","outputData");
-  RCalc->SetRscript(QString(
-  "library(\"preprocessCore\")\n"
-  "outputData <- normalize.quantiles(inputData)"
-  ).toLatin1());
-  RCalc->Update();
-
-  vtkSmartPointer<vtkArrayData> outputArrayData = vtkArrayData::SafeDownCast(RCalc->GetOutput());
-  vtkNew<vtkTable> outputTable;
-  voUtils::arrayToTable(outputArrayData->GetArrayByName("outputData"), outputTable.GetPointer());
-
-  dataTable->ShallowCopy(outputTable.GetPointer());
+  std::vector<double> values(numberOfRows * numberOfColumns);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkDataArray * column = vtkDataArray::SafeDownCast(dataTable->GetColumn(cid));
+    if (!column || column->GetNumberOfTuples() != numberOfRows)
+      {
+      return false;
+      }
+    for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+      {
+      values[cid * numberOfRows + rid] = column->GetTuple1(rid);
+      }
+    }
+  quantileNormalize(&values[0], numberOfRows, numberOfColumns);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkDataArray * column = vtkDataArray::SafeDownCast(dataTable->GetColumn(cid));
+    for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+      {
+      column->SetTuple1(rid, values[cid * numberOfRows + rid]);
+      }
+    column->Modified();
+    }
   dataTable->Modified();
 
   return true;
@@ -0,0 +1,72 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Visomics includes
+#include "voNormalization.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <cmath>
+
+namespace Normalization
+{
+
+//------------------------------------------------------------------------------
+void zScoreColumn(double * values, vtkIdType count, const QHash<int, QVariant>& settings)
+{
+  Q_UNUSED(settings);
+
+  // Mean and sample standard deviation of the values that aren't missing
+  vtkIdType numberOfValues = 0;
+  double mean = 0.;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    if (!vtkMath::IsNan(values[i]))
+      {
+      mean += values[i];
+      ++numberOfValues;
+      }
+    }
+  if (numberOfValues == 0)
+    {
+    return;
+    }
+  mean /= numberOfValues;
+  double sumOfSquares = 0.;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    if (!vtkMath::IsNan(values[i]))
+      {
+      sumOfSquares += (values[i] - mean) * (values[i] - mean);
+      }
+    }
+
+  // Constant columns are only centered
+  double standardDeviation = numberOfValues > 1 ? std::sqrt(sumOfSquares / (numberOfValues - 1)) : 0.;
+  double scale = standardDeviation > 0. ? 1. / standardDeviation : 1.;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    values[i] = (values[i] - mean) * scale;
+    }
+}
+
+} // end of Normalization namespace
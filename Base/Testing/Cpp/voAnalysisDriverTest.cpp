@@ -0,0 +1,223 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+
+// Visomics includes
+#include "voAnalysis.h"
+#include "voAnalysisDriver.h"
+#include "voApplication.h"
+#include "voDataModel.h"
+#include "voDataModelItem.h"
+#include "voDataObject.h"
+
+// VTK includes
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+QMutex ExecutionMutex;
+/// Name of the executed analyses, in the order they have been started
+QStringList ExecutedAnalyses;
+int RunningAnalysisCount = 0;
+int MaximumRunningAnalysisCount = 0;
+
+// --------------------------------------------------------------------------
+class voBatchAnalysis : public voAnalysis
+{
+public:
+  voBatchAnalysis(const QString& name, bool fail):voAnalysis(), Fail(fail)
+    {
+    this->setObjectName(name);
+    }
+  virtual ~voBatchAnalysis(){}
+
+  bool Fail;
+
+  virtual bool execute()
+    {
+    {
+    QMutexLocker locker(&ExecutionMutex);
+    ExecutedAnalyses << this->objectName();
+    ++RunningAnalysisCount;
+    MaximumRunningAnalysisCount = qMax(MaximumRunningAnalysisCount, RunningAnalysisCount);
+    }
+    // Give the other analyses a chance to be started concurrently
+    vtkNew<vtkIntArray> array;
+    for (int i = 0; i < 1000000; ++i)
+      {
+      array->InsertNextValue(i);
+      }
+    QMutexLocker locker(&ExecutionMutex);
+    --RunningAnalysisCount;
+    return !this->Fail;
+    }
+
+  virtual void setInputInformation()
+    {
+    this->addInputType("input", "vtkTable");
+    }
+};
+
+// --------------------------------------------------------------------------
+QList<voAnalysis*> createBatch(const QStringList& names, const QString& failingName)
+{
+  QList<voAnalysis*> analyses;
+  foreach(const QString& name, names)
+    {
+    voAnalysis * analysis = new voBatchAnalysis(name, name == failingName);
+    // Succeeded analyses are owned by the application, failed ones are deleted by the driver
+    analysis->setParent(qApp);
+    analyses << analysis;
+    }
+  return analyses;
+}
+
+// --------------------------------------------------------------------------
+void resetExecutions()
+{
+  ExecutedAnalyses.clear();
+  RunningAnalysisCount = 0;
+  MaximumRunningAnalysisCount = 0;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voAnalysisDriverTest(int argc, char * argv [])
+{
+  voApplication app(argc, argv, false);
+
+  vtkNew<vtkIntArray> inputArray;
+  inputArray->SetName("values");
+  inputArray->InsertNextValue(1);
+  inputArray->InsertNextValue(2);
+  vtkNew<vtkTable> inputTable;
+  inputTable->AddColumn(inputArray.GetPointer());
+  voDataModelItem * inputTarget =
+      app.dataModel()->addDataObject(new voDataObject("data", inputTable.GetPointer()));
+
+  voAnalysisDriver driver;
+  driver.setResultCacheEnabled(false);
+  driver.setAsynchronousExecutionEnabled(true);
+
+  //-----------------------------------------------------------------------------
+  // Analyses of a batch are started one at a time, in order
+  //-----------------------------------------------------------------------------
+  driver.setMaximumRunningAnalysisCount(1);
+  if (driver.maximumRunningAnalysisCount() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setMaximumRunningAnalysisCount()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList names = QStringList() << "job1" << "job2" << "job3" << "job4";
+  QList<voAnalysis*> analyses = createBatch(names, "job2");
+  driver.runAnalyses(analyses, inputTarget);
+  // "job1" is running, the others are pending until its completion is handled
+  driver.abortAnalysis(analyses.at(2));
+  driver.waitForAnalyses();
+
+  QStringList expectedExecutedAnalyses = QStringList() << "job1" << "job2" << "job4";
+  if (ExecutedAnalyses != expectedExecutedAnalyses || MaximumRunningAnalysisCount != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with runAnalyses()\n"
+              << "\tExpected executed analyses:" << qPrintable(expectedExecutedAnalyses.join(" ")) << "\n"
+              << "\tCurrent executed analyses:" << qPrintable(ExecutedAnalyses.join(" ")) << "\n"
+              << "\tMaximum running analysis count:" << MaximumRunningAnalysisCount << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!driver.runningAnalyses().isEmpty())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with waitForAnalyses()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (driver.numberOfFailedBatchAnalyses() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with numberOfFailedBatchAnalyses()\n"
+              << "\tExpected: 2\n"
+              << "\tCurrent:" << driver.numberOfFailedBatchAnalyses() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QString report = driver.batchReport();
+  QStringList expectedReportLines = QStringList()
+      << "Batch of 4 analyses: 2 succeeded, 1 failed, 1 aborted"
+      << "job1 on data: succeeded"
+      << "job2 on data: FAILED"
+      << "job3 on data: aborted"
+      << "job4 on data: succeeded";
+  foreach(const QString& expectedReportLine, expectedReportLines)
+    {
+    if (!report.contains(expectedReportLine))
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with batchReport()\n"
+                << "\tExpected line:" << qPrintable(expectedReportLine) << "\n"
+                << "\tCurrent report:" << qPrintable(report) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //-----------------------------------------------------------------------------
+  // Analyses whose inputs exceed the memory limit together aren't run concurrently
+  //-----------------------------------------------------------------------------
+  resetExecutions();
+  driver.setMaximumRunningAnalysisCount(3);
+  driver.setRunningAnalysisMemoryLimit(1);
+  if (driver.runningAnalysisMemoryLimit() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setRunningAnalysisMemoryLimit()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  names = QStringList() << "job5" << "job6" << "job7";
+  driver.runAnalyses(createBatch(names, QString()), inputTarget);
+  driver.waitForAnalyses();
+
+  // An analysis is started even if its inputs alone exceed the limit
+  if (ExecutedAnalyses != names || MaximumRunningAnalysisCount != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setRunningAnalysisMemoryLimit()\n"
+              << "\tExpected executed analyses:" << qPrintable(names.join(" ")) << "\n"
+              << "\tCurrent executed analyses:" << qPrintable(ExecutedAnalyses.join(" ")) << "\n"
+              << "\tMaximum running analysis count:" << MaximumRunningAnalysisCount << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (driver.numberOfFailedBatchAnalyses() != 0 ||
+      !driver.batchReport().startsWith("Batch of 3 analyses: 3 succeeded, 0 failed, 0 aborted"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with batchReport()\n"
+              << "\tCurrent report:" << qPrintable(driver.batchReport()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
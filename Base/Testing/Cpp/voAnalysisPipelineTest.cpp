@@ -0,0 +1,206 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+
+// Visomics includes
+#include "voAnalysisPipeline.h"
+#include "voDatasetCache.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool writeFile(const QString& fileName, const char* content)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  file.write(content);
+  file.close();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+QByteArray description(const char* spearmanThreshold, const char* fileName = "data.csv")
+{
+  return QString(
+    "{ \"nodes\": ["
+    "  { \"id\": \"pearson\", \"analysis\": \"voXCorrel\", \"inputs\": { \"input\": \"data\" },"
+    "    \"parameters\": { \"method\": \"pearson\" } },"
+    "  { \"id\": \"spearman\", \"analysis\": \"voXCorrel\", \"inputs\": { \"input\": \"data\" },"
+    "    \"parameters\": { \"method\": \"spearman\", \"threshold\": %1 } },"
+    "  { \"id\": \"data\", \"file\": \"%2\", \"settings\": { \"columnMetaDataTypes\": 1 } }"
+    "] }").arg(spearmanThreshold).arg(fileName).toUtf8();
+}
+
+//-----------------------------------------------------------------------------
+bool checkStatuses(int line, voAnalysisPipeline& pipeline,
+                   voAnalysisPipeline::NodeStatus dataStatus,
+                   voAnalysisPipeline::NodeStatus pearsonStatus,
+                   voAnalysisPipeline::NodeStatus spearmanStatus)
+{
+  if (pipeline.nodeStatus("data") != dataStatus ||
+      pipeline.nodeStatus("pearson") != pearsonStatus ||
+      pipeline.nodeStatus("spearman") != spearmanStatus)
+    {
+    std::cerr << "Line " << line << " - Problem with run() - Unexpected node statuses\n"
+              << qPrintable(pipeline.report()) << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voAnalysisPipelineTest(int argc, char * argv [])
+{
+  QApplication app(argc, argv);
+
+  QDir directory(QDir::temp().filePath("voAnalysisPipelineTest"));
+  if (!QDir().mkpath(directory.absolutePath()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to create " << qPrintable(directory.absolutePath()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  voDatasetCache::setCacheDirectory(directory.absolutePath());
+  QString dataFileName = directory.filePath("data.csv");
+  if (!writeFile(dataFileName,
+                 "Name,Exp1,Exp2,Exp3,Exp4\n"
+                 "Glucose,1,2,3,4\n"
+                 "Lactate,2,4,5,9\n"
+                 "Pyruvate,4,3,2,1\n"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(dataFileName) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  voAnalysisPipeline pipeline;
+  pipeline.setResultCacheEnabled(false);
+
+  //-----------------------------------------------------------------------------
+  // Invalid descriptions are rejected
+  //-----------------------------------------------------------------------------
+  const char* invalidDescriptions[] = {
+    "{ \"nodes\": [ { \"id\": \"data\", \"file\": \"data.csv\" ",
+    "{ \"nodes\": [ { \"id\": \"xcorrel\", \"analysis\": \"voXCorrel\", \"inputs\": { \"input\": \"data\" } } ] }",
+    "{ \"nodes\": [ { \"id\": \"data\", \"analysis\": \"voUnknown\" } ] }",
+    "{ \"nodes\": [ { \"id\": \"data\", \"file\": \"data.csv\", \"settings\": { \"unknown\": 1 } } ] }",
+    "{ \"nodes\": [ { \"id\": \"a\", \"analysis\": \"voXCorrel\", \"inputs\": { \"input\": \"b.corr\" } },"
+    "               { \"id\": \"b\", \"analysis\": \"voXCorrel\", \"inputs\": { \"input\": \"a.corr\" } } ] }"
+    };
+  for (size_t i = 0; i < sizeof(invalidDescriptions) / sizeof(const char*); ++i)
+    {
+    if (pipeline.setDescription(invalidDescriptions[i], directory.absolutePath()) ||
+        !pipeline.nodeIds().isEmpty())
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with setDescription() - "
+                << "Description " << i << " is expected to be rejected" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //-----------------------------------------------------------------------------
+  // Nodes are ordered and executed
+  //-----------------------------------------------------------------------------
+  if (!pipeline.setDescription(description("0.5"), directory.absolutePath()) ||
+      pipeline.nodeIds() != (QStringList() << "data" << "pearson" << "spearman"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setDescription()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!pipeline.run() || !pipeline.output("data") || !pipeline.output("pearson", "corr") ||
+      !pipeline.output("spearman", "corr") || pipeline.output("pearson"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with run()\n"
+              << qPrintable(pipeline.report()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkStatuses(__LINE__, pipeline, voAnalysisPipeline::Executed,
+                     voAnalysisPipeline::Executed, voAnalysisPipeline::Executed))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Unchanged nodes are reused
+  //-----------------------------------------------------------------------------
+  if (!pipeline.run() ||
+      !checkStatuses(__LINE__, pipeline, voAnalysisPipeline::Reused,
+                     voAnalysisPipeline::Reused, voAnalysisPipeline::Reused))
+    {
+    return EXIT_FAILURE;
+    }
+  if (!pipeline.setDescription(description("0.8"), directory.absolutePath()) || !pipeline.run() ||
+      !checkStatuses(__LINE__, pipeline, voAnalysisPipeline::Reused,
+                     voAnalysisPipeline::Reused, voAnalysisPipeline::Executed))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Modified input files are imported again along with the downstream nodes
+  //-----------------------------------------------------------------------------
+  if (!writeFile(dataFileName,
+                 "Name,Exp1,Exp2,Exp3,Exp4\n"
+                 "Glucose,1,2,3,4\n"
+                 "Lactate,2,4,5,9\n"
+                 "Pyruvate,4,3,2,2\n"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(dataFileName) << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!pipeline.run() ||
+      !checkStatuses(__LINE__, pipeline, voAnalysisPipeline::Executed,
+                     voAnalysisPipeline::Executed, voAnalysisPipeline::Executed))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Nodes downstream of a failed node are skipped
+  //-----------------------------------------------------------------------------
+  if (!pipeline.setDescription(description("0.8", "missing.csv"), directory.absolutePath()) ||
+      pipeline.run() ||
+      !checkStatuses(__LINE__, pipeline, voAnalysisPipeline::Failed,
+                     voAnalysisPipeline::Skipped, voAnalysisPipeline::Skipped) ||
+      pipeline.output("pearson", "corr"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  QFile::remove(voDatasetCache::cacheFileName(dataFileName));
+  QFile::remove(dataFileName);
+  QFile::remove(directory.filePath("usage.txt"));
+  directory.rmdir(directory.absolutePath());
+
+  return EXIT_SUCCESS;
+}
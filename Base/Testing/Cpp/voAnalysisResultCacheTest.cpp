@@ -0,0 +1,265 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QVariant>
+
+// QtPropertyBrowser includes
+#include <QtVariantPropertyManager>
+
+// Visomics includes
+#include "voAnalysis.h"
+#include "voAnalysisResultCache.h"
+#include "voDataObject.h"
+#include "voTableDataObject.h"
+
+// VTK includes
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+int NumberOfExecutions = 0;
+
+class voSumAnalysis : public voAnalysis
+{
+public:
+  voSumAnalysis():voAnalysis(){}
+  virtual ~voSumAnalysis(){}
+
+  virtual bool execute()
+    {
+    ++NumberOfExecutions;
+    vtkTable* table = vtkTable::SafeDownCast(this->input()->dataAsVTKDataObject());
+    vtkIntArray * inputArray = table ? vtkIntArray::SafeDownCast(table->GetColumn(0)) : 0;
+    if (!inputArray)
+      {
+      return false;
+      }
+    vtkNew<vtkTable> outputTable;
+    vtkNew<vtkIntArray> outputArray;
+    outputArray->SetName("Sum");
+    outputArray->SetNumberOfValues(1);
+    outputArray->SetValue(0, inputArray->GetValue(0) + inputArray->GetValue(1) + this->integerParameter("offset"));
+    outputTable->AddColumn(outputArray.GetPointer());
+    this->setOutput("sum", new voTableDataObject("sum", outputTable.GetPointer(), /* sortable= */ true));
+    return true;
+    }
+
+  virtual void setInputInformation()
+    {
+    this->addInputType("input", "vtkTable");
+    }
+
+  virtual void setOutputInformation()
+    {
+    this->addOutputType("sum", "vtkTable", "", "", "voTableView", "Sum");
+    }
+
+  virtual void setParameterInformation()
+    {
+    QList<QtProperty*> parameters;
+    parameters << this->addIntegerParameter("offset", QObject::tr("Offset"), 0, 10, 0);
+    this->addParameterGroup("Sum parameters", parameters);
+    }
+
+  void initialize(voDataObject* input, int offset)
+    {
+    this->initializeInputInformation();
+    this->initializeOutputInformation();
+    QHash<QString, QVariant> parameters;
+    parameters.insert("offset", offset);
+    this->initializeParameterInformation(parameters);
+    this->setInput("input", input);
+    }
+};
+
+//-----------------------------------------------------------------------------
+int sumOutput(voAnalysis* analysis)
+{
+  voTableDataObject * output = qobject_cast<voTableDataObject*>(analysis->output("sum"));
+  vtkTable * table = output ? vtkTable::SafeDownCast(output->dataAsVTKDataObject()) : 0;
+  if (!table || !output->sortable() || table->GetNumberOfColumns() != 1 || table->GetNumberOfRows() != 1)
+    {
+    return -1;
+    }
+  return table->GetValue(0, 0).ToInt();
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voAnalysisResultCacheTest(int argc, char * argv [])
+{
+  QApplication app(argc, argv);
+
+  QDir cacheDirectory(QDir::temp().filePath("voAnalysisResultCacheTest"));
+  voAnalysisResultCache::setCacheDirectory(cacheDirectory.absolutePath());
+
+  vtkNew<vtkTable> inputTable;
+  vtkNew<vtkIntArray> inputArray;
+  inputArray->SetName("Values");
+  inputArray->SetNumberOfValues(2);
+  inputArray->SetValue(0, 1);
+  inputArray->SetValue(1, 2);
+  inputTable->AddColumn(inputArray.GetPointer());
+  voDataObject * inputDataObject = new voDataObject("input", inputTable.GetPointer());
+
+  //-----------------------------------------------------------------------------
+  // Keys depend on the input content and on the parameter values
+  //-----------------------------------------------------------------------------
+  voSumAnalysis analysis;
+  analysis.initialize(inputDataObject, 1);
+  QString key = voAnalysisResultCache::key(&analysis);
+
+  voSumAnalysis sameAnalysis;
+  sameAnalysis.initialize(inputDataObject, 1);
+  voSumAnalysis otherAnalysis;
+  otherAnalysis.initialize(inputDataObject, 2);
+  if (key.isEmpty() || voAnalysisResultCache::key(&sameAnalysis) != key ||
+      voAnalysisResultCache::key(&otherAnalysis) == key)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with key() - "
+              << "Keys are expected to depend on parameter values only" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  inputArray->SetValue(1, 3);
+  inputArray->Modified();
+  if (voAnalysisResultCache::key(&sameAnalysis) == key)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with key() - "
+              << "Key is expected to change with the input content" << std::endl;
+    return EXIT_FAILURE;
+    }
+  inputArray->SetValue(1, 2);
+  inputArray->Modified();
+  if (voAnalysisResultCache::key(&sameAnalysis) != key)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with key() - "
+              << "Key is expected to be restored with the input content" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Outputs written by an analysis are restored without executing it
+  //-----------------------------------------------------------------------------
+  if (!analysis.run() || sumOutput(&analysis) != 4 ||
+      !voAnalysisResultCache::write(key, &analysis))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with write()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (voAnalysisResultCache::read(voAnalysisResultCache::key(&otherAnalysis), &otherAnalysis) ||
+      otherAnalysis.output("sum") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "No entry is expected for other parameter values" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int numberOfExecutions = NumberOfExecutions;
+  if (!voAnalysisResultCache::read(key, &sameAnalysis) || sumOutput(&sameAnalysis) != 4 ||
+      NumberOfExecutions != numberOfExecutions)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "Outputs are expected to be restored" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!sameAnalysis.outdatedOutputNames().isEmpty())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "Restored outputs are expected to be up to date" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // A truncated entry is rejected
+  //-----------------------------------------------------------------------------
+  QFile cacheFile(cacheDirectory.filePath(key + ".vores"));
+  voSumAnalysis truncatedAnalysis;
+  truncatedAnalysis.initialize(inputDataObject, 1);
+  if (!cacheFile.resize(cacheFile.size() - 1) ||
+      voAnalysisResultCache::read(key, &truncatedAnalysis) || truncatedAnalysis.output("sum") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "Truncated entry is expected to be rejected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // The least recently used entries are removed once the maximum size is exceeded
+  //-----------------------------------------------------------------------------
+  if (!analysis.run() || !voAnalysisResultCache::write(key, &analysis) ||
+      !otherAnalysis.run() || !voAnalysisResultCache::write(voAnalysisResultCache::key(&otherAnalysis), &otherAnalysis))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with write()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  voAnalysisResultCache::setMaximumSize(2 * cacheFile.size());
+
+  // Reading the first entry makes the second one the least recently used
+  voSumAnalysis usedAnalysis;
+  usedAnalysis.initialize(inputDataObject, 1);
+  voSumAnalysis thirdAnalysis;
+  thirdAnalysis.initialize(inputDataObject, 3);
+  QString otherKey = voAnalysisResultCache::key(&otherAnalysis);
+  QString thirdKey = voAnalysisResultCache::key(&thirdAnalysis);
+  if (!voAnalysisResultCache::read(key, &usedAnalysis) ||
+      !thirdAnalysis.run() || !voAnalysisResultCache::write(thirdKey, &thirdAnalysis))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() / write()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!cacheFile.exists() || QFile::exists(cacheDirectory.filePath(otherKey + ".vores")) ||
+      !QFile::exists(cacheDirectory.filePath(thirdKey + ".vores")))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setMaximumSize() - "
+              << "Only the least recently used entry is expected to be removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Entries larger than the maximum size aren't written
+  voAnalysisResultCache::setMaximumSize(cacheFile.size() - 1);
+  if (voAnalysisResultCache::write(otherKey, &otherAnalysis) ||
+      QFile::exists(cacheDirectory.filePath(otherKey + ".vores")))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with write() - "
+              << "Entry larger than the maximum size is not expected to be written" << std::endl;
+    return EXIT_FAILURE;
+    }
+  voAnalysisResultCache::setMaximumSize(-1);
+
+  QFile::remove(cacheFile.fileName());
+  QFile::remove(cacheDirectory.filePath(thirdKey + ".vores"));
+  QFile::remove(cacheDirectory.filePath("usage.txt"));
+  cacheDirectory.rmdir(cacheDirectory.absolutePath());
+
+  return EXIT_SUCCESS;
+}
@@ -33,6 +33,7 @@
 #include <vtkArrayData.h>
 #include <vtkIntArray.h>
 #include <vtkNew.h>
+#include <vtkSmartPointer.h>
 #include <vtkTable.h>
 
 // STD includes
@@ -106,6 +107,83 @@ public:
     }
 };
 
+// --------------------------------------------------------------------------
+// "sum" depends on "offset" only, "product" on "factor" only. The total of the
+// input values is kept as intermediate data.
+class voIncrementalAnalysis : public voAnalysis
+{
+public:
+  voIncrementalAnalysis():voAnalysis(), TotalComputationCount(0){}
+  virtual ~voIncrementalAnalysis(){}
+
+  int TotalComputationCount;
+
+  virtual bool execute()
+    {
+    vtkTable* table =  vtkTable::SafeDownCast(this->input()->dataAsVTKDataObject());
+    vtkIntArray * inputArray = table ? vtkIntArray::SafeDownCast(table->GetColumn(0)) : 0;
+    if (!inputArray)
+      {
+      return false;
+      }
+    vtkSmartPointer<vtkIntArray> totalArray = vtkIntArray::SafeDownCast(this->intermediateData("total"));
+    if (!totalArray)
+      {
+      totalArray = vtkSmartPointer<vtkIntArray>::New();
+      totalArray->InsertNextValue(inputArray->GetValue(0) + inputArray->GetValue(1));
+      this->setIntermediateData("total", totalArray, QStringList());
+      ++this->TotalComputationCount;
+      }
+    int total = totalArray->GetValue(0);
+    if (this->isOutputOutdated("sum"))
+      {
+      this->setOutput("sum", this->newOutput("sum", total + this->integerParameter("offset")));
+      }
+    if (this->isOutputOutdated("product"))
+      {
+      this->setOutput("product", this->newOutput("product", total * this->integerParameter("factor")));
+      }
+    return true;
+    }
+
+  virtual void setInputInformation()
+    {
+    this->addInputType("input", "vtkTable");
+    }
+
+  virtual void setOutputInformation()
+    {
+    this->addOutputType("sum", "vtkTable", "", "", "voTableView", "Sum");
+    this->addOutputType("product", "vtkTable", "", "", "voTableView", "Product");
+    this->setOutputParameters("sum", QStringList() << "offset");
+    this->setOutputParameters("product", QStringList() << "factor");
+    }
+
+  virtual void setParameterInformation()
+    {
+    this->addIntegerParameter("offset", QObject::tr("Offset"), 0, 10, 0);
+    this->addIntegerParameter("factor", QObject::tr("Factor"), 0, 10, 1);
+    }
+
+  voDataObject* newOutput(const QString& name, int value)
+    {
+    vtkNew<vtkTable> outputTable;
+    vtkNew<vtkIntArray> outputArray;
+    outputArray->InsertNextValue(value);
+    outputTable->AddColumn(outputArray.GetPointer());
+    return new voDataObject(name, outputTable.GetPointer());
+    }
+};
+
+//-----------------------------------------------------------------------------
+int outputValue(voAnalysis& analysis, const QString& outputName)
+{
+  voDataObject * dataObject = analysis.output(outputName);
+  vtkTable * table = dataObject ? vtkTable::SafeDownCast(dataObject->dataAsVTKDataObject()) : 0;
+  vtkIntArray * array = table ? vtkIntArray::SafeDownCast(table->GetColumn(0)) : 0;
+  return array ? array->GetValue(0) : -1;
+}
+
 } // end of anonymous namespace
 
 //-----------------------------------------------------------------------------
@@ -603,5 +681,85 @@ int voAnalysisTest(int argc, char * argv [])
     return EXIT_FAILURE;
     }
 
+  //-----------------------------------------------------------------------------
+  // Abort execution
+  //-----------------------------------------------------------------------------
+
+  analysis.setAbortExecution(true);
+  if (!analysis.abortExecution() || analysis.run())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setAbortExecution() / run() !" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  analysis.setAbortExecution(false);
+  if (analysis.abortExecution() || !analysis.run())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with setAbortExecution() / run() !" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Incremental execution
+  //-----------------------------------------------------------------------------
+
+  voIncrementalAnalysis incrementalAnalysis;
+  incrementalAnalysis.initializeInputInformation();
+  incrementalAnalysis.initializeOutputInformation();
+  incrementalAnalysis.initializeParameterInformation();
+  incrementalAnalysis.setInput("input", new voDataObject("input", table.GetPointer()));
+
+  if (incrementalAnalysis.outdatedOutputNames() != (QStringList() << "product" << "sum") ||
+      !incrementalAnalysis.run() || !incrementalAnalysis.outdatedOutputNames().isEmpty() ||
+      outputValue(incrementalAnalysis, "sum") != 3 || outputValue(incrementalAnalysis, "product") != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with run() / outdatedOutputNames() !" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Only the output computed from the modified parameter is recomputed
+  voDataObject * sumOutput = incrementalAnalysis.output("sum");
+  QHash<QString, QVariant> factorValue;
+  factorValue.insert("factor", 4);
+  incrementalAnalysis.setParameterValues(factorValue);
+  if (incrementalAnalysis.outdatedOutputNames() != (QStringList() << "product"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with outdatedOutputNames() !" << std::endl;
+    return EXIT_FAILURE;
+    }
+  incrementalAnalysis.removeOutdatedOutputs();
+  if (incrementalAnalysis.output("product") || incrementalAnalysis.output("sum") != sumOutput ||
+      incrementalAnalysis.numberOfOutput() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with removeOutdatedOutputs() !" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!incrementalAnalysis.run() || incrementalAnalysis.output("sum") != sumOutput ||
+      outputValue(incrementalAnalysis, "product") != 12 ||
+      incrementalAnalysis.TotalComputationCount != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with run() - "
+              << "Only the product is expected to be recomputed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modified inputs outdate every output and the intermediate data
+  intColumn->SetValue(1, 5);
+  intColumn->Modified();
+  if (incrementalAnalysis.outdatedOutputNames() != (QStringList() << "product" << "sum"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with outdatedOutputNames() !" << std::endl;
+    return EXIT_FAILURE;
+    }
+  incrementalAnalysis.removeOutdatedOutputs();
+  if (!incrementalAnalysis.run() || outputValue(incrementalAnalysis, "sum") != 6 ||
+      outputValue(incrementalAnalysis, "product") != 24 ||
+      incrementalAnalysis.TotalComputationCount != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with run() - "
+              << "Every output is expected to be recomputed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
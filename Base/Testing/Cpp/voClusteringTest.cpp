@@ -0,0 +1,412 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QString>
+
+// Visomics includes
+#include "voClustering.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool checkMerges(int line, voClustering::Linkage linkage, const double* data,
+                 vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                 const voClustering::Merge* expectedMerges)
+{
+  std::vector<float> distances;
+  std::vector<voClustering::Merge> merges;
+  voClustering::columnDistances(data, numberOfRows, numberOfColumns, distances);
+  if (!voClustering::hierarchicalClustering(distances, numberOfColumns, linkage, merges) ||
+      static_cast<vtkIdType>(merges.size()) != numberOfColumns - 1)
+    {
+    std::cerr << "Line " << line << " - Problem with hierarchicalClustering()" << std::endl;
+    return false;
+    }
+  for (size_t i = 0; i < merges.size(); ++i)
+    {
+    if (merges[i].First != expectedMerges[i].First ||
+        merges[i].Second != expectedMerges[i].Second ||
+        std::fabs(merges[i].Height - expectedMerges[i].Height) > 1e-5)
+      {
+      std::cerr << "Line " << line << " - Problem with hierarchicalClustering()\n"
+                << "\tStep: " << i + 1 << "\n"
+                << "\tCurrent: " << merges[i].First << " " << merges[i].Second
+                << " " << merges[i].Height << "\n"
+                << "\tExpected: " << expectedMerges[i].First << " " << expectedMerges[i].Second
+                << " " << expectedMerges[i].Height << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Heights computed by the O(n^3) textbook algorithm: merge the closest pair of clusters,
+// then update the distances with the Lance-Williams formula.
+std::vector<double> referenceHeights(voClustering::Linkage linkage, const std::vector<float>& condensedDistances,
+                                     vtkIdType count)
+{
+  bool ward = (linkage == voClustering::WardD2Linkage);
+  std::vector<double> distances(count * count, 0.);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    for (vtkIdType j = i + 1; j < count; ++j)
+      {
+      double distance = condensedDistances[voClustering::condensedIndex(i, j, count)];
+      distances[i * count + j] = distances[j * count + i] = ward ? distance * distance : distance;
+      }
+    }
+  std::vector<double> sizes(count, 1.);
+  std::vector<bool> active(count, true);
+  std::vector<double> heights;
+  for (vtkIdType step = 0; step < count - 1; ++step)
+    {
+    vtkIdType a = -1;
+    vtkIdType b = -1;
+    for (vtkIdType i = 0; i < count; ++i)
+      {
+      for (vtkIdType j = i + 1; j < count; ++j)
+        {
+        if (active[i] && active[j] && (a < 0 || distances[i * count + j] < distances[a * count + b]))
+          {
+          a = i;
+          b = j;
+          }
+        }
+      }
+    double dab = distances[a * count + b];
+    heights.push_back(ward ? std::sqrt(dab) : dab);
+    for (vtkIdType k = 0; k < count; ++k)
+      {
+      if (!active[k] || k == a || k == b)
+        {
+        continue;
+        }
+      double dak = distances[a * count + k];
+      double dbk = distances[b * count + k];
+      double na = sizes[a];
+      double nb = sizes[b];
+      double nk = sizes[k];
+      double distance = 0.;
+      switch (linkage)
+        {
+        case voClustering::SingleLinkage: distance = std::min(dak, dbk); break;
+        case voClustering::CompleteLinkage: distance = std::max(dak, dbk); break;
+        case voClustering::AverageLinkage: distance = (na * dak + nb * dbk) / (na + nb); break;
+        case voClustering::McQuittyLinkage: distance = (dak + dbk) / 2.; break;
+        case voClustering::MedianLinkage: distance = (dak + dbk) / 2. - dab / 4.; break;
+        case voClustering::CentroidLinkage:
+          distance = (na * dak + nb * dbk) / (na + nb) - na * nb * dab / ((na + nb) * (na + nb));
+          break;
+        case voClustering::WardD2Linkage:
+          distance = ((na + nk) * dak + (nb + nk) * dbk - nk * dab) / (na + nb + nk);
+          break;
+        }
+      distances[b * count + k] = distances[k * count + b] = distance;
+      }
+    sizes[b] += sizes[a];
+    active[a] = false;
+    }
+  return heights;
+}
+
+//-----------------------------------------------------------------------------
+bool checkHeights(int line, voClustering::Linkage linkage, const double* data,
+                  vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  std::vector<float> distances;
+  voClustering::columnDistances(data, numberOfRows, numberOfColumns, distances);
+  std::vector<double> expectedHeights = referenceHeights(linkage, distances, numberOfColumns);
+
+  std::vector<voClustering::Merge> merges;
+  if (!voClustering::hierarchicalClustering(distances, numberOfColumns, linkage, merges))
+    {
+    std::cerr << "Line " << line << " - Problem with hierarchicalClustering()" << std::endl;
+    return false;
+    }
+  std::vector<double> heights;
+  for (size_t i = 0; i < merges.size(); ++i)
+    {
+    heights.push_back(merges[i].Height);
+    }
+  // The order of the merges only matters when heights aren't monotonic
+  if (linkage != voClustering::MedianLinkage && linkage != voClustering::CentroidLinkage)
+    {
+    std::sort(expectedHeights.begin(), expectedHeights.end());
+    }
+  for (size_t i = 0; i < expectedHeights.size(); ++i)
+    {
+    if (std::fabs(heights[i] - expectedHeights[i]) > 1e-4 * (1. + std::fabs(expectedHeights[i])))
+      {
+      std::cerr << "Line " << line << " - Problem with hierarchicalClustering()\n"
+                << "\tLinkage: " << linkage << "\n"
+                << "\tStep: " << i + 1 << "\n"
+                << "\tCurrent: " << heights[i] << "\n"
+                << "\tExpected: " << expectedHeights[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+double squaredDistance(const double* a, const double* b, vtkIdType count)
+{
+  double sum = 0.;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    sum += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+  return sum;
+}
+
+//-----------------------------------------------------------------------------
+// Three well separated groups of 2D points must be recovered by all the algorithms
+bool checkKMeans(int line, voClustering::KMeansAlgorithm algorithm)
+{
+  // Columns are the corners of unit squares whose origins are (0, 0), (10, -10) and (-10, -10)
+  const double square[] = {0., 0., 1., 0., 0., 1., 1., 1.};
+  const double origins[] = {0., 0., 10., -10., -10., -10.};
+  std::vector<double> data;
+  for (int group = 0; group < 3; ++group)
+    {
+    for (int i = 0; i < 8; ++i)
+      {
+      data.push_back(square[i] + origins[2 * group + i % 2]);
+      }
+    }
+  voClustering::KMeansResult result;
+  voClustering::KMeansResult secondResult;
+  if (!voClustering::kMeans(&data[0], 2, 12, 3, 10, 5, algorithm, 1, result) ||
+      !voClustering::kMeans(&data[0], 2, 12, 3, 10, 5, algorithm, 1, secondResult))
+    {
+    std::cerr << "Line " << line << " - Problem with kMeans()" << std::endl;
+    return false;
+    }
+  if (result.Clusters != secondResult.Clusters || !result.Converged)
+    {
+    std::cerr << "Line " << line << " - Problem with kMeans()\n"
+              << "\tAlgorithm: " << algorithm << "\n"
+              << "\tRuns are expected to be reproducible and to converge" << std::endl;
+    return false;
+    }
+  for (vtkIdType i = 0; i < 12; ++i)
+    {
+    if (result.Clusters[i] != result.Clusters[(i / 4) * 4])
+      {
+      std::cerr << "Line " << line << " - Problem with kMeans()\n"
+                << "\tAlgorithm: " << algorithm << "\n"
+                << "\tColumn " << i << " is not in the cluster of its group" << std::endl;
+      return false;
+      }
+    }
+  for (int c = 0; c < 3; ++c)
+    {
+    // Each group of 4 points of the unit square has a sum of squares of 2
+    if (result.Sizes[c] != 4 || std::fabs(result.WithinSumOfSquares[c] - 2.) > 1e-12)
+      {
+      std::cerr << "Line " << line << " - Problem with kMeans()\n"
+                << "\tAlgorithm: " << algorithm << "\n"
+                << "\tCluster: " << c << "\n"
+                << "\tSize: " << result.Sizes[c] << "\n"
+                << "\tWithin sum of squares: " << result.WithinSumOfSquares[c] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voClusteringTest(int /*argc*/, char * /*argv*/ [])
+{
+  // 4 experiments of 1 analyte: 0, 1, 3 and 7
+  // Expected merges and heights follow R: hclust(dist(c(0, 1, 3, 7)), method="...")
+  const double data[] = {0., 1., 3., 7.};
+
+  const voClustering::Merge expectedSingle[] = {{-1, -2, 1.}, {-3, 1, 2.}, {-4, 2, 4.}};
+  const voClustering::Merge expectedComplete[] = {{-1, -2, 1.}, {-3, 1, 3.}, {-4, 2, 7.}};
+  const voClustering::Merge expectedAverage[] = {{-1, -2, 1.}, {-3, 1, 2.5}, {-4, 2, 17. / 3.}};
+  const voClustering::Merge expectedWardD2[] = {{-1, -2, 1.}, {-3, 1, std::sqrt(25. / 3.)},
+                                                {-4, 2, std::sqrt(1.5) * 17. / 3.}};
+  if (!checkMerges(__LINE__, voClustering::SingleLinkage, data, 1, 4, expectedSingle) ||
+      !checkMerges(__LINE__, voClustering::CompleteLinkage, data, 1, 4, expectedComplete) ||
+      !checkMerges(__LINE__, voClustering::AverageLinkage, data, 1, 4, expectedAverage) ||
+      !checkMerges(__LINE__, voClustering::WardD2Linkage, data, 1, 4, expectedWardD2))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Two groups of experiments merged last: (-1 -2), (-3 -4), then (1 2)
+  const double pairs[] = {0., 1., 10., 11.};
+  const voClustering::Merge expectedPairs[] = {{-1, -2, 1.}, {-3, -4, 1.}, {1, 2, 9.}};
+  if (!checkMerges(__LINE__, voClustering::SingleLinkage, pairs, 1, 4, expectedPairs))
+    {
+    return EXIT_FAILURE;
+    }
+
+  voClustering::Linkage linkage;
+  if (!voClustering::linkageFromString("ward.D2", linkage) ||
+      linkage != voClustering::WardD2Linkage ||
+      voClustering::linkageFromString("ward", linkage))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with linkageFromString()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // NaN values are skipped and the sum of squares is scaled up, like R's dist()
+  const double nan = vtkMath::Nan();
+  const double dataWithNaN[] = {1., 2., nan, 4., 0., 0., 0., 0.};
+  std::vector<float> distances;
+  voClustering::columnDistances(dataWithNaN, 4, 2, distances);
+  if (distances.size() != 1 || std::fabs(distances[0] - std::sqrt(28.)) > 1e-5)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with columnDistances()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const double columnOfNaN[] = {1., 2., nan, nan, 0., 0.};
+  voClustering::columnDistances(columnOfNaN, 2, 3, distances);
+  std::vector<voClustering::Merge> merges;
+  if (voClustering::hierarchicalClustering(distances, 3, voClustering::AverageLinkage, merges))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with hierarchicalClustering()\n"
+              << "\tNaN distances are expected to fail" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // All the linkages must match the textbook algorithm
+  const vtkIdType numberOfRows = 7;
+  const vtkIdType numberOfColumns = 60;
+  std::vector<double> randomData(numberOfRows * numberOfColumns);
+  unsigned int seed = 12345;
+  for (size_t i = 0; i < randomData.size(); ++i)
+    {
+    seed = seed * 1103515245u + 12345u;
+    randomData[i] = static_cast<double>(seed >> 8) / (1 << 24);
+    }
+  const voClustering::Linkage linkages[] = {
+    voClustering::SingleLinkage, voClustering::CompleteLinkage, voClustering::AverageLinkage,
+    voClustering::McQuittyLinkage, voClustering::MedianLinkage, voClustering::CentroidLinkage,
+    voClustering::WardD2Linkage};
+  for (size_t i = 0; i < sizeof(linkages) / sizeof(linkages[0]); ++i)
+    {
+    if (!checkHeights(__LINE__, linkages[i], &randomData[0], numberOfRows, numberOfColumns))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // k-means
+  const voClustering::KMeansAlgorithm algorithms[] = {
+    voClustering::HartiganWong, voClustering::Lloyd, voClustering::Forgy, voClustering::MacQueen};
+  for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); ++i)
+    {
+    if (!checkKMeans(__LINE__, algorithms[i]))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  voClustering::KMeansAlgorithm algorithm;
+  voClustering::KMeansResult result;
+  if (!voClustering::kMeansAlgorithmFromString("Hartigan-Wong", algorithm) ||
+      algorithm != voClustering::HartiganWong ||
+      voClustering::kMeansAlgorithmFromString("hartigan", algorithm) ||
+      voClustering::kMeans(data, 1, 4, 5, 10, 1, voClustering::Lloyd, 1, result) ||
+      voClustering::kMeans(dataWithNaN, 4, 2, 1, 10, 1, voClustering::Lloyd, 1, result))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with kMeans()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A converged Hartigan-Wong partition can't be improved by moving a single column
+  if (!voClustering::kMeans(&randomData[0], numberOfRows, numberOfColumns, 6, 50, 1,
+                            voClustering::HartiganWong, 3, result) ||
+      !result.Converged)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with kMeans()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType i = 0; i < numberOfColumns; ++i)
+    {
+    const double* column = &randomData[i * numberOfRows];
+    int cluster = result.Clusters[i];
+    double size = static_cast<double>(result.Sizes[cluster]);
+    if (size < 2.)
+      {
+      continue;
+      }
+    double removalDecrease = size / (size - 1.) *
+      squaredDistance(column, &result.Centers[cluster * numberOfRows], numberOfRows);
+    for (int c = 0; c < 6; ++c)
+      {
+      double otherSize = static_cast<double>(result.Sizes[c]);
+      double additionIncrease = otherSize / (otherSize + 1.) *
+        squaredDistance(column, &result.Centers[c * numberOfRows], numberOfRows);
+      if (c != cluster && additionIncrease < removalDecrease - 1e-9)
+        {
+        std::cerr << "Line " << __LINE__ << " - Problem with kMeans()\n"
+                  << "\tMoving column " << i << " to cluster " << c
+                  << " decreases the sum of squares" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // The best of several runs is at least as good as any of them
+  double bestTotal = 0.;
+  double singleTotal = 0.;
+  voClustering::KMeansResult singleResult;
+  if (!voClustering::kMeans(&randomData[0], numberOfRows, numberOfColumns, 6, 20, 8,
+                            voClustering::HartiganWong, 7, result) ||
+      !voClustering::kMeans(&randomData[0], numberOfRows, numberOfColumns, 6, 20, 1,
+                            voClustering::HartiganWong, 7, singleResult))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with kMeans()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int c = 0; c < 6; ++c)
+    {
+    bestTotal += result.WithinSumOfSquares[c];
+    singleTotal += singleResult.WithinSumOfSquares[c];
+    }
+  if (bestTotal > singleTotal)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with kMeans()\n"
+              << "\tBest total within sum of squares: " << bestTotal << "\n"
+              << "\tFirst run total within sum of squares: " << singleTotal << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QtGlobal>
+
+// Visomics includes
+#include "voCorrelation.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// The matrix is symmetric: the columns of the output are the rows of \a correlation
+std::vector<double*> columnPointers(std::vector<double>& correlation, vtkIdType numberOfRows)
+{
+  std::vector<double*> columns(numberOfRows);
+  for (vtkIdType c = 0; c < numberOfRows; ++c)
+    {
+    columns[c] = &correlation[c * numberOfRows];
+    }
+  return columns;
+}
+
+//-----------------------------------------------------------------------------
+bool checkCorrelation(int line, voCorrelation::Method method, const double* data,
+                      vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                      const double* expectedCorrelation)
+{
+  std::vector<double> correlation(numberOfRows * numberOfRows);
+  std::vector<double*> columns = columnPointers(correlation, numberOfRows);
+  if (!voCorrelation::correlationMatrix(data, numberOfRows, numberOfColumns, method, &columns[0]))
+    {
+    std::cerr << "Line " << line << " - Problem with correlationMatrix()" << std::endl;
+    return false;
+    }
+  for (vtkIdType i = 0; i < numberOfRows * numberOfRows; ++i)
+    {
+    if (vtkMath::IsNan(expectedCorrelation[i]) && vtkMath::IsNan(correlation[i]))
+      {
+      continue;
+      }
+    if (std::fabs(correlation[i] - expectedCorrelation[i]) > 1e-6)
+      {
+      std::cerr << "Line " << line << " - Problem with correlationMatrix()\n"
+                << "\tIndex: " << i << "\n"
+                << "\tCurrent: " << correlation[i] << "\n"
+                << "\tExpected: " << expectedCorrelation[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Check that thresholdedCorrelation() returns exactly the pairs of the upper
+// triangle of the dense matrix whose absolute correlation is above the threshold.
+bool checkThresholdedCorrelation(int line, voCorrelation::Method method, const double* data,
+                                 vtkIdType numberOfRows, vtkIdType numberOfColumns, double threshold)
+{
+  std::vector<double> correlation(numberOfRows * numberOfRows);
+  std::vector<double*> columns = columnPointers(correlation, numberOfRows);
+  std::vector<voCorrelation::Edge> edges;
+  if (!voCorrelation::correlationMatrix(data, numberOfRows, numberOfColumns, method, &columns[0]) ||
+      !voCorrelation::thresholdedCorrelation(data, numberOfRows, numberOfColumns, method, threshold, edges))
+    {
+    std::cerr << "Line " << line << " - Problem with thresholdedCorrelation()" << std::endl;
+    return false;
+    }
+  size_t e = 0;
+  for (vtkIdType i = 0; i < numberOfRows; ++i)
+    {
+    for (vtkIdType j = i + 1; j < numberOfRows; ++j)
+      {
+      double expected = correlation[i * numberOfRows + j];
+      if (!(std::fabs(expected) > threshold))
+        {
+        continue;
+        }
+      if (e >= edges.size() || edges[e].First != i || edges[e].Second != j ||
+          std::fabs(edges[e].Value - expected) > 1e-12)
+        {
+        std::cerr << "Line " << line << " - Problem with thresholdedCorrelation()\n"
+                  << "\tExpected edge: " << i << " - " << j << " (" << expected << ")" << std::endl;
+        return false;
+        }
+      ++e;
+      }
+    }
+  if (e != edges.size())
+    {
+    std::cerr << "Line " << line << " - Problem with thresholdedCorrelation()\n"
+              << "\tCurrent number of edges: " << edges.size() << "\n"
+              << "\tExpected number of edges: " << e << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voCorrelationTest(int /*argc*/, char * /*argv*/ [])
+{
+  // Expected values have been computed using R: cor(t(data), method="...")
+  const double data[] = {
+    1., 2., 3., 4., 5.,
+    5., 6., 7., 8., 7.,
+    3., 3., 3., 3., 3.
+    };
+  const double nan = vtkMath::Nan();
+
+  const double expectedPearson[] = {
+    1.,        0.8320503, nan,
+    0.8320503, 1.,        nan,
+    nan,       nan,       nan
+    };
+  if (!checkCorrelation(__LINE__, voCorrelation::Pearson, data, 3, 5, expectedPearson))
+    {
+    return EXIT_FAILURE;
+    }
+
+  const double expectedSpearman[] = {
+    1.,        0.8207827, nan,
+    0.8207827, 1.,        nan,
+    nan,       nan,       nan
+    };
+  if (!checkCorrelation(__LINE__, voCorrelation::Spearman, data, 3, 5, expectedSpearman))
+    {
+    return EXIT_FAILURE;
+    }
+
+  const double expectedKendall[] = {
+    1.,        0.7378648, nan,
+    0.7378648, 1.,        nan,
+    nan,       nan,       nan
+    };
+  if (!checkCorrelation(__LINE__, voCorrelation::Kendall, data, 3, 5, expectedKendall))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Rows with a missing value are not ranked nor sorted, their correlations are NaN
+  const double dataWithNan[] = {
+    1., 2., 3., 4., 5.,
+    5., 6., 7., 8., 7.,
+    4., nan, 1., 2., 3.
+    };
+  const voCorrelation::Method methods[] = {voCorrelation::Pearson, voCorrelation::Spearman, voCorrelation::Kendall};
+  const double* expectedCorrelations[] = {expectedPearson, expectedSpearman, expectedKendall};
+  for (int m = 0; m < 3; ++m)
+    {
+    if (!checkCorrelation(__LINE__, methods[m], dataWithNan, 3, 5, expectedCorrelations[m]))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (!vtkMath::IsNan(voCorrelation::kendallTau(dataWithNan, dataWithNan + 10, 5)))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with kendallTau() - "
+              << "NaN is expected for values containing NaN" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Kendall's tau must match the brute force O(n^2) definition on data with ties
+  const double x[] = {1., 2., 2., 3., 5., 5., 5., 8.};
+  const double y[] = {2., 1., 4., 4., 3., 3., 7., 6.};
+  double concordance = 0.;
+  double xTies = 0.;
+  double yTies = 0.;
+  double pairs = 0.;
+  for (int i = 0; i < 8; ++i)
+    {
+    for (int j = i + 1; j < 8; ++j)
+      {
+      double sign = (x[i] - x[j]) * (y[i] - y[j]);
+      concordance += sign > 0 ? 1. : (sign < 0 ? -1. : 0.);
+      xTies += x[i] == x[j] ? 1. : 0.;
+      yTies += y[i] == y[j] ? 1. : 0.;
+      pairs += 1.;
+      }
+    }
+  double expectedTau = concordance / std::sqrt((pairs - xTies) * (pairs - yTies));
+  double tau = voCorrelation::kendallTau(x, y, 8);
+  if (std::fabs(tau - expectedTau) > 1e-12)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with kendallTau()\n"
+              << "\tCurrent: " << tau << "\n"
+              << "\tExpected: " << expectedTau << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Use enough rows to span several tiles of the correlation matrix
+  const vtkIdType numberOfRows = 150;
+  const vtkIdType numberOfColumns = 6;
+  std::vector<double> randomData(numberOfRows * numberOfColumns);
+  unsigned int seed = 12345;
+  for (size_t i = 0; i < randomData.size(); ++i)
+    {
+    seed = seed * 1103515245u + 12345u;
+    randomData[i] = static_cast<double>((seed >> 16) % 10);
+    }
+  if (!checkThresholdedCorrelation(__LINE__, voCorrelation::Pearson, &randomData[0],
+                                   numberOfRows, numberOfColumns, 0.8) ||
+      !checkThresholdedCorrelation(__LINE__, voCorrelation::Spearman, &randomData[0],
+                                   numberOfRows, numberOfColumns, 0.8) ||
+      !checkThresholdedCorrelation(__LINE__, voCorrelation::Kendall, &randomData[0],
+                                   numberOfRows, numberOfColumns, 0.7))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,310 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryFile>
+
+// Visomics includes
+#include "voDatasetCache.h"
+#include "voDelimitedTextImportSettings.h"
+#include "voFileHash.h"
+#include "voIOManager.h"
+#include "vtkExtendedTable.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkStringArray.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool checkSameStrings(int line, const char* description, vtkStringArray* current, vtkStringArray* expected)
+{
+  if (!current || !expected || current->GetNumberOfValues() != expected->GetNumberOfValues())
+    {
+    std::cerr << "Line " << line << " - Problem with read() - " << description << " size" << std::endl;
+    return false;
+    }
+  for (vtkIdType i = 0; i < expected->GetNumberOfValues(); ++i)
+    {
+    if (current->GetValue(i) != expected->GetValue(i))
+      {
+      std::cerr << "Line " << line << " - Problem with read() - " << description << "\n"
+                << "\tIndex: " << i << "\n"
+                << "\tCurrent: " << current->GetValue(i) << "\n"
+                << "\tExpected: " << expected->GetValue(i) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool checkSameTables(int line, vtkExtendedTable* current, vtkExtendedTable* expected)
+{
+  vtkIdType numberOfRows = expected->GetNumberOfRows();
+  vtkIdType numberOfColumns = expected->GetNumberOfColumns();
+  if (current->GetNumberOfRows() != numberOfRows || current->GetNumberOfColumns() != numberOfColumns ||
+      current->GetNumberOfColumnMetaDataTypes() != expected->GetNumberOfColumnMetaDataTypes() ||
+      current->GetNumberOfRowMetaDataTypes() != expected->GetNumberOfRowMetaDataTypes() ||
+      current->GetColumnMetaDataTypeOfInterest() != expected->GetColumnMetaDataTypeOfInterest() ||
+      current->GetRowMetaDataTypeOfInterest() != expected->GetRowMetaDataTypeOfInterest())
+    {
+    std::cerr << "Line " << line << " - Problem with read() - Size or types of interest differ" << std::endl;
+    return false;
+    }
+  const double * currentData = current->GetDataBuffer();
+  const double * expectedData = expected->GetDataBuffer();
+  for (vtkIdType i = 0; i < numberOfRows * numberOfColumns; ++i)
+    {
+    if (currentData[i] != expectedData[i])
+      {
+      std::cerr << "Line " << line << " - Problem with read() - Data\n"
+                << "\tIndex: " << i << "\n"
+                << "\tCurrent: " << currentData[i] << "\n"
+                << "\tExpected: " << expectedData[i] << std::endl;
+      return false;
+      }
+    }
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    if (vtkStdString(current->GetColumnName(cid)) != vtkStdString(expected->GetColumnName(cid)))
+      {
+      std::cerr << "Line " << line << " - Problem with read() - Column name " << cid << std::endl;
+      return false;
+      }
+    }
+  for (vtkIdType id = 0; id < expected->GetNumberOfColumnMetaDataTypes(); ++id)
+    {
+    if (!checkSameStrings(line, "ColumnMetaData", current->GetColumnMetaDataAsString(id),
+                          expected->GetColumnMetaDataAsString(id)))
+      {
+      return false;
+      }
+    }
+  for (vtkIdType id = 0; id < expected->GetNumberOfRowMetaDataTypes(); ++id)
+    {
+    if (!checkSameStrings(line, "RowMetaData", current->GetRowMetaDataAsString(id),
+                          expected->GetRowMetaDataAsString(id)))
+      {
+      return false;
+      }
+    }
+  return checkSameStrings(line, "ColumnMetaDataLabels", current->GetColumnMetaDataLabels(),
+                          expected->GetColumnMetaDataLabels()) &&
+      checkSameStrings(line, "RowMetaDataLabels", current->GetRowMetaDataLabels(),
+                       expected->GetRowMetaDataLabels());
+}
+
+//-----------------------------------------------------------------------------
+bool writeFile(QFile& file, const char* content)
+{
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  file.write(content);
+  file.close();
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voDatasetCacheTest(int /*argc*/, char * /*argv*/ [])
+{
+  QDir cacheDirectory(QDir::temp().filePath("voDatasetCacheTest"));
+  voDatasetCache::setCacheDirectory(cacheDirectory.absolutePath());
+
+  QTemporaryFile sourceFile;
+  if (!sourceFile.open())
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to create temporary file" << std::endl;
+    return EXIT_FAILURE;
+    }
+  sourceFile.close();
+  if (!writeFile(sourceFile,
+                 "Name,Exp1,Exp2,Exp3\n"
+                 "Group,A,B,\"A, \"\"a\"\"\"\n"
+                 "Glucose,1,2.5,-3e2\n"
+                 "Lactate,0.1,1e-3,7\n"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(sourceFile.fileName()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  voDelimitedTextImportSettings settings;
+  settings.insert(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, 2);
+  settings.insert(voDelimitedTextImportSettings::ColumnMetaDataTypeOfInterest, 1);
+
+  //-----------------------------------------------------------------------------
+  // The first import writes the cache
+  //-----------------------------------------------------------------------------
+  QString cacheFileName = voDatasetCache::cacheFileName(sourceFile.fileName());
+  QFile::remove(cacheFileName);
+
+  vtkNew<vtkExtendedTable> importedTable;
+  if (!voIOManager::readCSVFileIntoExtendedTableUsingCache(
+        sourceFile.fileName(), importedTable.GetPointer(), settings))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with readCSVFileIntoExtendedTableUsingCache()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!QFile::exists(cacheFileName) || !cacheFileName.startsWith(cacheDirectory.absolutePath()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with readCSVFileIntoExtendedTableUsingCache() - "
+              << "Cache file " << qPrintable(cacheFileName) << " is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Reading the cache gives the imported table
+  //-----------------------------------------------------------------------------
+  QByteArray sourceHash = voFileHash::hash(sourceFile.fileName());
+  QByteArray settingsHash = voDatasetCache::settingsHash(settings);
+  vtkNew<vtkExtendedTable> cachedTable;
+  if (!voDatasetCache::read(cacheFileName, sourceHash, settingsHash, cachedTable.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkSameTables(__LINE__, cachedTable.GetPointer(), importedTable.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  if (cachedTable->GetContiguousDataBuffer() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - Shared buffer is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // The cache isn't used for other settings or another content
+  //-----------------------------------------------------------------------------
+  voDelimitedTextImportSettings otherSettings(settings);
+  otherSettings.insert(voDelimitedTextImportSettings::ColumnMetaDataTypeOfInterest, 0);
+  vtkNew<vtkExtendedTable> otherTable;
+  if (voDatasetCache::settingsHash(otherSettings) == settingsHash ||
+      voDatasetCache::read(cacheFileName, sourceHash, voDatasetCache::settingsHash(otherSettings),
+                           otherTable.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "Cache is not expected to match other settings" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!writeFile(sourceFile,
+                 "Name,Exp1,Exp2,Exp3\n"
+                 "Group,A,B,A\n"
+                 "Glucose,1,2.5,-3e2\n"
+                 "Lactate,0.1,1e-3,8\n"))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(sourceFile.fileName()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  QByteArray modifiedSourceHash = voFileHash::hash(sourceFile.fileName());
+  if (modifiedSourceHash == sourceHash ||
+      voDatasetCache::read(cacheFileName, modifiedSourceHash, settingsHash, otherTable.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "Cache is not expected to match a modified file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // The cache is updated by the next import
+  //-----------------------------------------------------------------------------
+  vtkNew<vtkExtendedTable> reimportedTable;
+  if (!voIOManager::readCSVFileIntoExtendedTableUsingCache(
+        sourceFile.fileName(), reimportedTable.GetPointer(), settings) ||
+      reimportedTable->GetValue(1, 2).ToDouble() != 8. ||
+      !voDatasetCache::read(cacheFileName, modifiedSourceHash, settingsHash, otherTable.GetPointer()) ||
+      otherTable->GetValue(1, 2).ToDouble() != 8.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with readCSVFileIntoExtendedTableUsingCache() - "
+              << "Cache is expected to be updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // A truncated cache is rejected
+  //-----------------------------------------------------------------------------
+  QFile cacheFile(cacheFileName);
+  if (!cacheFile.resize(cacheFile.size() - 1) ||
+      voDatasetCache::read(cacheFileName, modifiedSourceHash, settingsHash, otherTable.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with read() - "
+              << "Truncated cache is expected to be rejected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Least recently used cache files are removed once the maximum size is exceeded
+  //-----------------------------------------------------------------------------
+  qint64 defaultMaximumSize = voDatasetCache::maximumSize();
+  QStringList entryFileNames;
+  entryFileNames << cacheDirectory.filePath("first.vocache") << cacheDirectory.filePath("second.vocache")
+                 << cacheDirectory.filePath("third.vocache") << cacheDirectory.filePath("fourth.vocache");
+  if (!voDatasetCache::write(entryFileNames[0], modifiedSourceHash, settingsHash, reimportedTable.GetPointer()) ||
+      !voDatasetCache::write(entryFileNames[1], modifiedSourceHash, settingsHash, reimportedTable.GetPointer()) ||
+      !voDatasetCache::read(entryFileNames[0], modifiedSourceHash, settingsHash, otherTable.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with write()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  qint64 entrySize = QFileInfo(entryFileNames[0]).size();
+  voDatasetCache::setMaximumSize(2 * entrySize + entrySize / 2);
+  if (!voDatasetCache::write(entryFileNames[2], modifiedSourceHash, settingsHash, reimportedTable.GetPointer()) ||
+      QFile::exists(cacheFileName) || QFile::exists(entryFileNames[1]) ||
+      !QFile::exists(entryFileNames[0]) || !QFile::exists(entryFileNames[2]))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with write() - "
+              << "Least recently used cache files are expected to be removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  voDatasetCache::setMaximumSize(entrySize - 1);
+  if (voDatasetCache::write(entryFileNames[3], modifiedSourceHash, settingsHash, reimportedTable.GetPointer()) ||
+      QFile::exists(entryFileNames[3]))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with write() - "
+              << "Datasets larger than the maximum size are not expected to be cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+  voDatasetCache::setMaximumSize(defaultMaximumSize);
+
+  foreach(const QString& entryFileName, entryFileNames)
+    {
+    QFile::remove(entryFileName);
+    }
+  QFile::remove(cacheFileName);
+  QFile::remove(cacheDirectory.filePath("usage.txt"));
+  cacheDirectory.rmdir(cacheDirectory.absolutePath());
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QByteArray>
+#include <QTemporaryFile>
+
+// Visomics includes
+#include "voDelimitedTextImportSettings.h"
+#include "voDelimitedTextParser.h"
+#include "voIOManager.h"
+#include "vtkExtendedTable.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool parse(int line, const char* text, const voDelimitedTextImportSettings& settings, vtkExtendedTable* table)
+{
+  if (!voDelimitedTextParser::parse(text, static_cast<vtkIdType>(strlen(text)), settings, table))
+    {
+    std::cerr << "Line " << line << " - Problem with parse()" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// \a expected is the row-major numberOfRows x numberOfColumns data matrix
+bool checkData(int line, vtkExtendedTable* table, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+               const double* expected)
+{
+  const double * data = table->GetDataBuffer();
+  if (table->GetNumberOfRows() != numberOfRows || table->GetNumberOfColumns() != numberOfColumns || !data)
+    {
+    std::cerr << "Line " << line << " - Problem with parse() - Data size\n"
+              << "\tCurrent: " << table->GetNumberOfRows() << " x " << table->GetNumberOfColumns() << "\n"
+              << "\tExpected: " << numberOfRows << " x " << numberOfColumns << std::endl;
+    return false;
+    }
+  for (vtkIdType r = 0; r < numberOfRows; ++r)
+    {
+    for (vtkIdType c = 0; c < numberOfColumns; ++c)
+      {
+      if (data[c * numberOfRows + r] != expected[r * numberOfColumns + c])
+        {
+        std::cerr << "Line " << line << " - Problem with parse() - Data\n"
+                  << "\tRow: " << r << " Column: " << c << "\n"
+                  << "\tCurrent: " << data[c * numberOfRows + r] << "\n"
+                  << "\tExpected: " << expected[r * numberOfColumns + c] << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool checkStrings(int line, const char* description, vtkStringArray* array,
+                  vtkIdType count, const char* const* expected)
+{
+  if (!array || array->GetNumberOfValues() != count)
+    {
+    std::cerr << "Line " << line << " - Problem with parse() - " << description << " size\n"
+              << "\tCurrent: " << (array ? array->GetNumberOfValues() : -1) << "\n"
+              << "\tExpected: " << count << std::endl;
+    return false;
+    }
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    if (array->GetValue(i) != expected[i])
+      {
+      std::cerr << "Line " << line << " - Problem with parse() - " << description << "\n"
+                << "\tIndex: " << i << "\n"
+                << "\tCurrent: [" << array->GetValue(i) << "]\n"
+                << "\tExpected: [" << expected[i] << "]" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool checkSameTables(int line, vtkExtendedTable* current, vtkExtendedTable* expected)
+{
+  vtkIdType numberOfRows = expected->GetNumberOfRows();
+  vtkIdType numberOfColumns = expected->GetNumberOfColumns();
+  if (current->GetNumberOfRows() != numberOfRows || current->GetNumberOfColumns() != numberOfColumns ||
+      current->GetNumberOfColumnMetaDataTypes() != expected->GetNumberOfColumnMetaDataTypes() ||
+      current->GetNumberOfRowMetaDataTypes() != expected->GetNumberOfRowMetaDataTypes())
+    {
+    std::cerr << "Line " << line << " - Problem with readCSVFileIntoExtendedTable() - "
+              << "Size differs from fillExtendedTable()" << std::endl;
+    return false;
+    }
+  const double * currentData = current->GetDataBuffer();
+  const double * expectedData = expected->GetDataBuffer();
+  for (vtkIdType i = 0; i < numberOfRows * numberOfColumns; ++i)
+    {
+    if (currentData[i] != expectedData[i])
+      {
+      std::cerr << "Line " << line << " - Problem with readCSVFileIntoExtendedTable()\n"
+                << "\tIndex: " << i << "\n"
+                << "\tCurrent: " << currentData[i] << "\n"
+                << "\tExpected: " << expectedData[i] << std::endl;
+      return false;
+      }
+    }
+  for (vtkIdType id = 0; id < expected->GetNumberOfColumnMetaDataTypes(); ++id)
+    {
+    vtkStringArray * currentMetaData = current->GetColumnMetaDataAsString(id);
+    vtkStringArray * expectedMetaData = expected->GetColumnMetaDataAsString(id);
+    for (vtkIdType i = 0; i < expectedMetaData->GetNumberOfValues(); ++i)
+      {
+      if (currentMetaData->GetValue(i) != expectedMetaData->GetValue(i))
+        {
+        std::cerr << "Line " << line << " - Problem with readCSVFileIntoExtendedTable() - "
+                  << "Column metadata " << id << " differs at index " << i << std::endl;
+        return false;
+        }
+      }
+    }
+  for (vtkIdType id = 0; id < expected->GetNumberOfRowMetaDataTypes(); ++id)
+    {
+    vtkStringArray * currentMetaData = current->GetRowMetaDataAsString(id);
+    vtkStringArray * expectedMetaData = expected->GetRowMetaDataAsString(id);
+    for (vtkIdType i = 0; i < expectedMetaData->GetNumberOfValues(); ++i)
+      {
+      if (currentMetaData->GetValue(i) != expectedMetaData->GetValue(i))
+        {
+        std::cerr << "Line " << line << " - Problem with readCSVFileIntoExtendedTable() - "
+                  << "Row metadata " << id << " differs at index " << i << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voDelimitedTextParserTest(int /*argc*/, char * /*argv*/ [])
+{
+  //-----------------------------------------------------------------------------
+  // Two column metadata types (rows) and one row metadata type (column)
+  //-----------------------------------------------------------------------------
+  voDelimitedTextImportSettings settings;
+  settings.insert(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, 2);
+
+  const char text[] =
+      "Name,Exp1,Exp2,Exp3\n"
+      "Group,A,B,A\n"
+      "Glucose,1,2.5,-3e2\n"
+      "Lactate,0.1,1e-3,  7 \n";
+  vtkNew<vtkExtendedTable> table;
+  if (!parse(__LINE__, text, settings, table.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  const double expectedData[] = {
+    1., 2.5, -300.,
+    0.1, 0.001, 7.
+  };
+  const char * const expectedNames[] = {"Exp1", "Exp2", "Exp3"};
+  const char * const expectedGroups[] = {"A", "B", "A"};
+  const char * const expectedAnalytes[] = {"Glucose", "Lactate"};
+  const char * const expectedColumnLabels[] = {"Name", "Group"};
+  const char * const expectedRowLabels[] = {"Name"};
+  if (!checkData(__LINE__, table.GetPointer(), 2, 3, expectedData) ||
+      !checkStrings(__LINE__, "ColumnMetaData", table->GetColumnMetaDataAsString(0), 3, expectedNames) ||
+      !checkStrings(__LINE__, "ColumnMetaData", table->GetColumnMetaDataAsString(1), 3, expectedGroups) ||
+      !checkStrings(__LINE__, "RowMetaData", table->GetRowMetaDataAsString(0), 2, expectedAnalytes) ||
+      !checkStrings(__LINE__, "ColumnMetaDataLabels", table->GetColumnMetaDataLabels(), 2, expectedColumnLabels) ||
+      !checkStrings(__LINE__, "RowMetaDataLabels", table->GetRowMetaDataLabels(), 1, expectedRowLabels))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Transposed text gives the same table
+  //-----------------------------------------------------------------------------
+  voDelimitedTextImportSettings transposeSettings(settings);
+  transposeSettings.insert(voDelimitedTextImportSettings::Transpose, true);
+
+  const char transposedText[] =
+      "Name,Group,Glucose,Lactate\r\n"
+      "Exp1,A,1,0.1\r\n"
+      "\r\n"
+      "Exp2,B,2.5,1e-3\r\n"
+      "Exp3,A,-3e2,7";
+  vtkNew<vtkExtendedTable> transposedTable;
+  if (!parse(__LINE__, transposedText, transposeSettings, transposedTable.GetPointer()) ||
+      !checkData(__LINE__, transposedTable.GetPointer(), 2, 3, expectedData) ||
+      !checkStrings(__LINE__, "ColumnMetaData", transposedTable->GetColumnMetaDataAsString(0), 3, expectedNames) ||
+      !checkStrings(__LINE__, "ColumnMetaData", transposedTable->GetColumnMetaDataAsString(1), 3, expectedGroups) ||
+      !checkStrings(__LINE__, "RowMetaData", transposedTable->GetRowMetaDataAsString(0), 2, expectedAnalytes))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Quoted strings, merged delimiters, non numerical and missing values
+  //-----------------------------------------------------------------------------
+  voDelimitedTextImportSettings quoteSettings;
+  quoteSettings.insert(voDelimitedTextImportSettings::FieldDelimiterCharacters, QString(";\t"));
+  quoteSettings.insert(voDelimitedTextImportSettings::MergeConsecutiveDelimiters, true);
+
+  const char quotedText[] =
+      "ID;\"Sample; \"\"1\"\"\"\t\t\"Sample\n2\"\n"
+      "\"Alanine\";\"4.25\";NA\n"
+      "Leucine;;;-0.5\n";
+  vtkNew<vtkExtendedTable> quotedTable;
+  if (!parse(__LINE__, quotedText, quoteSettings, quotedTable.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  const double expectedQuotedData[] = {
+    4.25, 0.,
+    -0.5, 0.
+  };
+  const char * const expectedQuotedNames[] = {"Sample; \"1\"", "Sample\n2"};
+  const char * const expectedQuotedAnalytes[] = {"Alanine", "Leucine"};
+  if (!checkData(__LINE__, quotedTable.GetPointer(), 2, 2, expectedQuotedData) ||
+      !checkStrings(__LINE__, "ColumnMetaData", quotedTable->GetColumnMetaDataAsString(0), 2, expectedQuotedNames) ||
+      !checkStrings(__LINE__, "RowMetaData", quotedTable->GetRowMetaDataAsString(0), 2, expectedQuotedAnalytes))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Numbers outside of the fast path are converted exactly
+  //-----------------------------------------------------------------------------
+  voDelimitedTextImportSettings numberSettings;
+  numberSettings.insert(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, 0);
+  numberSettings.insert(voDelimitedTextImportSettings::NumberOfRowMetaDataTypes, 0);
+
+  const char numberText[] =
+      "0.1,123456789012345678901,1e-300,-2.5E+3,9007199254740993,+.5,1.7976931348623157e308\n";
+  vtkNew<vtkExtendedTable> numberTable;
+  const double expectedNumbers[] = {
+    0.1, 123456789012345678901., 1e-300, -2.5e3, 9007199254740993., 0.5, 1.7976931348623157e308
+  };
+  if (!parse(__LINE__, numberText, numberSettings, numberTable.GetPointer()) ||
+      !checkData(__LINE__, numberTable.GetPointer(), 1, 7, expectedNumbers))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Not enough rows for the metadata
+  //-----------------------------------------------------------------------------
+  vtkNew<vtkExtendedTable> invalidTable;
+  settings.insert(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, 5);
+  if (voDelimitedTextParser::parse(text, static_cast<vtkIdType>(strlen(text)), settings,
+                                   invalidTable.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with parse() - "
+              << "Failure is expected if the metadata don't fit" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // readCSVFileIntoExtendedTable() matches readCSVFileIntoTable() followed by fillExtendedTable()
+  //-----------------------------------------------------------------------------
+  QTemporaryFile file;
+  if (!file.open())
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to create temporary file" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string fileText = "Name,Group";
+  for (int r = 0; r < 500; ++r)
+    {
+    fileText += ",Analyte" + std::string(1, static_cast<char>('A' + r % 26));
+    }
+  for (int c = 0; c < 40; ++c)
+    {
+    fileText += "\n\"Exp " + std::string(1, static_cast<char>('a' + c % 26)) + "\"," + (c % 2 ? "A" : "B");
+    for (int r = 0; r < 500; ++r)
+      {
+      double value = (r * 37 + c * 11) % 101 / 8.;
+      fileText += "," + std::string(QByteArray::number(value).constData());
+      }
+    }
+  file.write(fileText.c_str(), static_cast<qint64>(fileText.size()));
+  file.close();
+
+  voDelimitedTextImportSettings fileSettings;
+  fileSettings.insert(voDelimitedTextImportSettings::Transpose, true);
+  fileSettings.insert(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, 2);
+
+  vtkNew<vtkTable> stringTable;
+  vtkNew<vtkExtendedTable> expectedTable;
+  voIOManager::readCSVFileIntoTable(file.fileName(), stringTable.GetPointer(), fileSettings);
+  voIOManager::fillExtendedTable(stringTable.GetPointer(), expectedTable.GetPointer(), fileSettings);
+
+  vtkNew<vtkExtendedTable> fileTable;
+  if (!voIOManager::readCSVFileIntoExtendedTable(file.fileName(), fileTable.GetPointer(), fileSettings))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with readCSVFileIntoExtendedTable()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkSameTables(__LINE__, fileTable.GetPointer(), expectedTable.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
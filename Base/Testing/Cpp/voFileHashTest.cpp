@@ -0,0 +1,132 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QTemporaryFile>
+
+// Visomics includes
+#include "voFileHash.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool writeFile(QFile& file, const QByteArray& content)
+{
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  bool success = file.write(content) == content.size();
+  file.close();
+  return success;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voFileHashTest(int /*argc*/, char * /*argv*/ [])
+{
+  QTemporaryFile file;
+  if (!file.open())
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to create temporary file" << std::endl;
+    return EXIT_FAILURE;
+    }
+  file.close();
+
+  // Content spanning several blocks, the last one being partial
+  QByteArray content;
+  for (int i = 0; i < 300000; ++i)
+    {
+    content.append(QByteArray::number(i)).append(',');
+    }
+  if (!writeFile(file, content))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(file.fileName()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Hashing by blocks gives the hash of the whole content
+  //-----------------------------------------------------------------------------
+  QByteArray expectedHash = QCryptographicHash::hash(content, QCryptographicHash::Md5);
+  if (voFileHash::hash(file.fileName()) != expectedHash)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with hash()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!voFileHash::hash(file.fileName() + ".missing").isEmpty() ||
+      !voFileHash::cachedHash(file.fileName() + ".missing").isEmpty())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with hash() - "
+              << "Empty hash is expected for a missing file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Cached hashes follow the modifications of the file
+  //-----------------------------------------------------------------------------
+  if (voFileHash::cachedHash(file.fileName()) != expectedHash ||
+      voFileHash::cachedHash(file.fileName()) != expectedHash)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with cachedHash()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  content.append("300000");
+  if (!writeFile(file, content))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(file.fileName()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  expectedHash = QCryptographicHash::hash(content, QCryptographicHash::Md5);
+  if (voFileHash::cachedHash(file.fileName()) != expectedHash)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with cachedHash() - "
+              << "Hash is expected to be updated with the file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Same size, written right after: the modification time can't tell it apart
+  content[0] = '9';
+  if (!writeFile(file, content))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << qPrintable(file.fileName()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  expectedHash = QCryptographicHash::hash(content, QCryptographicHash::Md5);
+  if (voFileHash::cachedHash(file.fileName()) != expectedHash)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with cachedHash() - "
+              << "Recently modified files are expected to be hashed again" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  voFileHash::clearCache();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,353 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Visomics includes
+#include "voLinearAlgebra.h"
+
+// Qt includes
+#include <QString>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool checkValue(int line, const char* function, double current, double expected, double tolerance)
+{
+  if (std::fabs(current - expected) <= tolerance)
+    {
+    return true;
+    }
+  std::cerr << "Line " << line << " - Problem with " << function << "\n"
+            << "\tCurrent: " << current << "\n"
+            << "\tExpected: " << expected << std::endl;
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+double dot(const double* x, const double* y, vtkIdType count)
+{
+  double sum = 0.;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    sum += x[i] * y[i];
+    }
+  return sum;
+}
+
+//-----------------------------------------------------------------------------
+bool checkValues(int line, const char* function, const std::vector<double>& current,
+                 const std::vector<double>& expected, double tolerance)
+{
+  if (current.size() != expected.size())
+    {
+    std::cerr << "Line " << line << " - Problem with " << function << "\n"
+              << "\tCurrent size: " << current.size() << "\n"
+              << "\tExpected size: " << expected.size() << std::endl;
+    return false;
+    }
+  for (size_t i = 0; i < current.size(); ++i)
+    {
+    if (!checkValue(line, function, current[i], expected[i], tolerance))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voLinearAlgebraTest(int /*argc*/, char * /*argv*/ [])
+{
+  // Eigenvalues of a symmetric matrix
+  const double matrix[] = {
+    2., 1., 0.,
+    1., 2., 0.,
+    0., 0., 5.};
+  double eigenvalues[3];
+  double eigenvectors[9];
+  voLinearAlgebra::symmetricEigenDecomposition(matrix, 3, eigenvalues, eigenvectors);
+  if (!checkValue(__LINE__, "symmetricEigenDecomposition()", eigenvalues[0], 5., 1e-12) ||
+      !checkValue(__LINE__, "symmetricEigenDecomposition()", eigenvalues[1], 3., 1e-12) ||
+      !checkValue(__LINE__, "symmetricEigenDecomposition()", eigenvalues[2], 1., 1e-12) ||
+      !checkValue(__LINE__, "symmetricEigenDecomposition()", std::fabs(eigenvectors[2]), 1., 1e-12) ||
+      !checkValue(__LINE__, "symmetricEigenDecomposition()",
+                  std::fabs(eigenvectors[3] * eigenvectors[4]), 0.5, 1e-12))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // 3 observations of 2 variables along the diagonal: (-1, -1), (0, 0) and (1, 1)
+  const double diagonal[] = {-1., -1., 0., 0., 1., 1.};
+  voLinearAlgebra::PCAResult result;
+  if (!voLinearAlgebra::truncatedPCA(diagonal, 2, 3, 5, result) ||
+      result.StandardDeviations.size() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with truncatedPCA()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkValue(__LINE__, "truncatedPCA()", result.StandardDeviations[0], std::sqrt(2.), 1e-12) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.StandardDeviations[1], 0., 1e-7) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.TotalVariance, 2., 1e-12) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.Rotation[0], std::sqrt(0.5), 1e-12) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.Rotation[1], std::sqrt(0.5), 1e-12) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.Projection[0], -std::sqrt(2.), 1e-12) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.Projection[2], std::sqrt(2.), 1e-12))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Wide matrix with a decreasing spectrum: the randomized decomposition of the first
+  // components must match the exact decomposition.
+  const vtkIdType numberOfRows = 500;
+  const vtkIdType numberOfColumns = 60;
+  std::vector<double> data(numberOfRows * numberOfColumns);
+  unsigned int seed = 12345;
+  for (size_t i = 0; i < data.size(); ++i)
+    {
+    seed = seed * 1103515245u + 12345u;
+    data[i] = 0.01 * static_cast<double>(seed >> 8) / (1 << 24) + 1000.;
+    }
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      data[c * numberOfRows + r] += 8. * std::sin(0.3 * c) * std::cos(0.01 * r) +
+                                    4. * std::cos(0.7 * c) * std::sin(0.05 * r) +
+                                    2. * std::sin(1.3 * c + 1.) * std::cos(0.2 * r);
+      }
+    }
+  voLinearAlgebra::PCAResult exactResult;
+  if (!voLinearAlgebra::truncatedPCA(&data[0], numberOfRows, numberOfColumns, 3, result) ||
+      !voLinearAlgebra::truncatedPCA(&data[0], numberOfRows, numberOfColumns, 60, exactResult) ||
+      result.StandardDeviations.size() != 3 || exactResult.StandardDeviations.size() != 60)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with truncatedPCA()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  double sumOfVariances = 0.;
+  for (int c = 0; c < 60; ++c)
+    {
+    sumOfVariances += exactResult.StandardDeviations[c] * exactResult.StandardDeviations[c];
+    }
+  if (!checkValue(__LINE__, "truncatedPCA()", sumOfVariances, exactResult.TotalVariance,
+                  1e-9 * exactResult.TotalVariance) ||
+      !checkValue(__LINE__, "truncatedPCA()", result.TotalVariance, exactResult.TotalVariance, 1e-9))
+    {
+    return EXIT_FAILURE;
+    }
+  for (int c = 0; c < 3; ++c)
+    {
+    const double* rotation = &result.Rotation[c * numberOfRows];
+    const double* exactRotation = &exactResult.Rotation[c * numberOfRows];
+    // Projection = centered data x rotation, its variance is the component variance
+    double mean = 0.;
+    double sumOfSquares = 0.;
+    for (vtkIdType j = 0; j < numberOfColumns; ++j)
+      {
+      mean += result.Projection[c * numberOfColumns + j] / numberOfColumns;
+      }
+    for (vtkIdType j = 0; j < numberOfColumns; ++j)
+      {
+      double deviation = result.Projection[c * numberOfColumns + j] - mean;
+      sumOfSquares += deviation * deviation;
+      }
+    if (!checkValue(__LINE__, "truncatedPCA()", result.StandardDeviations[c],
+                    exactResult.StandardDeviations[c], 1e-8 * exactResult.StandardDeviations[c]) ||
+        !checkValue(__LINE__, "truncatedPCA()", dot(rotation, exactRotation, numberOfRows), 1., 1e-8) ||
+        !checkValue(__LINE__, "truncatedPCA()", dot(rotation, rotation, numberOfRows), 1., 1e-12) ||
+        !checkValue(__LINE__, "truncatedPCA()", std::sqrt(sumOfSquares / (numberOfColumns - 1)),
+                    result.StandardDeviations[c], 1e-8 * result.StandardDeviations[c]))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+
+  // Partial least squares: 8 observations (rows) of 3 predictors, 2 responses and y = 2 x + 3
+  const vtkIdType numberOfObservations = 8;
+  std::vector<double> plsData(numberOfObservations * 6);
+  double responseMean = 0.;
+  for (vtkIdType i = 0; i < numberOfObservations; ++i)
+    {
+    double x1 = static_cast<double>(i);
+    double x2 = std::sin(1. + i);
+    double x3 = 0.1 * i * i;
+    plsData[0 * numberOfObservations + i] = x1;
+    plsData[1 * numberOfObservations + i] = x2;
+    plsData[2 * numberOfObservations + i] = x3;
+    plsData[3 * numberOfObservations + i] = 2. * x1 - x2 + 0.5 * x3 + 0.1 * std::cos(3. * i);
+    plsData[4 * numberOfObservations + i] = x2 + x3;
+    plsData[5 * numberOfObservations + i] = 2. * x1 + 3.;
+    responseMean += (2. * x1 + 3.) / numberOfObservations;
+    }
+  double responseSumOfSquares = 0.;
+  for (vtkIdType i = 0; i < numberOfObservations; ++i)
+    {
+    double deviation = plsData[5 * numberOfObservations + i] - responseMean;
+    responseSumOfSquares += deviation * deviation;
+    }
+  double responseDeviation = std::sqrt(responseSumOfSquares / numberOfObservations);
+
+  voLinearAlgebra::PLSAlgorithm algorithm;
+  if (!voLinearAlgebra::plsAlgorithmFromString("widekernelpls", algorithm) ||
+      algorithm != voLinearAlgebra::WideKernelPLS ||
+      voLinearAlgebra::plsAlgorithmFromString("nipals", algorithm))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with plsAlgorithmFromString()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A single exact predictor: one component explains everything. With leave-one-out
+  // cross-validation, the error of the mean is scaled by n / (n - 1).
+  std::vector<vtkIdType> predictors(1, 0);
+  std::vector<vtkIdType> responses(1, 5);
+  voLinearAlgebra::PLSResult plsResult;
+  if (!voLinearAlgebra::partialLeastSquares(&plsData[0], numberOfObservations, 6, predictors, responses,
+                                            5, voLinearAlgebra::KernelPLS, 0, plsResult) ||
+      plsResult.NumberOfComponents != 1 || plsResult.RMSEP.size() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with partialLeastSquares()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkValue(__LINE__, "partialLeastSquares()", plsResult.LoadingWeights[0], 1., 1e-12) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.Loadings[0], 1., 1e-12) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.YLoadings[0], 2., 1e-12) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.Scores[0], -3.5, 1e-12) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.RMSEP[0], responseDeviation, 1e-12) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.RMSEP[1], 0., 1e-12))
+    {
+    return EXIT_FAILURE;
+    }
+  if (!voLinearAlgebra::partialLeastSquares(&plsData[0], numberOfObservations, 6, predictors, responses,
+                                            1, voLinearAlgebra::KernelPLS, 100, plsResult) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.RMSEP[0],
+                  responseDeviation * numberOfObservations / (numberOfObservations - 1.), 1e-12) ||
+      !checkValue(__LINE__, "partialLeastSquares()", plsResult.RMSEP[1], 0., 1e-12))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // All the algorithms compute the same model of a single response, SIMPLS scores being normalized.
+  // Kernel, wide kernel and orthogonal scores algorithms also agree with several responses.
+  predictors.clear();
+  predictors.push_back(0);
+  predictors.push_back(1);
+  predictors.push_back(2);
+  const voLinearAlgebra::PLSAlgorithm algorithms[] = {
+    voLinearAlgebra::KernelPLS, voLinearAlgebra::WideKernelPLS,
+    voLinearAlgebra::OrthogonalScoresPLS, voLinearAlgebra::SIMPLS};
+  for (int numberOfResponses = 1; numberOfResponses <= 2; ++numberOfResponses)
+    {
+    responses.clear();
+    responses.push_back(3);
+    if (numberOfResponses == 2)
+      {
+      responses.push_back(4);
+      }
+    voLinearAlgebra::PLSResult reference;
+    voLinearAlgebra::PLSResult crossValidationReference;
+    for (int a = 0; a < 4; ++a)
+      {
+      voLinearAlgebra::PLSResult crossValidationResult;
+      if (!voLinearAlgebra::partialLeastSquares(&plsData[0], numberOfObservations, 6, predictors, responses,
+                                                10, algorithms[a], 0, plsResult) ||
+          !voLinearAlgebra::partialLeastSquares(&plsData[0], numberOfObservations, 6, predictors, responses,
+                                                10, algorithms[a], 3, crossValidationResult) ||
+          plsResult.NumberOfComponents != 3 || crossValidationResult.NumberOfComponents != 3)
+        {
+        std::cerr << "Line " << __LINE__ << " - Problem with partialLeastSquares()" << std::endl;
+        return EXIT_FAILURE;
+        }
+      // Orthogonal scores
+      for (int c1 = 0; c1 < 3; ++c1)
+        {
+        for (int c2 = 0; c2 < c1; ++c2)
+          {
+          if (!checkValue(__LINE__, "partialLeastSquares()",
+                          dot(&plsResult.Scores[c1 * numberOfObservations],
+                              &plsResult.Scores[c2 * numberOfObservations], numberOfObservations), 0., 1e-9))
+            {
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      if (a == 0)
+        {
+        reference = plsResult;
+        crossValidationReference = crossValidationResult;
+        continue;
+        }
+      // Three components span the predictors: all the algorithms end with the least squares fit
+      for (int c = 0; c < numberOfResponses; ++c)
+        {
+        if (!checkValue(__LINE__, "partialLeastSquares()", plsResult.RMSEP[c * 4 + 3],
+                        reference.RMSEP[c * 4 + 3], 1e-9))
+          {
+          return EXIT_FAILURE;
+          }
+        }
+      if (algorithms[a] != voLinearAlgebra::SIMPLS)
+        {
+        if (!checkValues(__LINE__, "partialLeastSquares()", plsResult.Scores, reference.Scores, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", plsResult.YScores, reference.YScores, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", plsResult.Loadings, reference.Loadings, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", plsResult.LoadingWeights,
+                         reference.LoadingWeights, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", plsResult.YLoadings, reference.YLoadings, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", plsResult.RMSEP, reference.RMSEP, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", crossValidationResult.RMSEP,
+                         crossValidationReference.RMSEP, 1e-7))
+          {
+          return EXIT_FAILURE;
+          }
+        }
+      else if (numberOfResponses == 1)
+        {
+        for (int c = 0; c < 3; ++c)
+          {
+          const double* scores = &plsResult.Scores[c * numberOfObservations];
+          const double* referenceScores = &reference.Scores[c * numberOfObservations];
+          if (!checkValue(__LINE__, "partialLeastSquares()",
+                          dot(scores, referenceScores, numberOfObservations),
+                          std::sqrt(dot(referenceScores, referenceScores, numberOfObservations)), 1e-9))
+            {
+            return EXIT_FAILURE;
+            }
+          }
+        if (!checkValues(__LINE__, "partialLeastSquares()", plsResult.RMSEP, reference.RMSEP, 1e-9) ||
+            !checkValues(__LINE__, "partialLeastSquares()", crossValidationResult.RMSEP,
+                         crossValidationReference.RMSEP, 1e-7))
+          {
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
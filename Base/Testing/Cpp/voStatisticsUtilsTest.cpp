@@ -0,0 +1,359 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QString>
+
+// Visomics includes
+#include "voStatisticsUtils.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool checkValue(int line, const char* function, double current, double expected, double tolerance)
+{
+  if (vtkMath::IsNan(expected) && vtkMath::IsNan(current))
+    {
+    return true;
+    }
+  if (!(std::fabs(current - expected) <= tolerance))
+    {
+    std::cerr << "Line " << line << " - Problem with " << function << "\n"
+              << "\tCurrent: " << current << "\n"
+              << "\tExpected: " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool checkAdjustment(int line, voStatisticsUtils::PValueAdjustment adjustment,
+                     const double* pValues, const double* expectedPValues, vtkIdType count)
+{
+  std::vector<double> adjustedPValues(pValues, pValues + count);
+  for (int inPlace = 0; inPlace < 2; ++inPlace)
+    {
+    voStatisticsUtils::adjustPValues(pValues, count, adjustment, &adjustedPValues[0]);
+    if (inPlace)
+      {
+      adjustedPValues.assign(pValues, pValues + count);
+      voStatisticsUtils::adjustPValues(&adjustedPValues[0], count, adjustment, &adjustedPValues[0]);
+      }
+    for (vtkIdType i = 0; i < count; ++i)
+      {
+      if (!checkValue(line, "adjustPValues()", adjustedPValues[i], expectedPValues[i], 1e-15))
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool checkDiagnostics(int line, const char* function, int current, int expected)
+{
+  if (current != expected)
+    {
+    std::cerr << "Line " << line << " - Problem with " << function << " diagnostics\n"
+              << "\tCurrent: " << current << "\n"
+              << "\tExpected: " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int voStatisticsUtilsTest(int /*argc*/, char * /*argv*/ [])
+{
+  // logGamma
+  if (!checkValue(__LINE__, "logGamma()", voStatisticsUtils::logGamma(1.), 0., 1e-14) ||
+      !checkValue(__LINE__, "logGamma()", voStatisticsUtils::logGamma(0.5),
+                  0.5 * std::log(vtkMath::Pi()), 1e-14) ||
+      !checkValue(__LINE__, "logGamma()", voStatisticsUtils::logGamma(10.), std::log(362880.), 1e-12) ||
+      !checkValue(__LINE__, "logGamma()", voStatisticsUtils::logGamma(0.1),
+                  voStatisticsUtils::logGamma(1.1) - std::log(0.1), 1e-13))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // studentTCDF: closed forms exist for 1 (Cauchy) and 2 degrees of freedom
+  const double ts[] = {-1e6, -35., -4., -1.5, -0.1, 0., 0.3, 2., 12.7};
+  for (size_t i = 0; i < sizeof(ts) / sizeof(ts[0]); ++i)
+    {
+    double t = ts[i];
+    double expected1 = 0.5 + std::atan(t) / vtkMath::Pi();
+    double expected2 = 0.5 + t / (2. * std::sqrt(2. + t * t));
+    if (!checkValue(__LINE__, "studentTCDF()", voStatisticsUtils::studentTCDF(t, 1.),
+                    expected1, 1e-12 * std::max(1e-3, expected1)) ||
+        !checkValue(__LINE__, "studentTCDF()", voStatisticsUtils::studentTCDF(t, 2.),
+                    expected2, 1e-12 * std::max(1e-3, expected2)))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  // Expected values have been computed using R: pt(t, df)
+  if (!checkValue(__LINE__, "studentTCDF()", voStatisticsUtils::studentTCDF(2.228139, 10.), 0.975, 1e-7) ||
+      !checkValue(__LINE__, "studentTCDF()", voStatisticsUtils::studentTCDF(-2.570582, 5.), 0.025, 1e-7) ||
+      !checkValue(__LINE__, "studentTCDF()", voStatisticsUtils::studentTCDF(1.959964, 1e7), 0.975, 1e-7) ||
+      !checkValue(__LINE__, "studentTCDF()", voStatisticsUtils::studentTCDF(vtkMath::Nan(), 3.),
+                  vtkMath::Nan(), 0.))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // fisherFCDF: closed form for (2, 2) degrees of freedom, F(1, df) is the square of T(df)
+  const double fs[] = {0., 1e-6, 0.3, 1., 4.5, 1e3};
+  for (size_t i = 0; i < sizeof(fs) / sizeof(fs[0]); ++i)
+    {
+    double f = fs[i];
+    if (!checkValue(__LINE__, "fisherFCDF()", voStatisticsUtils::fisherFCDF(f, 2., 2.), f / (1. + f), 1e-13) ||
+        !checkValue(__LINE__, "fisherFCDF()", voStatisticsUtils::fisherFCDF(f, 1., 7.),
+                    1. - 2. * voStatisticsUtils::studentTCDF(-std::sqrt(f), 7.), 1e-13))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // adjustPValues: expected values have been computed using R: p.adjust(pValues, method)
+  const double nan = vtkMath::Nan();
+  const double pValuesToAdjust[] = {0.04, 0.01, nan, 0.03, 0.005, 0.5};
+  const double bonferroniPValues[] = {0.2, 0.05, nan, 0.15, 0.025, 1.};
+  const double holmPValues[] = {0.09, 0.04, nan, 0.09, 0.025, 0.5};
+  const double benjaminiHochbergPValues[] = {0.05, 0.025, nan, 0.05, 0.025, 0.5};
+  voStatisticsUtils::PValueAdjustment adjustment;
+  if (!checkAdjustment(__LINE__, voStatisticsUtils::NoAdjustment, pValuesToAdjust, pValuesToAdjust, 6) ||
+      !checkAdjustment(__LINE__, voStatisticsUtils::Bonferroni, pValuesToAdjust, bonferroniPValues, 6) ||
+      !checkAdjustment(__LINE__, voStatisticsUtils::Holm, pValuesToAdjust, holmPValues, 6) ||
+      !checkAdjustment(__LINE__, voStatisticsUtils::BenjaminiHochberg, pValuesToAdjust,
+                       benjaminiHochbergPValues, 6))
+    {
+    return EXIT_FAILURE;
+    }
+  if (!voStatisticsUtils::adjustmentFromString("Benjamini-Hochberg", adjustment) ||
+      adjustment != voStatisticsUtils::BenjaminiHochberg ||
+      voStatisticsUtils::adjustmentFromString("fdr", adjustment))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with adjustmentFromString()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // tTest: R's "sleep" data set, 10 experiments per group
+  const vtkIdType numberOfRows = 5;
+  const vtkIdType numberOfColumns = 20;
+  const double sleep[] = {
+    0.7, -1.6, -0.2, -1.2, -0.1, 3.4, 3.7, 0.8, 0.0, 2.0,
+    1.9, 0.8, 1.1, 0.1, -0.1, 4.4, 5.5, 1.6, 4.6, 3.4};
+  std::vector<double> data(numberOfRows * numberOfColumns);
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    // Row 0: sleep data
+    data[c * numberOfRows + 0] = sleep[c];
+    // Row 1: constant data
+    data[c * numberOfRows + 1] = 5.;
+    // Row 2: sleep data with missing values in the first and last experiments
+    data[c * numberOfRows + 2] = (c == 0 || c == numberOfColumns - 1) ? nan : sleep[c];
+    // Row 3: a single observation in group 1
+    data[c * numberOfRows + 3] = (c == 0 || c >= 10) ? sleep[c] : nan;
+    // Row 4: negative means
+    data[c * numberOfRows + 4] = -1. - c;
+    }
+  std::vector<vtkIdType> sample1Columns;
+  std::vector<vtkIdType> sample2Columns;
+  std::vector<vtkIdType> sample1ColumnsWithoutNaN;
+  std::vector<vtkIdType> sample2ColumnsWithoutNaN;
+  for (vtkIdType c = 0; c < 10; ++c)
+    {
+    sample1Columns.push_back(c);
+    sample2Columns.push_back(c + 10);
+    if (c != 0)
+      {
+      sample1ColumnsWithoutNaN.push_back(c);
+      }
+    if (c != 9)
+      {
+      sample2ColumnsWithoutNaN.push_back(c + 10);
+      }
+    }
+
+  // Expected values have been computed using R: t.test(extra ~ group, data = sleep, var.equal=...)
+  std::vector<double> pValues(numberOfRows);
+  int diagnostics = -1;
+  if (!voStatisticsUtils::tTest(&data[0], numberOfRows, numberOfColumns, sample1Columns, sample2Columns,
+                                /* equalVariance= */ false, &pValues[0], &diagnostics))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with tTest()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkValue(__LINE__, "tTest()", pValues[0], 0.07939414, 1e-7) ||
+      !checkValue(__LINE__, "tTest()", pValues[1], 1., 0.) ||
+      !checkValue(__LINE__, "tTest()", pValues[3], nan, 0.) ||
+      !checkValue(__LINE__, "tTest()", pValues[4], 0., 1e-5) ||
+      !checkDiagnostics(__LINE__, "tTest()", diagnostics,
+                        voStatisticsUtils::ConstantData | voStatisticsUtils::InvalidData))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Missing values are ignored
+  std::vector<double> pValuesWithoutNaN(numberOfRows);
+  voStatisticsUtils::tTest(&data[0], numberOfRows, numberOfColumns,
+                           sample1ColumnsWithoutNaN, sample2ColumnsWithoutNaN,
+                           /* equalVariance= */ false, &pValuesWithoutNaN[0]);
+  if (!checkValue(__LINE__, "tTest()", pValues[2], pValuesWithoutNaN[2], 1e-15))
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!voStatisticsUtils::tTest(&data[0], numberOfRows, numberOfColumns, sample1Columns, sample2Columns,
+                                /* equalVariance= */ true, &pValues[0], &diagnostics) ||
+      !checkValue(__LINE__, "tTest()", pValues[0], 0.07918671, 1e-7) ||
+      !checkDiagnostics(__LINE__, "tTest()", diagnostics, voStatisticsUtils::ConstantData))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Out of range columns
+  std::vector<vtkIdType> invalidColumns(1, numberOfColumns);
+  if (voStatisticsUtils::tTest(&data[0], numberOfRows, numberOfColumns, sample1Columns, invalidColumns,
+                               /* equalVariance= */ false, &pValues[0]))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with tTest()\n"
+              << "\tOut of range columns are expected to fail" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // oneWayANOVA: with two groups, it is equivalent to Student's t-test, even if unbalanced
+  std::vector<std::vector<vtkIdType> > groups(2);
+  groups[0].assign(sample1Columns.begin(), sample1Columns.begin() + 4);
+  groups[1] = sample2Columns;
+  std::vector<double> expectedPValues(numberOfRows);
+  voStatisticsUtils::tTest(&data[0], numberOfRows, numberOfColumns, groups[0], groups[1],
+                           /* equalVariance= */ true, &expectedPValues[0]);
+  if (!voStatisticsUtils::oneWayANOVA(&data[0], numberOfRows, numberOfColumns, groups,
+                                      &pValues[0], &diagnostics))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with oneWayANOVA()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType r = 0; r < numberOfRows; ++r)
+    {
+    if (!checkValue(__LINE__, "oneWayANOVA()", pValues[r], expectedPValues[r], 1e-12))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (!checkDiagnostics(__LINE__, "oneWayANOVA()", diagnostics, voStatisticsUtils::ConstantData))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // R's "PlantGrowth" data set: three groups of 10 experiments
+  // Expected value has been computed using R: summary(aov(weight ~ group, data = PlantGrowth))
+  const double plantGrowth[] = {
+    4.17, 5.58, 5.18, 6.11, 4.50, 4.61, 5.17, 4.53, 5.33, 5.14,
+    4.81, 4.17, 4.41, 3.59, 5.87, 3.83, 6.03, 4.89, 4.32, 4.69,
+    6.31, 5.12, 5.54, 5.50, 5.37, 5.29, 4.92, 6.15, 5.80, 5.26};
+  std::vector<std::vector<vtkIdType> > plantGroups(3);
+  for (vtkIdType c = 0; c < 30; ++c)
+    {
+    plantGroups[c / 10].push_back(c);
+    }
+  double plantPValue = 0.;
+  if (!voStatisticsUtils::oneWayANOVA(plantGrowth, 1, 30, plantGroups, &plantPValue, &diagnostics) ||
+      !checkValue(__LINE__, "oneWayANOVA()", plantPValue, 0.01591, 1e-5) ||
+      !checkDiagnostics(__LINE__, "oneWayANOVA()", diagnostics, voStatisticsUtils::NoDiagnostic))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A single group is not enough
+  if (voStatisticsUtils::oneWayANOVA(plantGrowth, 1, 30, std::vector<std::vector<vtkIdType> >(1, plantGroups[0]),
+                                     &plantPValue))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with oneWayANOVA()\n"
+              << "\tA single group is expected to fail" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // foldChange
+  std::vector<double> foldChanges(numberOfRows);
+  if (!voStatisticsUtils::foldChange(&data[0], numberOfRows, numberOfColumns, sample1Columns, sample2Columns,
+                                     &foldChanges[0], &diagnostics))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with foldChange()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkValue(__LINE__, "foldChange()", foldChanges[0], -2.33 / 0.75, 1e-12) ||
+      !checkValue(__LINE__, "foldChange()", foldChanges[1], 1., 1e-12) ||
+      !checkValue(__LINE__, "foldChange()", foldChanges[2], nan, 0.) ||
+      !checkValue(__LINE__, "foldChange()", foldChanges[4], nan, 0.) ||
+      !checkDiagnostics(__LINE__, "foldChange()", diagnostics, voStatisticsUtils::InvalidFoldChange))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // rowMeans and foldChangeFromMeans: rows (1, 4) and (2, 8)
+  const double positiveData[] = {1., 2., 4., 8.};
+  std::vector<vtkIdType> positiveColumns;
+  positiveColumns.push_back(0);
+  positiveColumns.push_back(1);
+  double arithmeticMeans[2];
+  double geometricMeans[2];
+  if (!voStatisticsUtils::rowMeans(positiveData, 2, 2, positiveColumns,
+                                   voStatisticsUtils::ArithmeticMean, arithmeticMeans) ||
+      !voStatisticsUtils::rowMeans(positiveData, 2, 2, positiveColumns,
+                                   voStatisticsUtils::GeometricMean, geometricMeans) ||
+      voStatisticsUtils::rowMeans(positiveData, 2, 2, sample2Columns,
+                                  voStatisticsUtils::ArithmeticMean, arithmeticMeans))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with rowMeans()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const double reversedGeometricMeans[] = {geometricMeans[1], geometricMeans[0]};
+  double meanFoldChanges[2];
+  diagnostics = -1;
+  voStatisticsUtils::foldChangeFromMeans(geometricMeans, reversedGeometricMeans, 2,
+                                         meanFoldChanges, &diagnostics);
+  if (!checkValue(__LINE__, "rowMeans()", arithmeticMeans[0], 2.5, 1e-12) ||
+      !checkValue(__LINE__, "rowMeans()", arithmeticMeans[1], 5., 1e-12) ||
+      !checkValue(__LINE__, "rowMeans()", geometricMeans[0], 2., 1e-12) ||
+      !checkValue(__LINE__, "rowMeans()", geometricMeans[1], 4., 1e-12) ||
+      !checkValue(__LINE__, "foldChangeFromMeans()", meanFoldChanges[0], -2., 1e-12) ||
+      !checkValue(__LINE__, "foldChangeFromMeans()", meanFoldChanges[1], 2., 1e-12) ||
+      !checkDiagnostics(__LINE__, "foldChangeFromMeans()", diagnostics, voStatisticsUtils::NoDiagnostic))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
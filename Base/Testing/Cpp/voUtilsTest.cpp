@@ -200,6 +200,70 @@ bool compareTable(int line, vtkTable * outputTable, vtkTable * expectedTable, bo
 return true;
 }
 
+//-----------------------------------------------------------------------------
+// Fill a numberOfRows x numberOfColumns table of ArrayType columns, value(r, c) = r * numberOfColumns + c.
+// The first column of a mixed table is a vtkDoubleArray.
+template<typename ArrayType>
+void fillNumericalTable(vtkTable* table, vtkIdType numberOfRows, vtkIdType numberOfColumns, bool mixed)
+{
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkSmartPointer<vtkDataArray> column;
+    if (mixed && cid == 0)
+      {
+      column = vtkSmartPointer<vtkDoubleArray>::New();
+      }
+    else
+      {
+      column = vtkSmartPointer<ArrayType>::New();
+      }
+    column->SetNumberOfTuples(numberOfRows);
+    for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+      {
+      column->SetTuple1(rid, rid * numberOfColumns + cid);
+      }
+    table->AddColumn(column);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Check that \a transposedTable is made of \a expectedClassName columns holding the values of \a table
+bool checkTransposedValues(int line, vtkTable* table, vtkTable* transposedTable, const char* expectedClassName)
+{
+  if (transposedTable->GetNumberOfRows() != table->GetNumberOfColumns() ||
+      transposedTable->GetNumberOfColumns() != table->GetNumberOfRows())
+    {
+    std::cerr << "Line " << line << " - Problem with transposeTable() - Unexpected size" << std::endl;
+    return false;
+    }
+  for (vtkIdType cid = 0; cid < transposedTable->GetNumberOfColumns(); ++cid)
+    {
+    vtkAbstractArray * column = transposedTable->GetColumn(cid);
+    if (qstrcmp(column->GetClassName(), expectedClassName) != 0)
+      {
+      std::cerr << "Line " << line << " - Problem with transposeTable()\n"
+                << "\tColumn: " << cid << "\n"
+                << "\tClassName: " << column->GetClassName() << "\n"
+                << "\tExpected: " << expectedClassName << std::endl;
+      return false;
+      }
+    for (vtkIdType rid = 0; rid < transposedTable->GetNumberOfRows(); ++rid)
+      {
+      double current = column->GetVariantValue(rid).ToDouble();
+      double expected = table->GetValue(cid, rid).ToDouble();
+      if (current != expected)
+        {
+        std::cerr << "Line " << line << " - Problem with transposeTable()\n"
+                  << "\tRow: " << rid << " Column: " << cid << "\n"
+                  << "\tCurrent: " << current << "\n"
+                  << "\tExpected: " << expected << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 QStringList intListToStringList(const QList<int>& intList)
 {
@@ -670,6 +734,42 @@ int voUtilsTest(int argc, char * argv [])
     return EXIT_FAILURE;
     }
 
+  //-----------------------------------------------------------------------------
+  // Test transposeTable(vtkTable * srcTable, vtkTable * destTable, const TransposeOption& transposeOption)
+  //  -> Homogeneous numerical tables larger than a block, and mixed numerical tables
+  //-----------------------------------------------------------------------------
+
+  vtkNew<vtkTable> largeDoubleTable;
+  fillNumericalTable<vtkDoubleArray>(largeDoubleTable.GetPointer(), 70, 130, /* mixed= */ false);
+  vtkNew<vtkTable> transposedLargeDoubleTable;
+  if (!voUtils::transposeTable(largeDoubleTable.GetPointer(), transposedLargeDoubleTable.GetPointer()) ||
+      !checkTransposedValues(__LINE__, largeDoubleTable.GetPointer(),
+                             transposedLargeDoubleTable.GetPointer(), "vtkDoubleArray"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkTable> largeIntTable;
+  fillNumericalTable<vtkIntArray>(largeIntTable.GetPointer(), 130, 70, /* mixed= */ false);
+  vtkNew<vtkTable> transposedLargeIntTable;
+  if (!voUtils::transposeTable(largeIntTable.GetPointer(), transposedLargeIntTable.GetPointer()) ||
+      !checkTransposedValues(__LINE__, largeIntTable.GetPointer(),
+                             transposedLargeIntTable.GetPointer(), "vtkIntArray"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Columns of different types fall back to the per-column transposition into variants
+  vtkNew<vtkTable> mixedTable;
+  fillNumericalTable<vtkIntArray>(mixedTable.GetPointer(), 70, 10, /* mixed= */ true);
+  vtkNew<vtkTable> transposedMixedTable;
+  if (!voUtils::transposeTable(mixedTable.GetPointer(), transposedMixedTable.GetPointer()) ||
+      !checkTransposedValues(__LINE__, mixedTable.GetPointer(),
+                             transposedMixedTable.GetPointer(), "vtkVariantArray"))
+    {
+    return EXIT_FAILURE;
+    }
+
   //-----------------------------------------------------------------------------
   // Test transposeTable(vtkTable * table)
   //-----------------------------------------------------------------------------
@@ -0,0 +1,174 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+
+// Visomics includes
+#include "voUtils.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+double valueAt(vtkIdType row, vtkIdType column)
+{
+  return row * 0.5 + column;
+}
+
+//-----------------------------------------------------------------------------
+// Value by value transposition, as done for tables that aren't homogeneous
+bool transposeByColumn(vtkTable* table, vtkTable* transposedTable)
+{
+  for (vtkIdType rid = 0; rid < table->GetNumberOfRows(); ++rid)
+    {
+    vtkSmartPointer<vtkDoubleArray> transposedColumn = vtkSmartPointer<vtkDoubleArray>::New();
+    transposedColumn->SetNumberOfValues(table->GetNumberOfColumns());
+    transposedTable->AddColumn(transposedColumn);
+    }
+  for (vtkIdType cid = 0; cid < table->GetNumberOfColumns(); ++cid)
+    {
+    vtkDoubleArray * column = vtkDoubleArray::SafeDownCast(table->GetColumn(cid));
+    for (vtkIdType rid = 0; rid < column->GetNumberOfTuples(); ++rid)
+      {
+      vtkDoubleArray::SafeDownCast(transposedTable->GetColumn(rid))->SetValue(cid, column->GetValue(rid));
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Transpose the table using at most threadCount threads and return the elapsed time in ms.
+// threadCount = 0 uses transposeByColumn() instead of voUtils::transposeTable().
+// Return -1 if the transposed table is not valid.
+qint64 timeTranspose(vtkTable* table, int threadCount)
+{
+  QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, threadCount));
+
+  vtkNew<vtkTable> transposedTable;
+  QElapsedTimer timer;
+  timer.start();
+  bool success = threadCount == 0 ?
+        transposeByColumn(table, transposedTable.GetPointer()) :
+        voUtils::transposeTable(table, transposedTable.GetPointer());
+  qint64 elapsed = timer.elapsed();
+
+  if (!success ||
+      transposedTable->GetNumberOfRows() != table->GetNumberOfColumns() ||
+      transposedTable->GetNumberOfColumns() != table->GetNumberOfRows())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with transposeTable()" << std::endl;
+    return -1;
+    }
+  for (vtkIdType cid = 0; cid < transposedTable->GetNumberOfColumns(); ++cid)
+    {
+    vtkDoubleArray * column = vtkDoubleArray::SafeDownCast(transposedTable->GetColumn(cid));
+    if (!column)
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with transposeTable() - "
+                << "Column " << cid << " is expected to be a vtkDoubleArray" << std::endl;
+      return -1;
+      }
+    for (vtkIdType rid = 0; rid < column->GetNumberOfTuples(); ++rid)
+      {
+      if (column->GetValue(rid) != valueAt(cid, rid))
+        {
+        std::cerr << "Line " << __LINE__ << " - Problem with transposeTable()\n"
+                  << "\tRow: " << rid << " Column: " << cid << "\n"
+                  << "\tCurrent: " << column->GetValue(rid) << "\n"
+                  << "\tExpected: " << valueAt(cid, rid) << std::endl;
+        return -1;
+        }
+      }
+    }
+  return elapsed;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+// Usage: voUtilsTransposeBenchmark [numberOfRows numberOfColumns]
+int main(int argc, char * argv [])
+{
+  QCoreApplication app(argc, argv);
+  Q_UNUSED(app);
+
+  vtkIdType numberOfRows = 10000;
+  vtkIdType numberOfColumns = 1000;
+  if (argc > 2)
+    {
+    numberOfRows = atoi(argv[1]);
+    numberOfColumns = atoi(argv[2]);
+    }
+
+  vtkNew<vtkTable> table;
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkSmartPointer<vtkDoubleArray> column = vtkSmartPointer<vtkDoubleArray>::New();
+    column->SetNumberOfValues(numberOfRows);
+    for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+      {
+      column->SetValue(rid, valueAt(rid, cid));
+      }
+    table->AddColumn(column);
+    }
+
+  std::cout << "Transposing " << numberOfRows << " x " << numberOfColumns << " table" << std::endl;
+
+  // Speedups are relative to the value by value transposition
+  qint64 byColumnTime = timeTranspose(table.GetPointer(), 0);
+  if (byColumnTime < 0)
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "  By column: " << byColumnTime << " ms" << std::endl;
+
+  int idealThreadCount = qMax(1, QThread::idealThreadCount());
+  for (int threadCount = 1; threadCount <= idealThreadCount; threadCount *= 2)
+    {
+    qint64 elapsed = timeTranspose(table.GetPointer(), threadCount);
+    if (elapsed < 0)
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "  Blocked, " << threadCount << " thread(s): " << elapsed << " ms";
+    if (elapsed > 0)
+      {
+      std::cout << " (speedup: " << static_cast<double>(byColumnTime) / elapsed << ")";
+      }
+    std::cout << std::endl;
+    }
+  QThreadPool::globalInstance()->setMaxThreadCount(idealThreadCount);
+
+  return EXIT_SUCCESS;
+}
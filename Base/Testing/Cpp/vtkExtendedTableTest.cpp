@@ -18,18 +18,254 @@
 
 =========================================================================*/
 
+// Qt includes
+#include <QDir>
+
+// Visomics includes
 #include "vtkExtendedTable.h"
 
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
 // STD includes
 #include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Value expected at row r and column c of the data
+double expectedValue(vtkIdType r, vtkIdType c)
+{
+  return 10. * c + r;
+}
+
+//-----------------------------------------------------------------------------
+bool checkDataBuffer(int line, const double* buffer, int layout,
+                     vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  if (!buffer)
+    {
+    std::cerr << "Line " << line << " - Problem with GetDataBuffer() - Null buffer" << std::endl;
+    return false;
+    }
+  if (reinterpret_cast<size_t>(buffer) % 64 != 0)
+    {
+    std::cerr << "Line " << line << " - Problem with GetDataBuffer() - Buffer is not aligned" << std::endl;
+    return false;
+    }
+  for (vtkIdType r = 0; r < numberOfRows; ++r)
+    {
+    for (vtkIdType c = 0; c < numberOfColumns; ++c)
+      {
+      double value = layout == vtkExtendedTable::RowMajor ?
+            buffer[r * numberOfColumns + c] : buffer[c * numberOfRows + r];
+      if (value != expectedValue(r, c))
+        {
+        std::cerr << "Line " << line << " - Problem with GetDataBuffer()\n"
+                  << "\tRow: " << r << " Column: " << c << "\n"
+                  << "\tCurrent: " << value << "\n"
+                  << "\tExpected: " << expectedValue(r, c) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
 
 //-----------------------------------------------------------------------------
 int vtkExtendedTableTest(int /*argc*/, char * /*argv*/ [])
 {
-  //
-  //
-  //
-  //
+  const vtkIdType numberOfRows = 100;
+  const vtkIdType numberOfColumns = 3;
+
+  // Mix double and integer columns
+  vtkNew<vtkTable> data;
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    vtkSmartPointer<vtkDataArray> column;
+    if (c == 1)
+      {
+      column = vtkSmartPointer<vtkIntArray>::New();
+      }
+    else
+      {
+      column = vtkSmartPointer<vtkDoubleArray>::New();
+      }
+    column->SetNumberOfTuples(numberOfRows);
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      column->SetTuple1(r, expectedValue(r, c));
+      }
+    data->AddColumn(column);
+    }
+
+  //-----------------------------------------------------------------------------
+  // Test SetData(vtkTable*) and GetContiguousDataBuffer()
+  //-----------------------------------------------------------------------------
+  vtkNew<vtkExtendedTable> extendedTable;
+  extendedTable->SetData(data.GetPointer());
+
+  double * contiguousData = extendedTable->GetContiguousDataBuffer();
+  if (!checkDataBuffer(__LINE__, contiguousData, vtkExtendedTable::ColumnMajor,
+                       numberOfRows, numberOfColumns))
+    {
+    return EXIT_FAILURE;
+    }
+  if (extendedTable->GetDataBuffer(vtkExtendedTable::ColumnMajor) != contiguousData)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetDataBuffer() - "
+              << "Column-major buffer is expected to be the shared buffer" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Test GetDataBuffer(RowMajor)
+  //-----------------------------------------------------------------------------
+  if (!checkDataBuffer(__LINE__, extendedTable->GetDataBuffer(vtkExtendedTable::RowMajor),
+                       vtkExtendedTable::RowMajor, numberOfRows, numberOfColumns))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Values written in the shared buffer are seen by the columns, not by the source table
+  //-----------------------------------------------------------------------------
+  contiguousData[numberOfRows + 2] = -1.;
+  extendedTable->Modified();
+  if (extendedTable->GetValue(2, 1).ToDouble() != -1. || data->GetValue(2, 1).ToDouble() != expectedValue(2, 1))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetContiguousDataBuffer() - "
+              << "Column is expected to be a view of the shared buffer" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const double * rowMajorData = extendedTable->GetDataBuffer(vtkExtendedTable::RowMajor);
+  if (rowMajorData[2 * numberOfColumns + 1] != -1.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetDataBuffer() - "
+              << "Row-major buffer is expected to be updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+  contiguousData[numberOfRows + 2] = expectedValue(2, 1);
+  extendedTable->Modified();
+
+  //-----------------------------------------------------------------------------
+  // Replacing a column detaches the shared buffer
+  //-----------------------------------------------------------------------------
+  vtkNew<vtkDoubleArray> lastColumn;
+  lastColumn->DeepCopy(extendedTable->GetColumn(numberOfColumns - 1));
+  extendedTable->RemoveColumn(numberOfColumns - 1);
+  extendedTable->AddColumn(lastColumn.GetPointer());
+  if (extendedTable->GetContiguousDataBuffer() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetContiguousDataBuffer() - "
+              << "Null buffer is expected after replacing a column" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkDataBuffer(__LINE__, extendedTable->GetDataBuffer(vtkExtendedTable::ColumnMajor),
+                       vtkExtendedTable::ColumnMajor, numberOfRows, numberOfColumns))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Test AllocateData()
+  //-----------------------------------------------------------------------------
+  vtkNew<vtkExtendedTable> allocatedTable;
+  double * allocatedData = allocatedTable->AllocateData(numberOfRows, numberOfColumns);
+  if (!allocatedData || allocatedData != allocatedTable->GetContiguousDataBuffer() ||
+      allocatedTable->GetNumberOfRows() != numberOfRows ||
+      allocatedTable->GetNumberOfColumns() != numberOfColumns)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with AllocateData() - "
+              << "Columns are expected to be views of the returned buffer" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      allocatedData[c * numberOfRows + r] = expectedValue(r, c);
+      }
+    }
+  if (!checkDataBuffer(__LINE__, allocatedTable->GetDataBuffer(vtkExtendedTable::RowMajor),
+                       vtkExtendedTable::RowMajor, numberOfRows, numberOfColumns))
+    {
+    return EXIT_FAILURE;
+    }
+  if (allocatedTable->AllocateData(0, numberOfColumns) != 0 || allocatedTable->GetNumberOfColumns() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with AllocateData() - "
+              << "Empty data is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //-----------------------------------------------------------------------------
+  // Test out-of-core data and GetDataTile()
+  //-----------------------------------------------------------------------------
+  vtkExtendedTable::SetOutOfCoreDirectory(QDir::tempPath().toLocal8Bit().constData());
+  vtkExtendedTable::SetOutOfCoreThreshold(1);
+  vtkNew<vtkExtendedTable> outOfCoreTable;
+  outOfCoreTable->SetData(data.GetPointer());
+  vtkExtendedTable::SetOutOfCoreThreshold(0);
+  if (!outOfCoreTable->IsDataOutOfCore() || extendedTable->IsDataOutOfCore())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with IsDataOutOfCore()" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkDataBuffer(__LINE__, outOfCoreTable->GetContiguousDataBuffer(), vtkExtendedTable::ColumnMajor,
+                       numberOfRows, numberOfColumns))
+    {
+    return EXIT_FAILURE;
+    }
+  if (outOfCoreTable->GetDataTileNumberOfRows() != numberOfRows ||
+      extendedTable->GetDataTileNumberOfRows() != numberOfRows)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetDataTileNumberOfRows() - "
+              << "Small data are expected to fit in one tile" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const vtkIdType firstTileRow = 10;
+  const vtkIdType tileNumberOfRows = 20;
+  std::vector<double> tileBuffer;
+  const double * tile = outOfCoreTable->GetDataTile(firstTileRow, tileNumberOfRows, tileBuffer);
+  if (!tile || tile != &tileBuffer[0])
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetDataTile() - "
+              << "Rows are expected to be copied into the buffer" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType r = 0; r < tileNumberOfRows; ++r)
+    {
+    for (vtkIdType c = 0; c < numberOfColumns; ++c)
+      {
+      if (tile[c * tileNumberOfRows + r] != expectedValue(firstTileRow + r, c))
+        {
+        std::cerr << "Line " << __LINE__ << " - Problem with GetDataTile()\n"
+                  << "\tRow: " << r << " Column: " << c << "\n"
+                  << "\tCurrent: " << tile[c * tileNumberOfRows + r] << "\n"
+                  << "\tExpected: " << expectedValue(firstTileRow + r, c) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  if (outOfCoreTable->GetDataTile(0, numberOfRows, tileBuffer) != outOfCoreTable->GetContiguousDataBuffer() ||
+      outOfCoreTable->GetDataTile(numberOfRows - 1, 2, tileBuffer) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with GetDataTile() - "
+              << "Shared buffer or null tile is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
 
@@ -19,11 +19,11 @@
 =========================================================================*/
 
 // Qt includes
-#include <QCryptographicHash>
+#include <QAtomicInt>
 #include <QDebug>
 #include <QExplicitlySharedDataPointer>
-#include <QFile>
 #include <QHash>
+#include <QThread>
 #include <QUuid>
 
 // QtPropertyBrowser includes
@@ -37,8 +37,13 @@
 #include "voIOManager.h"
 
 // VTK includes
+#include <vtkAbstractArray.h>
 #include <vtkDataObject.h>
 #include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <algorithm>
 
 // --------------------------------------------------------------------------
 class voAnalysisPrivate
@@ -75,12 +80,39 @@ public:
 
   bool AcceptDefaultParameterValues;
 
-  bool AbortExecution;
+  /// Set from the GUI thread while execute() may be running in a worker thread
+  QAtomicInt AbortExecution;
 
   QString OutputDirectory;
   bool WriteOutputsToFilesEnabled;
 
   QtVariantPropertyManager*          VariantManager;
+
+  /// Input name -> uuid of the data object and modification time of its data
+  QHash<QString, QString> inputStamps()const;
+
+  /// Parameter id -> value, groups have no id
+  QHash<QString, QVariant> parameterValues()const;
+
+  /// True if the value of one of the parameters \a parameterIds differs from \a values
+  bool parameterValuesChanged(const QStringList& parameterIds, const QHash<QString, QVariant>& values)const;
+
+  /// Output name -> parameters it is computed from, every parameter if not declared
+  QHash<QString, QStringList> OutputParameters;
+
+  /// Inputs and parameter values of the last successful execution
+  bool                     Executed;
+  QHash<QString, QString>  ExecutedInputStamps;
+  QHash<QString, QVariant> ExecutedParameterValues;
+
+  struct IntermediateData
+  {
+    vtkSmartPointer<vtkObject> Data;
+    QStringList                ParameterIds;
+    QHash<QString, QString>    InputStamps;
+    QHash<QString, QVariant>   ParameterValues;
+  };
+  QHash<QString, IntermediateData> IntermediateDataHash;
 };
 
 // --------------------------------------------------------------------------
@@ -100,10 +132,11 @@ void voAnalysisPrivate::init()
   this->OutputInformationInitialized = false;
   this->ParameterInformationInitialized = false;
   this->AcceptDefaultParameterValues = false;
-  this->AbortExecution = false;
+  this->AbortExecution = 0;
   this->OutputDirectory = QLatin1String(".");
   this->WriteOutputsToFilesEnabled = false;
   this->VariantManager = new QtVariantPropertyManager(q);
+  this->Executed = false;
 }
 
 // --------------------------------------------------------------------------
@@ -111,6 +144,63 @@ voAnalysisPrivate::~voAnalysisPrivate()
 {
 }
 
+// --------------------------------------------------------------------------
+QHash<QString, QString> voAnalysisPrivate::inputStamps()const
+{
+  QHash<QString, QString> stamps;
+  foreach(const QString& inputName, this->InputDataObjects.keys())
+    {
+    voDataObject * dataObject = this->InputDataObjects.value(inputName).data();
+    if (!dataObject)
+      {
+      continue;
+      }
+    // Modifying the values of a column doesn't modify its table
+    unsigned long mtime = 0;
+    vtkDataObject * data = dataObject->dataAsVTKDataObject();
+    if (data)
+      {
+      mtime = data->GetMTime();
+      vtkTable * table = vtkTable::SafeDownCast(data);
+      for (vtkIdType cid = 0; table && cid < table->GetNumberOfColumns(); ++cid)
+        {
+        mtime = std::max(mtime, table->GetColumn(cid)->GetMTime());
+        }
+      }
+    stamps.insert(inputName, QString("%1:%2").arg(dataObject->uuid()).arg(mtime));
+    }
+  return stamps;
+}
+
+// --------------------------------------------------------------------------
+QHash<QString, QVariant> voAnalysisPrivate::parameterValues()const
+{
+  QHash<QString, QVariant> values;
+  foreach(QtProperty* prop, this->VariantManager->properties())
+    {
+    if (!prop->propertyId().isEmpty())
+      {
+      values.insert(prop->propertyId(), this->VariantManager->value(prop));
+      }
+    }
+  return values;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPrivate::parameterValuesChanged(const QStringList& parameterIds,
+                                               const QHash<QString, QVariant>& values)const
+{
+  QHash<QString, QVariant> currentValues = this->parameterValues();
+  foreach(const QString& id, parameterIds)
+    {
+    if (currentValues.value(id) != values.value(id))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
 // --------------------------------------------------------------------------
 // voAnalysis methods
 
@@ -495,6 +585,26 @@ void voAnalysis::setRawViewPrettyName(const QString& outputName, const QString&
     }
 }
 
+// --------------------------------------------------------------------------
+void voAnalysis::removeOutput(const QString& outputName)
+{
+  Q_D(voAnalysis);
+  if (!this->hasOutput(outputName))
+    {
+    return;
+    }
+  foreach(const QString& viewType, d->OutputViewInformation.values(outputName))
+    {
+    d->OutputViewPrettyName.remove(outputName + viewType);
+    }
+  d->OutputRawViewPrettyName.remove(outputName + d->OutputRawView.value(outputName));
+  d->OutputDataObjects.remove(outputName);
+  d->OutputInformation.remove(outputName);
+  d->OutputViewInformation.remove(outputName);
+  d->OutputRawView.remove(outputName);
+  d->OutputParameters.remove(outputName);
+}
+
 // --------------------------------------------------------------------------
 void voAnalysis::removeAllOutputs()
 {
@@ -505,21 +615,112 @@ void voAnalysis::removeAllOutputs()
   d->OutputRawView.clear();
   d->OutputViewPrettyName.clear();
   d->OutputRawViewPrettyName.clear();
+  d->OutputParameters.clear();
   d->OutputInformationInitialized = false;
 }
 
+// --------------------------------------------------------------------------
+QStringList voAnalysis::outdatedOutputNames()const
+{
+  QStringList outdatedOutputs;
+  foreach(const QString& outputName, this->outputNames())
+    {
+    if (this->isOutputOutdated(outputName))
+      {
+      outdatedOutputs << outputName;
+      }
+    }
+  return outdatedOutputs;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysis::isOutputOutdated(const QString& outputName)const
+{
+  Q_D(const voAnalysis);
+  if (!d->Executed || !this->output(outputName) || d->inputStamps() != d->ExecutedInputStamps)
+    {
+    return true;
+    }
+  QStringList parameterIds = d->OutputParameters.contains(outputName) ?
+        d->OutputParameters.value(outputName) : d->ExecutedParameterValues.keys();
+  return d->parameterValuesChanged(parameterIds, d->ExecutedParameterValues);
+}
+
+// --------------------------------------------------------------------------
+void voAnalysis::removeOutdatedOutputs()
+{
+  Q_D(voAnalysis);
+  QHash<QString, QExplicitlySharedDataPointer<voDataObject> > upToDateOutputs;
+  foreach(const QString& outputName, this->outputNames())
+    {
+    if (!this->isOutputOutdated(outputName))
+      {
+      upToDateOutputs.insert(outputName, d->OutputDataObjects.value(outputName));
+      }
+    }
+  this->removeAllOutputs();
+  this->initializeOutputInformation();
+  foreach(const QString& outputName, upToDateOutputs.keys())
+    {
+    if (this->hasOutput(outputName))
+      {
+      d->OutputDataObjects.insert(outputName, upToDateOutputs.value(outputName));
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+void voAnalysis::recordExecution()
+{
+  Q_D(voAnalysis);
+  d->Executed = true;
+  d->ExecutedInputStamps = d->inputStamps();
+  d->ExecutedParameterValues = d->parameterValues();
+}
+
 // --------------------------------------------------------------------------
 bool voAnalysis::abortExecution()const
 {
   Q_D(const voAnalysis);
-  return d->AbortExecution;
+  return d->AbortExecution != 0;
 }
 
 // --------------------------------------------------------------------------
 void voAnalysis::setAbortExecution(bool abortExecutionValue)
 {
   Q_D(voAnalysis);
-  d->AbortExecution = abortExecutionValue;
+  d->AbortExecution = abortExecutionValue ? 1 : 0;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysis::setProgress(double progress)
+{
+  emit this->progressChanged(qBound(0., progress, 1.));
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysis::mainThreadOnly()const
+{
+  return false;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysis::resultCacheable()const
+{
+  return true;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysis::moveOutputsToAnalysisThread()
+{
+  foreach(const QString& outputName, this->outputNames())
+    {
+    voDataObject * dataObject = this->output(outputName);
+    if (dataObject && dataObject->thread() == QThread::currentThread())
+      {
+      dataObject->moveToThread(this->thread());
+      }
+    }
 }
 
 // --------------------------------------------------------------------------
@@ -554,7 +755,22 @@ void voAnalysis::setWriteOutputsToFilesEnabled(bool enabled)
 bool voAnalysis::run()
 {
   Q_D(voAnalysis);
+  if (this->abortExecution())
+    {
+    return false;
+    }
+  this->setProgress(0.);
   bool success = this->execute();
+  // execute() may have returned early because the execution was aborted
+  if (success && this->abortExecution())
+    {
+    return false;
+    }
+  if (success)
+    {
+    this->setProgress(1.);
+    this->recordExecution();
+    }
   if (success && d->WriteOutputsToFilesEnabled)
     {
     this->writeOutputsToFiles(d->OutputDirectory);
@@ -599,13 +815,11 @@ void voAnalysis::writeOutputsToFiles(const QString& directory) const
   voInputFileDataObject * inputDataObject = qobject_cast<voInputFileDataObject*>(this->input());
   if (inputDataObject)
     {
-    QFile inputFile(inputDataObject->fileName());
-    if (inputFile.open(QIODevice::ReadOnly))
+    QByteArray fileHash = inputDataObject->fileHash();
+    if (!fileHash.isEmpty())
       {
-      QByteArray sha1 = QCryptographicHash::hash(inputFile.readAll(), QCryptographicHash::Md5);
-      inputHash = sha1.toHex();
+      inputHash = fileHash.toHex();
       inputHash.append("_");
-      inputFile.close();
       }
     }
 
@@ -655,6 +869,41 @@ void voAnalysis::setParameterValues(const QHash<QString, QVariant>& parameters)
     }
 }
 
+// --------------------------------------------------------------------------
+bool voAnalysis::convertParameterValues(const QHash<QString, QVariant>& values,
+                                        QHash<QString, QVariant>& parameters)const
+{
+  foreach(const QString& id, values.keys())
+    {
+    QtVariantProperty * prop = id.isEmpty() ? 0 : this->parameter(id);
+    if (!prop || prop->propertyType() == QtVariantPropertyManager::groupTypeId())
+      {
+      qCritical() << "Analysis" << this->metaObject()->className() << "has no parameter" << id;
+      return false;
+      }
+    QVariant value = values.value(id);
+    bool valid = true;
+    if (prop->propertyType() == QtVariantPropertyManager::enumTypeId() &&
+        value.type() == QVariant::String)
+      {
+      int index = prop->attributeValue(QLatin1String("enumNames")).toStringList().indexOf(value.toString());
+      valid = index >= 0;
+      value = index;
+      }
+    else
+      {
+      valid = value.convert(static_cast<QVariant::Type>(prop->valueType()));
+      }
+    if (!valid)
+      {
+      qCritical() << "Invalid value" << values.value(id) << "for parameter" << id;
+      return false;
+      }
+    parameters.insert(id, value);
+    }
+  return true;
+}
+
 // --------------------------------------------------------------------------
 QSet<QtVariantProperty*> voAnalysis::topLevelParameterGroups()const
 {
@@ -721,6 +970,51 @@ void voAnalysis::addParameterGroup(const QString& label, const QList<QtProperty*
     }
 }
 
+// --------------------------------------------------------------------------
+void voAnalysis::setOutputParameters(const QString& outputName, const QStringList& parameterIds)
+{
+  Q_D(voAnalysis);
+  if (!this->hasOutput(outputName))
+    {
+    return;
+    }
+  d->OutputParameters.insert(outputName, parameterIds);
+}
+
+// --------------------------------------------------------------------------
+void voAnalysis::setIntermediateData(const QString& name, vtkObject* data, const QStringList& parameterIds)
+{
+  Q_D(voAnalysis);
+  if (!data)
+    {
+    d->IntermediateDataHash.remove(name);
+    return;
+    }
+  voAnalysisPrivate::IntermediateData intermediateData;
+  intermediateData.Data = data;
+  intermediateData.ParameterIds = parameterIds;
+  intermediateData.InputStamps = d->inputStamps();
+  intermediateData.ParameterValues = d->parameterValues();
+  d->IntermediateDataHash.insert(name, intermediateData);
+}
+
+// --------------------------------------------------------------------------
+vtkObject* voAnalysis::intermediateData(const QString& name)const
+{
+  Q_D(const voAnalysis);
+  if (!d->IntermediateDataHash.contains(name))
+    {
+    return 0;
+    }
+  voAnalysisPrivate::IntermediateData intermediateData = d->IntermediateDataHash.value(name);
+  if (intermediateData.InputStamps != d->inputStamps() ||
+      d->parameterValuesChanged(intermediateData.ParameterIds, intermediateData.ParameterValues))
+    {
+    return 0;
+    }
+  return intermediateData.Data;
+}
+
 // --------------------------------------------------------------------------
 QtVariantProperty* voAnalysis::parameter(const QString& id)const
 {
@@ -34,6 +34,7 @@ class QtVariantProperty;
 class voAnalysisPrivate;
 class voDataObject;
 class vtkDataObject;
+class vtkObject;
 
 class voAnalysis : public QObject
 {
@@ -96,11 +97,54 @@ public:
   QString rawViewPrettyName(const QString& outputName, const QString& rawViewType);
   void setRawViewPrettyName(const QString& outputName, const QString& rawViewType, const QString& rawViewPrettyName);
 
+  /// Remove an output declared using addOutputType() along with its data object.
+  /// Analyses can call it from execute() to skip an output that was not requested.
+  void removeOutput(const QString& outputName);
+
   void removeAllOutputs();
 
+  /// Outputs the next execution has to compute: all of them if an input changed since the
+  /// last successful execution, otherwise the outputs without data object and those computed
+  /// from a parameter whose value changed.
+  /// \sa setOutputParameters()
+  QStringList outdatedOutputNames()const;
+  bool isOutputOutdated(const QString& outputName)const;
+
+  /// Remove the data objects of the outdated outputs and declare again the outputs removed
+  /// by the last execution. The data objects of the other outputs are kept, execute() can
+  /// skip computing them.
+  void removeOutdatedOutputs();
+
+  /// Record the current inputs and parameter values as the ones the outputs have been
+  /// computed from. Called by run() after a successful execution, and to be called when
+  /// the outputs are set without executing the analysis (e.g. voAnalysisResultCache::read()).
+  void recordExecution();
+
+  /// Request execute() to stop. It can be called from another thread than the one
+  /// running the analysis, execute() checks abortExecution() between steps and run()
+  /// returns false once the execution has been aborted.
   bool abortExecution()const;
   void setAbortExecution(bool abortExecutionValue);
 
+  /// Report the progress of execute(), between 0 and 1.
+  /// \sa progressChanged()
+  void setProgress(double progress);
+
+  /// Return true if execute() must be called from the GUI thread, e.g. because it uses
+  /// the embedded R interpreter or the network. voAnalysisDriver and voAnalysisPipeline
+  /// execute such analyses synchronously. The answer may depend on the parameter values,
+  /// false by default.
+  virtual bool mainThreadOnly()const;
+
+  /// Return false if the outputs must not be stored in voAnalysisResultCache, e.g. because
+  /// they come from a remote server and don't only depend on the inputs and the parameter
+  /// values. True by default.
+  virtual bool resultCacheable()const;
+
+  /// Hand the outputs created by the calling thread over to the thread of the analysis.
+  /// To be called by a worker thread once run() returns, worker threads have no event loop.
+  void moveOutputsToAnalysisThread();
+
   QString outputDirectory()const;
   void setOutputDirectory(const QString& directory);
 
@@ -120,6 +164,13 @@ public:
 
   void setParameterValues(const QHash<QString, QVariant>& parameters);
 
+  /// Convert \a values to the type of the parameters they are given for. Enumeration
+  /// values are given either by the name of their choice or by its index.
+  /// Return false if a parameter doesn't exist or if a value can't be converted.
+  /// \sa initializeParameterInformation()
+  bool convertParameterValues(const QHash<QString, QVariant>& values,
+                              QHash<QString, QVariant>& parameters)const;
+
   QSet<QtVariantProperty*> topLevelParameterGroups()const;
 
   int parameterCount()const;
@@ -136,6 +187,9 @@ signals:
 
   void outputSet(const QString& outputName, voDataObject* dataObject, voAnalysis* analysis);
 
+  /// Emitted from the thread running the analysis
+  void progressChanged(double progress);
+
 protected:
 
   virtual bool execute();
@@ -146,6 +200,18 @@ protected:
 
   void addParameterGroup(const QString& label, const QList<QtProperty*> parameters);
 
+  /// Declare that \a outputName is computed from the parameters \a parameterIds only,
+  /// by default an output depends on every parameter. Called from setOutputInformation().
+  void setOutputParameters(const QString& outputName, const QStringList& parameterIds);
+
+  /// Keep \a data, computed from the inputs and from the parameters \a parameterIds,
+  /// for the next executions (e.g. a distance matrix).
+  void setIntermediateData(const QString& name, vtkObject* data, const QStringList& parameterIds);
+
+  /// Data kept by setIntermediateData() if neither the inputs nor the parameters it has
+  /// been computed from changed since, NULL otherwise.
+  vtkObject* intermediateData(const QString& name)const;
+
   QtVariantProperty* parameter(const QString& id)const;
 
   QString enumParameter(const QString& id)const;
@@ -19,10 +19,16 @@
 =========================================================================*/
 
 // Qt includes
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QHash>
+#include <QRunnable>
 #include <QSharedPointer>
+#include <QStringList>
 #include <QDebug>
 #include <QMainWindow>
+#include <QThread>
+#include <QThreadPool>
 
 // QtPropertyBrowser includes
 #include <QtVariantPropertyManager>
@@ -31,24 +37,130 @@
 #include "voAnalysis.h"
 #include "voAnalysisDriver.h"
 #include "voAnalysisFactory.h"
+#include "voAnalysisResultCache.h"
 #include "voApplication.h"
 #include "voDataModelItem.h"
 #include "voDataObject.h"
 
+// VTK includes
+#include <vtkDataObject.h>
+
+namespace
+{
+
+// By default, analyses whose inputs exceed 2GB together are not run at the same time
+const qint64 DefaultRunningAnalysisMemoryLimit = Q_INT64_C(2) << 30;
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 class voAnalysisDriverPrivate
 {
+  Q_DECLARE_PUBLIC(voAnalysisDriver);
+
+protected:
+  voAnalysisDriver* const q_ptr;
+
 public:
-  voAnalysisDriverPrivate();
+  voAnalysisDriverPrivate(voAnalysisDriver& object);
   virtual ~voAnalysisDriverPrivate();
+
+  /// Executed by a worker thread
+  void executeAnalysis(voAnalysis* analysis);
+
+  /// Hand the pending executions to the thread pool, in order, as long as the limits
+  /// on the number of running analyses and on the size of their inputs allow it.
+  void startPendingExecutions();
+
+  /// Emit batchFinished() if all the executions of the current batch are done
+  void checkBatchFinished();
+
+  /// Size in bytes of the inputs of \a analysis
+  static qint64 inputMemorySize(voAnalysis* analysis);
+
+  struct Execution
+  {
+    voAnalysis*      Analysis;
+    /// NULL if the analysis is updated
+    voDataModelItem* InputTarget;
+    bool             Asynchronous;
+    bool             Started;
+    bool             InBatch;
+    qint64           InputMemorySize;
+    QDateTime        ScheduledTime;
+    QDateTime        StartTime;
+  };
+
+  struct BatchJob
+  {
+    QString AnalysisName;
+    QString InputName;
+    bool    Success;
+    bool    Aborted;
+    qint64  WaitingTime;
+    qint64  RunningTime;
+  };
+
+  bool ResultCacheEnabled;
+  bool AsynchronousExecutionEnabled;
+
+  /// Analysis uuid -> Execution
+  QHash<QString, Execution> Executions;
+  /// Uuid of the analyses waiting for being started, in order
+  QStringList PendingExecutions;
+  QThreadPool ThreadPool;
+  int         MaximumRunningAnalysisCount;
+  qint64      RunningAnalysisMemoryLimit;
+  int         RunningAnalysisCount;
+  qint64      RunningAnalysisMemorySize;
+
+  /// True while runAnalysisForAllInputs() schedules the analyses of a batch
+  bool             SchedulingBatch;
+  int              RemainingBatchJobCount;
+  QDateTime        BatchStartTime;
+  QList<BatchJob>  BatchJobs;
+  QString          BatchReport;
+  int              NumberOfFailedBatchAnalyses;
 };
 
+namespace
+{
+
+// --------------------------------------------------------------------------
+class voAnalysisExecutionTask : public QRunnable
+{
+public:
+  voAnalysisExecutionTask(voAnalysisDriverPrivate* driverPrivate, voAnalysis* analysis)
+    : DriverPrivate(driverPrivate), Analysis(analysis){}
+
+  virtual void run()
+    {
+    this->DriverPrivate->executeAnalysis(this->Analysis);
+    }
+
+private:
+  voAnalysisDriverPrivate* DriverPrivate;
+  voAnalysis*              Analysis;
+};
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 // voAnalysisDriverPrivate methods
 
 // --------------------------------------------------------------------------
-voAnalysisDriverPrivate::voAnalysisDriverPrivate()
+voAnalysisDriverPrivate::voAnalysisDriverPrivate(voAnalysisDriver& object) : q_ptr(&object)
 {
+  this->ResultCacheEnabled = true;
+  this->AsynchronousExecutionEnabled = false;
+  this->MaximumRunningAnalysisCount = qMax(1, QThread::idealThreadCount());
+  this->ThreadPool.setMaxThreadCount(this->MaximumRunningAnalysisCount);
+  this->RunningAnalysisMemoryLimit = DefaultRunningAnalysisMemoryLimit;
+  this->RunningAnalysisCount = 0;
+  this->RunningAnalysisMemorySize = 0;
+  this->SchedulingBatch = false;
+  this->RemainingBatchJobCount = 0;
+  this->NumberOfFailedBatchAnalyses = 0;
 }
 
 // --------------------------------------------------------------------------
@@ -56,18 +168,237 @@ voAnalysisDriverPrivate::~voAnalysisDriverPrivate()
 {
 }
 
+// --------------------------------------------------------------------------
+void voAnalysisDriverPrivate::executeAnalysis(voAnalysis* analysis)
+{
+  Q_Q(voAnalysisDriver);
+  bool success = q->runAnalysisUsingResultCache(analysis);
+  analysis->moveOutputsToAnalysisThread();
+
+  QMetaObject::invokeMethod(q, "onAnalysisExecutionFinished", Qt::QueuedConnection,
+                            Q_ARG(QString, analysis->uuid()), Q_ARG(bool, success));
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriverPrivate::startPendingExecutions()
+{
+  while (!this->PendingExecutions.isEmpty() &&
+         this->RunningAnalysisCount < this->MaximumRunningAnalysisCount)
+    {
+    Execution& execution = this->Executions[this->PendingExecutions.first()];
+    // Large inputs wait for the running analyses, but an analysis is always started
+    // when none is running so that inputs larger than the limit are processed too.
+    if (this->RunningAnalysisCount > 0 && this->RunningAnalysisMemoryLimit > 0 &&
+        this->RunningAnalysisMemorySize + execution.InputMemorySize > this->RunningAnalysisMemoryLimit)
+      {
+      break;
+      }
+    this->PendingExecutions.removeFirst();
+    execution.Started = true;
+    execution.StartTime = QDateTime::currentDateTime();
+    ++this->RunningAnalysisCount;
+    this->RunningAnalysisMemorySize += execution.InputMemorySize;
+    this->ThreadPool.start(new voAnalysisExecutionTask(this, execution.Analysis));
+    }
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriverPrivate::checkBatchFinished()
+{
+  Q_Q(voAnalysisDriver);
+  if (this->SchedulingBatch || this->RemainingBatchJobCount > 0 || this->BatchJobs.isEmpty())
+    {
+    return;
+    }
+
+  int succeededCount = 0;
+  int abortedCount = 0;
+  QStringList jobReports;
+  foreach(const BatchJob& job, this->BatchJobs)
+    {
+    QString status = job.Success ? QObject::tr("succeeded") :
+                     job.Aborted ? QObject::tr("aborted") : QObject::tr("FAILED");
+    succeededCount += job.Success ? 1 : 0;
+    abortedCount += job.Aborted ? 1 : 0;
+    jobReports << QObject::tr("  %1 on %2: %3 - waited %4 s, ran %5 s")
+                  .arg(job.AnalysisName).arg(job.InputName).arg(status)
+                  .arg(job.WaitingTime / 1000., 0, 'f', 1).arg(job.RunningTime / 1000., 0, 'f', 1);
+    }
+  int failedCount = this->BatchJobs.count() - succeededCount - abortedCount;
+  qint64 batchTime = this->BatchStartTime.msecsTo(QDateTime::currentDateTime());
+  this->BatchReport = QObject::tr("Batch of %1 analyses: %2 succeeded, %3 failed, %4 aborted in %5 s\n%6")
+      .arg(this->BatchJobs.count()).arg(succeededCount).arg(failedCount).arg(abortedCount)
+      .arg(batchTime / 1000., 0, 'f', 1).arg(jobReports.join("\n"));
+  this->BatchJobs.clear();
+  this->NumberOfFailedBatchAnalyses = failedCount + abortedCount;
+
+  if (failedCount > 0)
+    {
+    qWarning() << qPrintable(this->BatchReport);
+    }
+  else
+    {
+    qDebug() << qPrintable(this->BatchReport);
+    }
+  emit q->batchFinished();
+}
+
+// --------------------------------------------------------------------------
+qint64 voAnalysisDriverPrivate::inputMemorySize(voAnalysis* analysis)
+{
+  qint64 memorySize = 0;
+  foreach(const QString& inputName, analysis->inputNames())
+    {
+    voDataObject * dataObject = analysis->input(inputName);
+    vtkDataObject * data = dataObject ? dataObject->dataAsVTKDataObject() : 0;
+    if (data)
+      {
+      // GetActualMemorySize() is in kibibytes
+      memorySize += static_cast<qint64>(data->GetActualMemorySize()) * 1024;
+      }
+    }
+  return memorySize;
+}
+
 // --------------------------------------------------------------------------
 // voAnalysisDriver methods
 
 // --------------------------------------------------------------------------
 voAnalysisDriver::voAnalysisDriver(QObject* newParent):
-    Superclass(newParent), d_ptr(new voAnalysisDriverPrivate)
+    Superclass(newParent), d_ptr(new voAnalysisDriverPrivate(*this))
 {
 }
 
 // --------------------------------------------------------------------------
 voAnalysisDriver::~voAnalysisDriver()
 {
+  Q_D(voAnalysisDriver);
+  this->abortAllAnalyses();
+  d->ThreadPool.waitForDone();
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisDriver::resultCacheEnabled()const
+{
+  Q_D(const voAnalysisDriver);
+  return d->ResultCacheEnabled;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::setResultCacheEnabled(bool enabled)
+{
+  Q_D(voAnalysisDriver);
+  d->ResultCacheEnabled = enabled;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisDriver::asynchronousExecutionEnabled()const
+{
+  Q_D(const voAnalysisDriver);
+  return d->AsynchronousExecutionEnabled;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::setAsynchronousExecutionEnabled(bool enabled)
+{
+  Q_D(voAnalysisDriver);
+  d->AsynchronousExecutionEnabled = enabled;
+}
+
+// --------------------------------------------------------------------------
+int voAnalysisDriver::maximumRunningAnalysisCount()const
+{
+  Q_D(const voAnalysisDriver);
+  return d->MaximumRunningAnalysisCount;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::setMaximumRunningAnalysisCount(int count)
+{
+  Q_D(voAnalysisDriver);
+  d->MaximumRunningAnalysisCount = qMax(1, count);
+  d->ThreadPool.setMaxThreadCount(d->MaximumRunningAnalysisCount);
+  d->startPendingExecutions();
+}
+
+// --------------------------------------------------------------------------
+qint64 voAnalysisDriver::runningAnalysisMemoryLimit()const
+{
+  Q_D(const voAnalysisDriver);
+  return d->RunningAnalysisMemoryLimit;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::setRunningAnalysisMemoryLimit(qint64 limit)
+{
+  Q_D(voAnalysisDriver);
+  d->RunningAnalysisMemoryLimit = qMax(Q_INT64_C(0), limit);
+  d->startPendingExecutions();
+}
+
+// --------------------------------------------------------------------------
+QString voAnalysisDriver::batchReport()const
+{
+  Q_D(const voAnalysisDriver);
+  return d->BatchReport;
+}
+
+// --------------------------------------------------------------------------
+int voAnalysisDriver::numberOfFailedBatchAnalyses()const
+{
+  Q_D(const voAnalysisDriver);
+  return d->NumberOfFailedBatchAnalyses;
+}
+
+// --------------------------------------------------------------------------
+QList<voAnalysis*> voAnalysisDriver::runningAnalyses()const
+{
+  Q_D(const voAnalysisDriver);
+  QList<voAnalysis*> analyses;
+  foreach(const voAnalysisDriverPrivate::Execution& execution, d->Executions)
+    {
+    analyses << execution.Analysis;
+    }
+  return analyses;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::waitForAnalyses()
+{
+  Q_D(voAnalysisDriver);
+  // Completion notifications start the pending analyses
+  while (!d->Executions.isEmpty())
+    {
+    d->ThreadPool.waitForDone();
+    // Deliver the progress and completion notifications posted by the worker threads
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+    }
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::abortAnalysis(voAnalysis * analysis)
+{
+  Q_D(voAnalysisDriver);
+  if (!analysis || !d->Executions.contains(analysis->uuid()))
+    {
+    return;
+    }
+  analysis->setAbortExecution(true);
+  // Analyses that haven't been started yet are not handed to the thread pool
+  if (d->PendingExecutions.removeOne(analysis->uuid()))
+    {
+    QMetaObject::invokeMethod(this, "onAnalysisExecutionFinished", Qt::QueuedConnection,
+                              Q_ARG(QString, analysis->uuid()), Q_ARG(bool, false));
+    }
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::abortAllAnalyses()
+{
+  foreach(voAnalysis* analysis, this->runningAnalyses())
+    {
+    this->abortAnalysis(analysis);
+    }
 }
 
 // --------------------------------------------------------------------------
@@ -79,15 +410,42 @@ void voAnalysisDriver::runAnalysisForAllInputs(const QString& analysisName, bool
     return;
     }
 
+  Q_D(voAnalysisDriver);
   voDataModel * model = voApplication::application()->dataModel();
 
   // Collect inputs
   QList<voDataModelItem*> targetInputs = model->selectedInputObjects();
 
+  // Analyses run on the different inputs are independent, in asynchronous mode
+  // they are executed concurrently.
+  if (d->RemainingBatchJobCount == 0)
+    {
+    d->BatchStartTime = QDateTime::currentDateTime();
+    }
+  d->SchedulingBatch = true;
   foreach(voDataModelItem* targetInput, targetInputs)
     {
     this->runAnalysis(analysisName, targetInput, acceptDefaultParameter);
     }
+  d->SchedulingBatch = false;
+  d->checkBatchFinished();
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::runAnalyses(const QList<voAnalysis*>& analyses, voDataModelItem* inputTarget)
+{
+  Q_D(voAnalysisDriver);
+  if (d->RemainingBatchJobCount == 0)
+    {
+    d->BatchStartTime = QDateTime::currentDateTime();
+    }
+  d->SchedulingBatch = true;
+  foreach(voAnalysis* analysis, analyses)
+    {
+    this->runAnalysis(analysis, inputTarget);
+    }
+  d->SchedulingBatch = false;
+  d->checkBatchFinished();
 }
 
 // --------------------------------------------------------------------------
@@ -175,21 +533,7 @@ void voAnalysisDriver::runAnalysis(voAnalysis * analysis, voDataModelItem* input
     return;
     }
 
-  bool ret = analysis->run();
-  if (!ret)
-    {
-    qCritical() << "Analysis failed to run " << analysis->objectName();
-    return;
-    }
-
-  voAnalysisDriver::addAnalysisToObjectModel(analysisScopedPtr.take(), inputTarget);
-
-  connect(analysis, SIGNAL(outputSet(const QString&, voDataObject*, voAnalysis*)),
-          SLOT(onAnalysisOutputSet(const QString&,voDataObject*,voAnalysis*)));
-
-  emit this->analysisAddedToObjectModel(analysis);
-
-  qDebug() << " => Analysis" << analysis->objectName() << " DONE";
+  this->startAnalysis(analysisScopedPtr.take(), inputTarget);
 }
 
 // --------------------------------------------------------------------------
@@ -215,28 +559,178 @@ void voAnalysisDriver::runAnalysisForCurrentInput(
 void voAnalysisDriver::updateAnalysis(
   voAnalysis * analysis, const QHash<QString, QVariant>& parameters)
 {
+  Q_D(voAnalysisDriver);
   if (!analysis || parameters.count() == 0)
     {
     return;
     }
   // qDebug() << "voAnalysisDriver::updateAnalysis";
+  if (d->Executions.contains(analysis->uuid()))
+    {
+    qWarning() << "Failed to updateAnalysis - Analysis" << analysis->objectName() << "is already running";
+    return;
+    }
 
   // Update analysis parameter
   analysis->setParameterValues(parameters);
   analysis->setAcceptDefaultParameterValues(true);
 
-  // Clear outputs
-  analysis->removeAllOutputs();
-  analysis->initializeOutputInformation();
+  // Reset abort execution flag
+  analysis->setAbortExecution(false);
+
+  // Clear outdated outputs, the others are kept and aren't computed again
+  analysis->removeOutdatedOutputs();
 
   emit this->aboutToRunAnalysis(analysis);
+  if (analysis->abortExecution())
+    {
+    return;
+    }
+
+  this->startAnalysis(analysis, 0);
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::startAnalysis(voAnalysis * analysis, voDataModelItem* inputTarget)
+{
+  Q_D(voAnalysisDriver);
+  voAnalysisDriverPrivate::Execution execution;
+  execution.Analysis = analysis;
+  execution.InputTarget = inputTarget;
+  // Analyses using the embedded R interpreter or the network run on the GUI thread
+  execution.Asynchronous = d->AsynchronousExecutionEnabled && !analysis->mainThreadOnly();
+  execution.Started = !execution.Asynchronous;
+  execution.InBatch = d->SchedulingBatch;
+  execution.InputMemorySize = voAnalysisDriverPrivate::inputMemorySize(analysis);
+  execution.ScheduledTime = QDateTime::currentDateTime();
+  execution.StartTime = execution.ScheduledTime;
+  d->Executions.insert(analysis->uuid(), execution);
+  if (execution.InBatch)
+    {
+    ++d->RemainingBatchJobCount;
+    }
+
+  if (!execution.Asynchronous)
+    {
+    this->onAnalysisExecutionFinished(analysis->uuid(), this->runAnalysisUsingResultCache(analysis));
+    return;
+    }
+
+  // Outputs set by the worker thread are propagated to the data model once the execution completes
+  disconnect(analysis, SIGNAL(outputSet(const QString&, voDataObject*, voAnalysis*)),
+             this, SLOT(onAnalysisOutputSet(const QString&,voDataObject*,voAnalysis*)));
+  connect(analysis, SIGNAL(progressChanged(double)),
+          SLOT(onAnalysisProgressChanged(double)), Qt::QueuedConnection);
+
+  d->PendingExecutions << analysis->uuid();
+  d->startPendingExecutions();
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisDriver::onAnalysisProgressChanged(double progress)
+{
+  Q_D(voAnalysisDriver);
+  voAnalysis * analysis = qobject_cast<voAnalysis*>(this->sender());
+  if (!analysis || !d->Executions.contains(analysis->uuid()))
+    {
+    return;
+    }
+  emit this->analysisProgressChanged(analysis, progress);
+}
 
-  bool ret = analysis->run();
-  if (!ret)
+// --------------------------------------------------------------------------
+void voAnalysisDriver::onAnalysisExecutionFinished(const QString& analysisUuid, bool success)
+{
+  Q_D(voAnalysisDriver);
+  if (!d->Executions.contains(analysisUuid))
     {
-    qCritical() << "Analysis failed to run " << analysis->objectName();
     return;
     }
+  voAnalysisDriverPrivate::Execution execution = d->Executions.take(analysisUuid);
+  voAnalysis * analysis = execution.Analysis;
+  disconnect(analysis, SIGNAL(progressChanged(double)), this, SLOT(onAnalysisProgressChanged(double)));
+
+  QDateTime finishTime = QDateTime::currentDateTime();
+  if (execution.Asynchronous && execution.Started)
+    {
+    --d->RunningAnalysisCount;
+    d->RunningAnalysisMemorySize -= execution.InputMemorySize;
+    d->startPendingExecutions();
+    }
+  if (execution.InBatch)
+    {
+    voAnalysisDriverPrivate::BatchJob job;
+    job.AnalysisName = analysis->objectName();
+    job.InputName = execution.InputTarget ? execution.InputTarget->text() : QString();
+    job.Success = success;
+    job.Aborted = !success && analysis->abortExecution();
+    job.WaitingTime = execution.ScheduledTime.msecsTo(execution.Started ? execution.StartTime : finishTime);
+    job.RunningTime = execution.Started ? execution.StartTime.msecsTo(finishTime) : 0;
+    d->BatchJobs << job;
+    --d->RemainingBatchJobCount;
+    }
+
+  if (!success)
+    {
+    if (analysis->abortExecution())
+      {
+      qDebug() << " => Analysis" << analysis->objectName() << " ABORTED";
+      }
+    else
+      {
+      qCritical() << "Analysis failed to run " << analysis->objectName();
+      }
+    }
+
+  if (!execution.InputTarget)
+    {
+    // Update of an analysis already in the data model
+    connect(analysis, SIGNAL(outputSet(const QString&, voDataObject*, voAnalysis*)),
+            SLOT(onAnalysisOutputSet(const QString&,voDataObject*,voAnalysis*)), Qt::UniqueConnection);
+    if (success && execution.Asynchronous)
+      {
+      foreach(const QString& outputName, analysis->outputNames())
+        {
+        this->onAnalysisOutputSet(outputName, analysis->output(outputName), analysis);
+        }
+      }
+    emit this->analysisFinished(analysis, success);
+    }
+  else if (!success)
+    {
+    emit this->analysisFinished(analysis, false);
+    delete analysis;
+    }
+  else
+    {
+    voAnalysisDriver::addAnalysisToObjectModel(analysis, execution.InputTarget);
+
+    connect(analysis, SIGNAL(outputSet(const QString&, voDataObject*, voAnalysis*)),
+            SLOT(onAnalysisOutputSet(const QString&,voDataObject*,voAnalysis*)));
+
+    emit this->analysisAddedToObjectModel(analysis);
+    emit this->analysisFinished(analysis, true);
+
+    qDebug() << " => Analysis" << analysis->objectName() << " DONE";
+    }
+
+  if (execution.InBatch)
+    {
+    d->checkBatchFinished();
+    }
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisDriver::runAnalysisUsingResultCache(voAnalysis * analysis)
+{
+  Q_D(voAnalysisDriver);
+  QString resultKey;
+  if (d->ResultCacheEnabled && analysis->resultCacheable() &&
+      !voAnalysisResultCache::cacheDirectory().isEmpty())
+    {
+    resultKey = voAnalysisResultCache::key(analysis);
+    }
+  return voAnalysisResultCache::runAnalysis(resultKey, analysis);
 }
 
 // --------------------------------------------------------------------------
@@ -256,7 +750,11 @@ void voAnalysisDriver::onAnalysisOutputSet(
       model->findItemsWithRole(voDataModelItem::OutputNameRole, outputName, analysisContainer);
   foreach(voDataModelItem* item, items)
     {
-    item->setDataObject(dataObject);
+    // Outputs kept by an update are left as is, their views don't need to be refreshed
+    if (item->dataObject() != dataObject)
+      {
+      item->setDataObject(dataObject);
+      }
     }
 }
 
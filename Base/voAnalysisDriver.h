@@ -40,11 +40,66 @@ public:
 
   void runAnalysis(const QString& analysisName, voDataModelItem* inputTarget, bool acceptDefaultParameter = false);
 
+  /// If enabled (default), the outputs of an analysis already run with the same inputs
+  /// and parameter values are restored from voAnalysisResultCache instead of being computed.
+  bool resultCacheEnabled()const;
+  void setResultCacheEnabled(bool enabled);
+
+  /// If enabled, analyses are executed by a pool of worker threads: runAnalysis() and
+  /// updateAnalysis() return once the execution is scheduled and the outputs are added
+  /// to the data model by the GUI thread when it completes. The outputs of a running
+  /// analysis must not be accessed. Analyses for which voAnalysis::mainThreadOnly()
+  /// returns true are still executed synchronously. Disabled by default.
+  bool asynchronousExecutionEnabled()const;
+  void setAsynchronousExecutionEnabled(bool enabled);
+
+  /// Maximum number of analyses executed at the same time in asynchronous mode.
+  /// By default, the number of processor cores.
+  int maximumRunningAnalysisCount()const;
+  void setMaximumRunningAnalysisCount(int count);
+
+  /// In asynchronous mode, an analysis waits for running analyses to complete if the
+  /// size in bytes of its inputs, added to the size of the inputs of the running analyses,
+  /// exceeds this limit. An analysis is always started if none is running.
+  /// By default, 2GB. 0 disables the limit.
+  qint64 runningAnalysisMemoryLimit()const;
+  void setRunningAnalysisMemoryLimit(qint64 limit);
+
+  /// Analyses scheduled or running asynchronously
+  QList<voAnalysis*> runningAnalyses()const;
+
+  /// Summary of the last batch run by runAnalysisForAllInputs() or runAnalyses():
+  /// status, waiting and running time of each analysis.
+  QString batchReport()const;
+
+  /// Number of analyses of the last batch that failed or have been aborted
+  int numberOfFailedBatchAnalyses()const;
+
+  /// Run \a analyses, with their parameters already initialized, on \a inputTarget as one batch.
+  void runAnalyses(const QList<voAnalysis*>& analyses, voDataModelItem* inputTarget);
+
+  /// Block until all the analyses executed asynchronously complete and their
+  /// outputs are added to the data model.
+  void waitForAnalyses();
+
 signals:
   void aboutToRunAnalysis(voAnalysis*);
   void analysisAddedToObjectModel(voAnalysis*);
 
+  /// Progress of a running analysis, between 0 and 1
+  void analysisProgressChanged(voAnalysis* analysis, double progress);
+
+  /// Emitted once the execution of \a analysis completed, failed or has been aborted.
+  /// If it was not an update, a failed analysis is deleted right after.
+  void analysisFinished(voAnalysis* analysis, bool success);
+
+  /// Emitted once all the analyses run by runAnalysisForAllInputs() or runAnalyses() are finished
+  /// \sa batchReport()
+  void batchFinished();
+
 public slots:
+  /// Run \a analysisName on each selected input. In asynchronous mode, the analyses
+  /// are executed concurrently within the limits set on the running analyses.
   void runAnalysisForAllInputs(const QString& analysisName, bool acceptDefaultParameter = false);
 
   void runAnalysisForCurrentInput(
@@ -53,13 +108,30 @@ public slots:
   void updateAnalysis(
     voAnalysis * analysis, const QHash<QString, QVariant>& parameters);
 
+  /// Request a running analysis to stop, see voAnalysis::setAbortExecution()
+  void abortAnalysis(voAnalysis * analysis);
+  void abortAllAnalyses();
+
 protected slots:
 
   void onAnalysisOutputSet(const QString& outputName, voDataObject* dataObject, voAnalysis* analysis);
 
+  void onAnalysisProgressChanged(double progress);
+
+  /// Called by the GUI thread once \a analysisUuid has been executed
+  void onAnalysisExecutionFinished(const QString& analysisUuid, bool success);
+
 protected:
   void runAnalysis(voAnalysis * analysis, voDataModelItem* inputTarget);
 
+  /// Execute \a analysis, synchronously or not. Once done, the outputs of the analysis
+  /// are added below \a inputTarget, or updated in the data model if \a inputTarget is NULL.
+  void startAnalysis(voAnalysis * analysis, voDataModelItem* inputTarget);
+
+  /// Restore the outputs of \a analysis from the result cache or run it and store them.
+  /// \note It can be called from a worker thread.
+  bool runAnalysisUsingResultCache(voAnalysis * analysis);
+
   static void addAnalysisToObjectModel(voAnalysis * analysis, voDataModelItem* insertLocation);
 
 protected:
@@ -0,0 +1,823 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QExplicitlySharedDataPointer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QScriptEngine>
+#include <QScriptValue>
+#include <QScriptValueIterator>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QTime>
+#include <QVariant>
+#include <QWaitCondition>
+
+// Visomics includes
+#include "voAnalysis.h"
+#include "voAnalysisFactory.h"
+#include "voAnalysisPipeline.h"
+#include "voAnalysisResultCache.h"
+#include "voDataObject.h"
+#include "voDatasetCache.h"
+#include "voDelimitedTextImportSettings.h"
+#include "voFileHash.h"
+#include "voInputFileDataObject.h"
+#include "voIOManager.h"
+#include "vtkExtendedTable.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+namespace
+{
+
+// Import settings of the description and their type
+struct ImportSetting
+{
+  const char*                                               Name;
+  voDelimitedTextImportSettings::DelimitedTextReaderSettings Setting;
+  QVariant::Type                                            Type;
+};
+
+const ImportSetting ImportSettings[] =
+  {
+  {"delimiter", voDelimitedTextImportSettings::FieldDelimiterCharacters, QVariant::String},
+  {"mergeConsecutiveDelimiters", voDelimitedTextImportSettings::MergeConsecutiveDelimiters, QVariant::Bool},
+  {"useStringDelimiter", voDelimitedTextImportSettings::UseStringDelimiter, QVariant::Bool},
+  {"transpose", voDelimitedTextImportSettings::Transpose, QVariant::Bool},
+  {"columnMetaDataTypes", voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes, QVariant::Int},
+  {"columnMetaDataTypeOfInterest", voDelimitedTextImportSettings::ColumnMetaDataTypeOfInterest, QVariant::Int},
+  {"rowMetaDataTypes", voDelimitedTextImportSettings::NumberOfRowMetaDataTypes, QVariant::Int},
+  {"rowMetaDataTypeOfInterest", voDelimitedTextImportSettings::RowMetaDataTypeOfInterest, QVariant::Int},
+  {"normalization", voDelimitedTextImportSettings::NormalizationPipeline, QVariant::StringList}
+  };
+
+const char* const NodeStatusNames[] = {"not run", "running", "executed", "reused", "failed", "skipped"};
+
+//----------------------------------------------------------------------------
+/// Objects are converted to QVariantMap and arrays to QVariantList
+QVariant scriptValueToVariant(const QScriptValue& value)
+{
+  if (value.isArray())
+    {
+    QVariantList list;
+    quint32 length = value.property("length").toUInt32();
+    for (quint32 i = 0; i < length; ++i)
+      {
+      list << scriptValueToVariant(value.property(i));
+      }
+    return list;
+    }
+  if (value.isObject())
+    {
+    QVariantMap map;
+    QScriptValueIterator it(value);
+    while (it.hasNext())
+      {
+      it.next();
+      map.insert(it.name(), scriptValueToVariant(it.value()));
+      }
+    return map;
+    }
+  return value.toVariant();
+}
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+class voAnalysisPipelinePrivate
+{
+  Q_DECLARE_PUBLIC(voAnalysisPipeline);
+
+protected:
+  voAnalysisPipeline* const q_ptr;
+
+public:
+  voAnalysisPipelinePrivate(voAnalysisPipeline& object);
+  virtual ~voAnalysisPipelinePrivate();
+
+  struct Node
+  {
+    Node();
+    ~Node();
+
+    QString                        Id;
+    /// Set for import nodes
+    QString                        FileName;
+    voDelimitedTextImportSettings  Settings;
+    /// Set for analysis nodes
+    QString                        AnalysisName;
+    QHash<QString, QVariant>       ParameterValues;
+    /// Input name -> "<node id>[.<output name>]"
+    QHash<QString, QString>        Inputs;
+    QStringList                    UpstreamNodeIds;
+
+    voAnalysisPipeline::NodeStatus Status;
+    /// Hash of the inputs and parameter values the outputs have been computed for
+    QString                                     Key;
+    /// Output of an import node
+    QExplicitlySharedDataPointer<voDataObject>  Data;
+    /// Analysis holding the outputs of an analysis node
+    voAnalysis*                                 Analysis;
+
+    // Set by the worker thread executing the node
+    voAnalysis*                        NewAnalysis;
+    vtkSmartPointer<vtkExtendedTable>  NewTable;
+    QString                            NewKey;
+    bool                               Success;
+    /// The outputs of the previous run are still valid
+    bool                               Unchanged;
+    /// The outputs have been restored from voAnalysisResultCache
+    bool                               Restored;
+    int                                RunningTime;
+  };
+
+  /// Parse \a description into \a nodes, upstream nodes being listed first.
+  /// The caller takes ownership of the nodes, even if false is returned.
+  bool parseDescription(const QByteArray& description, const QString& baseDirectory,
+                        QList<Node*>& nodes)const;
+
+  /// Create the analysis of \a node and set its inputs, by the thread calling run()
+  bool prepareNode(Node* node);
+
+  /// Executed by a worker thread, or by the thread calling run() if the analysis
+  /// of the node can't run on another thread, see voAnalysis::mainThreadOnly()
+  void executeNode(Node* node);
+
+  /// Keep the outputs computed by executeNode(), by the thread calling run()
+  void finalizeNode(Node* node);
+
+  /// Data object referred to by \a reference, see voAnalysisPipeline
+  voDataObject* resolveReference(const QString& reference)const;
+
+  voAnalysisFactory       AnalysisFactory;
+  /// Node id -> Node
+  QHash<QString, Node*>   Nodes;
+  /// Upstream nodes first
+  QStringList             NodeIds;
+  QThreadPool             ThreadPool;
+  bool                    ResultCacheEnabled;
+  QString                 OutputDirectory;
+
+  /// Nodes executed by the worker threads and not yet finalized
+  QMutex                  FinishedNodesMutex;
+  QWaitCondition          NodeExecuted;
+  QList<Node*>            FinishedNodes;
+};
+
+namespace
+{
+
+// --------------------------------------------------------------------------
+class voAnalysisPipelineNodeTask : public QRunnable
+{
+public:
+  typedef voAnalysisPipelinePrivate::Node Node;
+  voAnalysisPipelineNodeTask(voAnalysisPipelinePrivate* pipelinePrivate, Node* node)
+    : PipelinePrivate(pipelinePrivate), PipelineNode(node){}
+
+  virtual void run()
+    {
+    this->PipelinePrivate->executeNode(this->PipelineNode);
+    }
+
+private:
+  voAnalysisPipelinePrivate* PipelinePrivate;
+  Node*                      PipelineNode;
+};
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+// voAnalysisPipelinePrivate::Node methods
+
+// --------------------------------------------------------------------------
+voAnalysisPipelinePrivate::Node::Node()
+{
+  this->Status = voAnalysisPipeline::NotRun;
+  this->Analysis = 0;
+  this->NewAnalysis = 0;
+  this->Success = false;
+  this->Unchanged = false;
+  this->Restored = false;
+  this->RunningTime = 0;
+}
+
+// --------------------------------------------------------------------------
+voAnalysisPipelinePrivate::Node::~Node()
+{
+  delete this->Analysis;
+  delete this->NewAnalysis;
+}
+
+// --------------------------------------------------------------------------
+// voAnalysisPipelinePrivate methods
+
+// --------------------------------------------------------------------------
+voAnalysisPipelinePrivate::voAnalysisPipelinePrivate(voAnalysisPipeline& object) : q_ptr(&object)
+{
+  this->ThreadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+  this->ResultCacheEnabled = true;
+}
+
+// --------------------------------------------------------------------------
+voAnalysisPipelinePrivate::~voAnalysisPipelinePrivate()
+{
+  this->ThreadPool.waitForDone();
+  qDeleteAll(this->Nodes);
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPipelinePrivate::parseDescription(const QByteArray& description,
+                                                 const QString& baseDirectory,
+                                                 QList<Node*>& nodes)const
+{
+  // JSON.parse doesn't evaluate the description, unlike QScriptEngine::evaluate()
+  QScriptEngine scriptEngine;
+  QScriptValue json = scriptEngine.globalObject().property("JSON");
+  QScriptValue root = json.property("parse").call(
+        json, QScriptValueList() << QScriptValue(&scriptEngine, QString::fromUtf8(description)));
+  if (scriptEngine.hasUncaughtException())
+    {
+    qCritical() << "Invalid pipeline description:" << scriptEngine.uncaughtException().toString();
+    return false;
+    }
+  QVariantList nodeDescriptions = scriptValueToVariant(root.property("nodes")).toList();
+  if (nodeDescriptions.isEmpty())
+    {
+    qCritical() << "Pipeline description has no nodes";
+    return false;
+    }
+
+  QList<Node*> unorderedNodes;
+  QSet<QString> nodeIds;
+  foreach(const QVariant& nodeDescription, nodeDescriptions)
+    {
+    QVariantMap properties = nodeDescription.toMap();
+    Node * node = new Node;
+    unorderedNodes << node;
+    node->Id = properties.value("id").toString();
+    if (node->Id.isEmpty() || node->Id.contains('.') || nodeIds.contains(node->Id))
+      {
+      qCritical() << "Pipeline node ids must be unique, non-empty and without '.':" << node->Id;
+      nodes << unorderedNodes;
+      return false;
+      }
+    nodeIds.insert(node->Id);
+
+    if (properties.contains("file") == properties.contains("analysis"))
+      {
+      qCritical() << "Pipeline node" << node->Id << "must have either a file or an analysis";
+      nodes << unorderedNodes;
+      return false;
+      }
+
+    // Import node
+    if (properties.contains("file"))
+      {
+      node->FileName = QDir(baseDirectory).absoluteFilePath(properties.value("file").toString());
+      QVariantMap settings = properties.value("settings").toMap();
+      foreach(const QString& name, settings.keys())
+        {
+        const ImportSetting * importSetting = 0;
+        for (size_t i = 0; i < sizeof(ImportSettings) / sizeof(ImportSetting); ++i)
+          {
+          if (name == QLatin1String(ImportSettings[i].Name))
+            {
+            importSetting = &ImportSettings[i];
+            }
+          }
+        QVariant value = settings.value(name);
+        if (importSetting && importSetting->Type == QVariant::StringList &&
+            value.type() == QVariant::String)
+          {
+          value = QStringList(value.toString());
+          }
+        if (!importSetting || !value.convert(importSetting->Type))
+          {
+          qCritical() << "Invalid import setting" << name << "for pipeline node" << node->Id;
+          nodes << unorderedNodes;
+          return false;
+          }
+        node->Settings.insert(importSetting->Setting, value);
+        }
+      continue;
+      }
+
+    // Analysis node
+    node->AnalysisName = properties.value("analysis").toString();
+    if (!this->AnalysisFactory.registeredAnalysisNames().contains(node->AnalysisName))
+      {
+      qCritical() << "Unknown analysis" << node->AnalysisName << "for pipeline node" << node->Id;
+      nodes << unorderedNodes;
+      return false;
+      }
+    QVariantMap parameters = properties.value("parameters").toMap();
+    foreach(const QString& id, parameters.keys())
+      {
+      node->ParameterValues.insert(id, parameters.value(id));
+      }
+    QVariantMap inputs = properties.value("inputs").toMap();
+    foreach(const QString& inputName, inputs.keys())
+      {
+      QString reference = inputs.value(inputName).toString();
+      node->Inputs.insert(inputName, reference);
+      QString upstreamNodeId = reference.section('.', 0, 0);
+      if (!node->UpstreamNodeIds.contains(upstreamNodeId))
+        {
+        node->UpstreamNodeIds << upstreamNodeId;
+        }
+      }
+    }
+
+  // Order the nodes, keeping the order of the description when possible
+  QSet<QString> orderedNodeIds;
+  while (!unorderedNodes.isEmpty())
+    {
+    bool nodeOrdered = false;
+    for (int i = 0; i < unorderedNodes.count(); ++i)
+      {
+      Node * node = unorderedNodes.at(i);
+      foreach(const QString& upstreamNodeId, node->UpstreamNodeIds)
+        {
+        if (!nodeIds.contains(upstreamNodeId))
+          {
+          qCritical() << "Pipeline node" << node->Id << "refers to unknown node" << upstreamNodeId;
+          nodes << unorderedNodes;
+          return false;
+          }
+        }
+      if (QSet<QString>::fromList(node->UpstreamNodeIds).subtract(orderedNodeIds).isEmpty())
+        {
+        nodes << unorderedNodes.takeAt(i);
+        orderedNodeIds.insert(node->Id);
+        nodeOrdered = true;
+        --i;
+        }
+      }
+    if (!nodeOrdered)
+      {
+      QStringList cycleNodeIds;
+      foreach(Node* node, unorderedNodes)
+        {
+        cycleNodeIds << node->Id;
+        }
+      qCritical() << "Pipeline has a cycle between nodes" << cycleNodeIds.join(", ");
+      nodes << unorderedNodes;
+      return false;
+      }
+    }
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPipelinePrivate::prepareNode(Node* node)
+{
+  if (node->AnalysisName.isEmpty())
+    {
+    return true;
+    }
+
+  voAnalysis * analysis = this->AnalysisFactory.createAnalysis(node->AnalysisName);
+  if (!analysis)
+    {
+    qCritical() << "Failed to create analysis" << node->AnalysisName;
+    return false;
+    }
+  node->NewAnalysis = analysis;
+  analysis->initializeInputInformation();
+  analysis->initializeOutputInformation();
+
+  analysis->initializeParameterInformation();
+  QHash<QString, QVariant> parameters;
+  if (!analysis->convertParameterValues(node->ParameterValues, parameters))
+    {
+    return false;
+    }
+  analysis->setParameterValues(parameters);
+  analysis->setAcceptDefaultParameterValues(true);
+
+  foreach(const QString& inputName, node->Inputs.keys())
+    {
+    if (!analysis->hasInput(inputName))
+      {
+      qCritical() << "Analysis" << node->AnalysisName << "has no input" << inputName;
+      return false;
+      }
+    }
+  foreach(const QString& inputName, analysis->inputNames())
+    {
+    QString reference = node->Inputs.value(inputName);
+    voDataObject * dataObject = this->resolveReference(reference);
+    if (!dataObject)
+      {
+      qCritical() << "Pipeline node" << node->Id << "- Missing input" << inputName << reference;
+      return false;
+      }
+    if (dataObject->type() != analysis->inputType(inputName))
+      {
+      qCritical() << "Pipeline node" << node->Id << "- Input" << inputName << "expects"
+                  << analysis->inputType(inputName) << "but" << reference << "is a" << dataObject->type();
+      return false;
+      }
+    analysis->setInput(inputName, dataObject);
+    }
+
+  if (!this->OutputDirectory.isEmpty())
+    {
+    QString directory = QDir(this->OutputDirectory).filePath(node->Id);
+    if (!QDir().mkpath(directory))
+      {
+      qCritical() << "Failed to create output directory" << directory;
+      return false;
+      }
+    analysis->setOutputDirectory(directory);
+    analysis->setWriteOutputsToFilesEnabled(true);
+    }
+  return true;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisPipelinePrivate::executeNode(Node* node)
+{
+  QTime runningTime;
+  runningTime.start();
+  node->Success = false;
+  node->Unchanged = false;
+  node->Restored = false;
+
+  if (node->AnalysisName.isEmpty())
+    {
+    QByteArray fileHash = voFileHash::cachedHash(node->FileName);
+    if (!fileHash.isEmpty())
+      {
+      QCryptographicHash hash(QCryptographicHash::Md5);
+      hash.addData(fileHash);
+      hash.addData(voDatasetCache::settingsHash(node->Settings));
+      node->NewKey = QString::fromLatin1(hash.result().toHex());
+      }
+    if (!node->NewKey.isEmpty() && node->NewKey == node->Key && node->Data)
+      {
+      node->Unchanged = true;
+      node->Success = true;
+      }
+    else
+      {
+      node->NewTable = vtkSmartPointer<vtkExtendedTable>::New();
+      node->Success = !node->NewKey.isEmpty() &&
+          voIOManager::readCSVFileIntoExtendedTableUsingCache(
+            node->FileName, node->NewTable.GetPointer(), node->Settings);
+      if (!node->Success)
+        {
+        qCritical() << "Failed to import" << node->FileName;
+        }
+      }
+    }
+  else
+    {
+    voAnalysis * analysis = node->NewAnalysis;
+    node->NewKey = voAnalysisResultCache::key(analysis);
+    if (!node->NewKey.isEmpty() && node->NewKey == node->Key && node->Analysis)
+      {
+      node->Unchanged = true;
+      node->Success = true;
+      }
+    else
+      {
+      QString resultKey = this->ResultCacheEnabled ? node->NewKey : QString();
+      node->Success = voAnalysisResultCache::runAnalysis(resultKey, analysis, &node->Restored);
+      analysis->moveOutputsToAnalysisThread();
+      }
+    }
+  node->RunningTime = runningTime.elapsed();
+
+  QMutexLocker locker(&this->FinishedNodesMutex);
+  this->FinishedNodes << node;
+  this->NodeExecuted.wakeAll();
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisPipelinePrivate::finalizeNode(Node* node)
+{
+  if (!node->Success)
+    {
+    node->Status = voAnalysisPipeline::Failed;
+    }
+  else if (node->Unchanged)
+    {
+    node->Status = voAnalysisPipeline::Reused;
+    }
+  else if (node->AnalysisName.isEmpty())
+    {
+    node->Data = new voInputFileDataObject(node->FileName, node->NewTable.GetPointer());
+    node->Key = node->NewKey;
+    node->Status = voAnalysisPipeline::Executed;
+    }
+  else
+    {
+    delete node->Analysis;
+    node->Analysis = node->NewAnalysis;
+    node->NewAnalysis = 0;
+    node->Key = node->NewKey;
+    node->Status = node->Restored ? voAnalysisPipeline::Reused : voAnalysisPipeline::Executed;
+    }
+  delete node->NewAnalysis;
+  node->NewAnalysis = 0;
+  node->NewTable = 0;
+  node->NewKey.clear();
+}
+
+// --------------------------------------------------------------------------
+voDataObject* voAnalysisPipelinePrivate::resolveReference(const QString& reference)const
+{
+  Node * node = this->Nodes.value(reference.section('.', 0, 0));
+  if (!node ||
+      (node->Status != voAnalysisPipeline::Executed && node->Status != voAnalysisPipeline::Reused))
+    {
+    return 0;
+    }
+  QString outputName = reference.section('.', 1);
+  if (node->AnalysisName.isEmpty())
+    {
+    return outputName.isEmpty() ? node->Data.data() : 0;
+    }
+  if (!node->Analysis)
+    {
+    return 0;
+    }
+  if (outputName.isEmpty() && node->Analysis->numberOfOutput() == 1)
+    {
+    outputName = node->Analysis->outputNames().first();
+    }
+  return node->Analysis->output(outputName);
+}
+
+// --------------------------------------------------------------------------
+// voAnalysisPipeline methods
+
+// --------------------------------------------------------------------------
+voAnalysisPipeline::voAnalysisPipeline(QObject* newParent):
+  Superclass(newParent), d_ptr(new voAnalysisPipelinePrivate(*this))
+{
+}
+
+// --------------------------------------------------------------------------
+voAnalysisPipeline::~voAnalysisPipeline()
+{
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPipeline::setDescription(const QByteArray& description, const QString& baseDirectory)
+{
+  Q_D(voAnalysisPipeline);
+  typedef voAnalysisPipelinePrivate::Node Node;
+  QList<Node*> nodes;
+  if (!d->parseDescription(description, baseDirectory, nodes))
+    {
+    qDeleteAll(nodes);
+    return false;
+    }
+
+  // Nodes having the same id and kind keep their outputs, they are reused by run()
+  // if their inputs and parameter values didn't change.
+  foreach(Node* node, nodes)
+    {
+    Node * previousNode = d->Nodes.value(node->Id);
+    if (previousNode && previousNode->AnalysisName.isEmpty() == node->AnalysisName.isEmpty())
+      {
+      node->Key = previousNode->Key;
+      node->Data = previousNode->Data;
+      node->Analysis = previousNode->Analysis;
+      previousNode->Analysis = 0;
+      }
+    }
+  qDeleteAll(d->Nodes);
+  d->Nodes.clear();
+  d->NodeIds.clear();
+  foreach(Node* node, nodes)
+    {
+    d->Nodes.insert(node->Id, node);
+    d->NodeIds << node->Id;
+    }
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPipeline::load(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    {
+    qCritical() << "Failed to read pipeline" << fileName;
+    return false;
+    }
+  return this->setDescription(file.readAll(), QFileInfo(fileName).absolutePath());
+}
+
+// --------------------------------------------------------------------------
+QStringList voAnalysisPipeline::nodeIds()const
+{
+  Q_D(const voAnalysisPipeline);
+  return d->NodeIds;
+}
+
+// --------------------------------------------------------------------------
+voAnalysisPipeline::NodeStatus voAnalysisPipeline::nodeStatus(const QString& nodeId)const
+{
+  Q_D(const voAnalysisPipeline);
+  voAnalysisPipelinePrivate::Node * node = d->Nodes.value(nodeId);
+  return node ? node->Status : Self::NotRun;
+}
+
+// --------------------------------------------------------------------------
+voDataObject* voAnalysisPipeline::output(const QString& nodeId, const QString& outputName)const
+{
+  Q_D(const voAnalysisPipeline);
+  if (nodeId.contains('.'))
+    {
+    return 0;
+    }
+  return d->resolveReference(outputName.isEmpty() ? nodeId : nodeId + "." + outputName);
+}
+
+// --------------------------------------------------------------------------
+int voAnalysisPipeline::maximumRunningNodeCount()const
+{
+  Q_D(const voAnalysisPipeline);
+  return d->ThreadPool.maxThreadCount();
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisPipeline::setMaximumRunningNodeCount(int count)
+{
+  Q_D(voAnalysisPipeline);
+  d->ThreadPool.setMaxThreadCount(qMax(1, count));
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPipeline::resultCacheEnabled()const
+{
+  Q_D(const voAnalysisPipeline);
+  return d->ResultCacheEnabled;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisPipeline::setResultCacheEnabled(bool enabled)
+{
+  Q_D(voAnalysisPipeline);
+  d->ResultCacheEnabled = enabled;
+}
+
+// --------------------------------------------------------------------------
+QString voAnalysisPipeline::outputDirectory()const
+{
+  Q_D(const voAnalysisPipeline);
+  return d->OutputDirectory;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisPipeline::setOutputDirectory(const QString& directory)
+{
+  Q_D(voAnalysisPipeline);
+  d->OutputDirectory = directory;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisPipeline::run()
+{
+  Q_D(voAnalysisPipeline);
+  typedef voAnalysisPipelinePrivate::Node Node;
+
+  foreach(Node* node, d->Nodes)
+    {
+    node->Status = Self::NotRun;
+    node->RunningTime = 0;
+    }
+
+  bool success = true;
+  int runningNodeCount = 0;
+  QList<Node*> mainThreadNodes;
+  forever
+    {
+    // Start the nodes whose upstream nodes are done. Upstream nodes being listed
+    // first, failures are propagated downstream within a single pass.
+    foreach(const QString& nodeId, d->NodeIds)
+      {
+      Node * node = d->Nodes.value(nodeId);
+      if (node->Status != Self::NotRun)
+        {
+        continue;
+        }
+      bool upstreamNodesDone = true;
+      bool upstreamNodesFailed = false;
+      foreach(const QString& upstreamNodeId, node->UpstreamNodeIds)
+        {
+        NodeStatus upstreamStatus = d->Nodes.value(upstreamNodeId)->Status;
+        upstreamNodesDone &= upstreamStatus == Self::Executed || upstreamStatus == Self::Reused;
+        upstreamNodesFailed |= upstreamStatus == Self::Failed || upstreamStatus == Self::Skipped;
+        }
+      if (upstreamNodesFailed || (upstreamNodesDone && !d->prepareNode(node)))
+        {
+        delete node->NewAnalysis;
+        node->NewAnalysis = 0;
+        node->Status = upstreamNodesFailed ? Self::Skipped : Self::Failed;
+        success = false;
+        emit this->nodeFinished(node->Id);
+        continue;
+        }
+      if (upstreamNodesDone)
+        {
+        node->Status = Self::Running;
+        ++runningNodeCount;
+        if (node->NewAnalysis && node->NewAnalysis->mainThreadOnly())
+          {
+          mainThreadNodes << node;
+          }
+        else
+          {
+          d->ThreadPool.start(new voAnalysisPipelineNodeTask(d, node));
+          }
+        }
+      }
+    // Once the other nodes are started, run those using R or the network on this thread
+    foreach(Node* node, mainThreadNodes)
+      {
+      d->executeNode(node);
+      }
+    mainThreadNodes.clear();
+    if (runningNodeCount == 0)
+      {
+      break;
+      }
+
+    // Wait for nodes to be executed
+    QList<Node*> finishedNodes;
+      {
+      QMutexLocker locker(&d->FinishedNodesMutex);
+      while (d->FinishedNodes.isEmpty())
+        {
+        d->NodeExecuted.wait(&d->FinishedNodesMutex);
+        }
+      finishedNodes = d->FinishedNodes;
+      d->FinishedNodes.clear();
+      }
+    foreach(Node* node, finishedNodes)
+      {
+      --runningNodeCount;
+      d->finalizeNode(node);
+      success &= node->Status != Self::Failed;
+      emit this->nodeFinished(node->Id);
+      }
+    }
+  d->ThreadPool.waitForDone();
+  return success;
+}
+
+// --------------------------------------------------------------------------
+QString voAnalysisPipeline::report()const
+{
+  Q_D(const voAnalysisPipeline);
+  QHash<int, int> statusCounts;
+  QString nodeReports;
+  foreach(const QString& nodeId, d->NodeIds)
+    {
+    voAnalysisPipelinePrivate::Node * node = d->Nodes.value(nodeId);
+    ++statusCounts[node->Status];
+    nodeReports.append(QString("\n  %1: %2").arg(nodeId).arg(NodeStatusNames[node->Status]));
+    if (node->Status == Self::Executed || node->Status == Self::Reused)
+      {
+      nodeReports.append(QString(" in %1s").arg(node->RunningTime / 1000., 0, 'f', 2));
+      }
+    }
+  return QString("Pipeline of %1 nodes: %2 executed, %3 reused, %4 failed, %5 skipped")
+      .arg(d->NodeIds.count()).arg(statusCounts.value(Self::Executed))
+      .arg(statusCounts.value(Self::Reused)).arg(statusCounts.value(Self::Failed))
+      .arg(statusCounts.value(Self::Skipped)) + nodeReports;
+}
@@ -0,0 +1,133 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voAnalysisPipeline_h
+#define __voAnalysisPipeline_h
+
+// Qt includes
+#include <QObject>
+#include <QScopedPointer>
+#include <QStringList>
+
+class voAnalysisPipelinePrivate;
+class voDataObject;
+
+/// Chain of analyses described in JSON and executed as a directed acyclic graph.
+///
+/// A node either imports a file or runs an analysis on the outputs of other nodes:
+/// \code
+/// {
+///   "nodes": [
+///     { "id": "data", "file": "metabolites.csv",
+///       "settings": { "columnMetaDataTypes": 2, "normalization": ["Log2", "Quantile"] } },
+///     { "id": "ttest", "analysis": "voTTest", "inputs": { "input": "data" },
+///       "parameters": { "sample1_range": "A-E", "sample2_range": "F-J" } },
+///     { "id": "correlation", "analysis": "voXCorrel", "inputs": { "input": "data" },
+///       "parameters": { "method": "spearman" } }
+///   ]
+/// }
+/// \endcode
+/// Inputs refer to "<node id>" or "<node id>.<output name>", the output name can be
+/// omitted for import nodes and for analyses with a single output. Analyses are given
+/// by class name and enumeration parameters by the name of their choice. Import settings
+/// are "delimiter", "mergeConsecutiveDelimiters", "useStringDelimiter", "transpose",
+/// "columnMetaDataTypes", "columnMetaDataTypeOfInterest", "rowMetaDataTypes",
+/// "rowMetaDataTypeOfInterest" and "normalization".
+///
+/// run() executes the nodes whose upstream nodes are done in a thread pool, independent
+/// branches run at the same time. Analyses for which voAnalysis::mainThreadOnly() returns
+/// true are executed by the thread calling run(). Each node keeps its outputs along with
+/// the hash of its inputs and parameter values, see voAnalysisResultCache::key(). When the
+/// pipeline is run again, possibly after setting a modified description, nodes whose hash
+/// didn't change keep their outputs instead of being executed.
+class voAnalysisPipeline : public QObject
+{
+  Q_OBJECT
+public:
+  typedef QObject Superclass;
+  typedef voAnalysisPipeline Self;
+  voAnalysisPipeline(QObject* newParent = 0);
+  virtual ~voAnalysisPipeline();
+
+  enum NodeStatus
+    {
+    NotRun = 0,
+    Running,
+    Executed,
+    /// Outputs kept from the previous run or restored from the result cache
+    Reused,
+    Failed,
+    /// An upstream node failed
+    Skipped
+    };
+
+  /// Set the nodes from the JSON \a description. Relative file names are resolved
+  /// against \a baseDirectory, the current directory by default.
+  /// Nodes keep the outputs of the previous description having the same id.
+  /// Return false and leave the pipeline untouched if the description is invalid,
+  /// refers to unknown nodes or analyses, or has a cycle.
+  bool setDescription(const QByteArray& description, const QString& baseDirectory = QString());
+
+  /// Read the description from \a fileName, relative file names are resolved
+  /// against the directory of \a fileName.
+  bool load(const QString& fileName);
+
+  /// Node ids, upstream nodes are listed first
+  QStringList nodeIds()const;
+
+  NodeStatus nodeStatus(const QString& nodeId)const;
+
+  /// Output \a outputName of \a nodeId, see the input references above.
+  /// Return NULL if the node has not been successfully run.
+  voDataObject* output(const QString& nodeId, const QString& outputName = QString())const;
+
+  /// Maximum number of nodes executed at the same time. Default is the number of cores.
+  int maximumRunningNodeCount()const;
+  void setMaximumRunningNodeCount(int count);
+
+  /// If enabled, outputs are also restored from and stored into voAnalysisResultCache.
+  /// Enabled by default.
+  bool resultCacheEnabled()const;
+  void setResultCacheEnabled(bool enabled);
+
+  /// If not empty, the outputs of each analysis are written into the subdirectory named
+  /// after its node. Empty by default.
+  QString outputDirectory()const;
+  void setOutputDirectory(const QString& directory);
+
+  /// Execute the nodes, return false if any of them failed. The nodes downstream
+  /// of a failed node are skipped.
+  bool run();
+
+  /// Summary of the last run: one line of counts followed by the status of each node.
+  QString report()const;
+
+signals:
+  /// Emitted by run() once \a nodeId is done, see nodeStatus()
+  void nodeFinished(const QString& nodeId);
+
+protected:
+  QScopedPointer<voAnalysisPipelinePrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(voAnalysisPipeline);
+  Q_DISABLE_COPY(voAnalysisPipeline);
+};
+
+#endif
@@ -0,0 +1,593 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+// QtPropertyBrowser includes
+#include <QtVariantPropertyManager>
+
+// Visomics includes
+#include "voAnalysis.h"
+#include "voAnalysisResultCache.h"
+#include "voCacheUsage.h"
+#include "voConfigure.h" // For Visomics_VERSION
+#include "voDataObject.h"
+#include "voTableDataObject.h"
+#include "vtkExtendedTable.h"
+
+// VTK includes
+#include <vtkAbstractArray.h>
+#include <vtkDataArray.h>
+#include <vtkDataObject.h>
+#include <vtkGenericDataObjectReader.h>
+#include <vtkGenericDataObjectWriter.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
+#include <vtkVariantArray.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// First bytes of a cache file
+const char Magic[8] = {'V', 'O', 'R', 'E', 'S', 'U', 'L', 'T'};
+
+// Incremented whenever the layout of the cache files or the keys change
+const quint32 FormatVersion = 2;
+
+// Serialization format of the cache files and of the hashed parameter values
+const int StreamVersion = QDataStream::Qt_4_7;
+
+// Size of the blocks of raw data added to a hash
+const qint64 HashBlockSize = 1 << 20;
+
+// Kind of data object stored for an output
+enum OutputKind
+  {
+  VTKDataObject = 0,
+  VTKTableDataObject,
+  VariantDataObject
+  };
+
+QString CacheDirectory;
+bool    CacheDirectoryInitialized = false;
+qint64  MaximumSize = Q_INT64_C(1) << 30;
+
+// Hash of the data objects, by uuid, along with the modification time they have been computed for
+QMutex                                              DataObjectHashesMutex;
+QHash<QString, QPair<unsigned long, QByteArray> >   DataObjectHashes;
+
+//----------------------------------------------------------------------------
+void addRawData(QCryptographicHash& hash, const char* data, qint64 size)
+{
+  for (qint64 offset = 0; offset < size; offset += HashBlockSize)
+    {
+    hash.addData(data + offset, static_cast<int>(std::min(HashBlockSize, size - offset)));
+    }
+}
+
+//----------------------------------------------------------------------------
+void addInteger(QCryptographicHash& hash, qint64 value)
+{
+  QByteArray bytes;
+  QDataStream stream(&bytes, QIODevice::WriteOnly);
+  stream.setVersion(StreamVersion);
+  stream << value;
+  hash.addData(bytes);
+}
+
+//----------------------------------------------------------------------------
+void addString(QCryptographicHash& hash, const char* value)
+{
+  QByteArray bytes(value ? value : "");
+  addInteger(hash, bytes.size());
+  hash.addData(bytes);
+}
+
+//----------------------------------------------------------------------------
+bool addArray(QCryptographicHash& hash, vtkAbstractArray* array)
+{
+  if (!array)
+    {
+    addInteger(hash, -1);
+    return true;
+    }
+  addString(hash, array->GetName());
+  addInteger(hash, array->GetDataType());
+  addInteger(hash, array->GetNumberOfComponents());
+  addInteger(hash, array->GetNumberOfTuples());
+  vtkIdType numberOfValues = array->GetNumberOfTuples() * array->GetNumberOfComponents();
+
+  vtkDataArray * dataArray = vtkDataArray::SafeDownCast(array);
+  vtkStringArray * stringArray = vtkStringArray::SafeDownCast(array);
+  vtkVariantArray * variantArray = vtkVariantArray::SafeDownCast(array);
+  if (dataArray)
+    {
+    if (numberOfValues > 0)
+      {
+      addRawData(hash, static_cast<const char*>(dataArray->GetVoidPointer(0)),
+                 numberOfValues * static_cast<qint64>(dataArray->GetDataTypeSize()));
+      }
+    }
+  else if (stringArray)
+    {
+    for (vtkIdType i = 0; i < numberOfValues; ++i)
+      {
+      addString(hash, stringArray->GetValue(i).c_str());
+      }
+    }
+  else if (variantArray)
+    {
+    for (vtkIdType i = 0; i < numberOfValues; ++i)
+      {
+      addString(hash, variantArray->GetValue(i).ToString().c_str());
+      }
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool addTable(QCryptographicHash& hash, vtkTable* table)
+{
+  addInteger(hash, table->GetNumberOfColumns());
+  for (vtkIdType cid = 0; cid < table->GetNumberOfColumns(); ++cid)
+    {
+    if (!addArray(hash, table->GetColumn(cid)))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool addExtendedTableMetaData(QCryptographicHash& hash, vtkExtendedTable* table)
+{
+  addInteger(hash, table->GetColumnMetaDataTypeOfInterest());
+  addInteger(hash, table->GetRowMetaDataTypeOfInterest());
+  bool success = addArray(hash, table->GetColumnMetaDataLabels()) &&
+      addArray(hash, table->GetRowMetaDataLabels());
+  addInteger(hash, table->GetNumberOfColumnMetaDataTypes());
+  for (vtkIdType id = 0; success && id < table->GetNumberOfColumnMetaDataTypes(); ++id)
+    {
+    success = addArray(hash, table->GetColumnMetaData(id));
+    }
+  addInteger(hash, table->GetNumberOfRowMetaDataTypes());
+  for (vtkIdType id = 0; success && id < table->GetNumberOfRowMetaDataTypes(); ++id)
+    {
+    success = addArray(hash, table->GetRowMetaData(id));
+    }
+  return success;
+}
+
+//----------------------------------------------------------------------------
+// Values of tables are modified through their columns, which don't modify the table
+unsigned long dataObjectMTime(vtkDataObject* dataObject)
+{
+  unsigned long mtime = dataObject->GetMTime();
+  vtkTable * table = vtkTable::SafeDownCast(dataObject);
+  for (vtkIdType cid = 0; table && cid < table->GetNumberOfColumns(); ++cid)
+    {
+    mtime = std::max(mtime, table->GetColumn(cid)->GetMTime());
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+QByteArray serializeDataObject(vtkDataObject* dataObject)
+{
+  vtkNew<vtkGenericDataObjectWriter> writer;
+  writer->SetInput(dataObject);
+  writer->SetFileTypeToBinary();
+  writer->WriteToOutputStringOn();
+  if (!writer->Write() || !writer->GetOutputString())
+    {
+    return QByteArray();
+    }
+  return QByteArray(writer->GetOutputString(), writer->GetOutputStringLength());
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataObject> deserializeDataObject(const QByteArray& serializedDataObject)
+{
+  vtkNew<vtkGenericDataObjectReader> reader;
+  reader->ReadFromInputStringOn();
+  reader->SetBinaryInputString(serializedDataObject.constData(), serializedDataObject.size());
+  reader->Update();
+  vtkDataObject * output = reader->GetOutput();
+  if (!output)
+    {
+    return 0;
+    }
+  // Detach the data object from the reader
+  vtkSmartPointer<vtkDataObject> dataObject;
+  dataObject.TakeReference(output->NewInstance());
+  dataObject->ShallowCopy(output);
+  return dataObject;
+}
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+QString voAnalysisResultCache::cacheDirectory()
+{
+  if (!CacheDirectoryInitialized)
+    {
+    QString location = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+    if (!location.isEmpty())
+      {
+      CacheDirectory = QDir(location).filePath("Results");
+      }
+    CacheDirectoryInitialized = true;
+    }
+  return CacheDirectory;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisResultCache::setCacheDirectory(const QString& directory)
+{
+  CacheDirectory = directory;
+  CacheDirectoryInitialized = true;
+}
+
+// --------------------------------------------------------------------------
+qint64 voAnalysisResultCache::maximumSize()
+{
+  return MaximumSize;
+}
+
+// --------------------------------------------------------------------------
+void voAnalysisResultCache::setMaximumSize(qint64 size)
+{
+  MaximumSize = size;
+}
+
+// --------------------------------------------------------------------------
+QByteArray voAnalysisResultCache::dataObjectHash(voDataObject* dataObject)
+{
+  vtkDataObject * data = dataObject ? dataObject->dataAsVTKDataObject() : 0;
+  if (!data)
+    {
+    return QByteArray();
+    }
+  unsigned long mtime = dataObjectMTime(data);
+  {
+  QMutexLocker locker(&DataObjectHashesMutex);
+  QPair<unsigned long, QByteArray> storedHash = DataObjectHashes.value(dataObject->uuid());
+  if (!storedHash.second.isEmpty() && storedHash.first == mtime)
+    {
+    return storedHash.second;
+    }
+  }
+
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  addString(hash, data->GetClassName());
+  bool success = true;
+  vtkTable * table = vtkTable::SafeDownCast(data);
+  vtkExtendedTable * extendedTable = vtkExtendedTable::SafeDownCast(data);
+  if (table)
+    {
+    success = addTable(hash, table) && (!extendedTable || addExtendedTableMetaData(hash, extendedTable));
+    }
+  else
+    {
+    QByteArray serializedData = serializeDataObject(data);
+    success = !serializedData.isEmpty();
+    hash.addData(serializedData);
+    }
+  if (!success)
+    {
+    return QByteArray();
+    }
+
+  QByteArray result = hash.result();
+  QMutexLocker locker(&DataObjectHashesMutex);
+  DataObjectHashes.insert(dataObject->uuid(), qMakePair(mtime, result));
+  return result;
+}
+
+// --------------------------------------------------------------------------
+QString voAnalysisResultCache::key(voAnalysis* analysis)
+{
+  if (!analysis)
+    {
+    return QString();
+    }
+
+  // Outputs computed by another version of the application aren't reused
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  addInteger(hash, FormatVersion);
+  addString(hash, Visomics_VERSION);
+  addString(hash, analysis->metaObject()->className());
+
+  QStringList inputNames = analysis->inputNames();
+  inputNames.sort();
+  foreach(const QString& inputName, inputNames)
+    {
+    QByteArray inputHash = voAnalysisResultCache::dataObjectHash(analysis->input(inputName));
+    if (inputHash.isEmpty())
+      {
+      return QString();
+      }
+    addString(hash, inputName.toUtf8().constData());
+    hash.addData(inputHash);
+    }
+
+  // Parameter values sorted by id, groups have no id
+  QMap<QString, QVariant> parameters;
+  QtVariantPropertyManager * propertyManager = analysis->propertyManager();
+  foreach(QtProperty* prop, propertyManager->properties())
+    {
+    if (!prop->propertyId().isEmpty())
+      {
+      parameters.insert(prop->propertyId(), propertyManager->value(prop));
+      }
+    }
+  QByteArray serializedParameters;
+  QDataStream parameterStream(&serializedParameters, QIODevice::WriteOnly);
+  parameterStream.setVersion(StreamVersion);
+  parameterStream << parameters;
+  hash.addData(serializedParameters);
+
+  return QString::fromLatin1(hash.result().toHex());
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisResultCache::read(const QString& key, voAnalysis* analysis)
+{
+  QString directory = voAnalysisResultCache::cacheDirectory();
+  if (!analysis || key.isEmpty() || directory.isEmpty())
+    {
+    return false;
+    }
+  QFile file(QDir(directory).filePath(key + ".vores"));
+  if (!file.exists() || !file.open(QIODevice::ReadOnly))
+    {
+    return false;
+    }
+
+  QDataStream stream(&file);
+  stream.setVersion(StreamVersion);
+  char magic[sizeof(Magic)];
+  if (stream.readRawData(magic, static_cast<int>(sizeof(Magic))) != static_cast<int>(sizeof(Magic)) ||
+      memcmp(magic, Magic, sizeof(Magic)) != 0)
+    {
+    return false;
+    }
+  quint32 version = 0;
+  QString className;
+  qint32 numberOfOutputs = 0;
+  stream >> version >> className >> numberOfOutputs;
+  if (stream.status() != QDataStream::Ok || version != FormatVersion ||
+      className != QLatin1String(analysis->metaObject()->className()) ||
+      numberOfOutputs < 0 || numberOfOutputs > analysis->numberOfOutput())
+    {
+    return false;
+    }
+
+  // All the outputs are read before setting any of them
+  QList<voDataObject*> outputs;
+  bool success = true;
+  for (qint32 i = 0; success && i < numberOfOutputs; ++i)
+    {
+    QString outputName;
+    qint32 kind = -1;
+    bool sortable = false;
+    stream >> outputName >> kind >> sortable;
+    success = stream.status() == QDataStream::Ok && analysis->hasOutput(outputName);
+    if (success && kind == VariantDataObject)
+      {
+      QVariant data;
+      stream >> data;
+      success = stream.status() == QDataStream::Ok && data.isValid();
+      if (success)
+        {
+        outputs << new voDataObject(outputName, data);
+        }
+      }
+    else if (success && (kind == VTKDataObject || kind == VTKTableDataObject))
+      {
+      QByteArray serializedData;
+      stream >> serializedData;
+      vtkSmartPointer<vtkDataObject> data;
+      if (stream.status() == QDataStream::Ok)
+        {
+        data = deserializeDataObject(serializedData);
+        }
+      success = data.GetPointer() != 0;
+      if (success && kind == VTKTableDataObject)
+        {
+        outputs << new voTableDataObject(outputName, data.GetPointer(), sortable);
+        }
+      else if (success)
+        {
+        outputs << new voDataObject(outputName, data.GetPointer());
+        }
+      }
+    else
+      {
+      success = false;
+      }
+    }
+  if (!success)
+    {
+    qWarning() << "Invalid analysis result cache" << file.fileName();
+    qDeleteAll(outputs);
+    return false;
+    }
+
+  // Outputs skipped by the analysis are not stored
+  QStringList storedOutputNames;
+  foreach(voDataObject* output, outputs)
+    {
+    storedOutputNames << output->name();
+    }
+  foreach(const QString& outputName, analysis->outputNames())
+    {
+    if (!storedOutputNames.contains(outputName))
+      {
+      analysis->removeOutput(outputName);
+      }
+    }
+  foreach(voDataObject* output, outputs)
+    {
+    analysis->setOutput(output->name(), output);
+    }
+  // Parameter updates can keep the restored outputs, see voAnalysis::removeOutdatedOutputs()
+  analysis->recordExecution();
+  file.close();
+  voCacheUsage::recordUse(directory, key + ".vores", "*.vores", MaximumSize);
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisResultCache::write(const QString& key, voAnalysis* analysis)
+{
+  QString directory = voAnalysisResultCache::cacheDirectory();
+  if (!analysis || key.isEmpty() || directory.isEmpty())
+    {
+    return false;
+    }
+
+  QByteArray content;
+  QDataStream stream(&content, QIODevice::WriteOnly);
+  stream.setVersion(StreamVersion);
+  stream.writeRawData(Magic, static_cast<int>(sizeof(Magic)));
+  stream << FormatVersion << QString::fromLatin1(analysis->metaObject()->className())
+         << static_cast<qint32>(analysis->numberOfOutput());
+  foreach(const QString& outputName, analysis->outputNames())
+    {
+    voDataObject * output = analysis->output(outputName);
+    if (!output)
+      {
+      return false;
+      }
+    voTableDataObject * tableOutput = qobject_cast<voTableDataObject*>(output);
+    if (output->isVTKDataObject())
+      {
+      QByteArray serializedData = serializeDataObject(output->dataAsVTKDataObject());
+      if (serializedData.isEmpty())
+        {
+        return false;
+        }
+      stream << outputName << static_cast<qint32>(tableOutput ? VTKTableDataObject : VTKDataObject)
+             << (tableOutput && tableOutput->sortable()) << serializedData;
+      }
+    else
+      {
+      stream << outputName << static_cast<qint32>(VariantDataObject) << false << output->data();
+      }
+    }
+  if (stream.status() != QDataStream::Ok)
+    {
+    return false;
+    }
+  if (MaximumSize >= 0 && content.size() > MaximumSize)
+    {
+    qDebug() << "Analysis result of" << analysis->objectName() << "exceeds the result cache maximum size";
+    return false;
+    }
+
+  if (!QDir().mkpath(directory))
+    {
+    return false;
+    }
+  QString cacheFileName = QDir(directory).filePath(key + ".vores");
+  QString temporaryFileName = cacheFileName + ".tmp";
+  QFile file(temporaryFileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  bool success = file.write(content) == content.size();
+  file.close();
+
+  QFile::remove(cacheFileName);
+  if (!success || !QFile::rename(temporaryFileName, cacheFileName))
+    {
+    QFile::remove(temporaryFileName);
+    return false;
+    }
+  voCacheUsage::recordUse(directory, key + ".vores", "*.vores", MaximumSize);
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voAnalysisResultCache::runAnalysis(const QString& key, voAnalysis* analysis, bool* restored)
+{
+  if (restored)
+    {
+    *restored = false;
+    }
+  if (!analysis)
+    {
+    return false;
+    }
+  bool useCache = !key.isEmpty() && analysis->resultCacheable();
+  if (useCache && voAnalysisResultCache::read(key, analysis))
+    {
+    qDebug() << " => Analysis" << analysis->objectName() << "restored from result cache";
+    if (analysis->writeOutputsToFilesEnabled())
+      {
+      analysis->writeOutputsToFiles(analysis->outputDirectory());
+      }
+    if (restored)
+      {
+      *restored = true;
+      }
+    return true;
+    }
+
+  if (!analysis->run())
+    {
+    return false;
+    }
+  if (useCache && !voAnalysisResultCache::cacheDirectory().isEmpty() &&
+      !voAnalysisResultCache::write(key, analysis))
+    {
+    qWarning() << "Failed to write analysis result cache for" << analysis->objectName();
+    }
+  return true;
+}
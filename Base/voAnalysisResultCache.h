@@ -0,0 +1,81 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voAnalysisResultCache_h
+#define __voAnalysisResultCache_h
+
+// Qt includes
+#include <QtGlobal>
+
+class QByteArray;
+class QString;
+class voAnalysis;
+class voDataObject;
+
+/// Cache of the outputs of the analyses, keyed by the content of their inputs,
+/// their class and their parameter values.
+///
+/// Each entry is a file named after its key. It stores the outputs in the binary
+/// VTK legacy format, or as a serialized QVariant for non-VTK outputs (e.g. QPixmap).
+/// The total size of the entries is bounded, the least recently used entries are
+/// removed first.
+namespace voAnalysisResultCache
+{
+
+/// Directory where the cache files are written. By default, the "Results" subdirectory
+/// of the cache location of the application. The cache is disabled if empty.
+QString cacheDirectory();
+void setCacheDirectory(const QString& directory);
+
+/// Maximum total size, in bytes, of the cache entries. 1GB by default, a negative size
+/// disables the limit. Once exceeded by a read or a write, the least recently used
+/// entries are removed. Entries larger than the maximum size are not written.
+qint64 maximumSize();
+void setMaximumSize(qint64 size);
+
+/// MD5 hash of the content of \a dataObject. Tables are hashed column by column,
+/// other VTK data objects through their binary serialization. The hash is computed
+/// once per modification of the data object.
+/// Return an empty array if the data object can't be hashed.
+QByteArray dataObjectHash(voDataObject* dataObject);
+
+/// Key of the outputs of \a analysis given the application version, its current inputs
+/// and parameter values. Return an empty string if an input can't be hashed.
+QString key(voAnalysis* analysis);
+
+/// Set the outputs of \a analysis from the cache entry \a key and record them as computed
+/// from its current inputs and parameter values, see voAnalysis::recordExecution().
+/// Outputs are left untouched and false is returned if the entry doesn't exist,
+/// is invalid or doesn't match the outputs declared by \a analysis.
+bool read(const QString& key, voAnalysis* analysis);
+
+/// Store the outputs of \a analysis into the cache entry \a key. The entry is written
+/// under a temporary name and renamed once complete.
+bool write(const QString& key, voAnalysis* analysis);
+
+/// Restore the outputs of \a analysis from the cache entry \a key, or run the analysis
+/// and store its outputs into that entry. The cache is bypassed if \a key is empty or
+/// if the outputs of \a analysis can't be cached, see voAnalysis::resultCacheable().
+/// Restored outputs are written to files if the analysis is configured to do so.
+/// If not NULL, \a restored is set to true when the analysis hasn't been run.
+bool runAnalysis(const QString& key, voAnalysis* analysis, bool* restored = 0);
+
+}
+
+#endif
@@ -35,12 +35,14 @@
 #include "voApplication.h"
 #include "voConfigure.h" // For Visomics_INSTALL_BIN_DIR, Visomics_INSTALL_LIB_DIR
 #include "voDataModel.h"
+#include "voDatasetCache.h"
 #include "voIOManager.h"
 #include "voNormalization.h"
 #include "voRegistry.h"
 #include "voViewManager.h"
 #include "voAnalysisFactory.h"
 #include "voViewFactory.h"
+#include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkSmartPointer.h>
@@ -121,8 +123,8 @@ QString voApplicationPrivate::discoverHomeDirectory()
 // voApplication methods
 
 // --------------------------------------------------------------------------
-voApplication::voApplication(int & argc, char ** argv):
-    Superclass(argc, argv), d_ptr(new voApplicationPrivate)
+voApplication::voApplication(int & argc, char ** argv, bool guiEnabled):
+    Superclass(argc, argv, guiEnabled), d_ptr(new voApplicationPrivate)
 {
   Q_D(voApplication);
   d->init();
@@ -153,10 +155,25 @@ void voApplication::initialize(bool& exitWhenDone)
   Q_D(voApplication);
 
   // Register normalization methods
-  this->normalizerRegistry()->registerMethod("Log2", Normalization::applyLog2);
+  this->normalizerRegistry()->registerColumnMethod("Log2", Normalization::log2Column);
+  this->normalizerRegistry()->registerColumnMethod("Median Center", Normalization::medianCenterColumn);
   this->normalizerRegistry()->registerMethod("Quantile", Normalization::applyQuantile);
+  this->normalizerRegistry()->registerColumnMethod("Z-Score", Normalization::zScoreColumn);
   
-  QWebSettings::globalSettings()->setAttribute(QWebSettings::DeveloperExtrasEnabled, true);
+  if (this->type() != QApplication::Tty)
+    {
+    QWebSettings::globalSettings()->setAttribute(QWebSettings::DeveloperExtrasEnabled, true);
+    }
+
+  // Data of more than 2GB are stored out of core, in scratch files next to the dataset cache
+  QString outOfCoreDirectory = voDatasetCache::cacheDirectory();
+  if (outOfCoreDirectory.isEmpty())
+    {
+    outOfCoreDirectory = QDir::tempPath();
+    }
+  QByteArray nativeOutOfCoreDirectory = QDir::toNativeSeparators(outOfCoreDirectory).toLocal8Bit();
+  vtkExtendedTable::SetOutOfCoreDirectory(nativeOutOfCoreDirectory.constData());
+  vtkExtendedTable::SetOutOfCoreThreshold(static_cast<vtkTypeInt64>(2) << 30);
 
   // TODO Parse command line arguments
   //d->parseArguments();
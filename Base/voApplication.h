@@ -41,7 +41,8 @@ class voApplication : public QApplication
   Q_OBJECT
 public:
   typedef QApplication Superclass;
-  voApplication(int & argc, char ** argv);
+  /// If \a guiEnabled is false, the application runs without a display, see QApplication::Tty
+  voApplication(int & argc, char ** argv, bool guiEnabled = true);
   virtual ~voApplication();
 
   /// Return a reference to the application singleton
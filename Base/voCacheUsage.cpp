@@ -0,0 +1,98 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Visomics includes
+#include "voCacheUsage.h"
+
+namespace
+{
+
+// Entries of a cache directory, from the least to the most recently used
+const char UsageFileName[] = "usage.txt";
+
+// Serialize the updates of the usage files and the removal of entries
+QMutex UsageMutex;
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+void voCacheUsage::recordUse(const QString& directory, const QString& entryFileName,
+                             const QString& nameFilter, qint64 maximumSize)
+{
+  QMutexLocker locker(&UsageMutex);
+  QDir cacheDirectory(directory);
+  QFile usageFile(cacheDirectory.filePath(UsageFileName));
+  QStringList usage;
+  if (usageFile.open(QIODevice::ReadOnly))
+    {
+    usage = QString::fromUtf8(usageFile.readAll()).split('\n', QString::SkipEmptyParts);
+    usageFile.close();
+    }
+  usage.removeAll(entryFileName);
+  usage << entryFileName;
+
+  QSet<QString> trackedEntries = usage.toSet();
+  QHash<QString, qint64> entrySizes;
+  QStringList untrackedEntries;
+  qint64 totalSize = 0;
+  foreach(const QFileInfo& entry,
+          cacheDirectory.entryInfoList(QStringList() << nameFilter, QDir::Files, QDir::Time | QDir::Reversed))
+    {
+    entrySizes.insert(entry.fileName(), entry.size());
+    totalSize += entry.size();
+    if (!trackedEntries.contains(entry.fileName()))
+      {
+      untrackedEntries << entry.fileName();
+      }
+    }
+  QStringList orderedEntries = untrackedEntries + usage;
+
+  usage.clear();
+  foreach(const QString& entry, orderedEntries)
+    {
+    if (!entrySizes.contains(entry))
+      {
+      continue;
+      }
+    if (maximumSize >= 0 && totalSize > maximumSize && entry != entryFileName &&
+        QFile::remove(cacheDirectory.filePath(entry)))
+      {
+      totalSize -= entrySizes.value(entry);
+      continue;
+      }
+    usage << entry;
+    }
+
+  if (usageFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    usageFile.write(usage.join("\n").toUtf8());
+    }
+}
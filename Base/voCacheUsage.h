@@ -0,0 +1,46 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __voCacheUsage_h
+#define __voCacheUsage_h
+
+// Qt includes
+#include <QtGlobal>
+
+class QString;
+
+/// Least recently used eviction of the files of a cache directory.
+///
+/// The names of the entries, from the least to the most recently used, are kept in
+/// a "usage.txt" file of the directory. Entries missing from it (e.g. written by
+/// another process) are considered older than the others, oldest first.
+namespace voCacheUsage
+{
+
+/// Mark the file \a entryFileName of \a directory as the most recently used entry, then
+/// remove the least recently used files matching \a nameFilter (e.g. "*.vores") until their
+/// total size is at most \a maximumSize bytes. A negative size disables the eviction.
+/// \note It can be called from several threads.
+void recordUse(const QString& directory, const QString& entryFileName,
+               const QString& nameFilter, qint64 maximumSize);
+
+}
+
+#endif
@@ -0,0 +1,1265 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QString>
+
+// Visomics includes
+#include "voClustering.h"
+#include "voConcurrentUtils.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Sum of the squared differences between x and y. Four independent accumulators
+// break the dependency chain so that the loop can be pipelined and vectorized.
+double squaredDistance(const double* x, const double* y, vtkIdType count)
+{
+  double sum0 = 0.;
+  double sum1 = 0.;
+  double sum2 = 0.;
+  double sum3 = 0.;
+  vtkIdType i = 0;
+  for (; i + 4 <= count; i += 4)
+    {
+    double d0 = x[i] - y[i];
+    double d1 = x[i + 1] - y[i + 1];
+    double d2 = x[i + 2] - y[i + 2];
+    double d3 = x[i + 3] - y[i + 3];
+    sum0 += d0 * d0;
+    sum1 += d1 * d1;
+    sum2 += d2 * d2;
+    sum3 += d3 * d3;
+    }
+  for (; i < count; ++i)
+    {
+    double d = x[i] - y[i];
+    sum0 += d * d;
+    }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+//----------------------------------------------------------------------------
+// Euclidean distance skipping the pairs involving NaN values, like the R function "dist".
+double distanceWithNaN(const double* x, const double* y, vtkIdType count)
+{
+  double sum = 0.;
+  vtkIdType validCount = 0;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    double d = x[i] - y[i];
+    if (d == d)
+      {
+      sum += d * d;
+      ++validCount;
+      }
+    }
+  if (validCount == 0)
+    {
+    return std::numeric_limits<double>::quiet_NaN();
+    }
+  return std::sqrt(sum * count / validCount);
+}
+
+//----------------------------------------------------------------------------
+// Compute the rows [begin, end) of the condensed distance matrix
+class DistanceFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  const std::vector<char>* ColumnHasNaN;
+  float* Distances;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType i = begin; i < end; ++i)
+      {
+      const double* x = this->Data + i * this->NumberOfRows;
+      float* distances = this->Distances + voClustering::condensedIndex(i, i + 1, this->NumberOfColumns);
+      for (vtkIdType j = i + 1; j < this->NumberOfColumns; ++j)
+        {
+        const double* y = this->Data + j * this->NumberOfRows;
+        double distance = ((*this->ColumnHasNaN)[i] || (*this->ColumnHasNaN)[j]) ?
+              distanceWithNaN(x, y, this->NumberOfRows) :
+              std::sqrt(squaredDistance(x, y, this->NumberOfRows));
+        *distances++ = static_cast<float>(distance);
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Objects that haven't been merged yet, as a doubly linked list allowing
+// to iterate over them and to remove any of them in constant time.
+class ActiveObjects
+{
+public:
+  ActiveObjects(vtkIdType count) : Next(count + 1), Previous(count + 1)
+    {
+    for (vtkIdType i = 0; i <= count; ++i)
+      {
+      this->Next[i] = i + 1;
+      this->Previous[i] = i - 1;
+      }
+    this->First = 0;
+    this->End = count;
+    }
+
+  vtkIdType first()const { return this->First; }
+  vtkIdType next(vtkIdType i)const { return this->Next[i]; }
+  vtkIdType end()const { return this->End; }
+
+  void remove(vtkIdType i)
+    {
+    if (i == this->First)
+      {
+      this->First = this->Next[i];
+      }
+    else
+      {
+      this->Next[this->Previous[i]] = this->Next[i];
+      }
+    this->Previous[this->Next[i]] = this->Previous[i];
+    }
+
+private:
+  std::vector<vtkIdType> Next;
+  std::vector<vtkIdType> Previous;
+  vtkIdType First;
+  vtkIdType End;
+};
+
+//----------------------------------------------------------------------------
+// Merge of the clusters represented by the objects First and Second
+struct Step
+{
+  vtkIdType First;
+  vtkIdType Second;
+  double    Distance;
+};
+
+//----------------------------------------------------------------------------
+bool StepLess(const Step& step1, const Step& step2)
+{
+  return step1.Distance < step2.Distance;
+}
+
+//----------------------------------------------------------------------------
+// Lance-Williams update: distance between cluster k and the union of clusters i and j,
+// using the same formulas as the R function "hclust".
+double lanceWilliams(voClustering::Linkage linkage, double dik, double djk, double dij,
+                     double ni, double nj, double nk)
+{
+  switch (linkage)
+    {
+    case voClustering::SingleLinkage:
+      return std::min(dik, djk);
+    case voClustering::CompleteLinkage:
+      return std::max(dik, djk);
+    case voClustering::AverageLinkage:
+      return (ni * dik + nj * djk) / (ni + nj);
+    case voClustering::McQuittyLinkage:
+      return 0.5 * (dik + djk);
+    case voClustering::MedianLinkage:
+      return 0.5 * (dik + djk) - 0.25 * dij;
+    case voClustering::CentroidLinkage:
+      return (ni * dik + nj * djk - ni * nj * dij / (ni + nj)) / (ni + nj);
+    case voClustering::WardD2Linkage:
+      // On squared distances
+      return ((ni + nk) * dik + (nj + nk) * djk - nk * dij) / (ni + nj + nk);
+    }
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+//----------------------------------------------------------------------------
+// Merge cluster i into cluster j: update the distances between j and the other active clusters
+void mergeClusters(voClustering::Linkage linkage, std::vector<float>& distances, vtkIdType count,
+                   const ActiveObjects& active, std::vector<double>& sizes,
+                   vtkIdType i, vtkIdType j, double dij)
+{
+  for (vtkIdType k = active.first(); k != active.end(); k = active.next(k))
+    {
+    if (k == i || k == j)
+      {
+      continue;
+      }
+    float& djk = distances[voClustering::condensedIndex(j, k, count)];
+    djk = static_cast<float>(lanceWilliams(linkage, distances[voClustering::condensedIndex(i, k, count)],
+                                           djk, dij, sizes[i], sizes[j], sizes[k]));
+    }
+  sizes[j] += sizes[i];
+}
+
+//----------------------------------------------------------------------------
+// Single linkage: the merges are the edges of the minimum spanning tree, built using Prim's algorithm.
+void minimumSpanningTreeLinkage(const std::vector<float>& distances, vtkIdType count, std::vector<Step>& steps)
+{
+  ActiveObjects active(count);
+  std::vector<double> treeDistances(count, std::numeric_limits<double>::infinity());
+  vtkIdType previous = active.first();
+  active.remove(previous);
+  while (active.first() != active.end())
+    {
+    Step step;
+    step.First = previous;
+    step.Second = active.first();
+    step.Distance = std::numeric_limits<double>::infinity();
+    for (vtkIdType k = active.first(); k != active.end(); k = active.next(k))
+      {
+      double distance = distances[voClustering::condensedIndex(previous, k, count)];
+      if (distance < treeDistances[k])
+        {
+        treeDistances[k] = distance;
+        }
+      if (treeDistances[k] < step.Distance)
+        {
+        step.Distance = treeDistances[k];
+        step.Second = k;
+        }
+      }
+    steps.push_back(step);
+    previous = step.Second;
+    active.remove(previous);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Nearest-neighbor chain algorithm, valid for the linkages satisfying the reducibility
+// property: complete, average, mcquitty and Ward.
+void nearestNeighborChainLinkage(voClustering::Linkage linkage, std::vector<float>& distances,
+                                 vtkIdType count, std::vector<Step>& steps)
+{
+  ActiveObjects active(count);
+  std::vector<double> sizes(count, 1.);
+  std::vector<vtkIdType> chain;
+  chain.reserve(count);
+  for (vtkIdType stepIndex = 0; stepIndex < count - 1; ++stepIndex)
+    {
+    if (chain.empty())
+      {
+      chain.push_back(active.first());
+      }
+    // Grow the chain until its last two clusters are reciprocal nearest neighbors
+    vtkIdType a;
+    vtkIdType b;
+    double minimum;
+    while (true)
+      {
+      a = chain.back();
+      b = -1;
+      minimum = std::numeric_limits<double>::infinity();
+      if (chain.size() > 1)
+        {
+        // Prefer the previous cluster of the chain in case of ties
+        b = chain[chain.size() - 2];
+        minimum = distances[voClustering::condensedIndex(a, b, count)];
+        }
+      for (vtkIdType k = active.first(); k != active.end(); k = active.next(k))
+        {
+        if (k == a)
+          {
+          continue;
+          }
+        double distance = distances[voClustering::condensedIndex(a, k, count)];
+        if (distance < minimum || b < 0)
+          {
+          minimum = distance;
+          b = k;
+          }
+        }
+      if (chain.size() > 1 && b == chain[chain.size() - 2])
+        {
+        break;
+        }
+      chain.push_back(b);
+      }
+    chain.pop_back();
+    chain.pop_back();
+
+    Step step;
+    step.First = std::min(a, b);
+    step.Second = std::max(a, b);
+    step.Distance = minimum;
+    steps.push_back(step);
+
+    mergeClusters(linkage, distances, count, active, sizes, step.First, step.Second, minimum);
+    active.remove(step.First);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Nearest neighbor of i among the active objects j > i
+void updateNearestNeighbor(const std::vector<float>& distances, vtkIdType count, const ActiveObjects& active,
+                           vtkIdType i, std::vector<vtkIdType>& neighbors, std::vector<double>& neighborDistances)
+{
+  neighbors[i] = -1;
+  neighborDistances[i] = std::numeric_limits<double>::infinity();
+  for (vtkIdType j = active.next(i); j != active.end(); j = active.next(j))
+    {
+    double distance = distances[voClustering::condensedIndex(i, j, count)];
+    if (neighbors[i] < 0 || distance < neighborDistances[i])
+      {
+      neighbors[i] = j;
+      neighborDistances[i] = distance;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Algorithm maintaining the nearest neighbor of each cluster, valid for all the linkages.
+// It is used for the median and centroid linkages, whose merge heights may decrease.
+void nearestNeighborListLinkage(voClustering::Linkage linkage, std::vector<float>& distances,
+                                vtkIdType count, std::vector<Step>& steps)
+{
+  ActiveObjects active(count);
+  std::vector<double> sizes(count, 1.);
+  std::vector<vtkIdType> neighbors(count);
+  std::vector<double> neighborDistances(count);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    updateNearestNeighbor(distances, count, active, i, neighbors, neighborDistances);
+    }
+
+  for (vtkIdType stepIndex = 0; stepIndex < count - 1; ++stepIndex)
+    {
+    // neighborDistances are lower bounds of the actual distances to the nearest neighbors,
+    // a cluster whose bound is the smallest is only merged once its bound is exact.
+    vtkIdType a;
+    while (true)
+      {
+      a = -1;
+      for (vtkIdType k = active.first(); k != active.end(); k = active.next(k))
+        {
+        if (neighbors[k] >= 0 && (a < 0 || neighborDistances[k] < neighborDistances[a]))
+          {
+          a = k;
+          }
+        }
+      if (distances[voClustering::condensedIndex(a, neighbors[a], count)] == neighborDistances[a])
+        {
+        break;
+        }
+      updateNearestNeighbor(distances, count, active, a, neighbors, neighborDistances);
+      }
+    vtkIdType b = neighbors[a];
+    Step step;
+    step.First = a;
+    step.Second = b;
+    step.Distance = neighborDistances[a];
+    steps.push_back(step);
+
+    mergeClusters(linkage, distances, count, active, sizes, a, b, step.Distance);
+    active.remove(a);
+
+    // Distances to b may have increased: bounds are kept and checked lazily
+    for (vtkIdType k = active.first(); k != b; k = active.next(k))
+      {
+      double distance = distances[voClustering::condensedIndex(k, b, count)];
+      if (neighbors[k] == a)
+        {
+        neighbors[k] = b;
+        }
+      if (distance < neighborDistances[k])
+        {
+        neighbors[k] = b;
+        neighborDistances[k] = distance;
+        }
+      }
+    updateNearestNeighbor(distances, count, active, b, neighbors, neighborDistances);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType findRoot(std::vector<vtkIdType>& parents, vtkIdType node)
+{
+  vtkIdType root = node;
+  while (parents[root] != root)
+    {
+    root = parents[root];
+    }
+  // Path compression
+  while (parents[node] != root)
+    {
+    vtkIdType next = parents[node];
+    parents[node] = root;
+    node = next;
+    }
+  return root;
+}
+
+//----------------------------------------------------------------------------
+// Convert the merged objects into the cluster labels of the R "merge" matrix, using a union-find
+// structure whose nodes are the objects followed by the clusters formed at each step.
+void labelMerges(const std::vector<Step>& steps, vtkIdType count, std::vector<voClustering::Merge>& merges)
+{
+  std::vector<vtkIdType> parents(2 * count - 1);
+  for (vtkIdType i = 0; i < 2 * count - 1; ++i)
+    {
+    parents[i] = i;
+    }
+  merges.resize(steps.size());
+  for (size_t s = 0; s < steps.size(); ++s)
+    {
+    vtkIdType nodes[2] = {findRoot(parents, steps[s].First), findRoot(parents, steps[s].Second)};
+    int labels[2];
+    for (int n = 0; n < 2; ++n)
+      {
+      parents[nodes[n]] = count + static_cast<vtkIdType>(s);
+      labels[n] = static_cast<int>(nodes[n] < count ? -(nodes[n] + 1) : nodes[n] - count + 1);
+      }
+    // Same order as R: singletons first, then increasing cluster or object numbers
+    bool swap = (labels[0] < 0 && labels[1] < 0) ? labels[0] < labels[1] :
+                (labels[0] > 0 && labels[1] > 0) ? labels[0] > labels[1] : labels[0] > 0;
+    merges[s].First = swap ? labels[1] : labels[0];
+    merges[s].Second = swap ? labels[0] : labels[1];
+    merges[s].Height = steps[s].Distance;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Reproducible pseudo-random generator (Marsaglia's 32-bit xorshift), each k-means run owns one.
+class RandomGenerator
+{
+public:
+  RandomGenerator(unsigned int seed)
+    {
+    // Scramble consecutive seeds, the state must not be zero
+    this->State = static_cast<vtkTypeUInt32>(seed) * 2654435761u + 0x9E3779B9u;
+    this->State = this->State ? this->State : 0x9E3779B9u;
+    }
+
+  /// Uniform value in [0, 1)
+  double uniform()
+    {
+    this->State ^= this->State << 13;
+    this->State ^= this->State >> 17;
+    this->State ^= this->State << 5;
+    return this->State * (1. / 4294967296.);
+    }
+
+  /// Uniform integer in [0, count)
+  vtkIdType uniformIndex(vtkIdType count)
+    {
+    return std::min(count - 1, static_cast<vtkIdType>(this->uniform() * count));
+    }
+
+private:
+  vtkTypeUInt32 State;
+};
+
+//----------------------------------------------------------------------------
+// Columns and centers of a k-means run, points are the columns of the data
+class KMeansRun
+{
+public:
+  const double* Data;
+  vtkIdType Dimension;
+  vtkIdType NumberOfPoints;
+  int K;
+  std::vector<double> Centers;
+  std::vector<int> Clusters;
+  std::vector<vtkIdType> Sizes;
+
+  const double* point(vtkIdType i)const { return this->Data + i * this->Dimension; }
+  double* center(int c) { return &this->Centers[c * this->Dimension]; }
+  const double* center(int c)const { return &this->Centers[c * this->Dimension]; }
+
+  double squaredDistanceToCenter(vtkIdType i, int c)const
+    {
+    return squaredDistance(this->point(i), this->center(c), this->Dimension);
+    }
+
+  /// Nearest center of point i, and squared distances to the nearest and second nearest centers
+  int nearestCenter(vtkIdType i, double& nearestDistance, double& secondDistance)const
+    {
+    int nearest = 0;
+    nearestDistance = std::numeric_limits<double>::infinity();
+    secondDistance = std::numeric_limits<double>::infinity();
+    for (int c = 0; c < this->K; ++c)
+      {
+      double distance = this->squaredDistanceToCenter(i, c);
+      if (distance < nearestDistance)
+        {
+        secondDistance = nearestDistance;
+        nearestDistance = distance;
+        nearest = c;
+        }
+      else if (distance < secondDistance)
+        {
+        secondDistance = distance;
+        }
+      }
+    return nearest;
+    }
+
+  /// k-means++: the first center is drawn uniformly, the next ones proportionally
+  /// to their squared distance to the closest center already chosen.
+  void seedCenters(RandomGenerator& random)
+    {
+    this->Centers.resize(this->K * this->Dimension);
+    std::vector<double> distances(this->NumberOfPoints, std::numeric_limits<double>::infinity());
+    vtkIdType chosen = random.uniformIndex(this->NumberOfPoints);
+    for (int c = 0; c < this->K; ++c)
+      {
+      std::copy(this->point(chosen), this->point(chosen) + this->Dimension, this->center(c));
+      if (c == this->K - 1)
+        {
+        break;
+        }
+      double sum = 0.;
+      for (vtkIdType i = 0; i < this->NumberOfPoints; ++i)
+        {
+        distances[i] = std::min(distances[i], this->squaredDistanceToCenter(i, c));
+        sum += distances[i];
+        }
+      if (!(sum > 0.))
+        {
+        // All the points coincide with a center
+        chosen = random.uniformIndex(this->NumberOfPoints);
+        continue;
+        }
+      double target = random.uniform() * sum;
+      chosen = this->NumberOfPoints - 1;
+      for (vtkIdType i = 0; i < this->NumberOfPoints; ++i)
+        {
+        target -= distances[i];
+        if (target < 0. && distances[i] > 0.)
+          {
+          chosen = i;
+          break;
+          }
+        }
+      }
+    }
+
+  /// Assign each point to its nearest center
+  void assignPoints()
+    {
+    this->Clusters.resize(this->NumberOfPoints);
+    for (vtkIdType i = 0; i < this->NumberOfPoints; ++i)
+      {
+      double nearestDistance;
+      double secondDistance;
+      this->Clusters[i] = this->nearestCenter(i, nearestDistance, secondDistance);
+      }
+    }
+
+  /// Move the centers to the mean of their points, empty clusters keep their center
+  void updateCenters()
+    {
+    std::vector<double> sums(this->Centers.size(), 0.);
+    this->Sizes.assign(this->K, 0);
+    for (vtkIdType i = 0; i < this->NumberOfPoints; ++i)
+      {
+      const double* x = this->point(i);
+      double* sum = &sums[this->Clusters[i] * this->Dimension];
+      for (vtkIdType d = 0; d < this->Dimension; ++d)
+        {
+        sum[d] += x[d];
+        }
+      ++this->Sizes[this->Clusters[i]];
+      }
+    for (int c = 0; c < this->K; ++c)
+      {
+      if (this->Sizes[c] == 0)
+        {
+        continue;
+        }
+      double scale = 1. / this->Sizes[c];
+      double* center = this->center(c);
+      const double* sum = &sums[c * this->Dimension];
+      for (vtkIdType d = 0; d < this->Dimension; ++d)
+        {
+        center[d] = sum[d] * scale;
+        }
+      }
+    }
+
+  /// Add (sign = 1) or remove (sign = -1) point i to/from the center c of a cluster of size n
+  void movePoint(vtkIdType i, int c, double sign)
+    {
+    double n = static_cast<double>(this->Sizes[c]);
+    double newSize = n + sign;
+    const double* x = this->point(i);
+    double* center = this->center(c);
+    for (vtkIdType d = 0; d < this->Dimension; ++d)
+      {
+      center[d] = newSize > 0. ? (center[d] * n + sign * x[d]) / newSize : center[d];
+      }
+    this->Sizes[c] += static_cast<vtkIdType>(sign);
+    }
+};
+
+//----------------------------------------------------------------------------
+// Lloyd's algorithm with Hamerly's bounds: a point can't change cluster while the
+// upper bound of the distance to its center is below the lower bound of the distance
+// to the other centers, or below half the distance between its center and the closest one.
+int lloyd(KMeansRun& run, int maximumIterations, bool& converged)
+{
+  vtkIdType n = run.NumberOfPoints;
+  std::vector<double> upperBounds(n);
+  std::vector<double> lowerBounds(n);
+  run.Clusters.resize(n);
+  for (vtkIdType i = 0; i < n; ++i)
+    {
+    double nearestDistance;
+    double secondDistance;
+    run.Clusters[i] = run.nearestCenter(i, nearestDistance, secondDistance);
+    upperBounds[i] = std::sqrt(nearestDistance);
+    lowerBounds[i] = std::sqrt(secondDistance);
+    }
+
+  std::vector<double> previousCenters;
+  std::vector<double> drifts(run.K);
+  std::vector<double> halfSeparations(run.K);
+  converged = false;
+  int iteration = 0;
+  while (iteration < maximumIterations && !converged)
+    {
+    ++iteration;
+    previousCenters = run.Centers;
+    run.updateCenters();
+    double maximumDrift = 0.;
+    for (int c = 0; c < run.K; ++c)
+      {
+      drifts[c] = std::sqrt(squaredDistance(&previousCenters[c * run.Dimension], run.center(c), run.Dimension));
+      maximumDrift = std::max(maximumDrift, drifts[c]);
+      }
+    for (vtkIdType i = 0; i < n; ++i)
+      {
+      upperBounds[i] += drifts[run.Clusters[i]];
+      lowerBounds[i] -= maximumDrift;
+      }
+    for (int c = 0; c < run.K; ++c)
+      {
+      double separation = std::numeric_limits<double>::infinity();
+      for (int other = 0; other < run.K; ++other)
+        {
+        if (other != c)
+          {
+          separation = std::min(separation, squaredDistance(run.center(c), run.center(other), run.Dimension));
+          }
+        }
+      halfSeparations[c] = 0.5 * std::sqrt(separation);
+      }
+
+    converged = true;
+    for (vtkIdType i = 0; i < n; ++i)
+      {
+      int cluster = run.Clusters[i];
+      double bound = std::max(halfSeparations[cluster], lowerBounds[i]);
+      if (upperBounds[i] <= bound)
+        {
+        continue;
+        }
+      // Tighten the upper bound before computing all the distances
+      upperBounds[i] = std::sqrt(run.squaredDistanceToCenter(i, cluster));
+      if (upperBounds[i] <= bound)
+        {
+        continue;
+        }
+      double nearestDistance;
+      double secondDistance;
+      int nearest = run.nearestCenter(i, nearestDistance, secondDistance);
+      upperBounds[i] = std::sqrt(nearestDistance);
+      lowerBounds[i] = std::sqrt(secondDistance);
+      if (nearest != cluster && nearestDistance < run.squaredDistanceToCenter(i, cluster))
+        {
+        run.Clusters[i] = nearest;
+        converged = false;
+        }
+      }
+    }
+  return iteration;
+}
+
+//----------------------------------------------------------------------------
+// MacQueen's algorithm: centers are updated as soon as a point changes cluster
+int macQueen(KMeansRun& run, int maximumIterations, bool& converged)
+{
+  run.assignPoints();
+  run.updateCenters();
+  converged = false;
+  int iteration = 0;
+  while (iteration < maximumIterations && !converged)
+    {
+    ++iteration;
+    converged = true;
+    for (vtkIdType i = 0; i < run.NumberOfPoints; ++i)
+      {
+      double nearestDistance;
+      double secondDistance;
+      int nearest = run.nearestCenter(i, nearestDistance, secondDistance);
+      int cluster = run.Clusters[i];
+      if (nearest != cluster && nearestDistance < run.squaredDistanceToCenter(i, cluster))
+        {
+        run.movePoint(i, cluster, -1.);
+        run.movePoint(i, nearest, 1.);
+        run.Clusters[i] = nearest;
+        converged = false;
+        }
+      }
+    }
+  return iteration;
+}
+
+//----------------------------------------------------------------------------
+// Hartigan-Wong algorithm (AS 136), as implemented by the R function "kmeans".
+// Moving point i from cluster a to cluster b changes the sum of squares by
+// n_b / (n_b + 1) * |x_i - c_b|^2 - n_a / (n_a - 1) * |x_i - c_a|^2.
+// The optimal transfer stage moves each point to the cluster minimizing that change,
+// only considering the clusters updated during the last pass ("live set") for the points
+// whose cluster isn't live. The quick transfer stage then only considers swapping each
+// point between its cluster and its second closest one, until none of them moves.
+class HartiganWongRun
+{
+public:
+  HartiganWongRun(KMeansRun& run):Run(run), UnchangedSteps(0)
+    {
+    vtkIdType n = run.NumberOfPoints;
+    this->SecondClusters.resize(n);
+    this->Distances.resize(n);
+    run.Clusters.resize(n);
+    for (vtkIdType i = 0; i < n; ++i)
+      {
+      double nearestDistance = std::numeric_limits<double>::infinity();
+      double secondDistance = std::numeric_limits<double>::infinity();
+      int nearest = 0;
+      int second = 1;
+      for (int c = 0; c < run.K; ++c)
+        {
+        double distance = run.squaredDistanceToCenter(i, c);
+        if (distance < nearestDistance)
+          {
+          secondDistance = nearestDistance;
+          second = nearest;
+          nearestDistance = distance;
+          nearest = c;
+          }
+        else if (distance < secondDistance)
+          {
+          secondDistance = distance;
+          second = c;
+          }
+        }
+      run.Clusters[i] = nearest;
+      this->SecondClusters[i] = second != nearest ? second : (nearest + 1) % run.K;
+      }
+    run.updateCenters();
+
+    this->RemovalFactors.resize(run.K);
+    this->AdditionFactors.resize(run.K);
+    for (int c = 0; c < run.K; ++c)
+      {
+      this->updateFactors(c);
+      }
+    this->Transferred.assign(run.K, true);
+    // Before the first pass, every cluster counts as just updated
+    this->LastUpdates.assign(run.K, -1);
+    this->Live.resize(run.K);
+    }
+
+  /// Return true if a whole pass over the points didn't move any of them
+  bool optimalTransfer()
+    {
+    KMeansRun& run = this->Run;
+    vtkIdType n = run.NumberOfPoints;
+    // Steps are numbered from 1, a cluster is live until the step stored in Live
+    for (int c = 0; c < run.K; ++c)
+      {
+      if (this->Transferred[c])
+        {
+        this->Live[c] = n + 1;
+        }
+      }
+    for (vtkIdType i = 0; i < n; ++i)
+      {
+      vtkIdType step = i + 1;
+      ++this->UnchangedSteps;
+      int cluster = run.Clusters[i];
+      if (run.Sizes[cluster] != 1)
+        {
+        if (this->LastUpdates[cluster] != 0)
+          {
+          this->Distances[i] = run.squaredDistanceToCenter(i, cluster) * this->RemovalFactors[cluster];
+          }
+        int previousSecond = this->SecondClusters[i];
+        int best = previousSecond;
+        double bestIncrease =
+          run.squaredDistanceToCenter(i, previousSecond) * this->AdditionFactors[previousSecond];
+        for (int c = 0; c < run.K; ++c)
+          {
+          if ((step >= this->Live[cluster] && step >= this->Live[c]) ||
+              c == cluster || c == previousSecond)
+            {
+            continue;
+            }
+          double distance;
+          if (!this->distanceBelow(i, c, bestIncrease / this->AdditionFactors[c], distance))
+            {
+            continue;
+            }
+          bestIncrease = distance * this->AdditionFactors[c];
+          best = c;
+          }
+        if (bestIncrease >= this->transferThreshold(i))
+          {
+          this->SecondClusters[i] = best;
+          }
+        else
+          {
+          this->UnchangedSteps = 0;
+          this->Live[cluster] = n + step;
+          this->Live[best] = n + step;
+          this->LastUpdates[cluster] = step;
+          this->LastUpdates[best] = step;
+          this->transfer(i, best);
+          }
+        }
+      if (this->UnchangedSteps == n)
+        {
+        return true;
+        }
+      }
+    for (int c = 0; c < run.K; ++c)
+      {
+      this->Transferred[c] = false;
+      this->Live[c] -= n;
+      }
+    return false;
+    }
+
+  /// Return false if the points kept moving for too many steps
+  bool quickTransfer()
+    {
+    KMeansRun& run = this->Run;
+    vtkIdType n = run.NumberOfPoints;
+    vtkIdType maximumSteps = 50 * n;
+    vtkIdType unchangedCount = 0;
+    vtkIdType step = 0;
+    for (;;)
+      {
+      for (vtkIdType i = 0; i < n; ++i)
+        {
+        ++unchangedCount;
+        ++step;
+        if (step >= maximumSteps)
+          {
+          return false;
+          }
+        int cluster = run.Clusters[i];
+        int second = this->SecondClusters[i];
+        if (run.Sizes[cluster] != 1)
+          {
+          if (step <= this->LastUpdates[cluster])
+            {
+            this->Distances[i] = run.squaredDistanceToCenter(i, cluster) * this->RemovalFactors[cluster];
+            }
+          double distance;
+          if ((step < this->LastUpdates[cluster] || step < this->LastUpdates[second]) &&
+              this->distanceBelow(i, second, this->transferThreshold(i) / this->AdditionFactors[second], distance))
+            {
+            unchangedCount = 0;
+            this->UnchangedSteps = 0;
+            this->Transferred[cluster] = true;
+            this->Transferred[second] = true;
+            this->LastUpdates[cluster] = step + n;
+            this->LastUpdates[second] = step + n;
+            this->transfer(i, second);
+            }
+          }
+        if (unchangedCount == n)
+          {
+          return true;
+          }
+        }
+      }
+    }
+
+  /// Reset the update steps between two optimal transfer stages
+  void resetLastUpdates()
+    {
+    this->LastUpdates.assign(this->Run.K, 0);
+    }
+
+private:
+  KMeansRun& Run;
+  /// Second closest cluster of each point
+  std::vector<int> SecondClusters;
+  /// Decrease of the sum of squares when removing each point from its cluster
+  std::vector<double> Distances;
+  /// n / (n - 1) and n / (n + 1) for each cluster of size n
+  std::vector<double> RemovalFactors;
+  std::vector<double> AdditionFactors;
+  /// Clusters updated during the last quick transfer stage
+  std::vector<bool> Transferred;
+  /// Step at which each cluster was last updated
+  std::vector<vtkIdType> LastUpdates;
+  std::vector<vtkIdType> Live;
+  /// Number of steps since the last transfer, shared by both stages
+  vtkIdType UnchangedSteps;
+
+  void updateFactors(int c)
+    {
+    double size = static_cast<double>(this->Run.Sizes[c]);
+    this->RemovalFactors[c] = size > 1. ? size / (size - 1.) : std::numeric_limits<double>::max();
+    this->AdditionFactors[c] = size / (size + 1.);
+    }
+
+  /// Increase of the sum of squares below which point i is moved to another cluster.
+  /// Ties up to rounding errors are ignored, the point would keep moving back and forth.
+  double transferThreshold(vtkIdType i)const
+    {
+    return this->Distances[i] * (1. - 1e-12);
+    }
+
+  /// Squared distance between point i and center c, stop as soon as it reaches \a limit
+  bool distanceBelow(vtkIdType i, int c, double limit, double& distance)const
+    {
+    // The limit is NaN when comparing an empty cluster to a point lying on its center
+    if (!(limit > 0.))
+      {
+      return false;
+      }
+    const double* x = this->Run.point(i);
+    const double* center = this->Run.center(c);
+    distance = 0.;
+    for (vtkIdType d = 0; d < this->Run.Dimension; ++d)
+      {
+      double difference = x[d] - center[d];
+      distance += difference * difference;
+      if (distance >= limit)
+        {
+        return false;
+        }
+      }
+    return true;
+    }
+
+  void transfer(vtkIdType i, int to)
+    {
+    int from = this->Run.Clusters[i];
+    this->Run.movePoint(i, from, -1.);
+    this->Run.movePoint(i, to, 1.);
+    this->updateFactors(from);
+    this->updateFactors(to);
+    this->Run.Clusters[i] = to;
+    this->SecondClusters[i] = from;
+    }
+};
+
+//----------------------------------------------------------------------------
+int hartiganWong(KMeansRun& run, int maximumIterations, bool& converged)
+{
+  if (run.K < 2)
+    {
+    run.assignPoints();
+    run.updateCenters();
+    converged = true;
+    return 1;
+    }
+  HartiganWongRun hartiganWongRun(run);
+  converged = false;
+  int iteration = 0;
+  while (iteration < maximumIterations)
+    {
+    ++iteration;
+    if (hartiganWongRun.optimalTransfer())
+      {
+      converged = true;
+      break;
+      }
+    if (!hartiganWongRun.quickTransfer())
+      {
+      break;
+      }
+    // With two clusters, the quick transfer stage considers every possible transfer
+    if (run.K == 2)
+      {
+      converged = true;
+      break;
+      }
+    hartiganWongRun.resetLastUpdates();
+    }
+  return iteration;
+}
+
+//----------------------------------------------------------------------------
+// Compute the k-means runs [begin, end)
+class KMeansFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  int K;
+  int MaximumIterations;
+  voClustering::KMeansAlgorithm Algorithm;
+  unsigned int Seed;
+  std::vector<voClustering::KMeansResult>* Results;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType s = begin; s < end; ++s)
+      {
+      RandomGenerator random(this->Seed + static_cast<unsigned int>(s));
+      KMeansRun run;
+      run.Data = this->Data;
+      run.Dimension = this->NumberOfRows;
+      run.NumberOfPoints = this->NumberOfColumns;
+      run.K = this->K;
+      run.seedCenters(random);
+
+      voClustering::KMeansResult& result = (*this->Results)[s];
+      switch (this->Algorithm)
+        {
+        case voClustering::HartiganWong:
+          result.Iterations = hartiganWong(run, this->MaximumIterations, result.Converged);
+          break;
+        case voClustering::Lloyd:
+        case voClustering::Forgy:
+          result.Iterations = lloyd(run, this->MaximumIterations, result.Converged);
+          break;
+        case voClustering::MacQueen:
+          result.Iterations = macQueen(run, this->MaximumIterations, result.Converged);
+          break;
+        }
+
+      // Incremental updates accumulate rounding errors, recompute the centers from scratch
+      run.updateCenters();
+      result.WithinSumOfSquares.assign(this->K, 0.);
+      for (vtkIdType i = 0; i < this->NumberOfColumns; ++i)
+        {
+        result.WithinSumOfSquares[run.Clusters[i]] += run.squaredDistanceToCenter(i, run.Clusters[i]);
+        }
+      result.Centers.swap(run.Centers);
+      result.Clusters.swap(run.Clusters);
+      result.Sizes.swap(run.Sizes);
+      }
+    }
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool voClustering::linkageFromString(const QString& linkageName, Linkage& linkage)
+{
+  if (linkageName == QLatin1String("single"))
+    {
+    linkage = voClustering::SingleLinkage;
+    }
+  else if (linkageName == QLatin1String("complete"))
+    {
+    linkage = voClustering::CompleteLinkage;
+    }
+  else if (linkageName == QLatin1String("average"))
+    {
+    linkage = voClustering::AverageLinkage;
+    }
+  else if (linkageName == QLatin1String("mcquitty"))
+    {
+    linkage = voClustering::McQuittyLinkage;
+    }
+  else if (linkageName == QLatin1String("median"))
+    {
+    linkage = voClustering::MedianLinkage;
+    }
+  else if (linkageName == QLatin1String("centroid"))
+    {
+    linkage = voClustering::CentroidLinkage;
+    }
+  else if (linkageName == QLatin1String("ward.D2"))
+    {
+    linkage = voClustering::WardD2Linkage;
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void voClustering::columnDistances(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                   std::vector<float>& distances)
+{
+  distances.resize(numberOfColumns > 1 ? numberOfColumns * (numberOfColumns - 1) / 2 : 0);
+  if (distances.empty())
+    {
+    return;
+    }
+
+  std::vector<char> columnHasNaN(numberOfColumns, 0);
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    const double* column = data + c * numberOfRows;
+    for (vtkIdType r = 0; r < numberOfRows && !columnHasNaN[c]; ++r)
+      {
+      columnHasNaN[c] = (column[r] != column[r]);
+      }
+    }
+
+  DistanceFunctor functor;
+  functor.Data = data;
+  functor.NumberOfRows = numberOfRows;
+  functor.NumberOfColumns = numberOfColumns;
+  functor.ColumnHasNaN = &columnHasNaN;
+  functor.Distances = &distances[0];
+  // The first rows of the condensed matrix are the longest, keep the ranges small to balance the load
+  voConcurrentUtils::parallelFor(numberOfColumns - 1, functor, 16);
+}
+
+//----------------------------------------------------------------------------
+bool voClustering::hierarchicalClustering(std::vector<float>& distances, vtkIdType count, Linkage linkage,
+                                          std::vector<Merge>& merges)
+{
+  merges.clear();
+  if (count < 2 || static_cast<vtkIdType>(distances.size()) != count * (count - 1) / 2)
+    {
+    return false;
+    }
+  for (size_t i = 0; i < distances.size(); ++i)
+    {
+    if (!(std::fabs(distances[i]) <= std::numeric_limits<float>::max()))
+      {
+      return false;
+      }
+    }
+
+  std::vector<Step> steps;
+  steps.reserve(count - 1);
+  switch (linkage)
+    {
+    case voClustering::SingleLinkage:
+      minimumSpanningTreeLinkage(distances, count, steps);
+      std::stable_sort(steps.begin(), steps.end(), StepLess);
+      break;
+    case voClustering::CompleteLinkage:
+    case voClustering::AverageLinkage:
+    case voClustering::McQuittyLinkage:
+      nearestNeighborChainLinkage(linkage, distances, count, steps);
+      std::stable_sort(steps.begin(), steps.end(), StepLess);
+      break;
+    case voClustering::WardD2Linkage:
+      for (size_t i = 0; i < distances.size(); ++i)
+        {
+        distances[i] *= distances[i];
+        }
+      nearestNeighborChainLinkage(linkage, distances, count, steps);
+      std::stable_sort(steps.begin(), steps.end(), StepLess);
+      for (size_t s = 0; s < steps.size(); ++s)
+        {
+        steps[s].Distance = std::sqrt(steps[s].Distance);
+        }
+      break;
+    case voClustering::MedianLinkage:
+    case voClustering::CentroidLinkage:
+      // Heights aren't monotonic, steps are kept in the order they happened
+      nearestNeighborListLinkage(linkage, distances, count, steps);
+      break;
+    }
+
+  labelMerges(steps, count, merges);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voClustering::kMeansAlgorithmFromString(const QString& algorithmName, KMeansAlgorithm& algorithm)
+{
+  if (algorithmName == QLatin1String("Hartigan-Wong"))
+    {
+    algorithm = voClustering::HartiganWong;
+    }
+  else if (algorithmName == QLatin1String("Lloyd"))
+    {
+    algorithm = voClustering::Lloyd;
+    }
+  else if (algorithmName == QLatin1String("Forgy"))
+    {
+    algorithm = voClustering::Forgy;
+    }
+  else if (algorithmName == QLatin1String("MacQueen"))
+    {
+    algorithm = voClustering::MacQueen;
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voClustering::kMeans(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns, int k,
+                          int maximumIterations, int numberOfStarts, KMeansAlgorithm algorithm, unsigned int seed,
+                          KMeansResult& result)
+{
+  if (!data || k < 1 || k > numberOfColumns || numberOfRows < 1)
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < numberOfRows * numberOfColumns; ++i)
+    {
+    if (!(std::fabs(data[i]) <= std::numeric_limits<double>::max()))
+      {
+      return false;
+      }
+    }
+
+  std::vector<KMeansResult> results(std::max(1, numberOfStarts));
+  KMeansFunctor functor;
+  functor.Data = data;
+  functor.NumberOfRows = numberOfRows;
+  functor.NumberOfColumns = numberOfColumns;
+  functor.K = k;
+  functor.MaximumIterations = std::max(1, maximumIterations);
+  functor.Algorithm = algorithm;
+  functor.Seed = seed;
+  functor.Results = &results;
+  voConcurrentUtils::parallelFor(static_cast<vtkIdType>(results.size()), functor, 1);
+
+  // Keep the first run having the smallest total within-cluster sum of squares
+  size_t best = 0;
+  double bestTotal = std::numeric_limits<double>::infinity();
+  for (size_t s = 0; s < results.size(); ++s)
+    {
+    double total = 0.;
+    for (int c = 0; c < k; ++c)
+      {
+      total += results[s].WithinSumOfSquares[c];
+      }
+    if (total < bestTotal)
+      {
+      bestTotal = total;
+      best = s;
+      }
+    }
+  result = results[best];
+  return true;
+}
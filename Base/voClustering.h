@@ -0,0 +1,141 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voClustering_h
+#define __voClustering_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class QString;
+
+/// Native implementation of the clustering algorithms performed by the analyses.
+///
+/// Input matrices are stored column-major, like vtkExtendedTable::GetDataBuffer(): the value
+/// at row \a r and column \a c of a matrix having \a numberOfRows rows is located at
+/// index c * numberOfRows + r. Columns (experiments) are clustered.
+///
+/// Distances between \a count objects are stored in condensed form: the upper triangle of
+/// the distance matrix, row by row, without the diagonal. See condensedIndex().
+namespace voClustering
+{
+
+/// Agglomeration methods, see the R function "hclust"
+enum Linkage
+  {
+  SingleLinkage = 0,
+  CompleteLinkage,
+  AverageLinkage,
+  McQuittyLinkage,
+  MedianLinkage,
+  CentroidLinkage,
+  WardD2Linkage
+  };
+
+/// Merge of two clusters. Like the "merge" matrix of the R function "hclust", negative
+/// values are singletons (-1 being the first object) and positive values refer to the
+/// cluster formed at an earlier step (1 being the first step).
+struct Merge
+{
+  int    First;
+  int    Second;
+  double Height;
+};
+
+/// Convert "single", "complete", "average", "mcquitty", "median", "centroid" or "ward.D2"
+/// into the associated linkage. Return false if \a linkageName doesn't match any linkage.
+bool linkageFromString(const QString& linkageName, Linkage& linkage);
+
+/// Index of the distance between the objects \a i and \a j (i != j) in a condensed
+/// distance matrix of \a count objects.
+inline vtkIdType condensedIndex(vtkIdType i, vtkIdType j, vtkIdType count)
+{
+  if (i > j)
+    {
+    vtkIdType tmp = i;
+    i = j;
+    j = tmp;
+    }
+  return i * (2 * count - i - 1) / 2 + j - i - 1;
+}
+
+/// Euclidean distances between the columns of \a data, like the R expression "dist(t(data))".
+/// Like R, NaN values are skipped and the sum of squares is scaled up proportionally.
+/// \a distances is resized to hold the numberOfColumns * (numberOfColumns - 1) / 2 condensed distances,
+/// rows of the condensed matrix are computed concurrently.
+void columnDistances(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                     std::vector<float>& distances);
+
+/// Agglomerative hierarchical clustering of \a count objects, like the R function "hclust".
+/// Single linkage uses the minimum spanning tree of the objects, complete, average, mcquitty
+/// and Ward linkages use the nearest-neighbor chain algorithm, median and centroid linkages
+/// maintain a list of nearest neighbors. All of them run in O(count^2) memory.
+/// \a distances is used as workspace and is modified.
+/// \a merges receives the count - 1 merges, ordered by step.
+/// Return false if there are less than 2 objects or if some distances aren't finite.
+bool hierarchicalClustering(std::vector<float>& distances, vtkIdType count, Linkage linkage,
+                            std::vector<Merge>& merges);
+
+/// Variants of the k-means algorithm, see the R function "kmeans"
+enum KMeansAlgorithm
+  {
+  HartiganWong = 0,
+  Lloyd,
+  Forgy,
+  MacQueen
+  };
+
+/// Partition of the columns computed by kMeans()
+struct KMeansResult
+{
+  /// Center c spans the indices [c * numberOfRows, (c + 1) * numberOfRows)
+  std::vector<double> Centers;
+  /// Cluster of each column, from 0 to k - 1
+  std::vector<int> Clusters;
+  /// Within-cluster sum of squares of each cluster
+  std::vector<double> WithinSumOfSquares;
+  /// Number of columns of each cluster
+  std::vector<vtkIdType> Sizes;
+  int Iterations;
+  bool Converged;
+};
+
+/// Convert "Hartigan-Wong", "Lloyd", "Forgy" or "MacQueen" into the associated algorithm.
+/// Return false if \a algorithmName doesn't match any algorithm.
+bool kMeansAlgorithmFromString(const QString& algorithmName, KMeansAlgorithm& algorithm);
+
+/// Partition the columns of \a data into \a k clusters, like the R function "kmeans".
+/// Each of the \a numberOfStarts runs is seeded using k-means++, whereas R draws the initial
+/// centers among the columns at random, so results may differ from R's for the same data.
+/// The runs are computed concurrently, the one having the smallest total within-cluster
+/// sum of squares is kept.
+/// Lloyd and Forgy use Hamerly's bounds to skip most distance computations, Hartigan-Wong
+/// follows the optimal and quick transfer stages of the AS 136 algorithm used by R.
+/// Runs are reproducible: run s uses a random generator initialized from \a seed + s.
+/// Return false if \a k isn't in [1, numberOfColumns] or if some values aren't finite.
+bool kMeans(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns, int k,
+            int maximumIterations, int numberOfStarts, KMeansAlgorithm algorithm, unsigned int seed,
+            KMeansResult& result);
+
+}
+
+#endif
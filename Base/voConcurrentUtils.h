@@ -0,0 +1,89 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voConcurrentUtils_h
+#define __voConcurrentUtils_h
+
+// Qt includes
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
+
+// VTK includes
+#include <vtkType.h>
+
+namespace voConcurrentUtils
+{
+
+//----------------------------------------------------------------------------
+template<typename Functor>
+struct RangeTask
+{
+  Functor*  Function;
+  vtkIdType Begin;
+  vtkIdType End;
+};
+
+//----------------------------------------------------------------------------
+template<typename Functor>
+void runRangeTask(RangeTask<Functor>& task)
+{
+  (*task.Function)(task.Begin, task.End);
+}
+
+//----------------------------------------------------------------------------
+/// Split [0, count) into contiguous ranges and call functor(begin, end) for each
+/// of them using the global QThreadPool. The call blocks until all ranges are processed.
+/// If \a grainSize is not strictly positive, the range size is chosen so that each
+/// thread gets a few ranges to balance the load.
+/// \note \a functor is shared by all the threads, its operator() must be reentrant.
+template<typename Functor>
+void parallelFor(vtkIdType count, Functor& functor, vtkIdType grainSize = 0)
+{
+  if (count <= 0)
+    {
+    return;
+    }
+  if (grainSize <= 0)
+    {
+    vtkIdType threadCount = qMax(1, QThread::idealThreadCount());
+    grainSize = qMax(static_cast<vtkIdType>(1), count / (4 * threadCount));
+    }
+  if (grainSize >= count)
+    {
+    functor(0, count);
+    return;
+    }
+
+  QVector<RangeTask<Functor> > tasks;
+  tasks.reserve(static_cast<int>((count + grainSize - 1) / grainSize));
+  for (vtkIdType begin = 0; begin < count; begin += grainSize)
+    {
+    RangeTask<Functor> task;
+    task.Function = &functor;
+    task.Begin = begin;
+    task.End = qMin(count, begin + grainSize);
+    tasks << task;
+    }
+  QtConcurrent::blockingMap(tasks, &runRangeTask<Functor>);
+}
+
+}
+
+#endif
@@ -0,0 +1,649 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QString>
+
+// Visomics includes
+#include "voConcurrentUtils.h"
+#include "voCorrelation.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+// Number of rows of a tile of the correlation matrix
+const vtkIdType RowBlockSize = 64;
+
+// Number of columns accumulated at once for a given tile
+const vtkIdType ColumnBlockSize = 256;
+
+//----------------------------------------------------------------------------
+inline double dot(const double* a, const double* b, vtkIdType count)
+{
+  // Independent accumulators allow the compiler to vectorize the loop
+  double sum0 = 0., sum1 = 0., sum2 = 0., sum3 = 0.;
+  vtkIdType k = 0;
+  for (; k + 3 < count; k += 4)
+    {
+    sum0 += a[k] * b[k];
+    sum1 += a[k + 1] * b[k + 1];
+    sum2 += a[k + 2] * b[k + 2];
+    sum3 += a[k + 3] * b[k + 3];
+    }
+  for (; k < count; ++k)
+    {
+    sum0 += a[k] * b[k];
+    }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+//----------------------------------------------------------------------------
+// Center each row and scale it to unit norm. Return false for constant rows.
+void standardizeRows(double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                     std::vector<char>& validRows)
+{
+  validRows.assign(numberOfRows, 1);
+  for (vtkIdType r = 0; r < numberOfRows; ++r)
+    {
+    double* row = data + r * numberOfColumns;
+    double mean = 0.;
+    for (vtkIdType c = 0; c < numberOfColumns; ++c)
+      {
+      mean += row[c];
+      }
+    mean /= numberOfColumns;
+    double sumOfSquares = 0.;
+    for (vtkIdType c = 0; c < numberOfColumns; ++c)
+      {
+      row[c] -= mean;
+      sumOfSquares += row[c] * row[c];
+      }
+    if (sumOfSquares <= 0. || vtkMath::IsNan(sumOfSquares))
+      {
+      validRows[r] = 0;
+      continue;
+      }
+    double scale = 1. / std::sqrt(sumOfSquares);
+    for (vtkIdType c = 0; c < numberOfColumns; ++c)
+      {
+      row[c] *= scale;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute tiles of the (symmetric) matrix of dot products of standardized rows.
+// Each tile is either copied into the columns of the dense output matrix, or thresholded into a list of edges.
+class PearsonTileFunctor
+{
+public:
+  const double* Data;
+  const char* ValidRows;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  std::vector<std::pair<vtkIdType, vtkIdType> > Tiles;
+
+  // Dense output, one buffer per column
+  double* const* Correlation;
+
+  // Sparse output
+  double Threshold;
+  std::vector<std::vector<voCorrelation::Edge> >* TileEdges;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    std::vector<double> tile(RowBlockSize * RowBlockSize);
+    for (vtkIdType t = begin; t < end; ++t)
+      {
+      vtkIdType rowBegin = this->Tiles[t].first * RowBlockSize;
+      vtkIdType rowEnd = std::min(rowBegin + RowBlockSize, this->NumberOfRows);
+      vtkIdType columnBegin = this->Tiles[t].second * RowBlockSize;
+      vtkIdType columnEnd = std::min(columnBegin + RowBlockSize, this->NumberOfRows);
+      this->computeTile(rowBegin, rowEnd, columnBegin, columnEnd, &tile[0]);
+
+      for (vtkIdType i = rowBegin; i < rowEnd; ++i)
+        {
+        const double* tileRow = &tile[(i - rowBegin) * RowBlockSize];
+        for (vtkIdType j = std::max(columnBegin, i); j < columnEnd; ++j)
+          {
+          double value = tileRow[j - columnBegin];
+          if (this->Correlation)
+            {
+            this->Correlation[j][i] = value;
+            this->Correlation[i][j] = value;
+            }
+          else if (j != i && std::fabs(value) > this->Threshold)
+            {
+            voCorrelation::Edge edge;
+            edge.First = i;
+            edge.Second = j;
+            edge.Value = value;
+            (*this->TileEdges)[t].push_back(edge);
+            }
+          }
+        }
+      }
+    }
+
+  // Fill tile[(i - rowBegin) * RowBlockSize + (j - columnBegin)] for j >= i
+  void computeTile(vtkIdType rowBegin, vtkIdType rowEnd,
+                   vtkIdType columnBegin, vtkIdType columnEnd, double* tile)const
+    {
+    std::fill(tile, tile + RowBlockSize * RowBlockSize, 0.);
+
+    // Accumulate partial dot products so that both groups of rows stay in cache
+    for (vtkIdType k = 0; k < this->NumberOfColumns; k += ColumnBlockSize)
+      {
+      vtkIdType count = std::min(ColumnBlockSize, this->NumberOfColumns - k);
+      for (vtkIdType i = rowBegin; i < rowEnd; ++i)
+        {
+        const double* rowI = this->Data + i * this->NumberOfColumns + k;
+        double* tileRow = tile + (i - rowBegin) * RowBlockSize;
+        for (vtkIdType j = std::max(columnBegin, i); j < columnEnd; ++j)
+          {
+          const double* rowJ = this->Data + j * this->NumberOfColumns + k;
+          tileRow[j - columnBegin] += dot(rowI, rowJ, count);
+          }
+        }
+      }
+
+    for (vtkIdType i = rowBegin; i < rowEnd; ++i)
+      {
+      double* tileRow = tile + (i - rowBegin) * RowBlockSize;
+      for (vtkIdType j = std::max(columnBegin, i); j < columnEnd; ++j)
+        {
+        double& value = tileRow[j - columnBegin];
+        if (!this->ValidRows[i] || !this->ValidRows[j])
+          {
+          value = vtkMath::Nan();
+          }
+        else if (i == j)
+          {
+          value = 1.;
+          }
+        else
+          {
+          value = std::max(-1., std::min(1., value));
+          }
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+bool edgeLess(const voCorrelation::Edge& a, const voCorrelation::Edge& b)
+{
+  if (a.First != b.First)
+    {
+    return a.First < b.First;
+    }
+  return a.Second < b.Second;
+}
+
+//----------------------------------------------------------------------------
+// Compute the dense matrix if \a correlation is not null, the thresholded edges otherwise.
+void pearsonMatrix(double* standardizedData, const std::vector<char>& validRows,
+                   vtkIdType numberOfRows, vtkIdType numberOfColumns, double* const* correlation,
+                   double threshold, std::vector<voCorrelation::Edge>* edges)
+{
+  PearsonTileFunctor functor;
+  functor.Data = standardizedData;
+  functor.ValidRows = &validRows[0];
+  functor.NumberOfRows = numberOfRows;
+  functor.NumberOfColumns = numberOfColumns;
+  functor.Correlation = correlation;
+  functor.Threshold = threshold;
+
+  vtkIdType numberOfBlocks = (numberOfRows + RowBlockSize - 1) / RowBlockSize;
+  for (vtkIdType rowBlock = 0; rowBlock < numberOfBlocks; ++rowBlock)
+    {
+    for (vtkIdType columnBlock = rowBlock; columnBlock < numberOfBlocks; ++columnBlock)
+      {
+      functor.Tiles.push_back(std::make_pair(rowBlock, columnBlock));
+      }
+    }
+  std::vector<std::vector<voCorrelation::Edge> > tileEdges(correlation ? 0 : functor.Tiles.size());
+  functor.TileEdges = &tileEdges;
+
+  voConcurrentUtils::parallelFor(static_cast<vtkIdType>(functor.Tiles.size()), functor, 1);
+
+  if (!correlation)
+    {
+    for (size_t t = 0; t < tileEdges.size(); ++t)
+      {
+      edges->insert(edges->end(), tileEdges[t].begin(), tileEdges[t].end());
+      }
+    std::sort(edges->begin(), edges->end(), edgeLess);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Return true if one of the values is NaN. NaN isn't ordered, such values can't be sorted.
+bool containsNan(const double* values, vtkIdType count)
+{
+  for (vtkIdType k = 0; k < count; ++k)
+    {
+    if (vtkMath::IsNan(values[k]))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+// Values must not contain NaN, see containsNan()
+class IndexValueLess
+{
+public:
+  IndexValueLess(const double* values) : Values(values){}
+  bool operator()(vtkIdType a, vtkIdType b)const
+    {
+    if (this->Values[a] != this->Values[b])
+      {
+      return this->Values[a] < this->Values[b];
+      }
+    return a < b;
+    }
+  const double* Values;
+};
+
+//----------------------------------------------------------------------------
+// Return the number of pairs of tied values, given sorted values.
+double tiedPairCount(const double* sortedValues, vtkIdType count)
+{
+  double ties = 0.;
+  vtkIdType runLength = 1;
+  for (vtkIdType k = 1; k <= count; ++k)
+    {
+    if (k < count && sortedValues[k] == sortedValues[k - 1])
+      {
+      ++runLength;
+      continue;
+      }
+    ties += 0.5 * runLength * (runLength - 1);
+    runLength = 1;
+    }
+  return ties;
+}
+
+//----------------------------------------------------------------------------
+// Sort values in ascending order and return the number of swaps a bubble sort would do.
+double mergeSortSwapCount(double* values, double* buffer, vtkIdType count)
+{
+  double swaps = 0.;
+  for (vtkIdType width = 1; width < count; width *= 2)
+    {
+    for (vtkIdType left = 0; left < count; left += 2 * width)
+      {
+      vtkIdType middle = std::min(left + width, count);
+      vtkIdType right = std::min(left + 2 * width, count);
+      vtkIdType i = left, j = middle, k = left;
+      while (i < middle && j < right)
+        {
+        if (values[j] < values[i])
+          {
+          swaps += middle - i;
+          buffer[k++] = values[j++];
+          }
+        else
+          {
+          buffer[k++] = values[i++];
+          }
+        }
+      while (i < middle) { buffer[k++] = values[i++]; }
+      while (j < right) { buffer[k++] = values[j++]; }
+      }
+    std::copy(buffer, buffer + count, values);
+    }
+  return swaps;
+}
+
+//----------------------------------------------------------------------------
+// Pre-computed information about a row used as the "x" variable of Kendall's tau.
+struct KendallRow
+{
+  std::vector<vtkIdType> Order; // Permutation sorting the row
+  std::vector<double> SortedValues;
+  double TiedPairs;
+  bool HasTies;
+  bool HasNan; // Correlations with a row containing NaN are NaN
+};
+
+//----------------------------------------------------------------------------
+void prepareKendallRow(const double* values, vtkIdType count, KendallRow& row)
+{
+  row.HasNan = containsNan(values, count);
+  if (row.HasNan)
+    {
+    row.Order.clear();
+    row.SortedValues.clear();
+    row.TiedPairs = 0.;
+    row.HasTies = false;
+    return;
+    }
+  row.Order.resize(count);
+  for (vtkIdType k = 0; k < count; ++k)
+    {
+    row.Order[k] = k;
+    }
+  std::sort(row.Order.begin(), row.Order.end(), IndexValueLess(values));
+  row.SortedValues.resize(count);
+  for (vtkIdType k = 0; k < count; ++k)
+    {
+    row.SortedValues[k] = values[row.Order[k]];
+    }
+  row.TiedPairs = tiedPairCount(&row.SortedValues[0], count);
+  row.HasTies = row.TiedPairs > 0.;
+}
+
+//----------------------------------------------------------------------------
+double kendallTauFromPreparedRows(const KendallRow& xRow, const KendallRow& yRow,
+                                  const double* yValues, vtkIdType count,
+                                  double* yBuffer, double* mergeBuffer)
+{
+  if (xRow.HasNan || yRow.HasNan)
+    {
+    return vtkMath::Nan();
+    }
+  double pairs = 0.5 * count * (count - 1);
+  double denominator = std::sqrt((pairs - xRow.TiedPairs) * (pairs - yRow.TiedPairs));
+  if (!(denominator > 0.))
+    {
+    return vtkMath::Nan();
+    }
+
+  // Reorder y following the ascending order of x
+  for (vtkIdType k = 0; k < count; ++k)
+    {
+    yBuffer[k] = yValues[xRow.Order[k]];
+    }
+
+  // Within each group of tied x, sort y so that joint ties are not counted as swaps
+  double jointTiedPairs = 0.;
+  if (xRow.HasTies)
+    {
+    vtkIdType runBegin = 0;
+    for (vtkIdType k = 1; k <= count; ++k)
+      {
+      if (k < count && xRow.SortedValues[k] == xRow.SortedValues[runBegin])
+        {
+        continue;
+        }
+      if (k - runBegin > 1)
+        {
+        std::sort(yBuffer + runBegin, yBuffer + k);
+        jointTiedPairs += tiedPairCount(yBuffer + runBegin, k - runBegin);
+        }
+      runBegin = k;
+      }
+    }
+
+  double swaps = mergeSortSwapCount(yBuffer, mergeBuffer, count);
+  double numerator = pairs - xRow.TiedPairs - yRow.TiedPairs + jointTiedPairs - 2. * swaps;
+  return std::max(-1., std::min(1., numerator / denominator));
+}
+
+//----------------------------------------------------------------------------
+class KendallRowFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  const std::vector<KendallRow>* Rows;
+
+  // Dense output, one buffer per column
+  double* const* Correlation;
+
+  // Sparse output
+  double Threshold;
+  std::vector<std::vector<voCorrelation::Edge> >* RowEdges;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    vtkIdType n = this->NumberOfRows;
+    std::vector<double> yBuffer(this->NumberOfColumns);
+    std::vector<double> mergeBuffer(this->NumberOfColumns);
+    for (vtkIdType i = begin; i < end; ++i)
+      {
+      const KendallRow& xRow = (*this->Rows)[i];
+      for (vtkIdType j = i; j < n; ++j)
+        {
+        double value = kendallTauFromPreparedRows(
+              xRow, (*this->Rows)[j], this->Data + j * this->NumberOfColumns, this->NumberOfColumns,
+              &yBuffer[0], &mergeBuffer[0]);
+        if (this->Correlation)
+          {
+          this->Correlation[j][i] = value;
+          this->Correlation[i][j] = value;
+          }
+        else if (j != i && std::fabs(value) > this->Threshold)
+          {
+          voCorrelation::Edge edge;
+          edge.First = i;
+          edge.Second = j;
+          edge.Value = value;
+          (*this->RowEdges)[i].push_back(edge);
+          }
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+class KendallPrepareFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfColumns;
+  std::vector<KendallRow>* Rows;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType i = begin; i < end; ++i)
+      {
+      prepareKendallRow(this->Data + i * this->NumberOfColumns, this->NumberOfColumns, (*this->Rows)[i]);
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Compute the dense matrix if \a correlation is not null, the thresholded edges otherwise.
+void kendallMatrix(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                   double* const* correlation, double threshold, std::vector<voCorrelation::Edge>* edges)
+{
+  std::vector<KendallRow> rows(numberOfRows);
+
+  KendallPrepareFunctor prepare;
+  prepare.Data = data;
+  prepare.NumberOfColumns = numberOfColumns;
+  prepare.Rows = &rows;
+  voConcurrentUtils::parallelFor(numberOfRows, prepare);
+
+  KendallRowFunctor functor;
+  functor.Data = data;
+  functor.NumberOfRows = numberOfRows;
+  functor.NumberOfColumns = numberOfColumns;
+  functor.Rows = &rows;
+  functor.Correlation = correlation;
+  functor.Threshold = threshold;
+  std::vector<std::vector<voCorrelation::Edge> > rowEdges(correlation ? 0 : numberOfRows);
+  functor.RowEdges = &rowEdges;
+  // Rows have a decreasing amount of work, use small ranges to balance the load
+  voConcurrentUtils::parallelFor(numberOfRows, functor, 8);
+
+  for (size_t r = 0; r < rowEdges.size(); ++r)
+    {
+    edges->insert(edges->end(), rowEdges[r].begin(), rowEdges[r].end());
+    }
+}
+
+//----------------------------------------------------------------------------
+bool computeCorrelation(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                        voCorrelation::Method method, double* const* correlation,
+                        double threshold, std::vector<voCorrelation::Edge>* edges)
+{
+  if (!data || numberOfRows <= 0 || numberOfColumns < 2)
+    {
+    return false;
+    }
+
+  if (method == voCorrelation::Kendall)
+    {
+    kendallMatrix(data, numberOfRows, numberOfColumns, correlation, threshold, edges);
+    return true;
+    }
+
+  // Pearson and Spearman both work on a standardized copy of the data
+  std::vector<double> work(data, data + numberOfRows * numberOfColumns);
+  if (method == voCorrelation::Spearman)
+    {
+    voCorrelation::rankRows(&work[0], numberOfRows, numberOfColumns);
+    }
+  std::vector<char> validRows;
+  standardizeRows(&work[0], numberOfRows, numberOfColumns, validRows);
+  pearsonMatrix(&work[0], validRows, numberOfRows, numberOfColumns, correlation, threshold, edges);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+class RankRowFunctor
+{
+public:
+  double* Data;
+  vtkIdType NumberOfColumns;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    std::vector<vtkIdType> order(this->NumberOfColumns);
+    std::vector<double> ranks(this->NumberOfColumns);
+    for (vtkIdType r = begin; r < end; ++r)
+      {
+      double* row = this->Data + r * this->NumberOfColumns;
+      if (containsNan(row, this->NumberOfColumns))
+        {
+        std::fill(row, row + this->NumberOfColumns, vtkMath::Nan());
+        continue;
+        }
+      for (vtkIdType k = 0; k < this->NumberOfColumns; ++k)
+        {
+        order[k] = k;
+        }
+      std::sort(order.begin(), order.end(), IndexValueLess(row));
+      vtkIdType runBegin = 0;
+      for (vtkIdType k = 1; k <= this->NumberOfColumns; ++k)
+        {
+        if (k < this->NumberOfColumns && row[order[k]] == row[order[runBegin]])
+          {
+          continue;
+          }
+        double averageRank = 0.5 * (runBegin + k + 1); // Mean of [runBegin + 1, k]
+        for (vtkIdType t = runBegin; t < k; ++t)
+          {
+          ranks[order[t]] = averageRank;
+          }
+        runBegin = k;
+        }
+      std::copy(ranks.begin(), ranks.end(), row);
+      }
+    }
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool voCorrelation::methodFromString(const QString& methodName, Method& method)
+{
+  QString name = methodName.toLower();
+  if (name == QLatin1String("pearson"))
+    {
+    method = voCorrelation::Pearson;
+    }
+  else if (name == QLatin1String("spearman"))
+    {
+    method = voCorrelation::Spearman;
+    }
+  else if (name == QLatin1String("kendall"))
+    {
+    method = voCorrelation::Kendall;
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void voCorrelation::rankRows(double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  if (!data || numberOfColumns <= 0)
+    {
+    return;
+    }
+  RankRowFunctor functor;
+  functor.Data = data;
+  functor.NumberOfColumns = numberOfColumns;
+  voConcurrentUtils::parallelFor(numberOfRows, functor);
+}
+
+//----------------------------------------------------------------------------
+double voCorrelation::kendallTau(const double* x, const double* y, vtkIdType count)
+{
+  if (!x || !y || count < 2)
+    {
+    return vtkMath::Nan();
+    }
+  KendallRow xRow;
+  prepareKendallRow(x, count, xRow);
+  KendallRow yRow;
+  prepareKendallRow(y, count, yRow);
+  std::vector<double> yBuffer(count);
+  std::vector<double> mergeBuffer(count);
+  return kendallTauFromPreparedRows(xRow, yRow, y, count, &yBuffer[0], &mergeBuffer[0]);
+}
+
+//----------------------------------------------------------------------------
+bool voCorrelation::correlationMatrix(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                      Method method, double* const* correlationColumns)
+{
+  if (!correlationColumns)
+    {
+    return false;
+    }
+  return computeCorrelation(data, numberOfRows, numberOfColumns, method, correlationColumns, 0., 0);
+}
+
+//----------------------------------------------------------------------------
+bool voCorrelation::thresholdedCorrelation(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                           Method method, double threshold, std::vector<Edge>& edges)
+{
+  edges.clear();
+  return computeCorrelation(data, numberOfRows, numberOfColumns, method, 0, threshold, &edges);
+}
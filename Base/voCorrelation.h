@@ -0,0 +1,83 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voCorrelation_h
+#define __voCorrelation_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class QString;
+
+/// Native implementation of the correlation coefficients computed by the R function "cor".
+///
+/// Matrices are stored row-major: the value at row \a r and column \a c of a
+/// matrix having \a numberOfColumns columns is located at index r * numberOfColumns + c.
+/// Correlations are always computed between rows.
+namespace voCorrelation
+{
+
+enum Method
+  {
+  Pearson = 0,
+  Spearman,
+  Kendall
+  };
+
+/// Pair of rows (First < Second) and their correlation
+struct Edge
+{
+  vtkIdType First;
+  vtkIdType Second;
+  double    Value;
+};
+
+/// Convert "pearson", "spearman" or "kendall" into the associated method.
+/// Return false if \a methodName doesn't match any method.
+bool methodFromString(const QString& methodName, Method& method);
+
+/// Compute the \a numberOfRows x \a numberOfRows correlation matrix of the rows of \a data.
+/// \a correlationColumns[c] must be able to hold the numberOfRows values of column c,
+/// tiles are written directly into the columns so that they can be the buffers of a vtkTable.
+/// Correlations involving a constant row or a row containing NaN (e.g. a missing value)
+/// are set to NaN, like R does.
+/// Tiles of the output matrix are computed concurrently.
+bool correlationMatrix(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                       Method method, double* const* correlationColumns);
+
+/// Compute the correlation of each pair of rows of \a data without storing the dense matrix.
+/// Only pairs whose absolute correlation is strictly greater than \a threshold are
+/// returned in \a edges, ordered by First then Second.
+bool thresholdedCorrelation(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                            Method method, double threshold, std::vector<Edge>& edges);
+
+/// Replace each row of \a data by its rank, ties are given their average rank.
+/// Ranks start at 1. Rows containing NaN are filled with NaN.
+void rankRows(double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns);
+
+/// Compute Kendall's tau-b between \a x and \a y using Knight's O(n log n) algorithm.
+/// Return NaN if \a x or \a y contains NaN.
+double kendallTau(const double* x, const double* y, vtkIdType count);
+
+}
+
+#endif
@@ -0,0 +1,411 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QString>
+#include <QtAlgorithms>
+
+// Visomics includes
+#include "voCacheUsage.h"
+#include "voConfigure.h" // For Visomics_VERSION
+#include "voDatasetCache.h"
+#include "voDelimitedTextImportSettings.h"
+#include "voUtils.h"
+#include "vtkExtendedTable.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <cstring>
+
+namespace
+{
+
+// First bytes of a cache file
+const char Magic[8] = {'V', 'O', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+// Incremented whenever the layout of the cache files changes. The data being stored
+// normalized, the settings hash also depends on the application version.
+const quint32 FormatVersion = 2;
+
+// Serialization format of the header, the metadata and the settings
+const int StreamVersion = QDataStream::Qt_4_7;
+
+// Offset of the data, the header is padded up to it. It is a multiple of 64 bytes so that
+// the data of a memory mapped cache file have the alignment of vtkExtendedTable::GetDataBuffer().
+const qint64 DataOffset = 128;
+
+QString CacheDirectory;
+bool    CacheDirectoryInitialized = false;
+qint64  MaximumSize = Q_INT64_C(2) << 30;
+
+//----------------------------------------------------------------------------
+void writeStringArray(QDataStream& stream, vtkStringArray* array)
+{
+  qint64 count = array ? array->GetNumberOfValues() : 0;
+  stream << count;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    const vtkStdString& value = array->GetValue(i);
+    stream << QByteArray(value.c_str(), static_cast<int>(value.size()));
+    }
+}
+
+//----------------------------------------------------------------------------
+bool readStringArray(QDataStream& stream, qint64 maximumCount, vtkStringArray* array)
+{
+  qint64 count = 0;
+  stream >> count;
+  if (stream.status() != QDataStream::Ok || count < 0 || count > maximumCount)
+    {
+    return false;
+    }
+  array->SetNumberOfValues(count);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    QByteArray value;
+    stream >> value;
+    array->SetValue(i, vtkStdString(value.constData(), value.size()));
+    }
+  return stream.status() == QDataStream::Ok;
+}
+
+//----------------------------------------------------------------------------
+bool readStringTable(QDataStream& stream, qint64 maximumCount, vtkTable* table)
+{
+  qint32 numberOfColumns = 0;
+  stream >> numberOfColumns;
+  if (stream.status() != QDataStream::Ok || numberOfColumns < 0 || numberOfColumns > maximumCount)
+    {
+    return false;
+    }
+  for (qint32 cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkSmartPointer<vtkStringArray> column = vtkSmartPointer<vtkStringArray>::New();
+    if (!readStringArray(stream, maximumCount, column))
+      {
+      return false;
+      }
+    table->AddColumn(column);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Cache files written next to their source file are not evicted
+void recordUse(const QString& cacheFileName)
+{
+  QString directory = voDatasetCache::cacheDirectory();
+  QFileInfo cacheFileInfo(cacheFileName);
+  if (directory.isEmpty() || cacheFileInfo.absolutePath() != QDir(directory).absolutePath())
+    {
+    return;
+    }
+  voCacheUsage::recordUse(directory, cacheFileInfo.fileName(), "*.vocache", MaximumSize);
+}
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+QString voDatasetCache::cacheDirectory()
+{
+  if (!CacheDirectoryInitialized)
+    {
+    QString location = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+    if (!location.isEmpty())
+      {
+      CacheDirectory = QDir(location).filePath("Datasets");
+      }
+    CacheDirectoryInitialized = true;
+    }
+  return CacheDirectory;
+}
+
+// --------------------------------------------------------------------------
+void voDatasetCache::setCacheDirectory(const QString& directory)
+{
+  CacheDirectory = directory;
+  CacheDirectoryInitialized = true;
+}
+
+// --------------------------------------------------------------------------
+qint64 voDatasetCache::maximumSize()
+{
+  return MaximumSize;
+}
+
+// --------------------------------------------------------------------------
+void voDatasetCache::setMaximumSize(qint64 size)
+{
+  MaximumSize = size;
+}
+
+// --------------------------------------------------------------------------
+QString voDatasetCache::cacheFileName(const QString& sourceFileName)
+{
+  QFileInfo sourceInfo(sourceFileName);
+  QString directory = voDatasetCache::cacheDirectory();
+  if (directory.isEmpty())
+    {
+    return sourceInfo.absoluteFilePath() + ".vocache";
+    }
+  // Files having the same name in different directories get different cache files
+  QByteArray pathHash = QCryptographicHash::hash(
+        sourceInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex().left(8);
+  return QDir(directory).filePath(
+        QString("%1.%2.vocache").arg(sourceInfo.fileName()).arg(QString::fromLatin1(pathHash)));
+}
+
+// --------------------------------------------------------------------------
+QByteArray voDatasetCache::settingsHash(const voDelimitedTextImportSettings& settings)
+{
+  QList<int> keys = settings.keys();
+  qSort(keys);
+
+  QByteArray serializedSettings;
+  QDataStream stream(&serializedSettings, QIODevice::WriteOnly);
+  stream.setVersion(StreamVersion);
+  stream << FormatVersion << QString(Visomics_VERSION);
+  foreach(int key, keys)
+    {
+    stream << key << settings.value(key);
+    }
+  return QCryptographicHash::hash(serializedSettings, QCryptographicHash::Md5);
+}
+
+// --------------------------------------------------------------------------
+bool voDatasetCache::read(const QString& cacheFileName, const QByteArray& sourceHash,
+                          const QByteArray& settingsHash, vtkExtendedTable* table)
+{
+  if (!table || !QFile::exists(cacheFileName))
+    {
+    return false;
+    }
+  QFile file(cacheFileName);
+  if (!file.open(QIODevice::ReadOnly))
+    {
+    return false;
+    }
+
+  // Header
+  QDataStream headerStream(file.read(DataOffset));
+  headerStream.setVersion(StreamVersion);
+  char magic[sizeof(Magic)];
+  if (headerStream.readRawData(magic, static_cast<int>(sizeof(Magic))) != static_cast<int>(sizeof(Magic)) ||
+      memcmp(magic, Magic, sizeof(Magic)) != 0)
+    {
+    return false;
+    }
+  quint32 version = 0;
+  quint32 littleEndian = 0;
+  QByteArray storedSourceHash;
+  QByteArray storedSettingsHash;
+  qint64 numberOfRows = 0;
+  qint64 numberOfColumns = 0;
+  qint64 metadataOffset = 0;
+  qint64 metadataSize = 0;
+  headerStream >> version >> littleEndian >> storedSourceHash >> storedSettingsHash
+               >> numberOfRows >> numberOfColumns >> metadataOffset >> metadataSize;
+  if (headerStream.status() != QDataStream::Ok || version != FormatVersion ||
+      littleEndian != (Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 1u : 0u) ||
+      storedSourceHash != sourceHash || storedSettingsHash != settingsHash)
+    {
+    return false;
+    }
+  qint64 dataSize = numberOfRows * numberOfColumns * static_cast<qint64>(sizeof(double));
+  if (numberOfRows < 0 || numberOfColumns < 0 || metadataSize < 0 ||
+      metadataOffset != DataOffset + dataSize || file.size() != metadataOffset + metadataSize)
+    {
+    qWarning() << "Invalid dataset cache" << cacheFileName;
+    return false;
+    }
+
+  // Map the file, read it if mapping isn't supported
+  const char * content = 0;
+  QByteArray contentBuffer;
+  uchar * mappedContent = file.map(0, file.size());
+  if (mappedContent)
+    {
+    content = reinterpret_cast<const char*>(mappedContent);
+    }
+  else
+    {
+    file.seek(0);
+    contentBuffer = file.readAll();
+    if (contentBuffer.size() != file.size())
+      {
+      return false;
+      }
+    content = contentBuffer.constData();
+    }
+
+  // Metadata are checked before modifying the table
+  QByteArray metadata = QByteArray::fromRawData(content + metadataOffset, static_cast<int>(metadataSize));
+  QDataStream metadataStream(metadata);
+  metadataStream.setVersion(StreamVersion);
+  qint64 columnMetaDataTypeOfInterest = -1;
+  qint64 rowMetaDataTypeOfInterest = -1;
+  metadataStream >> columnMetaDataTypeOfInterest >> rowMetaDataTypeOfInterest;
+  vtkNew<vtkStringArray> columnMetaDataLabels;
+  vtkNew<vtkStringArray> rowMetaDataLabels;
+  vtkNew<vtkTable> columnMetaData;
+  vtkNew<vtkTable> rowMetaData;
+  bool success = metadataStream.status() == QDataStream::Ok &&
+      readStringArray(metadataStream, metadataSize, columnMetaDataLabels.GetPointer()) &&
+      readStringArray(metadataStream, metadataSize, rowMetaDataLabels.GetPointer()) &&
+      readStringTable(metadataStream, metadataSize, columnMetaData.GetPointer()) &&
+      readStringTable(metadataStream, metadataSize, rowMetaData.GetPointer());
+  if (!success)
+    {
+    qWarning() << "Invalid dataset cache" << cacheFileName;
+    if (mappedContent)
+      {
+      file.unmap(mappedContent);
+      }
+    return false;
+    }
+
+  // The shared buffer of the table is writable, the mapped data are copied into it
+  double * data = table->AllocateData(numberOfRows, numberOfColumns);
+  if (data)
+    {
+    memcpy(data, content + DataOffset, dataSize);
+    }
+  if (mappedContent)
+    {
+    file.unmap(mappedContent);
+    }
+
+  table->SetColumnMetaDataTable(columnMetaData.GetPointer());
+  table->SetRowMetaDataTable(rowMetaData.GetPointer());
+  table->SetColumnMetaDataLabels(columnMetaDataLabels.GetPointer());
+  table->SetRowMetaDataLabels(rowMetaDataLabels.GetPointer());
+  if (columnMetaDataTypeOfInterest >= 0)
+    {
+    table->SetColumnMetaDataTypeOfInterest(columnMetaDataTypeOfInterest);
+    }
+  if (rowMetaDataTypeOfInterest >= 0)
+    {
+    table->SetRowMetaDataTypeOfInterest(rowMetaDataTypeOfInterest);
+    }
+  voUtils::setTableColumnNames(table->GetData(), table->GetColumnMetaDataOfInterestAsString());
+  table->Modified();
+
+  recordUse(cacheFileName);
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voDatasetCache::write(const QString& cacheFileName, const QByteArray& sourceHash,
+                           const QByteArray& settingsHash, vtkExtendedTable* table)
+{
+  if (!table)
+    {
+    return false;
+    }
+
+  const double * data = table->GetDataBuffer();
+  qint64 numberOfRows = data ? table->GetNumberOfRows() : 0;
+  qint64 numberOfColumns = data ? table->GetNumberOfColumns() : 0;
+  qint64 dataSize = numberOfRows * numberOfColumns * static_cast<qint64>(sizeof(double));
+
+  // Metadata, only string metadata are supported
+  QByteArray metadata;
+  QDataStream metadataStream(&metadata, QIODevice::WriteOnly);
+  metadataStream.setVersion(StreamVersion);
+  metadataStream << static_cast<qint64>(table->GetColumnMetaDataTypeOfInterest())
+                 << static_cast<qint64>(table->GetRowMetaDataTypeOfInterest());
+  writeStringArray(metadataStream, table->GetColumnMetaDataLabels());
+  writeStringArray(metadataStream, table->GetRowMetaDataLabels());
+  metadataStream << static_cast<qint32>(table->GetNumberOfColumnMetaDataTypes());
+  for (vtkIdType id = 0; id < table->GetNumberOfColumnMetaDataTypes(); ++id)
+    {
+    vtkStringArray * columnMetaData = table->GetColumnMetaDataAsString(id);
+    if (!columnMetaData)
+      {
+      return false;
+      }
+    writeStringArray(metadataStream, columnMetaData);
+    }
+  metadataStream << static_cast<qint32>(table->GetNumberOfRowMetaDataTypes());
+  for (vtkIdType id = 0; id < table->GetNumberOfRowMetaDataTypes(); ++id)
+    {
+    vtkStringArray * rowMetaData = table->GetRowMetaDataAsString(id);
+    if (!rowMetaData)
+      {
+      return false;
+      }
+    writeStringArray(metadataStream, rowMetaData);
+    }
+
+  // Header
+  QByteArray header;
+  QDataStream headerStream(&header, QIODevice::WriteOnly);
+  headerStream.setVersion(StreamVersion);
+  headerStream.writeRawData(Magic, static_cast<int>(sizeof(Magic)));
+  headerStream << FormatVersion << (Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 1u : 0u)
+               << sourceHash << settingsHash << numberOfRows << numberOfColumns
+               << DataOffset + dataSize << static_cast<qint64>(metadata.size());
+  Q_ASSERT(header.size() <= DataOffset);
+  header.append(QByteArray(static_cast<int>(DataOffset) - header.size(), '\0'));
+
+  if (MaximumSize >= 0 && DataOffset + dataSize + metadata.size() > MaximumSize)
+    {
+    qDebug() << "Dataset" << cacheFileName << "exceeds the dataset cache maximum size";
+    return false;
+    }
+
+  if (!QDir().mkpath(QFileInfo(cacheFileName).absolutePath()))
+    {
+    return false;
+    }
+  QString temporaryFileName = cacheFileName + ".tmp";
+  QFile file(temporaryFileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    return false;
+    }
+  bool success = file.write(header) == header.size() &&
+      (dataSize == 0 || file.write(reinterpret_cast<const char*>(data), dataSize) == dataSize) &&
+      file.write(metadata) == metadata.size();
+  file.close();
+
+  QFile::remove(cacheFileName);
+  if (!success || !QFile::rename(temporaryFileName, cacheFileName))
+    {
+    QFile::remove(temporaryFileName);
+    return false;
+    }
+  recordUse(cacheFileName);
+  return true;
+}
@@ -0,0 +1,76 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voDatasetCache_h
+#define __voDatasetCache_h
+
+// Qt includes
+#include <QtGlobal>
+
+class QByteArray;
+class QString;
+class voDelimitedTextImportSettings;
+class vtkExtendedTable;
+
+/// Binary cache of the vtkExtendedTable imported from a delimited text file.
+///
+/// A cache file starts with a header of fixed size identifying the source file content
+/// and the import settings by their hashes. It is followed by the data, stored column-major
+/// at a 64-byte aligned offset so that the file can be memory mapped and the matrix used
+/// as is, then by the metadata, the metadata labels and the metadata types of interest.
+/// The data are stored after normalization, loading a cache file doesn't normalize them again.
+/// The total size of the cache files of cacheDirectory() is bounded, the least recently
+/// used ones are removed first.
+namespace voDatasetCache
+{
+
+/// Directory where the cache files are written. By default, the "Datasets" subdirectory
+/// of the cache location of the application. If empty, cache files are written next to
+/// their source file.
+QString cacheDirectory();
+void setCacheDirectory(const QString& directory);
+
+/// Maximum total size, in bytes, of the cache files. 2GB by default, a negative size
+/// disables the limit. Once exceeded by a read or a write, the least recently used files
+/// of cacheDirectory() are removed. Datasets larger than the maximum size are not cached.
+qint64 maximumSize();
+void setMaximumSize(qint64 size);
+
+/// Cache file associated with \a sourceFileName
+QString cacheFileName(const QString& sourceFileName);
+
+/// MD5 hash of \a settings, independent of the order of the settings. It depends on the
+/// application version, so that data imported or normalized by another version aren't used.
+QByteArray settingsHash(const voDelimitedTextImportSettings& settings);
+
+/// Fill \a table with the content of \a cacheFileName. \a sourceHash is the hash
+/// of the source file content, see voFileHash.
+/// Return false if the file doesn't exist, is invalid or if it has been written for
+/// another source content or other import settings.
+bool read(const QString& cacheFileName, const QByteArray& sourceHash, const QByteArray& settingsHash,
+          vtkExtendedTable* table);
+
+/// Write \a table into \a cacheFileName. The file is written under a temporary
+/// name and renamed once complete, a partially written cache is never read.
+bool write(const QString& cacheFileName, const QByteArray& sourceHash, const QByteArray& settingsHash,
+           vtkExtendedTable* table);
+
+}
+
+#endif
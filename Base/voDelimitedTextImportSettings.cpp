@@ -20,6 +20,7 @@
 
 // Qt includes
 #include <QDebug>
+#include <QStringList>
 #include <QVariant>
 
 // Visomics includes
@@ -43,7 +44,9 @@ void voDelimitedTextImportSettings::printAdditionalInfo()const
            << " NumberOfColumnMetaDataTypes:" << this->value(Self::NumberOfColumnMetaDataTypes).toInt() << endl
            << " ColumnMetaDataTypeOfInterest:" << this->value(Self::ColumnMetaDataTypeOfInterest).toInt() << endl
            << " NumberOfRowMetaDataTypes:" << this->value(Self::NumberOfRowMetaDataTypes).toInt() << endl
-           << " RowMetaDataTypeOfInterest:" << this->value(Self::RowMetaDataTypeOfInterest).toInt();
+           << " RowMetaDataTypeOfInterest:" << this->value(Self::RowMetaDataTypeOfInterest).toInt() << endl
+           << " NormalizationMethod:" << this->value(Self::NormalizationMethod).toString() << endl
+           << " NormalizationPipeline:" << this->value(Self::NormalizationPipeline).toStringList();
 }
 
 // --------------------------------------------------------------------------
@@ -59,4 +62,5 @@ void voDelimitedTextImportSettings::setDefaultSettings()
   this->insert(Self::NumberOfRowMetaDataTypes, 1);
   this->insert(Self::RowMetaDataTypeOfInterest, 0);
   this->insert(Self::NormalizationMethod, "No");
+  this->insert(Self::NormalizationPipeline, QStringList());
 }
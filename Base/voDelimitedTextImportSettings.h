@@ -45,6 +45,7 @@ public:
     RowMetaDataTypeOfInterest,
     // Normalization settings
     NormalizationMethod,
+    NormalizationPipeline, // QStringList of methods applied in order, supersedes NormalizationMethod if not empty
     };
 
   voDelimitedTextImportSettings();
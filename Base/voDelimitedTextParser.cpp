@@ -0,0 +1,707 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QString>
+
+// Visomics includes
+#include "voConcurrentUtils.h"
+#include "voDelimitedTextImportSettings.h"
+#include "voDelimitedTextParser.h"
+#include "vtkExtendedTable.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Size, in bytes, of the chunks scanned concurrently for line breaks
+const vtkIdType ChunkSize = 1 << 22;
+
+// Powers of ten exactly representable as doubles
+const double PowersOf10[] =
+  {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+const int MaximumExactPowerOf10 = 22;
+
+// Largest integer such that all the integers below are exactly representable as doubles
+const vtkTypeUInt64 MaximumExactMantissa = static_cast<vtkTypeUInt64>(1) << 53;
+
+//----------------------------------------------------------------------------
+struct Format
+{
+  bool IsDelimiter[256];
+  bool MergeConsecutiveDelimiters;
+  bool UseStringDelimiter;
+  char StringDelimiter;
+  /// True if strtod() expects a '.' as decimal separator in the current locale
+  bool UseStrtod;
+};
+
+//----------------------------------------------------------------------------
+// Characters [Begin, End) of a field. The string delimiters of a quoted field are excluded,
+// Escaped is true if the field contains doubled string delimiters.
+struct Field
+{
+  const char* Begin;
+  const char* End;
+  bool Escaped;
+};
+
+//----------------------------------------------------------------------------
+// Non numerical cells and extra fields of a line
+struct LineReport
+{
+  vtkIdType InvalidCount;
+  vtkIdType FirstInvalidField;
+  vtkIdType ExtraFieldCount;
+};
+
+//----------------------------------------------------------------------------
+inline bool isDelimiter(const Format& format, char c)
+{
+  return format.IsDelimiter[static_cast<unsigned char>(c)];
+}
+
+//----------------------------------------------------------------------------
+inline bool isDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+//----------------------------------------------------------------------------
+// Split the line [begin, end) into fields
+void splitLine(const char* begin, const char* end, const Format& format, std::vector<Field>& fields)
+{
+  fields.clear();
+  const char * p = begin;
+  while (true)
+    {
+    Field field;
+    field.Escaped = false;
+    if (format.UseStringDelimiter && p < end && *p == format.StringDelimiter)
+      {
+      field.Begin = ++p;
+      while (p < end)
+        {
+        if (*p == format.StringDelimiter)
+          {
+          if (p + 1 < end && p[1] == format.StringDelimiter)
+            {
+            field.Escaped = true;
+            p += 2;
+            continue;
+            }
+          break;
+          }
+        ++p;
+        }
+      field.End = p;
+      // Skip the closing string delimiter and whatever follows it up to the next field
+      while (p < end && !isDelimiter(format, *p))
+        {
+        ++p;
+        }
+      }
+    else
+      {
+      field.Begin = p;
+      while (p < end && !isDelimiter(format, *p))
+        {
+        ++p;
+        }
+      field.End = p;
+      }
+    fields.push_back(field);
+
+    if (p >= end)
+      {
+      break;
+      }
+    ++p;
+    if (format.MergeConsecutiveDelimiters)
+      {
+      while (p < end && isDelimiter(format, *p))
+        {
+        ++p;
+        }
+      if (p >= end)
+        {
+        break;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+std::string fieldToString(const Field& field, const Format& format)
+{
+  if (!field.Escaped)
+    {
+    return std::string(field.Begin, field.End);
+    }
+  std::string value;
+  value.reserve(field.End - field.Begin);
+  for (const char * p = field.Begin; p < field.End; ++p)
+    {
+    value.push_back(*p);
+    if (*p == format.StringDelimiter && p + 1 < field.End && p[1] == format.StringDelimiter)
+      {
+      ++p;
+      }
+    }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+// Convert the decimal number [begin, end), surrounded by optional blanks, into \a value.
+// Numbers having at most 15 significant digits and a small exponent, which covers
+// most of the exported data, are converted exactly with a single multiplication or
+// division (Clinger's fast path). Others are converted by strtod(), or by a stream
+// using the "C" locale if the current locale has another decimal separator.
+bool parseDouble(const char* begin, const char* end, bool useStrtod, double& value)
+{
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    {
+    ++begin;
+    }
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+    {
+    --end;
+    }
+
+  const char * p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    {
+    negative = (*p == '-');
+    ++p;
+    }
+
+  vtkTypeUInt64 mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  bool exact = true;
+  bool hasDigits = false;
+  for (; p < end && isDigit(*p); ++p)
+    {
+    hasDigits = true;
+    int digit = *p - '0';
+    if (significantDigits < 19)
+      {
+      mantissa = mantissa * 10 + digit;
+      significantDigits += (mantissa != 0);
+      }
+    else
+      {
+      ++exponent;
+      exact = exact && digit == 0;
+      }
+    }
+  if (p < end && *p == '.')
+    {
+    for (++p; p < end && isDigit(*p); ++p)
+      {
+      hasDigits = true;
+      int digit = *p - '0';
+      if (significantDigits < 19)
+        {
+        mantissa = mantissa * 10 + digit;
+        significantDigits += (mantissa != 0);
+        --exponent;
+        }
+      else
+        {
+        exact = exact && digit == 0;
+        }
+      }
+    }
+  if (!hasDigits)
+    {
+    return false;
+    }
+  if (p < end && (*p == 'e' || *p == 'E'))
+    {
+    ++p;
+    bool negativeExponent = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      {
+      negativeExponent = (*p == '-');
+      ++p;
+      }
+    if (p == end || !isDigit(*p))
+      {
+      return false;
+      }
+    int explicitExponent = 0;
+    for (; p < end && isDigit(*p); ++p)
+      {
+      if (explicitExponent < 100000)
+        {
+        explicitExponent = explicitExponent * 10 + (*p - '0');
+        }
+      }
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+  if (p != end)
+    {
+    return false;
+    }
+
+  if (exact && mantissa <= MaximumExactMantissa &&
+      exponent >= -MaximumExactPowerOf10 && exponent <= MaximumExactPowerOf10)
+    {
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / PowersOf10[-exponent] : result * PowersOf10[exponent];
+    value = negative ? -result : result;
+    return true;
+    }
+
+  // Numbers are short, copy them on the stack to terminate them
+  const vtkIdType MaximumLength = 64;
+  if (useStrtod && end - begin < MaximumLength)
+    {
+    char number[MaximumLength];
+    std::copy(begin, end, number);
+    number[end - begin] = '\0';
+    char * numberEnd = 0;
+    errno = 0;
+    double result = strtod(number, &numberEnd);
+    if (numberEnd != number + (end - begin) || errno == ERANGE)
+      {
+      return false;
+      }
+    value = result;
+    return true;
+    }
+
+  std::istringstream stream(std::string(begin, end));
+  stream.imbue(std::locale::classic());
+  double result = 0.;
+  stream >> result;
+  if (stream.fail())
+    {
+    return false;
+    }
+  value = result;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Record the line breaks of the chunks [begin, end) along with the parity of the number
+// of string delimiters preceding each of them within its chunk.
+class LineBreakFunctor
+{
+public:
+  const char* Text;
+  vtkIdType Size;
+  const Format* TextFormat;
+  std::vector<std::vector<vtkIdType> >* LineBreaks;
+  std::vector<std::vector<char> >* LineBreakParities;
+  std::vector<char>* ChunkParities;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    bool useStringDelimiter = this->TextFormat->UseStringDelimiter;
+    char stringDelimiter = this->TextFormat->StringDelimiter;
+    for (vtkIdType chunk = begin; chunk < end; ++chunk)
+      {
+      std::vector<vtkIdType>& lineBreaks = (*this->LineBreaks)[chunk];
+      std::vector<char>& parities = (*this->LineBreakParities)[chunk];
+      const char * first = this->Text + chunk * ChunkSize;
+      const char * last = this->Text + std::min(this->Size, (chunk + 1) * ChunkSize);
+      char parity = 0;
+      for (const char * p = first; p < last; ++p)
+        {
+        if (*p == '\n')
+          {
+          lineBreaks.push_back(p - this->Text);
+          parities.push_back(parity);
+          }
+        else if (useStringDelimiter && *p == stringDelimiter)
+          {
+          parity ^= 1;
+          }
+        }
+      (*this->ChunkParities)[chunk] = parity;
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Parse the lines [begin, end). Line l and field f are the row l and column f of
+// the table, or its row f and column l if the table is transposed.
+class LineFunctor
+{
+public:
+  const char* Text;
+  const std::vector<vtkIdType>* LineBegins;
+  const std::vector<vtkIdType>* LineEnds;
+  const Format* TextFormat;
+  bool Transpose;
+  vtkIdType Width;
+  vtkIdType NumberOfColumnMetaDataTypes;
+  vtkIdType NumberOfRowMetaDataTypes;
+  vtkIdType NumberOfDataRows;
+  vtkIdType NumberOfDataColumns;
+  double* Data;
+  /// Value (rid, cid) is stored at index rid * NumberOfRowMetaDataTypes + cid
+  std::vector<std::string>* Labels;
+  /// Value (rid, cid) is stored at index rid * NumberOfDataColumns + cid - NumberOfRowMetaDataTypes
+  std::vector<std::string>* ColumnMetaData;
+  /// Value (rid, cid) is stored at index cid * NumberOfDataRows + rid - NumberOfColumnMetaDataTypes
+  std::vector<std::string>* RowMetaData;
+  std::vector<LineReport>* Reports;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    std::vector<Field> fields;
+    for (vtkIdType line = begin; line < end; ++line)
+      {
+      splitLine(this->Text + (*this->LineBegins)[line], this->Text + (*this->LineEnds)[line],
+                *this->TextFormat, fields);
+      vtkIdType fieldCount = static_cast<vtkIdType>(fields.size());
+
+      LineReport& report = (*this->Reports)[line];
+      report.InvalidCount = 0;
+      report.FirstInvalidField = -1;
+      report.ExtraFieldCount = std::max(static_cast<vtkIdType>(0), fieldCount - this->Width);
+
+      for (vtkIdType fid = 0; fid < this->Width; ++fid)
+        {
+        vtkIdType rid = this->Transpose ? fid : line;
+        vtkIdType cid = this->Transpose ? line : fid;
+        if (rid < this->NumberOfColumnMetaDataTypes || cid < this->NumberOfRowMetaDataTypes)
+          {
+          if (fid >= fieldCount)
+            {
+            continue;
+            }
+          std::string value = fieldToString(fields[fid], *this->TextFormat);
+          if (rid < this->NumberOfColumnMetaDataTypes && cid < this->NumberOfRowMetaDataTypes)
+            {
+            (*this->Labels)[rid * this->NumberOfRowMetaDataTypes + cid] = value;
+            }
+          else if (rid < this->NumberOfColumnMetaDataTypes)
+            {
+            (*this->ColumnMetaData)[rid * this->NumberOfDataColumns +
+                                    cid - this->NumberOfRowMetaDataTypes] = value;
+            }
+          else
+            {
+            (*this->RowMetaData)[cid * this->NumberOfDataRows +
+                                 rid - this->NumberOfColumnMetaDataTypes] = value;
+            }
+          continue;
+          }
+
+        double value = 0.;
+        if (fid >= fieldCount ||
+            !parseDouble(fields[fid].Begin, fields[fid].End, this->TextFormat->UseStrtod, value))
+          {
+          value = 0.;
+          if (report.InvalidCount++ == 0)
+            {
+            report.FirstInvalidField = fid;
+            }
+          }
+        this->Data[(cid - this->NumberOfRowMetaDataTypes) * this->NumberOfDataRows +
+                   rid - this->NumberOfColumnMetaDataTypes] = value;
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Split the text into non-empty lines, the line breaks of quoted strings are ignored
+void findLines(const char* text, vtkIdType size, const Format& format,
+               std::vector<vtkIdType>& lineBegins, std::vector<vtkIdType>& lineEnds)
+{
+  vtkIdType chunkCount = (size + ChunkSize - 1) / ChunkSize;
+  std::vector<std::vector<vtkIdType> > lineBreaks(chunkCount);
+  std::vector<std::vector<char> > lineBreakParities(chunkCount);
+  std::vector<char> chunkParities(chunkCount, 0);
+
+  LineBreakFunctor functor;
+  functor.Text = text;
+  functor.Size = size;
+  functor.TextFormat = &format;
+  functor.LineBreaks = &lineBreaks;
+  functor.LineBreakParities = &lineBreakParities;
+  functor.ChunkParities = &chunkParities;
+  voConcurrentUtils::parallelFor(chunkCount, functor, 1);
+
+  lineBegins.clear();
+  lineEnds.clear();
+  vtkIdType lineBegin = 0;
+  char parity = 0;
+  for (vtkIdType chunk = 0; chunk <= chunkCount; ++chunk)
+    {
+    bool lastChunk = (chunk == chunkCount);
+    size_t lineBreakCount = lastChunk ? 1 : lineBreaks[chunk].size();
+    for (size_t i = 0; i < lineBreakCount; ++i)
+      {
+      if (!lastChunk && (parity ^ lineBreakParities[chunk][i]) != 0)
+        {
+        continue;
+        }
+      vtkIdType lineEnd = lastChunk ? size : lineBreaks[chunk][i];
+      vtkIdType nextLineBegin = lineEnd + 1;
+      if (lineEnd > lineBegin && text[lineEnd - 1] == '\r')
+        {
+        --lineEnd;
+        }
+      if (lineEnd > lineBegin)
+        {
+        lineBegins.push_back(lineBegin);
+        lineEnds.push_back(lineEnd);
+        }
+      lineBegin = nextLineBegin;
+      }
+    if (!lastChunk)
+      {
+      parity ^= chunkParities[chunk];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkStringArray> newStringArray(const std::vector<std::string>& values,
+                                               vtkIdType offset, vtkIdType count)
+{
+  vtkSmartPointer<vtkStringArray> array = vtkSmartPointer<vtkStringArray>::New();
+  array->SetNumberOfValues(count);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    array->SetValue(i, values[offset + i]);
+    }
+  return array;
+}
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+bool voDelimitedTextParser::parse(const char* text, vtkIdType size,
+                                  const voDelimitedTextImportSettings& settings, vtkExtendedTable* table)
+{
+  if (!table || (!text && size > 0))
+    {
+    return false;
+    }
+
+  Format format;
+  std::fill(format.IsDelimiter, format.IsDelimiter + 256, false);
+  QByteArray delimiters =
+      settings.value(voDelimitedTextImportSettings::FieldDelimiterCharacters).toString().toLatin1();
+  for (int i = 0; i < delimiters.size(); ++i)
+    {
+    format.IsDelimiter[static_cast<unsigned char>(delimiters.at(i))] = true;
+    }
+  format.MergeConsecutiveDelimiters =
+      settings.value(voDelimitedTextImportSettings::MergeConsecutiveDelimiters).toBool();
+  format.UseStringDelimiter =
+      settings.value(voDelimitedTextImportSettings::UseStringDelimiter).toBool();
+  format.StringDelimiter =
+      settings.value(voDelimitedTextImportSettings::StringDelimiter).toChar().toLatin1();
+  const struct lconv * numericFormat = localeconv();
+  format.UseStrtod = numericFormat && numericFormat->decimal_point &&
+      std::string(numericFormat->decimal_point) == ".";
+
+  bool transpose = settings.value(voDelimitedTextImportSettings::Transpose).toBool();
+  vtkIdType numberOfColumnMetaDataTypes =
+      settings.value(voDelimitedTextImportSettings::NumberOfColumnMetaDataTypes).toInt();
+  vtkIdType numberOfRowMetaDataTypes =
+      settings.value(voDelimitedTextImportSettings::NumberOfRowMetaDataTypes).toInt();
+
+  std::vector<vtkIdType> lineBegins;
+  std::vector<vtkIdType> lineEnds;
+  findLines(text, size, format, lineBegins, lineEnds);
+  vtkIdType lineCount = static_cast<vtkIdType>(lineBegins.size());
+
+  vtkIdType width = 0;
+  if (lineCount > 0)
+    {
+    std::vector<Field> fields;
+    splitLine(text + lineBegins[0], text + lineEnds[0], format, fields);
+    width = static_cast<vtkIdType>(fields.size());
+    }
+
+  vtkIdType numberOfRows = transpose ? width : lineCount;
+  vtkIdType numberOfColumns = transpose ? lineCount : width;
+  if (numberOfColumnMetaDataTypes < 0 || numberOfColumnMetaDataTypes > numberOfRows ||
+      numberOfRowMetaDataTypes < 0 || numberOfRowMetaDataTypes > numberOfColumns)
+    {
+    qCritical() << "Failed to parse delimited text: a table of" << numberOfRows << "rows and"
+                << numberOfColumns << "columns can't have" << numberOfColumnMetaDataTypes
+                << "column metadata types and" << numberOfRowMetaDataTypes << "row metadata types";
+    return false;
+    }
+  vtkIdType numberOfDataRows = numberOfRows - numberOfColumnMetaDataTypes;
+  vtkIdType numberOfDataColumns = numberOfColumns - numberOfRowMetaDataTypes;
+
+  std::vector<std::string> labels(numberOfColumnMetaDataTypes * numberOfRowMetaDataTypes);
+  std::vector<std::string> columnMetaDataValues(numberOfColumnMetaDataTypes * numberOfDataColumns);
+  std::vector<std::string> rowMetaDataValues(numberOfRowMetaDataTypes * numberOfDataRows);
+  std::vector<LineReport> reports(lineCount);
+
+  LineFunctor functor;
+  functor.Text = text;
+  functor.LineBegins = &lineBegins;
+  functor.LineEnds = &lineEnds;
+  functor.TextFormat = &format;
+  functor.Transpose = transpose;
+  functor.Width = width;
+  functor.NumberOfColumnMetaDataTypes = numberOfColumnMetaDataTypes;
+  functor.NumberOfRowMetaDataTypes = numberOfRowMetaDataTypes;
+  functor.NumberOfDataRows = numberOfDataRows;
+  functor.NumberOfDataColumns = numberOfDataColumns;
+  functor.Data = table->AllocateData(numberOfDataRows, numberOfDataColumns);
+  functor.Labels = &labels;
+  functor.ColumnMetaData = &columnMetaDataValues;
+  functor.RowMetaData = &rowMetaDataValues;
+  functor.Reports = &reports;
+  voConcurrentUtils::parallelFor(lineCount, functor);
+
+  // Report the non numerical cells and the extra fields once
+  vtkIdType invalidCount = 0;
+  vtkIdType linesWithExtraFields = 0;
+  for (vtkIdType line = 0; line < lineCount; ++line)
+    {
+    if (reports[line].InvalidCount > 0 && invalidCount == 0)
+      {
+      vtkIdType fid = reports[line].FirstInvalidField;
+      qCritical() << "Data at column" << (transpose ? line : fid) << "and row" << (transpose ? fid : line)
+                  << "is not a numeric value !" << " - Defaulting to 0";
+      }
+    invalidCount += reports[line].InvalidCount;
+    linesWithExtraFields += (reports[line].ExtraFieldCount > 0);
+    }
+  if (invalidCount > 1)
+    {
+    qCritical() << invalidCount << "data values are not numeric - Defaulting to 0";
+    }
+  if (linesWithExtraFields > 0)
+    {
+    qWarning() << linesWithExtraFields << "lines have more than" << width
+               << "fields - Extra fields are ignored";
+    }
+
+  // ColumnMetaData
+  vtkNew<vtkTable> columnMetaData;
+  if (numberOfDataColumns > 0)
+    {
+    for (vtkIdType rid = 0; rid < numberOfColumnMetaDataTypes; ++rid)
+      {
+      columnMetaData->AddColumn(
+            newStringArray(columnMetaDataValues, rid * numberOfDataColumns, numberOfDataColumns));
+      }
+    }
+
+  // ColumnMetaDataLabels
+  vtkNew<vtkStringArray> columnMetaDataLabels;
+  if (numberOfRowMetaDataTypes > 0) // If there are no row metadata types, there is no room for column metadata labels
+    {
+    for (vtkIdType rid = 0; rid < numberOfColumnMetaDataTypes; ++rid)
+      {
+      columnMetaDataLabels->InsertNextValue(labels[rid * numberOfRowMetaDataTypes]);
+      }
+    }
+
+  // RowMetaData
+  vtkNew<vtkTable> rowMetaData;
+  if (numberOfDataRows > 0)
+    {
+    for (vtkIdType cid = 0; cid < numberOfRowMetaDataTypes; ++cid)
+      {
+      rowMetaData->AddColumn(newStringArray(rowMetaDataValues, cid * numberOfDataRows, numberOfDataRows));
+      }
+    }
+
+  // RowMetaDataLabels
+  vtkNew<vtkStringArray> rowMetaDataLabels;
+  if (numberOfColumnMetaDataTypes > 0) // If there are no column metadata types, there is no room for row metadata labels
+    {
+    for (vtkIdType cid = 0; cid < numberOfRowMetaDataTypes; ++cid)
+      {
+      rowMetaDataLabels->InsertNextValue(labels[cid]);
+      }
+    }
+
+  table->SetColumnMetaDataTable(columnMetaData.GetPointer());
+  table->SetRowMetaDataTable(rowMetaData.GetPointer());
+  table->SetColumnMetaDataLabels(columnMetaDataLabels.GetPointer());
+  table->SetRowMetaDataLabels(rowMetaDataLabels.GetPointer());
+
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool voDelimitedTextParser::parseFile(const QString& fileName,
+                                      const voDelimitedTextImportSettings& settings, vtkExtendedTable* table)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    {
+    qCritical() << "Failed to open file" << fileName;
+    return false;
+    }
+  qint64 size = file.size();
+  if (size == 0)
+    {
+    return voDelimitedTextParser::parse("", 0, settings, table);
+    }
+
+  uchar * mappedText = file.map(0, size);
+  if (mappedText)
+    {
+    bool success = voDelimitedTextParser::parse(
+          reinterpret_cast<const char*>(mappedText), size, settings, table);
+    file.unmap(mappedText);
+    return success;
+    }
+
+  // Mapping isn't supported by every device, read the whole file instead
+  QByteArray text = file.readAll();
+  if (text.size() != size)
+    {
+    qCritical() << "Failed to read file" << fileName;
+    return false;
+    }
+  return voDelimitedTextParser::parse(text.constData(), text.size(), settings, table);
+}
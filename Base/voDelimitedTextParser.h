@@ -0,0 +1,61 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voDelimitedTextParser_h
+#define __voDelimitedTextParser_h
+
+// VTK includes
+#include <vtkType.h>
+
+class QString;
+class voDelimitedTextImportSettings;
+class vtkExtendedTable;
+
+/// Parser filling a vtkExtendedTable directly from delimited text.
+///
+/// Unlike vtkDelimitedTextReader, cells are never stored as strings: numerical cells are
+/// parsed into the buffer allocated by vtkExtendedTable::AllocateData() and only the
+/// metadata rows and columns are kept as strings.
+///
+/// The text is first split on line boundaries: it is cut into chunks that are scanned
+/// concurrently, a line break belongs to a quoted string if an odd number of string
+/// delimiters precedes it. The lines are then parsed concurrently.
+///
+/// Lines are the rows of the table, or its columns if the Transpose setting is enabled.
+/// Empty lines are skipped and a trailing carriage return is ignored. The width of the
+/// table is the number of fields of the first line: extra fields are ignored and missing
+/// fields are considered empty. Like voIOManager::fillExtendedTable(), numerical cells
+/// that are empty or not a number default to 0, they are reported once.
+namespace voDelimitedTextParser
+{
+
+/// Parse the \a size characters of \a text into \a table according to \a settings.
+/// The metadata types of interest and the normalization are not applied.
+/// Return false if the text doesn't have enough rows or columns for the metadata.
+bool parse(const char* text, vtkIdType size, const voDelimitedTextImportSettings& settings,
+           vtkExtendedTable* table);
+
+/// Memory map \a fileName and parse it, see parse().
+/// Return false if the file can't be read or parsed.
+bool parseFile(const QString& fileName, const voDelimitedTextImportSettings& settings,
+               vtkExtendedTable* table);
+
+}
+
+#endif
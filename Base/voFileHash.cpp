@@ -0,0 +1,119 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+
+// Visomics includes
+#include "voFileHash.h"
+
+namespace
+{
+
+// Size of the blocks read to hash a file
+const qint64 HashBlockSize = 1 << 20;
+
+// Files modified less than this number of seconds before being hashed are not cached
+const int ModificationTimeResolution = 2;
+
+struct CachedHash
+{
+  qint64     Size;
+  QDateTime  LastModified;
+  QByteArray Hash;
+};
+
+QMutex                      CachedHashesMutex;
+QHash<QString, CachedHash>  CachedHashes;
+
+} // end of anonymous namespace
+
+// --------------------------------------------------------------------------
+QByteArray voFileHash::hash(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    {
+    return QByteArray();
+    }
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  while (!file.atEnd())
+    {
+    QByteArray block = file.read(HashBlockSize);
+    if (block.isEmpty())
+      {
+      return QByteArray();
+      }
+    hash.addData(block);
+    }
+  return hash.result();
+}
+
+// --------------------------------------------------------------------------
+QByteArray voFileHash::cachedHash(const QString& fileName)
+{
+  QFileInfo fileInfo(fileName);
+  if (!fileInfo.exists())
+    {
+    return QByteArray();
+    }
+  QString filePath = fileInfo.absoluteFilePath();
+  qint64 size = fileInfo.size();
+  QDateTime lastModified = fileInfo.lastModified();
+  {
+  QMutexLocker locker(&CachedHashesMutex);
+  QHash<QString, CachedHash>::const_iterator it = CachedHashes.constFind(filePath);
+  if (it != CachedHashes.constEnd() && it->Size == size && it->LastModified == lastModified)
+    {
+    return it->Hash;
+    }
+  }
+
+  QDateTime hashTime = QDateTime::currentDateTime();
+  QByteArray fileHash = voFileHash::hash(filePath);
+
+  QMutexLocker locker(&CachedHashesMutex);
+  if (fileHash.isEmpty() || lastModified.secsTo(hashTime) < ModificationTimeResolution)
+    {
+    CachedHashes.remove(filePath);
+    return fileHash;
+    }
+  CachedHash cachedHash;
+  cachedHash.Size = size;
+  cachedHash.LastModified = lastModified;
+  cachedHash.Hash = fileHash;
+  CachedHashes.insert(filePath, cachedHash);
+  return fileHash;
+}
+
+// --------------------------------------------------------------------------
+void voFileHash::clearCache()
+{
+  QMutexLocker locker(&CachedHashesMutex);
+  CachedHashes.clear();
+}
@@ -0,0 +1,45 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voFileHash_h
+#define __voFileHash_h
+
+class QByteArray;
+class QString;
+
+/// MD5 hashes of files, computed by reading them block by block so that
+/// hashing a file never loads it entirely in memory.
+namespace voFileHash
+{
+
+/// MD5 hash of the content of \a fileName.
+/// Return an empty array if the file can't be read.
+QByteArray hash(const QString& fileName);
+
+/// Same as hash(), but the hash is computed only once per file path, size and
+/// modification time. Files modified within the last seconds are hashed again,
+/// the resolution of the modification time may not tell their next change apart.
+QByteArray cachedHash(const QString& fileName);
+
+/// Forget the hashes computed by cachedHash()
+void clearCache();
+
+}
+
+#endif
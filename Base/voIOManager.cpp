@@ -21,12 +21,16 @@
 // Qt includes
 #include <QFileInfo>
 #include <QDebug>
+#include <QStringList>
 
 // Visomics includes
 #include "voAnalysis.h"
 #include "voApplication.h"
 #include "voDataModel.h"
 #include "voDataModelItem.h"
+#include "voDatasetCache.h"
+#include "voDelimitedTextParser.h"
+#include "voFileHash.h"
 #include "voInputFileDataObject.h"
 #include "voIOManager.h"
 #include "voRegistry.h"
@@ -43,6 +47,55 @@
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 
+// --------------------------------------------------------------------------
+// Helper functions
+
+namespace
+{
+
+// --------------------------------------------------------------------------
+// Apply the metadata types of interest and the normalization to a table whose data and
+// metadata have been imported
+void finalizeExtendedTable(vtkExtendedTable* destTable, const voDelimitedTextImportSettings& settings)
+{
+  // ColumnMetaDataTypeOfInterest
+  int columnMetaDataTypeOfInterest =
+      settings.value(voDelimitedTextImportSettings::ColumnMetaDataTypeOfInterest).toInt();
+
+  // RowMetaDataTypeOfInterest
+  int rowMetaDataTypeOfInterest =
+      settings.value(voDelimitedTextImportSettings::RowMetaDataTypeOfInterest).toInt();
+
+  destTable->SetColumnMetaDataTypeOfInterest(columnMetaDataTypeOfInterest);
+  destTable->SetRowMetaDataTypeOfInterest(rowMetaDataTypeOfInterest);
+
+  // Set column names
+  voUtils::setTableColumnNames(destTable->GetData(), destTable->GetColumnMetaDataOfInterestAsString());
+
+  // NormalizationMethod
+  QString normalizationMethod =
+      settings.value(voDelimitedTextImportSettings::NormalizationMethod).toString();
+
+  // NormalizationPipeline
+  QStringList normalizationPipeline =
+      settings.value(voDelimitedTextImportSettings::NormalizationPipeline).toStringList();
+  if (normalizationPipeline.isEmpty())
+    {
+    normalizationPipeline << normalizationMethod;
+    }
+
+  // Normalize
+  if (voApplication::application())
+    {
+    voApplication::application()->normalizerRegistry()->applyPipeline(
+          normalizationPipeline, destTable->GetData(), settings);
+    }
+
+  //destTable->GetData()->Dump();
+}
+
+} // end of anonymous namespace
+
 // --------------------------------------------------------------------------
 bool voIOManager::readCSVFileIntoTable(const QString& fileName, vtkTable * outputTable, const voDelimitedTextImportSettings& settings)
 {
@@ -232,37 +285,58 @@ void voIOManager::fillExtendedTable(vtkTable* sourceTable, vtkExtendedTable* des
 
   //data->Dump();
 
-  // ColumnMetaDataTypeOfInterest
-  int columnMetaDataTypeOfInterest =
-      settings.value(voDelimitedTextImportSettings::ColumnMetaDataTypeOfInterest).toInt();
-
-  // RowMetaDataTypeOfInterest
-  int rowMetaDataTypeOfInterest =
-      settings.value(voDelimitedTextImportSettings::RowMetaDataTypeOfInterest).toInt();
-
   destTable->SetColumnMetaDataTable(columnMetaData.GetPointer());
   destTable->SetRowMetaDataTable(rowMetaData.GetPointer());
   destTable->SetData(data.GetPointer());
-  destTable->SetColumnMetaDataTypeOfInterest(columnMetaDataTypeOfInterest);
-  destTable->SetRowMetaDataTypeOfInterest(rowMetaDataTypeOfInterest);
   destTable->SetColumnMetaDataLabels(columnMetaDataLabels.GetPointer());
   destTable->SetRowMetaDataLabels(rowMetaDataLabels.GetPointer());
 
-  // Set column names
-  voUtils::setTableColumnNames(destTable->GetData(), destTable->GetColumnMetaDataOfInterestAsString());
+  finalizeExtendedTable(destTable, settings);
+}
 
-  // NormalizationMethod
-  QString normalizationMethod =
-      settings.value(voDelimitedTextImportSettings::NormalizationMethod).toString();
+// --------------------------------------------------------------------------
+bool voIOManager::readCSVFileIntoExtendedTable(const QString& fileName, vtkExtendedTable* destTable,
+                                               const voDelimitedTextImportSettings& settings)
+{
+  if (!destTable)
+    {
+    return false;
+    }
+  if (!voDelimitedTextParser::parseFile(fileName, settings, destTable))
+    {
+    return false;
+    }
+  finalizeExtendedTable(destTable, settings);
+  return true;
+}
 
-  // Normalize
-  if (voApplication::application())
+// --------------------------------------------------------------------------
+bool voIOManager::readCSVFileIntoExtendedTableUsingCache(const QString& fileName, vtkExtendedTable* destTable,
+                                                         const voDelimitedTextImportSettings& settings)
+{
+  if (!destTable)
     {
-    voApplication::application()->normalizerRegistry()->apply(
-          normalizationMethod, destTable->GetData(), settings);
+    return false;
+    }
+  QByteArray sourceHash = voFileHash::cachedHash(fileName);
+  QByteArray settingsHash = voDatasetCache::settingsHash(settings);
+  QString cacheFileName = voDatasetCache::cacheFileName(fileName);
+  if (!sourceHash.isEmpty() &&
+      voDatasetCache::read(cacheFileName, sourceHash, settingsHash, destTable))
+    {
+    return true;
     }
 
-  //destTable->GetData()->Dump();
+  if (!Self::readCSVFileIntoExtendedTable(fileName, destTable, settings))
+    {
+    return false;
+    }
+  if (!sourceHash.isEmpty() &&
+      !voDatasetCache::write(cacheFileName, sourceHash, settingsHash, destTable))
+    {
+    qWarning() << "Failed to write dataset cache" << cacheFileName;
+    }
+  return true;
 }
 
 // --------------------------------------------------------------------------
@@ -270,11 +344,12 @@ void voIOManager::openCSVFile(const QString& fileName, const voDelimitedTextImpo
 {
   // settings.printAdditionalInfo();
 
-  vtkNew<vtkTable> table;
-  Self::readCSVFileIntoTable(fileName, table.GetPointer(), settings);
-
   vtkNew<vtkExtendedTable> extendedTable;
-  Self::fillExtendedTable(table.GetPointer(), extendedTable.GetPointer(), settings);
+  if (!Self::readCSVFileIntoExtendedTableUsingCache(fileName, extendedTable.GetPointer(), settings))
+    {
+    qCritical() << "Failed to import" << fileName;
+    return;
+    }
 
   voInputFileDataObject * dataObject =
       new voInputFileDataObject(fileName, extendedTable.GetPointer());
@@ -45,6 +45,18 @@ public:
   static void fillExtendedTable(vtkTable* sourceTable, vtkExtendedTable* destTable,
                                 const voDelimitedTextImportSettings& settings = voDelimitedTextImportSettings());
 
+  /// Parse \a fileName directly into \a destTable, see voDelimitedTextParser.
+  /// Equivalent to readCSVFileIntoTable() followed by fillExtendedTable() without
+  /// storing every cell as a string.
+  static bool readCSVFileIntoExtendedTable(const QString& fileName, vtkExtendedTable* destTable,
+                                           const voDelimitedTextImportSettings& settings = voDelimitedTextImportSettings());
+
+  /// Load \a destTable from the dataset cache if it has been written for the current content
+  /// of \a fileName and for \a settings, see voDatasetCache. Otherwise, parse the file using
+  /// readCSVFileIntoExtendedTable() and write the cache.
+  static bool readCSVFileIntoExtendedTableUsingCache(const QString& fileName, vtkExtendedTable* destTable,
+                                                     const voDelimitedTextImportSettings& settings = voDelimitedTextImportSettings());
+
   void openCSVFile(const QString& fileName, const voDelimitedTextImportSettings& settings);
 
   static bool writeDataObjectToFile(vtkDataObject * dataObject, const QString& fileName);
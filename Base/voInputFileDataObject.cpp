@@ -19,9 +19,11 @@
 =========================================================================*/
 
 // Qt includes
+#include <QByteArray>
 #include <QFileInfo>
 
 // Visomics includes
+#include "voFileHash.h"
 #include "voInputFileDataObject.h"
 
 // VTK includes
@@ -85,3 +87,9 @@ void voInputFileDataObject::setFileName(const QString& newFileName)
   d->FileName = newFileName;
 }
 
+// --------------------------------------------------------------------------
+QByteArray voInputFileDataObject::fileHash()const
+{
+  Q_D(const voInputFileDataObject);
+  return voFileHash::cachedHash(d->FileName);
+}
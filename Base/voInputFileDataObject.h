@@ -40,7 +40,12 @@ public:
 
   QString fileName()const;
   void setFileName(const QString& newFileName);
-  
+
+  /// MD5 hash of the content of the file, computed by blocks and only once
+  /// per modification of the file.
+  /// \sa voFileHash::cachedHash()
+  QByteArray fileHash()const;
+
 protected:
   QScopedPointer<voInputFileDataObjectPrivate> d_ptr;
 
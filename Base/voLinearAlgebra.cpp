@@ -0,0 +1,1234 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QString>
+
+// Visomics includes
+#include "voConcurrentUtils.h"
+#include "voLinearAlgebra.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+// Number of rows processed at once by the matrix products, the slice of each
+// column stays in the L1 cache while it is combined with all the vectors.
+const vtkIdType RowBlockSize = 256;
+
+// Random vectors sampled in addition to the requested components
+const int Oversampling = 10;
+
+// Power iterations refining the sampled range
+const int PowerIterations = 3;
+
+// Iterations and convergence threshold of the iterative PLS algorithms
+const int PLSMaximumIterations = 500;
+const double PLSTolerance = 1e-12;
+
+//----------------------------------------------------------------------------
+double dot(const double* x, const double* y, vtkIdType count)
+{
+  double sum0 = 0.;
+  double sum1 = 0.;
+  double sum2 = 0.;
+  double sum3 = 0.;
+  vtkIdType i = 0;
+  for (; i + 4 <= count; i += 4)
+    {
+    sum0 += x[i] * y[i];
+    sum1 += x[i + 1] * y[i + 1];
+    sum2 += x[i + 2] * y[i + 2];
+    sum3 += x[i + 3] * y[i + 3];
+    }
+  for (; i < count; ++i)
+    {
+    sum0 += x[i] * y[i];
+    }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+//----------------------------------------------------------------------------
+// Y = (A - mean 1^T) X where A is rows x columns and X is columns x count.
+// Computes the rows [begin, end) of Y.
+class MultiplyFunctor
+{
+public:
+  const double* A;
+  const double* Means;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  const double* X;
+  const double* XColumnSums;
+  int Count;
+  double* Y;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType blockBegin = begin; blockBegin < end; blockBegin += RowBlockSize)
+      {
+      vtkIdType blockSize = std::min(RowBlockSize, end - blockBegin);
+      for (int c = 0; c < this->Count; ++c)
+        {
+        double* y = this->Y + c * this->NumberOfRows + blockBegin;
+        double sum = this->XColumnSums[c];
+        const double* means = this->Means + blockBegin;
+        for (vtkIdType r = 0; r < blockSize; ++r)
+          {
+          y[r] = -means[r] * sum;
+          }
+        }
+      for (vtkIdType j = 0; j < this->NumberOfColumns; ++j)
+        {
+        const double* a = this->A + j * this->NumberOfRows + blockBegin;
+        for (int c = 0; c < this->Count; ++c)
+          {
+          double x = this->X[c * this->NumberOfColumns + j];
+          double* y = this->Y + c * this->NumberOfRows + blockBegin;
+          for (vtkIdType r = 0; r < blockSize; ++r)
+            {
+            y[r] += a[r] * x;
+            }
+          }
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Z = (A - mean 1^T)^T Y where A is rows x columns and Y is rows x count.
+// Computes the rows [begin, end) of Z, i.e. the columns [begin, end) of A.
+class TransposeMultiplyFunctor
+{
+public:
+  const double* A;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  const double* Y;
+  const double* MeanDotY;
+  int Count;
+  double* Z;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType j = begin; j < end; ++j)
+      {
+      const double* a = this->A + j * this->NumberOfRows;
+      for (int c = 0; c < this->Count; ++c)
+        {
+        this->Z[c * this->NumberOfColumns + j] =
+          dot(a, this->Y + c * this->NumberOfRows, this->NumberOfRows) - this->MeanDotY[c];
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Centered data matrix, never formed explicitly
+class CenteredMatrix
+{
+public:
+  const double* A;
+  vtkIdType NumberOfRows;
+  vtkIdType NumberOfColumns;
+  std::vector<double> Means;
+
+  // Y = Ac X
+  void multiply(const std::vector<double>& X, int count, std::vector<double>& Y)const
+    {
+    std::vector<double> columnSums(count, 0.);
+    for (int c = 0; c < count; ++c)
+      {
+      for (vtkIdType j = 0; j < this->NumberOfColumns; ++j)
+        {
+        columnSums[c] += X[c * this->NumberOfColumns + j];
+        }
+      }
+    Y.resize(this->NumberOfRows * count);
+    MultiplyFunctor functor;
+    functor.A = this->A;
+    functor.Means = &this->Means[0];
+    functor.NumberOfRows = this->NumberOfRows;
+    functor.NumberOfColumns = this->NumberOfColumns;
+    functor.X = &X[0];
+    functor.XColumnSums = &columnSums[0];
+    functor.Count = count;
+    functor.Y = &Y[0];
+    voConcurrentUtils::parallelFor(this->NumberOfRows, functor);
+    }
+
+  // Z = Ac^T Y
+  void transposeMultiply(const std::vector<double>& Y, int count, std::vector<double>& Z)const
+    {
+    std::vector<double> meanDotY(count);
+    for (int c = 0; c < count; ++c)
+      {
+      meanDotY[c] = dot(&this->Means[0], &Y[c * this->NumberOfRows], this->NumberOfRows);
+      }
+    Z.resize(this->NumberOfColumns * count);
+    TransposeMultiplyFunctor functor;
+    functor.A = this->A;
+    functor.NumberOfRows = this->NumberOfRows;
+    functor.NumberOfColumns = this->NumberOfColumns;
+    functor.Y = &Y[0];
+    functor.MeanDotY = &meanDotY[0];
+    functor.Count = count;
+    functor.Z = &Z[0];
+    voConcurrentUtils::parallelFor(this->NumberOfColumns, functor);
+    }
+};
+
+//----------------------------------------------------------------------------
+// Reproducible pseudo-random generator (Marsaglia's 32-bit xorshift)
+class RandomGenerator
+{
+public:
+  RandomGenerator(vtkTypeUInt32 seed) : State(seed ? seed : 0x9E3779B9u) {}
+
+  /// Uniform value in [-1, 1)
+  double symmetricUniform()
+    {
+    this->State ^= this->State << 13;
+    this->State ^= this->State >> 17;
+    this->State ^= this->State << 5;
+    return this->State * (2. / 4294967296.) - 1.;
+    }
+
+private:
+  vtkTypeUInt32 State;
+};
+
+//----------------------------------------------------------------------------
+// y = X v where X is rows x columns
+void multiplyVector(const double* X, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                    const double* v, double* y)
+{
+  std::fill(y, y + numberOfRows, 0.);
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    double value = v[c];
+    if (value == 0.)
+      {
+      continue;
+      }
+    const double* column = X + c * numberOfRows;
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      y[r] += column[r] * value;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// z = X' y where X is rows x columns
+void transposeMultiplyVector(const double* X, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                             const double* y, double* z)
+{
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    z[c] = dot(X + c * numberOfRows, y, numberOfRows);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Scale x to unit length unless it is zero, return its initial length
+double normalize(double* x, vtkIdType count)
+{
+  double norm = std::sqrt(dot(x, x, count));
+  if (norm > 0.)
+    {
+    double scale = 1. / norm;
+    for (vtkIdType i = 0; i < count; ++i)
+      {
+      x[i] *= scale;
+      }
+    }
+  return norm;
+}
+
+//----------------------------------------------------------------------------
+// Index of the column of X having the largest sum of squares
+vtkIdType largestColumn(const double* X, vtkIdType numberOfRows, vtkIdType numberOfColumns, double& sumOfSquares)
+{
+  vtkIdType largest = 0;
+  sumOfSquares = -1.;
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    double columnSumOfSquares = dot(X + c * numberOfRows, X + c * numberOfRows, numberOfRows);
+    if (columnSumOfSquares > sumOfSquares)
+      {
+      largest = c;
+      sumOfSquares = columnSumOfSquares;
+      }
+    }
+  return largest;
+}
+
+//----------------------------------------------------------------------------
+// Unit direction w maximizing |M' w| where M is rows x columns: the leading left singular vector
+// of M. Return false if M is zero.
+bool leadingDirection(const std::vector<double>& M, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                      std::vector<double>& w)
+{
+  w.assign(numberOfRows, 0.);
+  if (numberOfColumns == 1)
+    {
+    std::copy(M.begin(), M.begin() + numberOfRows, w.begin());
+    }
+  else
+    {
+    int size = static_cast<int>(numberOfColumns);
+    std::vector<double> gram(size * size);
+    for (int c1 = 0; c1 < size; ++c1)
+      {
+      for (int c2 = c1; c2 < size; ++c2)
+        {
+        gram[c1 * size + c2] = gram[c2 * size + c1] =
+          dot(&M[c1 * numberOfRows], &M[c2 * numberOfRows], numberOfRows);
+        }
+      }
+    std::vector<double> eigenvalues(size);
+    std::vector<double> eigenvectors(size * size);
+    voLinearAlgebra::symmetricEigenDecomposition(&gram[0], size, &eigenvalues[0], &eigenvectors[0]);
+    multiplyVector(&M[0], numberOfRows, numberOfColumns, &eigenvectors[0], &w[0]);
+    }
+  return normalize(&w[0], numberOfRows) > 0.;
+}
+
+//----------------------------------------------------------------------------
+// K = G K G with G = I - t t' / |t|^2, where K is a symmetric size x size matrix
+void deflateKernel(std::vector<double>& K, vtkIdType size, const double* t, double tSquaredNorm)
+{
+  std::vector<double> Kt(size);
+  multiplyVector(&K[0], size, size, t, &Kt[0]);
+  double tKt = dot(t, &Kt[0], size) / tSquaredNorm;
+  for (vtkIdType j = 0; j < size; ++j)
+    {
+    double* column = &K[j * size];
+    for (vtkIdType i = 0; i < size; ++i)
+      {
+      column[i] += (tKt * t[i] * t[j] - t[i] * Kt[j] - Kt[i] * t[j]) / tSquaredNorm;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// X X' where X is rows x columns
+void outerProduct(const std::vector<double>& X, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                  std::vector<double>& K)
+{
+  K.assign(numberOfRows * numberOfRows, 0.);
+  for (vtkIdType c = 0; c < numberOfColumns; ++c)
+    {
+    const double* column = &X[c * numberOfRows];
+    for (vtkIdType j = 0; j < numberOfRows; ++j)
+      {
+      double value = column[j];
+      double* k = &K[j * numberOfRows];
+      for (vtkIdType i = 0; i < numberOfRows; ++i)
+        {
+        k[i] += column[i] * value;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Partial least squares model of centered matrices X (observations x predictors) and
+// Y (observations x responses). Scores, loadings and weights are stored column by column.
+class PLSModel
+{
+public:
+  PLSModel(const std::vector<double>& x, const std::vector<double>& y, vtkIdType numberOfObservations,
+           vtkIdType numberOfPredictors, vtkIdType numberOfResponses)
+    : X(x), Y(y), NumberOfObservations(numberOfObservations), NumberOfPredictors(numberOfPredictors),
+      NumberOfResponses(numberOfResponses), Components(0)
+    {
+    this->XSumOfSquares = dot(&x[0], &x[0], numberOfObservations * numberOfPredictors);
+    }
+
+  const std::vector<double>& X;
+  const std::vector<double>& Y;
+  vtkIdType NumberOfObservations;
+  vtkIdType NumberOfPredictors;
+  vtkIdType NumberOfResponses;
+  double XSumOfSquares;
+
+  int Components;
+  std::vector<double> T;
+  std::vector<double> TSquaredNorms;
+  std::vector<double> U;
+  std::vector<double> P;
+  std::vector<double> W;
+  std::vector<double> Q;
+  // Projection such that T = X R, used to predict new observations
+  std::vector<double> R;
+
+  void fit(int numberOfComponents, voLinearAlgebra::PLSAlgorithm algorithm)
+    {
+    switch (algorithm)
+      {
+      case voLinearAlgebra::KernelPLS:
+        this->fitKernel(numberOfComponents);
+        break;
+      case voLinearAlgebra::WideKernelPLS:
+        this->fitWideKernel(numberOfComponents);
+        break;
+      case voLinearAlgebra::SIMPLS:
+        this->fitSIMPLS(numberOfComponents);
+        break;
+      case voLinearAlgebra::OrthogonalScoresPLS:
+        this->fitOrthogonalScores(numberOfComponents);
+        break;
+      }
+    }
+
+  // Add to squaredErrors (responses x (numberOfComponents + 1)) the squared errors of
+  // the predictions of the centered observations x (count x predictors) whose centered
+  // responses are y (count x responses). Columns beyond the fitted components repeat the
+  // error of the last component.
+  void accumulateSquaredErrors(const double* x, const double* y, vtkIdType count,
+                               int numberOfComponents, double* squaredErrors)const
+    {
+    vtkIdType m = this->NumberOfResponses;
+    std::vector<double> residuals(y, y + count * m);
+    std::vector<double> scores(count);
+    for (int a = 0; a <= numberOfComponents; ++a)
+      {
+      if (a > 0 && a <= this->Components)
+        {
+        multiplyVector(x, count, this->NumberOfPredictors, &this->R[(a - 1) * this->NumberOfPredictors],
+                       &scores[0]);
+        for (vtkIdType c = 0; c < m; ++c)
+          {
+          double q = this->Q[(a - 1) * m + c];
+          double* residual = &residuals[c * count];
+          for (vtkIdType i = 0; i < count; ++i)
+            {
+            residual[i] -= scores[i] * q;
+            }
+          }
+        }
+      for (vtkIdType c = 0; c < m; ++c)
+        {
+        squaredErrors[c * (numberOfComponents + 1) + a] +=
+          dot(&residuals[c * count], &residuals[c * count], count);
+        }
+      }
+    }
+
+private:
+  // Kernel algorithm of Dayal and MacGregor. X'X isn't formed, X-loadings are computed from the scores.
+  void fitKernel(int numberOfComponents)
+    {
+    vtkIdType p = this->NumberOfPredictors;
+    vtkIdType m = this->NumberOfResponses;
+    std::vector<double> XtY(p * m);
+    for (vtkIdType c = 0; c < m; ++c)
+      {
+      transposeMultiplyVector(&this->X[0], this->NumberOfObservations, p,
+                              &this->Y[c * this->NumberOfObservations], &XtY[c * p]);
+      }
+    std::vector<double> w;
+    while (this->Components < numberOfComponents)
+      {
+      if (!leadingDirection(XtY, p, m, w) || !this->addComponent(w))
+        {
+        break;
+        }
+      const double* loading = &this->P[(this->Components - 1) * p];
+      const double* yLoading = &this->Q[(this->Components - 1) * m];
+      double tSquaredNorm = this->TSquaredNorms.back();
+      for (vtkIdType c = 0; c < m; ++c)
+        {
+        double scale = tSquaredNorm * yLoading[c];
+        for (vtkIdType k = 0; k < p; ++k)
+          {
+          XtY[c * p + k] -= scale * loading[k];
+          }
+        }
+      }
+    }
+
+  // Wide kernel algorithm of Rannar et al.: the weights are obtained from the observations x
+  // observations kernels XX' and YY'.
+  void fitWideKernel(int numberOfComponents)
+    {
+    vtkIdType n = this->NumberOfObservations;
+    vtkIdType m = this->NumberOfResponses;
+    std::vector<double> K;
+    std::vector<double> L;
+    outerProduct(this->X, n, this->NumberOfPredictors, K);
+    outerProduct(this->Y, n, m, L);
+    std::vector<double> t(n);
+    std::vector<double> previous(n);
+    std::vector<double> Lt(n);
+    std::vector<double> w(this->NumberOfPredictors);
+    while (this->Components < numberOfComponents)
+      {
+      // Start from the deflated response Y - TQ' having the largest sum of squares
+      double sumOfSquares = -1.;
+      for (vtkIdType c = 0; c < m; ++c)
+        {
+        std::copy(&this->Y[c * n], &this->Y[c * n] + n, previous.begin());
+        for (int a = 0; a < this->Components; ++a)
+          {
+          double yLoading = this->Q[a * m + c];
+          for (vtkIdType i = 0; i < n; ++i)
+            {
+            previous[i] -= this->T[a * n + i] * yLoading;
+            }
+          }
+        double columnSumOfSquares = dot(&previous[0], &previous[0], n);
+        if (columnSumOfSquares > sumOfSquares)
+          {
+          t.swap(previous);
+          sumOfSquares = columnSumOfSquares;
+          }
+        }
+      if (!(normalize(&t[0], n) > 0.))
+        {
+        break;
+        }
+      // Power iterations: t is the leading eigenvector of XX'YY'
+      for (int iteration = 0; iteration < PLSMaximumIterations; ++iteration)
+        {
+        previous.swap(t);
+        multiplyVector(&L[0], n, n, &previous[0], &Lt[0]);
+        multiplyVector(&K[0], n, n, &Lt[0], &t[0]);
+        if (!(normalize(&t[0], n) > 0.))
+          {
+          break;
+          }
+        double change = 0.;
+        for (vtkIdType i = 0; i < n; ++i)
+          {
+          change = std::max(change, std::fabs(t[i] - previous[i]));
+          }
+        if (change <= PLSTolerance)
+          {
+          break;
+          }
+        }
+      // YY't is orthogonal to the previous scores: X' YY't = Xa' YY't
+      multiplyVector(&L[0], n, n, &t[0], &Lt[0]);
+      transposeMultiplyVector(&this->X[0], n, this->NumberOfPredictors, &Lt[0], &w[0]);
+      if (!(normalize(&w[0], this->NumberOfPredictors) > 0.) || !this->addComponent(w))
+        {
+        break;
+        }
+      const double* scores = &this->T[(this->Components - 1) * n];
+      deflateKernel(K, n, scores, this->TSquaredNorms.back());
+      deflateKernel(L, n, scores, this->TSquaredNorms.back());
+      }
+    }
+
+  // de Jong's SIMPLS: the cross product X'Y is deflated by projecting it out of the span of
+  // the previous loadings. Scores are scaled to unit length.
+  void fitSIMPLS(int numberOfComponents)
+    {
+    vtkIdType n = this->NumberOfObservations;
+    vtkIdType p = this->NumberOfPredictors;
+    vtkIdType m = this->NumberOfResponses;
+    std::vector<double> S(p * m);
+    for (vtkIdType c = 0; c < m; ++c)
+      {
+      transposeMultiplyVector(&this->X[0], n, p, &this->Y[c * n], &S[c * p]);
+      }
+    std::vector<double> V;
+    std::vector<double> r;
+    std::vector<double> t(n);
+    std::vector<double> loading(p);
+    std::vector<double> yLoading(m);
+    std::vector<double> v(p);
+    while (this->Components < numberOfComponents)
+      {
+      // Same direction as S q where q is the leading eigenvector of S'S
+      if (!leadingDirection(S, p, m, r))
+        {
+        break;
+        }
+      multiplyVector(&this->X[0], n, p, &r[0], &t[0]);
+      double tNorm = std::sqrt(dot(&t[0], &t[0], n));
+      if (!(tNorm * tNorm > std::numeric_limits<double>::epsilon() * this->XSumOfSquares))
+        {
+        break;
+        }
+      for (vtkIdType i = 0; i < n; ++i)
+        {
+        t[i] /= tNorm;
+        }
+      for (vtkIdType k = 0; k < p; ++k)
+        {
+        r[k] /= tNorm;
+        }
+      transposeMultiplyVector(&this->X[0], n, p, &t[0], &loading[0]);
+      transposeMultiplyVector(&this->Y[0], n, m, &t[0], &yLoading[0]);
+      std::vector<double> w(r);
+      this->storeComponent(w, r, t, 1., loading, yLoading, false);
+
+      // Orthonormal basis of the loadings
+      std::copy(this->P.end() - p, this->P.end(), v.begin());
+      for (int a = 0; a < this->Components - 1; ++a)
+        {
+        double projection = dot(&V[a * p], &v[0], p);
+        for (vtkIdType k = 0; k < p; ++k)
+          {
+          v[k] -= projection * V[a * p + k];
+          }
+        }
+      normalize(&v[0], p);
+      V.insert(V.end(), v.begin(), v.end());
+      for (vtkIdType c = 0; c < m; ++c)
+        {
+        double projection = dot(&v[0], &S[c * p], p);
+        for (vtkIdType k = 0; k < p; ++k)
+          {
+          S[c * p + k] -= projection * v[k];
+          }
+        }
+      }
+    }
+
+  // NIPALS with explicit deflation of X and Y, giving orthogonal scores
+  void fitOrthogonalScores(int numberOfComponents)
+    {
+    vtkIdType n = this->NumberOfObservations;
+    vtkIdType p = this->NumberOfPredictors;
+    vtkIdType m = this->NumberOfResponses;
+    std::vector<double> Xa(this->X);
+    std::vector<double> Ya(this->Y);
+    std::vector<double> u(n);
+    std::vector<double> w(p);
+    std::vector<double> t(n);
+    std::vector<double> previous(n);
+    std::vector<double> q(m);
+    while (this->Components < numberOfComponents)
+      {
+      double sumOfSquares = 0.;
+      vtkIdType start = largestColumn(&Ya[0], n, m, sumOfSquares);
+      if (!(sumOfSquares > 0.))
+        {
+        break;
+        }
+      std::copy(&Ya[start * n], &Ya[start * n] + n, u.begin());
+      bool valid = true;
+      for (int iteration = 0; iteration < PLSMaximumIterations; ++iteration)
+        {
+        transposeMultiplyVector(&Xa[0], n, p, &u[0], &w[0]);
+        if (!(normalize(&w[0], p) > 0.))
+          {
+          valid = false;
+          break;
+          }
+        previous.swap(t);
+        multiplyVector(&Xa[0], n, p, &w[0], &t[0]);
+        if (m == 1)
+          {
+          break;
+          }
+        double tSquaredNorm = dot(&t[0], &t[0], n);
+        transposeMultiplyVector(&Ya[0], n, m, &t[0], &q[0]);
+        double change = 0.;
+        double size = 0.;
+        for (vtkIdType i = 0; i < n; ++i)
+          {
+          change += std::fabs(t[i] - previous[i]);
+          size += std::fabs(t[i]);
+          }
+        if (iteration > 0 && change <= PLSTolerance * size)
+          {
+          break;
+          }
+        double qSquaredNorm = dot(&q[0], &q[0], m);
+        if (!(qSquaredNorm > 0.) || !(tSquaredNorm > 0.))
+          {
+          break;
+          }
+        multiplyVector(&Ya[0], n, m, &q[0], &u[0]);
+        }
+      if (!valid || !this->addComponent(w))
+        {
+        break;
+        }
+      const double* scores = &this->T[(this->Components - 1) * n];
+      const double* loading = &this->P[(this->Components - 1) * p];
+      const double* yLoading = &this->Q[(this->Components - 1) * m];
+      for (vtkIdType k = 0; k < p; ++k)
+        {
+        for (vtkIdType i = 0; i < n; ++i)
+          {
+          Xa[k * n + i] -= scores[i] * loading[k];
+          }
+        }
+      for (vtkIdType c = 0; c < m; ++c)
+        {
+        for (vtkIdType i = 0; i < n; ++i)
+          {
+          Ya[c * n + i] -= scores[i] * yLoading[c];
+          }
+        }
+      }
+    }
+
+  // Add the component of unit weight w: the projection r making the scores orthogonal to the
+  // previous ones is r = w - sum (p_j' w) r_j. Return false if the predictors are exhausted.
+  bool addComponent(std::vector<double>& w)
+    {
+    vtkIdType n = this->NumberOfObservations;
+    vtkIdType p = this->NumberOfPredictors;
+    std::vector<double> r(w);
+    for (int a = 0; a < this->Components; ++a)
+      {
+      double projection = dot(&this->P[a * p], &w[0], p);
+      for (vtkIdType k = 0; k < p; ++k)
+        {
+        r[k] -= projection * this->R[a * p + k];
+        }
+      }
+    std::vector<double> t(n);
+    multiplyVector(&this->X[0], n, p, &r[0], &t[0]);
+    double tSquaredNorm = dot(&t[0], &t[0], n);
+    if (!(tSquaredNorm > std::numeric_limits<double>::epsilon() * this->XSumOfSquares * dot(&r[0], &r[0], p)))
+      {
+      return false;
+      }
+    std::vector<double> loading(p);
+    std::vector<double> yLoading(this->NumberOfResponses);
+    transposeMultiplyVector(&this->X[0], n, p, &t[0], &loading[0]);
+    transposeMultiplyVector(&this->Y[0], n, this->NumberOfResponses, &t[0], &yLoading[0]);
+    for (vtkIdType k = 0; k < p; ++k)
+      {
+      loading[k] /= tSquaredNorm;
+      }
+    for (vtkIdType c = 0; c < this->NumberOfResponses; ++c)
+      {
+      yLoading[c] /= tSquaredNorm;
+      }
+    this->storeComponent(w, r, t, tSquaredNorm, loading, yLoading, true);
+    return true;
+    }
+
+  // Orient and append a component. The Y-scores are Y q (divided by |q|^2 if scaleYScores)
+  // made orthogonal to the previous scores.
+  void storeComponent(std::vector<double>& w, std::vector<double>& r, std::vector<double>& t,
+                      double tSquaredNorm, std::vector<double>& loading, std::vector<double>& yLoading,
+                      bool scaleYScores)
+    {
+    vtkIdType n = this->NumberOfObservations;
+    vtkIdType m = this->NumberOfResponses;
+    vtkIdType largest = 0;
+    for (vtkIdType c = 1; c < m; ++c)
+      {
+      largest = std::fabs(yLoading[c]) > std::fabs(yLoading[largest]) ? c : largest;
+      }
+    if (yLoading[largest] < 0.)
+      {
+      std::transform(w.begin(), w.end(), w.begin(), std::negate<double>());
+      std::transform(r.begin(), r.end(), r.begin(), std::negate<double>());
+      std::transform(t.begin(), t.end(), t.begin(), std::negate<double>());
+      std::transform(loading.begin(), loading.end(), loading.begin(), std::negate<double>());
+      std::transform(yLoading.begin(), yLoading.end(), yLoading.begin(), std::negate<double>());
+      }
+
+    std::vector<double> u(n);
+    multiplyVector(&this->Y[0], n, m, &yLoading[0], &u[0]);
+    double qSquaredNorm = dot(&yLoading[0], &yLoading[0], m);
+    if (scaleYScores && qSquaredNorm > 0.)
+      {
+      for (vtkIdType i = 0; i < n; ++i)
+        {
+        u[i] /= qSquaredNorm;
+        }
+      }
+    for (int a = 0; a < this->Components; ++a)
+      {
+      const double* scores = &this->T[a * n];
+      double projection = dot(scores, &u[0], n) / this->TSquaredNorms[a];
+      for (vtkIdType i = 0; i < n; ++i)
+        {
+        u[i] -= projection * scores[i];
+        }
+      }
+
+    this->W.insert(this->W.end(), w.begin(), w.end());
+    this->R.insert(this->R.end(), r.begin(), r.end());
+    this->T.insert(this->T.end(), t.begin(), t.end());
+    this->TSquaredNorms.push_back(tSquaredNorm);
+    this->P.insert(this->P.end(), loading.begin(), loading.end());
+    this->Q.insert(this->Q.end(), yLoading.begin(), yLoading.end());
+    this->U.insert(this->U.end(), u.begin(), u.end());
+    ++this->Components;
+    }
+};
+
+//----------------------------------------------------------------------------
+// Means of the columns of data restricted to the given rows
+void columnMeans(const double* data, vtkIdType numberOfRows, const std::vector<vtkIdType>& columns,
+                 const std::vector<vtkIdType>& rows, std::vector<double>& means)
+{
+  means.assign(columns.size(), 0.);
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    const double* column = data + columns[c] * numberOfRows;
+    for (size_t i = 0; i < rows.size(); ++i)
+      {
+      means[c] += column[rows[i]];
+      }
+    means[c] /= rows.size();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Copy the given rows and columns of data, minus the column means, into matrix (rows x columns)
+void gatherCentered(const double* data, vtkIdType numberOfRows, const std::vector<vtkIdType>& columns,
+                    const std::vector<vtkIdType>& rows, const std::vector<double>& means,
+                    std::vector<double>& matrix)
+{
+  vtkIdType count = static_cast<vtkIdType>(rows.size());
+  matrix.resize(count * columns.size());
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    const double* column = data + columns[c] * numberOfRows;
+    double* destination = &matrix[c * count];
+    for (vtkIdType i = 0; i < count; ++i)
+      {
+      destination[i] = column[rows[i]] - means[c];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Fit the segments [begin, end): a segment is predicted by the model fitted on the other
+// observations. Each segment adds its squared errors into its own slice of SquaredErrors.
+class CrossValidationFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  const std::vector<vtkIdType>* Predictors;
+  const std::vector<vtkIdType>* Responses;
+  int NumberOfComponents;
+  voLinearAlgebra::PLSAlgorithm Algorithm;
+  int NumberOfSegments;
+  double* SquaredErrors;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    vtkIdType errorCount = static_cast<vtkIdType>(this->Responses->size()) * (this->NumberOfComponents + 1);
+    for (vtkIdType segment = begin; segment < end; ++segment)
+      {
+      std::vector<vtkIdType> trainingRows;
+      std::vector<vtkIdType> testRows;
+      for (vtkIdType i = 0; i < this->NumberOfRows; ++i)
+        {
+        (i % this->NumberOfSegments == segment ? testRows : trainingRows).push_back(i);
+        }
+      std::vector<double> xMeans;
+      std::vector<double> yMeans;
+      columnMeans(this->Data, this->NumberOfRows, *this->Predictors, trainingRows, xMeans);
+      columnMeans(this->Data, this->NumberOfRows, *this->Responses, trainingRows, yMeans);
+      std::vector<double> X;
+      std::vector<double> Y;
+      gatherCentered(this->Data, this->NumberOfRows, *this->Predictors, trainingRows, xMeans, X);
+      gatherCentered(this->Data, this->NumberOfRows, *this->Responses, trainingRows, yMeans, Y);
+      PLSModel model(X, Y, static_cast<vtkIdType>(trainingRows.size()),
+                     static_cast<vtkIdType>(this->Predictors->size()),
+                     static_cast<vtkIdType>(this->Responses->size()));
+      model.fit(std::min(this->NumberOfComponents, static_cast<int>(trainingRows.size()) - 1),
+                this->Algorithm);
+
+      // Test observations are centered using the training means
+      gatherCentered(this->Data, this->NumberOfRows, *this->Predictors, testRows, xMeans, X);
+      gatherCentered(this->Data, this->NumberOfRows, *this->Responses, testRows, yMeans, Y);
+      model.accumulateSquaredErrors(&X[0], &Y[0], static_cast<vtkIdType>(testRows.size()),
+                                    this->NumberOfComponents, this->SquaredErrors + segment * errorCount);
+      }
+    }
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void voLinearAlgebra::symmetricEigenDecomposition(const double* matrix, int size,
+                                                  double* eigenvalues, double* eigenvectors)
+{
+  std::vector<double> a(matrix, matrix + size * size);
+  std::fill(eigenvectors, eigenvectors + size * size, 0.);
+  for (int i = 0; i < size; ++i)
+    {
+    eigenvectors[i * size + i] = 1.;
+    }
+
+  const int maximumSweeps = 100;
+  for (int sweep = 0; sweep < maximumSweeps; ++sweep)
+    {
+    double offDiagonal = 0.;
+    double diagonal = 0.;
+    for (int p = 0; p < size; ++p)
+      {
+      diagonal += a[p * size + p] * a[p * size + p];
+      for (int q = p + 1; q < size; ++q)
+        {
+        offDiagonal += a[q * size + p] * a[q * size + p];
+        }
+      }
+    if (offDiagonal <= std::numeric_limits<double>::epsilon() * std::numeric_limits<double>::epsilon() * diagonal ||
+        offDiagonal == 0.)
+      {
+      break;
+      }
+    for (int p = 0; p < size - 1; ++p)
+      {
+      for (int q = p + 1; q < size; ++q)
+        {
+        double apq = a[q * size + p];
+        if (apq == 0.)
+          {
+          continue;
+          }
+        // Rotation annihilating a(p, q)
+        double theta = (a[q * size + q] - a[p * size + p]) / (2. * apq);
+        double t = (theta >= 0. ? 1. : -1.) / (std::fabs(theta) + std::sqrt(theta * theta + 1.));
+        double c = 1. / std::sqrt(t * t + 1.);
+        double s = t * c;
+        for (int k = 0; k < size; ++k)
+          {
+          // Columns p and q
+          double akp = a[p * size + k];
+          double akq = a[q * size + k];
+          a[p * size + k] = c * akp - s * akq;
+          a[q * size + k] = s * akp + c * akq;
+          }
+        for (int k = 0; k < size; ++k)
+          {
+          // Rows p and q
+          double apk = a[k * size + p];
+          double aqk = a[k * size + q];
+          a[k * size + p] = c * apk - s * aqk;
+          a[k * size + q] = s * apk + c * aqk;
+          }
+        for (int k = 0; k < size; ++k)
+          {
+          double vkp = eigenvectors[p * size + k];
+          double vkq = eigenvectors[q * size + k];
+          eigenvectors[p * size + k] = c * vkp - s * vkq;
+          eigenvectors[q * size + k] = s * vkp + c * vkq;
+          }
+        }
+      }
+    }
+
+  // Sort by decreasing eigenvalue
+  std::vector<std::pair<double, int> > order(size);
+  for (int i = 0; i < size; ++i)
+    {
+    order[i] = std::make_pair(-a[i * size + i], i);
+    }
+  std::sort(order.begin(), order.end());
+  std::vector<double> vectors(eigenvectors, eigenvectors + size * size);
+  for (int i = 0; i < size; ++i)
+    {
+    eigenvalues[i] = -order[i].first;
+    std::copy(&vectors[order[i].second * size], &vectors[order[i].second * size] + size,
+              eigenvectors + i * size);
+    }
+}
+
+//----------------------------------------------------------------------------
+void voLinearAlgebra::orthonormalizeColumns(double* matrix, vtkIdType numberOfRows, int numberOfColumns)
+{
+  for (int c = 0; c < numberOfColumns; ++c)
+    {
+    double* column = matrix + c * numberOfRows;
+    double initialNorm = std::sqrt(dot(column, column, numberOfRows));
+    // A second pass recovers the orthogonality lost to cancellation
+    for (int pass = 0; pass < 2; ++pass)
+      {
+      for (int previous = 0; previous < c; ++previous)
+        {
+        const double* previousColumn = matrix + previous * numberOfRows;
+        double projection = dot(previousColumn, column, numberOfRows);
+        for (vtkIdType r = 0; r < numberOfRows; ++r)
+          {
+          column[r] -= projection * previousColumn[r];
+          }
+        }
+      }
+    double norm = std::sqrt(dot(column, column, numberOfRows));
+    double scale = (norm > 1e-10 * initialNorm && norm > 0.) ? 1. / norm : 0.;
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      column[r] *= scale;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool voLinearAlgebra::truncatedPCA(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                   int numberOfComponents, PCAResult& result)
+{
+  if (!data || numberOfRows < 1 || numberOfColumns < 1 || numberOfComponents < 1)
+    {
+    return false;
+    }
+  int components = static_cast<int>(std::min(static_cast<vtkIdType>(numberOfComponents),
+                                             std::min(numberOfRows, numberOfColumns)));
+  int sampleCount = static_cast<int>(std::min(static_cast<vtkIdType>(components + Oversampling),
+                                              std::min(numberOfRows, numberOfColumns)));
+
+  // Row means and total variance
+  CenteredMatrix matrix;
+  matrix.A = data;
+  matrix.NumberOfRows = numberOfRows;
+  matrix.NumberOfColumns = numberOfColumns;
+  matrix.Means.assign(numberOfRows, 0.);
+  for (vtkIdType j = 0; j < numberOfColumns; ++j)
+    {
+    const double* column = data + j * numberOfRows;
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      matrix.Means[r] += column[r];
+      }
+    }
+  for (vtkIdType r = 0; r < numberOfRows; ++r)
+    {
+    matrix.Means[r] /= numberOfColumns;
+    if (!(std::fabs(matrix.Means[r]) <= std::numeric_limits<double>::max()))
+      {
+      return false;
+      }
+    }
+  double sumOfSquares = 0.;
+  for (vtkIdType j = 0; j < numberOfColumns; ++j)
+    {
+    const double* column = data + j * numberOfRows;
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      double deviation = column[r] - matrix.Means[r];
+      sumOfSquares += deviation * deviation;
+      }
+    }
+  double denominator = numberOfColumns > 1 ? numberOfColumns - 1. : 1.;
+  result.TotalVariance = sumOfSquares / denominator;
+
+  // Sample the range of the centered matrix
+  std::vector<double> omega(numberOfColumns * sampleCount);
+  RandomGenerator random(static_cast<vtkTypeUInt32>(numberOfRows * 31 + numberOfColumns));
+  for (size_t i = 0; i < omega.size(); ++i)
+    {
+    omega[i] = random.symmetricUniform();
+    }
+  std::vector<double> Q;
+  std::vector<double> Z;
+  matrix.multiply(omega, sampleCount, Q);
+  // Sampling as many vectors as the smallest dimension captures the whole range
+  bool exact = (sampleCount >= std::min(numberOfRows, numberOfColumns));
+  for (int iteration = 0; iteration < (exact ? 0 : PowerIterations); ++iteration)
+    {
+    voLinearAlgebra::orthonormalizeColumns(&Q[0], numberOfRows, sampleCount);
+    matrix.transposeMultiply(Q, sampleCount, Z);
+    voLinearAlgebra::orthonormalizeColumns(&Z[0], numberOfColumns, sampleCount);
+    matrix.multiply(Z, sampleCount, Q);
+    }
+  voLinearAlgebra::orthonormalizeColumns(&Q[0], numberOfRows, sampleCount);
+
+  // Ac ~ Q B with B = Q^T Ac, the SVD of B is obtained from the eigen decomposition of B B^T = Z^T Z
+  matrix.transposeMultiply(Q, sampleCount, Z);
+  std::vector<double> gram(sampleCount * sampleCount);
+  for (int c1 = 0; c1 < sampleCount; ++c1)
+    {
+    for (int c2 = c1; c2 < sampleCount; ++c2)
+      {
+      gram[c1 * sampleCount + c2] = gram[c2 * sampleCount + c1] =
+        dot(&Z[c1 * numberOfColumns], &Z[c2 * numberOfColumns], numberOfColumns);
+      }
+    }
+  std::vector<double> eigenvalues(sampleCount);
+  std::vector<double> eigenvectors(sampleCount * sampleCount);
+  voLinearAlgebra::symmetricEigenDecomposition(&gram[0], sampleCount, &eigenvalues[0], &eigenvectors[0]);
+
+  // Rotation = Q U and projection = Ac^T Q U = Z U
+  result.Rotation.assign(numberOfRows * components, 0.);
+  result.Projection.assign(numberOfColumns * components, 0.);
+  result.StandardDeviations.resize(components);
+  for (int c = 0; c < components; ++c)
+    {
+    double* rotation = &result.Rotation[c * numberOfRows];
+    double* projection = &result.Projection[c * numberOfColumns];
+    for (int s = 0; s < sampleCount; ++s)
+      {
+      double u = eigenvectors[c * sampleCount + s];
+      const double* q = &Q[s * numberOfRows];
+      const double* z = &Z[s * numberOfColumns];
+      for (vtkIdType r = 0; r < numberOfRows; ++r)
+        {
+        rotation[r] += q[r] * u;
+        }
+      for (vtkIdType j = 0; j < numberOfColumns; ++j)
+        {
+        projection[j] += z[j] * u;
+        }
+      }
+    result.StandardDeviations[c] = std::sqrt(std::max(0., eigenvalues[c]) / denominator);
+
+    vtkIdType largest = 0;
+    for (vtkIdType r = 1; r < numberOfRows; ++r)
+      {
+      largest = std::fabs(rotation[r]) > std::fabs(rotation[largest]) ? r : largest;
+      }
+    if (rotation[largest] < 0.)
+      {
+      std::transform(rotation, rotation + numberOfRows, rotation, std::negate<double>());
+      std::transform(projection, projection + numberOfColumns, projection, std::negate<double>());
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voLinearAlgebra::plsAlgorithmFromString(const QString& algorithmName, PLSAlgorithm& algorithm)
+{
+  if (algorithmName == QLatin1String("kernelpls"))
+    {
+    algorithm = voLinearAlgebra::KernelPLS;
+    }
+  else if (algorithmName == QLatin1String("widekernelpls"))
+    {
+    algorithm = voLinearAlgebra::WideKernelPLS;
+    }
+  else if (algorithmName == QLatin1String("simpls"))
+    {
+    algorithm = voLinearAlgebra::SIMPLS;
+    }
+  else if (algorithmName == QLatin1String("oscorespls"))
+    {
+    algorithm = voLinearAlgebra::OrthogonalScoresPLS;
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voLinearAlgebra::partialLeastSquares(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                          const std::vector<vtkIdType>& predictors,
+                                          const std::vector<vtkIdType>& responses,
+                                          int numberOfComponents, PLSAlgorithm algorithm, int numberOfSegments,
+                                          PLSResult& result)
+{
+  if (!data || numberOfRows < 2 || predictors.empty() || responses.empty() || numberOfComponents < 1)
+    {
+    return false;
+    }
+  std::vector<vtkIdType> columns(predictors);
+  columns.insert(columns.end(), responses.begin(), responses.end());
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    if (columns[c] < 0 || columns[c] >= numberOfColumns)
+      {
+      return false;
+      }
+    const double* column = data + columns[c] * numberOfRows;
+    for (vtkIdType i = 0; i < numberOfRows; ++i)
+      {
+      if (!(std::fabs(column[i]) <= std::numeric_limits<double>::max()))
+        {
+        return false;
+        }
+      }
+    }
+  vtkIdType numberOfPredictors = static_cast<vtkIdType>(predictors.size());
+  vtkIdType numberOfResponses = static_cast<vtkIdType>(responses.size());
+  int components = static_cast<int>(std::min(static_cast<vtkIdType>(numberOfComponents),
+                                             std::min(numberOfRows - 1, numberOfPredictors)));
+
+  // Fit all the observations
+  std::vector<vtkIdType> rows(numberOfRows);
+  for (vtkIdType i = 0; i < numberOfRows; ++i)
+    {
+    rows[i] = i;
+    }
+  std::vector<double> xMeans;
+  std::vector<double> yMeans;
+  columnMeans(data, numberOfRows, predictors, rows, xMeans);
+  columnMeans(data, numberOfRows, responses, rows, yMeans);
+  std::vector<double> X;
+  std::vector<double> Y;
+  gatherCentered(data, numberOfRows, predictors, rows, xMeans, X);
+  gatherCentered(data, numberOfRows, responses, rows, yMeans, Y);
+  PLSModel model(X, Y, numberOfRows, numberOfPredictors, numberOfResponses);
+  model.fit(components, algorithm);
+  if (model.Components == 0)
+    {
+    return false;
+    }
+  components = model.Components;
+  result.NumberOfComponents = components;
+  result.Scores = model.T;
+  result.YScores = model.U;
+  result.Loadings = model.P;
+  result.LoadingWeights = model.W;
+  result.YLoadings = model.Q;
+
+  // Prediction error
+  vtkIdType errorCount = numberOfResponses * (components + 1);
+  std::vector<double> squaredErrors(errorCount, 0.);
+  int segments = static_cast<int>(std::min(static_cast<vtkIdType>(numberOfSegments), numberOfRows));
+  if (segments >= 2)
+    {
+    std::vector<double> segmentSquaredErrors(segments * errorCount, 0.);
+    CrossValidationFunctor functor;
+    functor.Data = data;
+    functor.NumberOfRows = numberOfRows;
+    functor.Predictors = &predictors;
+    functor.Responses = &responses;
+    functor.NumberOfComponents = components;
+    functor.Algorithm = algorithm;
+    functor.NumberOfSegments = segments;
+    functor.SquaredErrors = &segmentSquaredErrors[0];
+    voConcurrentUtils::parallelFor(segments, functor, 1);
+    for (int segment = 0; segment < segments; ++segment)
+      {
+      for (vtkIdType i = 0; i < errorCount; ++i)
+        {
+        squaredErrors[i] += segmentSquaredErrors[segment * errorCount + i];
+        }
+      }
+    }
+  else
+    {
+    model.accumulateSquaredErrors(&X[0], &Y[0], numberOfRows, components, &squaredErrors[0]);
+    }
+  result.RMSEP.resize(errorCount);
+  for (vtkIdType i = 0; i < errorCount; ++i)
+    {
+    result.RMSEP[i] = std::sqrt(squaredErrors[i] / numberOfRows);
+    }
+  return true;
+}
@@ -0,0 +1,137 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voLinearAlgebra_h
+#define __voLinearAlgebra_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class QString;
+
+/// Native implementation of the matrix decompositions performed by the analyses.
+///
+/// Matrices are stored column-major, like vtkExtendedTable::GetDataBuffer(): the value
+/// at row \a r and column \a c of a matrix having \a numberOfRows rows is located at
+/// index c * numberOfRows + r.
+namespace voLinearAlgebra
+{
+
+/// Eigenvalues and eigenvectors of the \a size x \a size symmetric \a matrix, computed
+/// using the cyclic Jacobi method. Eigenvalues are sorted in decreasing order, column i
+/// of \a eigenvectors is the unit eigenvector associated with eigenvalues[i].
+/// \a eigenvalues must be able to hold size values and \a eigenvectors size * size values.
+void symmetricEigenDecomposition(const double* matrix, int size, double* eigenvalues, double* eigenvectors);
+
+/// Orthonormalize in place the columns of \a matrix using two passes of the modified
+/// Gram-Schmidt process. Columns depending linearly on the previous ones are set to zero.
+void orthonormalizeColumns(double* matrix, vtkIdType numberOfRows, int numberOfColumns);
+
+/// Principal components computed by truncatedPCA()
+struct PCAResult
+{
+  /// Principal axes (rows x components): column c is the unit vector of component c
+  std::vector<double> Rotation;
+  /// Standard deviation of each component
+  std::vector<double> StandardDeviations;
+  /// Coordinates of the columns in the principal axes (columns x components)
+  std::vector<double> Projection;
+  /// Sum of the variances of the rows, it is also the sum of the variances of all the components
+  double TotalVariance;
+};
+
+/// Principal component analysis of the columns (observations) of \a data whose rows are
+/// the variables, like the R expression "prcomp(t(data), center=TRUE, scale.=FALSE)" restricted
+/// to the first \a numberOfComponents components. \a numberOfComponents is clamped to
+/// min(numberOfRows, numberOfColumns).
+///
+/// The rows are centered implicitly and the decomposition uses the randomized SVD of
+/// Halko, Martinsson and Tropp: the range of the centered matrix is sampled with a few more
+/// random vectors than components, refined by power iterations, then the small projected
+/// problem is solved exactly. Besides \a data, memory is proportional to
+/// (numberOfRows + numberOfColumns) * numberOfComponents. The result is exact when
+/// the number of sampled vectors reaches the number of columns.
+/// Matrix products are computed concurrently. The sign of each component is chosen so that
+/// the largest coordinate of its axis is positive.
+/// Return false if \a data is empty or if some values aren't finite.
+bool truncatedPCA(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                  int numberOfComponents, PCAResult& result);
+
+/// Partial least squares algorithms, see the R function "plsr" of the package "pls"
+enum PLSAlgorithm
+  {
+  KernelPLS = 0,
+  WideKernelPLS,
+  SIMPLS,
+  OrthogonalScoresPLS
+  };
+
+/// Partial least squares regression computed by partialLeastSquares()
+struct PLSResult
+{
+  int NumberOfComponents;
+  /// X-scores (observations x components)
+  std::vector<double> Scores;
+  /// Y-scores (observations x components)
+  std::vector<double> YScores;
+  /// X-loadings (predictors x components)
+  std::vector<double> Loadings;
+  /// Loading weights (predictors x components), the projection R of SIMPLS
+  std::vector<double> LoadingWeights;
+  /// Y-loadings (responses x components)
+  std::vector<double> YLoadings;
+  /// Root mean squared error of prediction ((components + 1) x responses): row c is the
+  /// error of the model using c components, row 0 being the intercept only model
+  std::vector<double> RMSEP;
+};
+
+/// Convert "kernelpls", "widekernelpls", "simpls" or "oscorespls" into the associated algorithm.
+/// Return false if \a algorithmName doesn't match any algorithm.
+bool plsAlgorithmFromString(const QString& algorithmName, PLSAlgorithm& algorithm);
+
+/// Partial least squares regression of the \a responses columns of \a data on its
+/// \a predictors columns, like the R expression "plsr(Y ~ X, method=algorithm)".
+/// Rows of \a data are the observations: the row-major buffer of a vtkExtendedTable
+/// (analytes x experiments) is used as is, without transposing it.
+/// \a numberOfComponents is clamped to min(numberOfRows - 1, number of predictors) and
+/// extraction stops early when the predictors are exhausted.
+///
+/// Kernel, wide kernel and orthogonal scores algorithms compute the same model, they only
+/// differ by the matrices they work on: the kernel algorithm deflates X'Y (predictors x
+/// responses), the wide kernel algorithm deflates XX' and YY' (observations x observations)
+/// and the orthogonal scores algorithm deflates X and Y. The sign of each component is
+/// chosen so that the largest coefficient of its Y-loadings is positive.
+///
+/// If \a numberOfSegments is at least 2, RMSEP is estimated by cross-validation using
+/// that many interleaved segments (observation i belongs to segment i % numberOfSegments,
+/// like the R option segment.type="interleaved"), the segments are fitted concurrently.
+/// Otherwise RMSEP is the training error.
+/// Return false if there are less than 2 observations, if a column index is out of range
+/// or if some values aren't finite.
+bool partialLeastSquares(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                         const std::vector<vtkIdType>& predictors, const std::vector<vtkIdType>& responses,
+                         int numberOfComponents, PLSAlgorithm algorithm, int numberOfSegments,
+                         PLSResult& result);
+
+}
+
+#endif
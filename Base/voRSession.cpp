@@ -0,0 +1,248 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+// Visomics includes
+#include "voDataObject.h"
+#include "voRSession.h"
+
+// VTK includes
+#include <vtkArray.h>
+#include <vtkArrayData.h>
+#include <vtkDataObject.h>
+#include <vtkRInterface.h>
+#include <vtkSmartPointer.h>
+
+//----------------------------------------------------------------------------
+class voRSessionPrivate
+{
+public:
+  voRSessionPrivate();
+
+  /// Remove least recently used matrices until there are at most \a count of them
+  void shrinkCache(int count);
+
+  vtkSmartPointer<vtkRInterface> RInterface;
+  mutable QMutex Mutex;
+
+  QSet<QString> LoadedPackages;
+
+  /// Cache key -> R variable holding the matrix
+  QHash<QString, QString> CachedArrayVariables;
+  /// Cache keys, most recently used last
+  QStringList CachedArrayKeys;
+  int MaximumCachedArrayCount;
+  int CachedArrayCounter;
+};
+
+//----------------------------------------------------------------------------
+// voRSessionPrivate methods
+
+//----------------------------------------------------------------------------
+voRSessionPrivate::voRSessionPrivate() : Mutex(QMutex::Recursive)
+{
+  this->MaximumCachedArrayCount = 4;
+  this->CachedArrayCounter = 0;
+}
+
+//----------------------------------------------------------------------------
+void voRSessionPrivate::shrinkCache(int count)
+{
+  while (this->CachedArrayKeys.count() > qMax(0, count))
+    {
+    QString variableName = this->CachedArrayVariables.take(this->CachedArrayKeys.takeFirst());
+    this->RInterface->EvalRscript(QString("rm(%1)").arg(variableName).toLatin1(), false);
+    }
+}
+
+//----------------------------------------------------------------------------
+// voRSession methods
+
+//----------------------------------------------------------------------------
+voRSession::voRSession():d_ptr(new voRSessionPrivate)
+{
+  Q_D(voRSession);
+  d->RInterface = vtkSmartPointer<vtkRInterface>::New();
+}
+
+//----------------------------------------------------------------------------
+voRSession::~voRSession()
+{
+}
+
+//----------------------------------------------------------------------------
+voRSession* voRSession::instance()
+{
+  static voRSession Instance;
+  return &Instance;
+}
+
+//----------------------------------------------------------------------------
+QMutex* voRSession::mutex()const
+{
+  Q_D(const voRSession);
+  return &d->Mutex;
+}
+
+//----------------------------------------------------------------------------
+bool voRSession::requirePackage(const QString& package)
+{
+  Q_D(voRSession);
+  QMutexLocker locker(&d->Mutex);
+  if (d->LoadedPackages.contains(package))
+    {
+    return true;
+    }
+  if (!this->evalScript(QString("library(\"%1\")").arg(package)))
+    {
+    qCritical() << QObject::tr("Failed to load R package \"%1\"").arg(package);
+    return false;
+    }
+  d->LoadedPackages.insert(package);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voRSession::putArray(const QString& variableName, vtkArray* array, const QString& cacheKey)
+{
+  Q_D(voRSession);
+  if (!array || variableName.isEmpty())
+    {
+    return false;
+    }
+  QMutexLocker locker(&d->Mutex);
+  if (cacheKey.isEmpty() || d->MaximumCachedArrayCount == 0)
+    {
+    d->RInterface->AssignVTKArrayToRVariable(array, variableName.toLatin1());
+    return true;
+    }
+
+  // Replace the matrix previously associated with the key
+  if (d->CachedArrayVariables.contains(cacheKey))
+    {
+    d->CachedArrayKeys.removeOne(cacheKey);
+    d->CachedArrayKeys.append(cacheKey);
+    }
+  else
+    {
+    d->shrinkCache(d->MaximumCachedArrayCount - 1);
+    d->CachedArrayVariables.insert(cacheKey, QString(".voCachedArray%1").arg(++d->CachedArrayCounter));
+    d->CachedArrayKeys.append(cacheKey);
+    }
+  d->RInterface->AssignVTKArrayToRVariable(array, d->CachedArrayVariables.value(cacheKey).toLatin1());
+  return this->assignCachedArray(variableName, cacheKey);
+}
+
+//----------------------------------------------------------------------------
+bool voRSession::assignCachedArray(const QString& variableName, const QString& cacheKey)
+{
+  Q_D(voRSession);
+  QMutexLocker locker(&d->Mutex);
+  if (cacheKey.isEmpty() || !d->CachedArrayVariables.contains(cacheKey))
+    {
+    return false;
+    }
+  d->CachedArrayKeys.removeOne(cacheKey);
+  d->CachedArrayKeys.append(cacheKey);
+  // R copies on modification, the matrix is not duplicated
+  return this->evalScript(
+        QString("%1 <- %2").arg(variableName).arg(d->CachedArrayVariables.value(cacheKey)));
+}
+
+//----------------------------------------------------------------------------
+bool voRSession::getArray(const QString& variableName, const QString& arrayName, vtkArrayData* output)
+{
+  Q_D(voRSession);
+  if (!output)
+    {
+    return false;
+    }
+  QMutexLocker locker(&d->Mutex);
+  vtkArray * array = d->RInterface->AssignRVariableToVTKArray(variableName.toLatin1());
+  if (!array)
+    {
+    return false;
+    }
+  array->SetName(arrayName.toLatin1());
+  output->AddArray(array);
+  array->Delete();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voRSession::evalScript(const QString& script)
+{
+  Q_D(voRSession);
+  QMutexLocker locker(&d->Mutex);
+  return d->RInterface->EvalRscript(script.toLatin1(), /* showRoutput= */ false) == 0;
+}
+
+//----------------------------------------------------------------------------
+QString voRSession::cacheKey(voDataObject* dataObject, const QString& qualifier)
+{
+  if (!dataObject)
+    {
+    return QString();
+    }
+  vtkDataObject * data = dataObject->dataAsVTKDataObject();
+  unsigned long modifiedTime = data ? data->GetMTime() : 0;
+  return QString("%1:%2:%3").arg(dataObject->uuid()).arg(modifiedTime).arg(qualifier);
+}
+
+//----------------------------------------------------------------------------
+QString voRSession::cacheKey(voDataObject* dataObject, const QList<int>& columnList)
+{
+  QStringList columns;
+  foreach(int column, columnList)
+    {
+    columns << QString::number(column);
+    }
+  return voRSession::cacheKey(dataObject, QString("columns=%1").arg(columns.join(",")));
+}
+
+//----------------------------------------------------------------------------
+int voRSession::maximumCachedArrayCount()const
+{
+  Q_D(const voRSession);
+  return d->MaximumCachedArrayCount;
+}
+
+//----------------------------------------------------------------------------
+void voRSession::setMaximumCachedArrayCount(int count)
+{
+  Q_D(voRSession);
+  QMutexLocker locker(&d->Mutex);
+  d->MaximumCachedArrayCount = qMax(0, count);
+  d->shrinkCache(d->MaximumCachedArrayCount);
+}
+
+//----------------------------------------------------------------------------
+void voRSession::clearCache()
+{
+  Q_D(voRSession);
+  QMutexLocker locker(&d->Mutex);
+  d->shrinkCache(0);
+}
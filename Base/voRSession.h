@@ -0,0 +1,100 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voRSession_h
+#define __voRSession_h
+
+// Qt includes
+#include <QList>
+#include <QScopedPointer>
+#include <QString>
+
+class QMutex;
+class voDataObject;
+class voRSessionPrivate;
+class vtkArray;
+class vtkArrayData;
+
+/// Embedded R interpreter shared by all the analyses and normalization methods.
+///
+/// Packages loaded using requirePackage() stay loaded for the lifetime of the application.
+/// Input matrices transferred using putArray() with a cache key stay resident in R,
+/// assignCachedArray() then binds them to a variable without converting the data again.
+///
+/// R is not reentrant: a sequence of calls making up one computation must hold mutex().
+/// \code
+/// voRSession * session = voRSession::instance();
+/// QMutexLocker locker(session->mutex());
+/// QString key = voRSession::cacheKey(this->input());
+/// if (!session->assignCachedArray("metabData", key))
+///   {
+///   session->putArray("metabData", array, key);
+///   }
+/// session->evalScript("correl <- cor(t(metabData))");
+/// session->getArray("correl", "correl", outputArrayData);
+/// \endcode
+class voRSession
+{
+public:
+  static voRSession* instance();
+
+  QMutex* mutex()const;
+
+  /// Load \a package unless it has already been loaded. Return false if it can't be loaded.
+  bool requirePackage(const QString& package);
+
+  /// Assign \a array to the R variable \a variableName.
+  /// If \a cacheKey is not empty, the matrix is kept resident in R and can later
+  /// be bound to other variables using assignCachedArray().
+  bool putArray(const QString& variableName, vtkArray* array, const QString& cacheKey = QString());
+
+  /// Bind the matrix cached under \a cacheKey to \a variableName.
+  /// Return false if no matrix is cached under that key.
+  bool assignCachedArray(const QString& variableName, const QString& cacheKey);
+
+  /// Convert the R variable \a variableName into an array named \a arrayName added to \a output.
+  bool getArray(const QString& variableName, const QString& arrayName, vtkArrayData* output);
+
+  bool evalScript(const QString& script);
+
+  /// Key identifying the data of \a dataObject, it changes when the data are modified.
+  /// \a qualifier allows to distinguish matrices derived from the same data object.
+  static QString cacheKey(voDataObject* dataObject, const QString& qualifier = QString());
+
+  /// Key identifying the matrix made of the columns \a columnList of \a dataObject.
+  static QString cacheKey(voDataObject* dataObject, const QList<int>& columnList);
+
+  /// Maximum number of matrices kept resident in R. Least recently used ones are removed first.
+  int maximumCachedArrayCount()const;
+  void setMaximumCachedArrayCount(int count);
+
+  void clearCache();
+
+protected:
+  voRSession();
+  virtual ~voRSession();
+
+  QScopedPointer<voRSessionPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(voRSession);
+  Q_DISABLE_COPY(voRSession);
+};
+
+#endif
@@ -18,23 +18,113 @@
 
 =========================================================================*/
 
+// Qt includes
+#include <QList>
+#include <QStringList>
+
 // Visomics includes
+#include "voConcurrentUtils.h"
 #include "voRegistry.h"
+#include "vtkExtendedTable.h"
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <vector>
+
 //----------------------------------------------------------------------------
 namespace
 {
 bool applyNoop(vtkTable * /*dataTable*/, const QHash<int, QVariant>& /*settings*/){ return true; }
-} // end of Normalization namespace
+
+//----------------------------------------------------------------------------
+// Apply all the column kernels to each of the columns [begin, end) of a column-major buffer
+class ColumnPipelineFunctor
+{
+public:
+  double* Data;
+  vtkIdType NumberOfRows;
+  const QList<voRegistry::ApplyColumnNormalizationFunction>* Functions;
+  const QHash<int, QVariant>* Settings;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType c = begin; c < end; ++c)
+      {
+      double* values = this->Data + c * this->NumberOfRows;
+      foreach(voRegistry::ApplyColumnNormalizationFunction function, *this->Functions)
+        {
+        (*function)(values, this->NumberOfRows, *this->Settings);
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Apply the column kernels to all the columns of dataTable: in place if the table is backed
+// by a contiguous buffer, through a copy of its numeric columns otherwise.
+bool applyColumnFunctions(const QList<voRegistry::ApplyColumnNormalizationFunction>& functions,
+                          vtkTable * dataTable, const QHash<int, QVariant>& settings)
+{
+  vtkIdType numberOfRows = dataTable->GetNumberOfRows();
+  vtkIdType numberOfColumns = dataTable->GetNumberOfColumns();
+  if (functions.isEmpty() || numberOfRows == 0 || numberOfColumns == 0)
+    {
+    return true;
+    }
+
+  ColumnPipelineFunctor functor;
+  functor.NumberOfRows = numberOfRows;
+  functor.Functions = &functions;
+  functor.Settings = &settings;
+
+  vtkExtendedTable * extendedTable = vtkExtendedTable::SafeDownCast(dataTable);
+  functor.Data = extendedTable ? extendedTable->GetContiguousDataBuffer() : 0;
+  if (functor.Data)
+    {
+    voConcurrentUtils::parallelFor(numberOfColumns, functor);
+    dataTable->Modified();
+    return true;
+    }
+
+  std::vector<double> values(numberOfRows * numberOfColumns);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkDataArray * column = vtkDataArray::SafeDownCast(dataTable->GetColumn(cid));
+    if (!column || column->GetNumberOfTuples() != numberOfRows)
+      {
+      return false;
+      }
+    for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+      {
+      values[cid * numberOfRows + rid] = column->GetTuple1(rid);
+      }
+    }
+  functor.Data = &values[0];
+  voConcurrentUtils::parallelFor(numberOfColumns, functor);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkDataArray * column = vtkDataArray::SafeDownCast(dataTable->GetColumn(cid));
+    for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+      {
+      column->SetTuple1(rid, values[cid * numberOfRows + rid]);
+      }
+    column->Modified();
+    }
+  dataTable->Modified();
+  return true;
+}
+
+} // end of anonymous namespace
 
 //----------------------------------------------------------------------------
 class voRegistryPrivate
 {
 public:
   QHash<QString, voRegistry::ApplyNormalizationFunction> MethodNameToFunctionMap;
+  QHash<QString, voRegistry::ApplyColumnNormalizationFunction> MethodNameToColumnFunctionMap;
 };
 
 //----------------------------------------------------------------------------
@@ -55,7 +145,7 @@ voRegistry::~voRegistry()
 void voRegistry::registerMethod(const QString& methodName, ApplyNormalizationFunction function)
 {
   Q_D(voRegistry);
-  if (d->MethodNameToFunctionMap.keys().contains(methodName))
+  if (this->isRegistered(methodName))
     {
     return;
     }
@@ -66,13 +156,67 @@ void voRegistry::registerMethod(const QString& methodName, ApplyNormalizationFun
   d->MethodNameToFunctionMap.insert(methodName, function);
 }
 
+//----------------------------------------------------------------------------
+void voRegistry::registerColumnMethod(const QString& methodName, ApplyColumnNormalizationFunction function)
+{
+  Q_D(voRegistry);
+  if (this->isRegistered(methodName))
+    {
+    return;
+    }
+  if (!function)
+    {
+    return;
+    }
+  d->MethodNameToColumnFunctionMap.insert(methodName, function);
+}
+
+//----------------------------------------------------------------------------
+bool voRegistry::isRegistered(const QString& methodName)const
+{
+  Q_D(const voRegistry);
+  return d->MethodNameToFunctionMap.contains(methodName) ||
+      d->MethodNameToColumnFunctionMap.contains(methodName);
+}
+
 //----------------------------------------------------------------------------  
 bool voRegistry::apply(const QString& methodName, vtkTable * dataTable, const QHash<int, QVariant>& settings)
+{
+  return this->applyPipeline(QStringList() << methodName, dataTable, settings);
+}
+
+//----------------------------------------------------------------------------
+bool voRegistry::applyPipeline(const QStringList& methodNames, vtkTable * dataTable,
+                               const QHash<int, QVariant>& settings)
 {
   Q_D(voRegistry);
-  if (!d->MethodNameToFunctionMap.keys().contains(methodName))
+  foreach(const QString& methodName, methodNames)
+    {
+    if (!this->isRegistered(methodName))
+      {
+      return false;
+      }
+    }
+  if (!dataTable)
     {
     return false;
     }
-  return (*d->MethodNameToFunctionMap.value(methodName))(dataTable, settings);
+
+  // Consecutive column kernels are applied in a single pass
+  QList<ApplyColumnNormalizationFunction> columnFunctions;
+  foreach(const QString& methodName, methodNames)
+    {
+    if (d->MethodNameToColumnFunctionMap.contains(methodName))
+      {
+      columnFunctions << d->MethodNameToColumnFunctionMap.value(methodName);
+      continue;
+      }
+    if (!applyColumnFunctions(columnFunctions, dataTable, settings) ||
+        !(*d->MethodNameToFunctionMap.value(methodName))(dataTable, settings))
+      {
+      return false;
+      }
+    columnFunctions.clear();
+    }
+  return applyColumnFunctions(columnFunctions, dataTable, settings);
 }
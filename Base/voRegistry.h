@@ -27,10 +27,22 @@
 #include <QtGlobal>
 #include <QVariant>
 
+// VTK includes
+#include <vtkType.h>
+
 class QString;
+class QStringList;
 class voRegistryPrivate;
 class vtkTable;
 
+/// Registry of the normalization methods applied to the data of imported tables.
+///
+/// A method either transforms the whole table (e.g. quantile normalization) or is a column
+/// kernel transforming the values of one column independently of the other columns
+/// (e.g. log2, centering or scaling). A pipeline chains several methods: consecutive column
+/// kernels are fused, each column is processed by all of them while it is in cache, and the
+/// columns are processed concurrently. Whole-table methods split the pipeline into passes.
+
 class voRegistry
 {
 public:
@@ -39,8 +51,19 @@ public:
 
   typedef bool(*ApplyNormalizationFunction)(vtkTable*, const QHash<int, QVariant>&);
   void registerMethod(const QString& methodName, ApplyNormalizationFunction function);
-  
+
+  typedef void(*ApplyColumnNormalizationFunction)(double*, vtkIdType, const QHash<int, QVariant>&);
+  void registerColumnMethod(const QString& methodName, ApplyColumnNormalizationFunction function);
+
+  /// Return true if \a methodName has been registered using either registerMethod()
+  /// or registerColumnMethod()
+  bool isRegistered(const QString& methodName)const;
+
   bool apply(const QString& methodName, vtkTable * dataTable, const QHash<int, QVariant>& settings);
+
+  /// Apply the methods \a methodNames in order. Return false if a method fails or if one of
+  /// them isn't registered, in which case \a dataTable isn't modified.
+  bool applyPipeline(const QStringList& methodNames, vtkTable * dataTable, const QHash<int, QVariant>& settings);
   
 protected:
   QScopedPointer<voRegistryPrivate> d_ptr;
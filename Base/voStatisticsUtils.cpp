@@ -0,0 +1,759 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QString>
+
+// Visomics includes
+#include "voConcurrentUtils.h"
+#include "voStatisticsUtils.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+// Number of rows whose statistics are accumulated at once. Columns are traversed
+// once per block, the inner loops run over contiguous rows and can be vectorized.
+const vtkIdType RowBlockSize = 256;
+
+//----------------------------------------------------------------------------
+bool validColumns(const std::vector<vtkIdType>& columns, vtkIdType numberOfColumns)
+{
+  for (size_t i = 0; i < columns.size(); ++i)
+    {
+    if (columns[i] < 0 || columns[i] >= numberOfColumns)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Count, mean and variance of the non-NaN values of rows [begin, end) within the given columns.
+// Results are stored at index (row - begin).
+void groupStatistics(const double* data, vtkIdType numberOfRows, const std::vector<vtkIdType>& columns,
+                     vtkIdType begin, vtkIdType end, double* count, double* mean, double* variance)
+{
+  vtkIdType blockSize = end - begin;
+  std::fill(count, count + blockSize, 0.);
+  std::fill(mean, mean + blockSize, 0.);
+  std::fill(variance, variance + blockSize, 0.);
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    const double* column = data + columns[c] * numberOfRows + begin;
+    for (vtkIdType r = 0; r < blockSize; ++r)
+      {
+      double value = column[r];
+      bool valid = (value == value);
+      count[r] += valid ? 1. : 0.;
+      mean[r] += valid ? value : 0.;
+      }
+    }
+  for (vtkIdType r = 0; r < blockSize; ++r)
+    {
+    mean[r] /= count[r];
+    }
+  // Two passes, like the R function "var"
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    const double* column = data + columns[c] * numberOfRows + begin;
+    for (vtkIdType r = 0; r < blockSize; ++r)
+      {
+      double value = column[r];
+      double deviation = value - mean[r];
+      variance[r] += (value == value) ? deviation * deviation : 0.;
+      }
+    }
+  for (vtkIdType r = 0; r < blockSize; ++r)
+    {
+    variance[r] /= (count[r] - 1.);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Arithmetic or geometric mean of rows [begin, end) within the given columns, NaN values are not ignored.
+// Results are stored at index (row - begin).
+void groupMean(const double* data, vtkIdType numberOfRows, const std::vector<vtkIdType>& columns,
+               voStatisticsUtils::MeanMethod meanMethod, vtkIdType begin, vtkIdType end, double* mean)
+{
+  vtkIdType blockSize = end - begin;
+  std::fill(mean, mean + blockSize, 0.);
+  bool geometric = (meanMethod == voStatisticsUtils::GeometricMean);
+  for (size_t c = 0; c < columns.size(); ++c)
+    {
+    const double* column = data + columns[c] * numberOfRows + begin;
+    if (geometric)
+      {
+      for (vtkIdType r = 0; r < blockSize; ++r)
+        {
+        mean[r] += std::log(column[r]);
+        }
+      }
+    else
+      {
+      for (vtkIdType r = 0; r < blockSize; ++r)
+        {
+        mean[r] += column[r];
+        }
+      }
+    }
+  double scale = 1. / columns.size();
+  for (vtkIdType r = 0; r < blockSize; ++r)
+    {
+    mean[r] *= scale;
+    }
+  if (geometric)
+    {
+    for (vtkIdType r = 0; r < blockSize; ++r)
+      {
+      mean[r] = std::exp(mean[r]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Continued fraction of the incomplete beta function, evaluated using the modified Lentz's method.
+// It converges quickly for x < (a + 1) / (a + b + 2).
+double incompleteBetaContinuedFraction(double a, double b, double x)
+{
+  const double epsilon = std::numeric_limits<double>::epsilon();
+  const double tiny = 1e-300;
+  const int maximumIterations = 1000;
+
+  double c = 1.;
+  double d = 1. - (a + b) * x / (a + 1.);
+  d = 1. / (std::fabs(d) < tiny ? tiny : d);
+  double result = d;
+  for (int m = 1; m <= maximumIterations; ++m)
+    {
+    // Even step
+    double numerator = m * (b - m) * x / ((a + 2. * m - 1.) * (a + 2. * m));
+    d = 1. + numerator * d;
+    d = 1. / (std::fabs(d) < tiny ? tiny : d);
+    c = 1. + numerator / c;
+    c = std::fabs(c) < tiny ? tiny : c;
+    result *= d * c;
+
+    // Odd step
+    numerator = -(a + m) * (a + b + m) * x / ((a + 2. * m) * (a + 2. * m + 1.));
+    d = 1. + numerator * d;
+    d = 1. / (std::fabs(d) < tiny ? tiny : d);
+    c = 1. + numerator / c;
+    c = std::fabs(c) < tiny ? tiny : c;
+    double delta = d * c;
+    result *= delta;
+    if (std::fabs(delta - 1.) < epsilon)
+      {
+      break;
+      }
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+// I_x(a, b) where y = 1 - x is given separately to avoid cancellation when x is close to 1.
+double incompleteBeta(double a, double b, double x, double y)
+{
+  if (x <= 0.)
+    {
+    return 0.;
+    }
+  if (y <= 0.)
+    {
+    return 1.;
+    }
+  double logPrefactor = voStatisticsUtils::logGamma(a + b) - voStatisticsUtils::logGamma(a)
+    - voStatisticsUtils::logGamma(b) + a * std::log(x) + b * std::log(y);
+  double prefactor = std::exp(logPrefactor);
+  if (x < (a + 1.) / (a + b + 2.))
+    {
+    return prefactor * incompleteBetaContinuedFraction(a, b, x) / a;
+    }
+  return 1. - prefactor * incompleteBetaContinuedFraction(b, a, y) / b;
+}
+
+//----------------------------------------------------------------------------
+class PValueLess
+{
+public:
+  PValueLess(const double* pValues) : PValues(pValues){}
+  bool operator()(vtkIdType left, vtkIdType right)const
+    {
+    return this->PValues[left] < this->PValues[right];
+    }
+  const double* PValues;
+};
+
+//----------------------------------------------------------------------------
+class TTestFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  const std::vector<vtkIdType>* Sample1Columns;
+  const std::vector<vtkIdType>* Sample2Columns;
+  bool EqualVariance;
+  double* PValues;
+  char* RowDiagnostics;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    std::vector<double> statistics(6 * RowBlockSize);
+    double* count1 = &statistics[0];
+    double* mean1 = count1 + RowBlockSize;
+    double* variance1 = mean1 + RowBlockSize;
+    double* count2 = variance1 + RowBlockSize;
+    double* mean2 = count2 + RowBlockSize;
+    double* variance2 = mean2 + RowBlockSize;
+    for (vtkIdType blockBegin = begin; blockBegin < end; blockBegin += RowBlockSize)
+      {
+      vtkIdType blockEnd = std::min(blockBegin + RowBlockSize, end);
+      groupStatistics(this->Data, this->NumberOfRows, *this->Sample1Columns,
+                      blockBegin, blockEnd, count1, mean1, variance1);
+      groupStatistics(this->Data, this->NumberOfRows, *this->Sample2Columns,
+                      blockBegin, blockEnd, count2, mean2, variance2);
+      for (vtkIdType r = blockBegin; r < blockEnd; ++r)
+        {
+        vtkIdType i = r - blockBegin;
+        this->RowDiagnostics[r] = static_cast<char>(
+              this->testRow(count1[i], mean1[i], variance1[i],
+                            count2[i], mean2[i], variance2[i], this->PValues[r]));
+        }
+      }
+    }
+
+  // Follow the R function "t.test"
+  int testRow(double n1, double mean1, double variance1,
+              double n2, double mean2, double variance2, double& pValue)const
+    {
+    pValue = vtkMath::Nan();
+    double standardError;
+    double degreesOfFreedom;
+    if (this->EqualVariance)
+      {
+      if (n1 < 1. || n2 < 1. || n1 + n2 < 3.)
+        {
+        return voStatisticsUtils::InvalidData;
+        }
+      degreesOfFreedom = n1 + n2 - 2.;
+      double pooledVariance = 0.;
+      if (n1 > 1.)
+        {
+        pooledVariance += (n1 - 1.) * variance1;
+        }
+      if (n2 > 1.)
+        {
+        pooledVariance += (n2 - 1.) * variance2;
+        }
+      pooledVariance /= degreesOfFreedom;
+      standardError = std::sqrt(pooledVariance * (1. / n1 + 1. / n2));
+      }
+    else
+      {
+      if (n1 < 2. || n2 < 2.)
+        {
+        return voStatisticsUtils::InvalidData;
+        }
+      double squaredError1 = variance1 / n1;
+      double squaredError2 = variance2 / n2;
+      standardError = std::sqrt(squaredError1 + squaredError2);
+      // Welch-Satterthwaite approximation
+      degreesOfFreedom = (squaredError1 + squaredError2) * (squaredError1 + squaredError2) /
+        (squaredError1 * squaredError1 / (n1 - 1.) + squaredError2 * squaredError2 / (n2 - 1.));
+      }
+    if (vtkMath::IsNan(standardError))
+      {
+      return voStatisticsUtils::InvalidData;
+      }
+    if (standardError < 10. * std::numeric_limits<double>::epsilon() *
+                        std::max(std::fabs(mean1), std::fabs(mean2)))
+      {
+      pValue = 1.;
+      return voStatisticsUtils::ConstantData;
+      }
+    double t = (mean1 - mean2) / standardError;
+    pValue = 2. * voStatisticsUtils::studentTCDF(-std::fabs(t), degreesOfFreedom);
+    return voStatisticsUtils::NoDiagnostic;
+    }
+};
+
+//----------------------------------------------------------------------------
+// P(F > f) where F follows Fisher's F distribution
+double fisherFUpperTail(double f, double numeratorDegreesOfFreedom, double denominatorDegreesOfFreedom)
+{
+  double scaledF = numeratorDegreesOfFreedom * f;
+  double x = denominatorDegreesOfFreedom / (denominatorDegreesOfFreedom + scaledF);
+  double y = scaledF / (denominatorDegreesOfFreedom + scaledF);
+  return incompleteBeta(0.5 * denominatorDegreesOfFreedom, 0.5 * numeratorDegreesOfFreedom, x, y);
+}
+
+//----------------------------------------------------------------------------
+class ANOVAFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  const std::vector<std::vector<vtkIdType> >* Groups;
+  double* PValues;
+  char* RowDiagnostics;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    // Values are shifted by the first value of the row to limit cancellation errors
+    // when the sums of squares are accumulated in a single pass.
+    std::vector<double> accumulators(8 * RowBlockSize);
+    double* shift = &accumulators[0];
+    double* groupCount = shift + RowBlockSize;
+    double* groupSum = groupCount + RowBlockSize;
+    double* totalCount = groupSum + RowBlockSize;
+    double* totalSum = totalCount + RowBlockSize;
+    double* totalSumOfSquares = totalSum + RowBlockSize;
+    double* weightedSquaredGroupSums = totalSumOfSquares + RowBlockSize;
+    double* numberOfGroups = weightedSquaredGroupSums + RowBlockSize;
+    const std::vector<std::vector<vtkIdType> >& groups = *this->Groups;
+    for (vtkIdType blockBegin = begin; blockBegin < end; blockBegin += RowBlockSize)
+      {
+      vtkIdType blockEnd = std::min(blockBegin + RowBlockSize, end);
+      vtkIdType blockSize = blockEnd - blockBegin;
+      const double* firstColumn = this->Data + groups[0][0] * this->NumberOfRows + blockBegin;
+      for (vtkIdType r = 0; r < blockSize; ++r)
+        {
+        shift[r] = (firstColumn[r] == firstColumn[r]) ? firstColumn[r] : 0.;
+        }
+      std::fill(totalCount, totalCount + 5 * RowBlockSize, 0.);
+
+      for (size_t g = 0; g < groups.size(); ++g)
+        {
+        std::fill(groupCount, groupCount + 2 * RowBlockSize, 0.);
+        for (size_t c = 0; c < groups[g].size(); ++c)
+          {
+          const double* column = this->Data + groups[g][c] * this->NumberOfRows + blockBegin;
+          for (vtkIdType r = 0; r < blockSize; ++r)
+            {
+            double value = column[r];
+            bool valid = (value == value);
+            double deviation = valid ? value - shift[r] : 0.;
+            groupCount[r] += valid ? 1. : 0.;
+            groupSum[r] += deviation;
+            totalSumOfSquares[r] += deviation * deviation;
+            }
+          }
+        for (vtkIdType r = 0; r < blockSize; ++r)
+          {
+          bool nonEmpty = groupCount[r] > 0.;
+          totalCount[r] += groupCount[r];
+          totalSum[r] += groupSum[r];
+          weightedSquaredGroupSums[r] += nonEmpty ? groupSum[r] * groupSum[r] / groupCount[r] : 0.;
+          numberOfGroups[r] += nonEmpty ? 1. : 0.;
+          }
+        }
+
+      for (vtkIdType r = blockBegin; r < blockEnd; ++r)
+        {
+        vtkIdType i = r - blockBegin;
+        this->RowDiagnostics[r] = static_cast<char>(
+              this->testRow(numberOfGroups[i], totalCount[i], shift[i], totalSum[i],
+                            totalSumOfSquares[i], weightedSquaredGroupSums[i], this->PValues[r]));
+        }
+      }
+    }
+
+  int testRow(double numberOfGroups, double count, double shift, double sum,
+              double sumOfSquares, double weightedSquaredGroupSums, double& pValue)const
+    {
+    pValue = vtkMath::Nan();
+    if (numberOfGroups < 2. || count <= numberOfGroups)
+      {
+      return voStatisticsUtils::InvalidData;
+      }
+    double totalSumOfSquares = std::max(0., sumOfSquares - sum * sum / count);
+    double betweenSumOfSquares = std::max(0., weightedSquaredGroupSums - sum * sum / count);
+    double withinSumOfSquares = std::max(0., totalSumOfSquares - betweenSumOfSquares);
+    if (vtkMath::IsNan(totalSumOfSquares) || vtkMath::IsInf(totalSumOfSquares))
+      {
+      return voStatisticsUtils::InvalidData;
+      }
+    double mean = shift + sum / count;
+    double tolerance = 10. * std::numeric_limits<double>::epsilon() * std::fabs(mean);
+    if (totalSumOfSquares <= tolerance * tolerance * count)
+      {
+      pValue = 1.;
+      return voStatisticsUtils::ConstantData;
+      }
+    double betweenDegreesOfFreedom = numberOfGroups - 1.;
+    double withinDegreesOfFreedom = count - numberOfGroups;
+    if (withinSumOfSquares <= 0.)
+      {
+      pValue = 0.;
+      return voStatisticsUtils::NoDiagnostic;
+      }
+    double f = (betweenSumOfSquares / betweenDegreesOfFreedom) /
+               (withinSumOfSquares / withinDegreesOfFreedom);
+    pValue = fisherFUpperTail(f, betweenDegreesOfFreedom, withinDegreesOfFreedom);
+    return voStatisticsUtils::NoDiagnostic;
+    }
+};
+
+//----------------------------------------------------------------------------
+class MeanFunctor
+{
+public:
+  const double* Data;
+  vtkIdType NumberOfRows;
+  const std::vector<vtkIdType>* Columns;
+  voStatisticsUtils::MeanMethod Method;
+  double* Means;
+
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    for (vtkIdType blockBegin = begin; blockBegin < end; blockBegin += RowBlockSize)
+      {
+      vtkIdType blockEnd = std::min(blockBegin + RowBlockSize, end);
+      groupMean(this->Data, this->NumberOfRows, *this->Columns, this->Method,
+                blockBegin, blockEnd, this->Means + blockBegin);
+      }
+    }
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool voStatisticsUtils::adjustmentFromString(const QString& adjustmentName, PValueAdjustment& adjustment)
+{
+  if (adjustmentName == QLatin1String("None"))
+    {
+    adjustment = NoAdjustment;
+    }
+  else if (adjustmentName == QLatin1String("Bonferroni"))
+    {
+    adjustment = Bonferroni;
+    }
+  else if (adjustmentName == QLatin1String("Holm"))
+    {
+    adjustment = Holm;
+    }
+  else if (adjustmentName == QLatin1String("Benjamini-Hochberg"))
+    {
+    adjustment = BenjaminiHochberg;
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void voStatisticsUtils::adjustPValues(const double* pValues, vtkIdType count, PValueAdjustment adjustment,
+                                      double* adjustedPValues)
+{
+  if (!pValues || !adjustedPValues || count <= 0)
+    {
+    return;
+    }
+
+  // Indices of the tests, NaN p-values are ignored
+  std::vector<vtkIdType> order;
+  order.reserve(count);
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    if (!vtkMath::IsNan(pValues[i]))
+      {
+      order.push_back(i);
+      }
+    }
+  if (adjustedPValues != pValues)
+    {
+    std::copy(pValues, pValues + count, adjustedPValues);
+    }
+  vtkIdType numberOfTests = static_cast<vtkIdType>(order.size());
+  if (adjustment == NoAdjustment || numberOfTests == 0)
+    {
+    return;
+    }
+
+  if (adjustment == Bonferroni)
+    {
+    for (vtkIdType i = 0; i < numberOfTests; ++i)
+      {
+      vtkIdType index = order[i];
+      adjustedPValues[index] = std::min(1., numberOfTests * pValues[index]);
+      }
+    return;
+    }
+
+  // Sorting the indices keeps pValues intact when adjusting in place
+  std::vector<double> sortedPValues(numberOfTests);
+  std::sort(order.begin(), order.end(), PValueLess(pValues));
+  for (vtkIdType i = 0; i < numberOfTests; ++i)
+    {
+    sortedPValues[i] = pValues[order[i]];
+    }
+
+  if (adjustment == Holm)
+    {
+    // Step-down: cumulative maximum of (n - i) * p(i) in increasing order
+    double adjusted = 0.;
+    for (vtkIdType i = 0; i < numberOfTests; ++i)
+      {
+      adjusted = std::max(adjusted, std::min(1., (numberOfTests - i) * sortedPValues[i]));
+      adjustedPValues[order[i]] = adjusted;
+      }
+    }
+  else // BenjaminiHochberg
+    {
+    // Step-up: cumulative minimum of n / i * p(i) in decreasing order
+    double adjusted = 1.;
+    for (vtkIdType i = numberOfTests - 1; i >= 0; --i)
+      {
+      adjusted = std::min(adjusted, static_cast<double>(numberOfTests) / (i + 1) * sortedPValues[i]);
+      adjustedPValues[order[i]] = adjusted;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+double voStatisticsUtils::logGamma(double x)
+{
+  // Lanczos approximation (g = 7, n = 9)
+  static const double coefficients[] = {
+    0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+    771.32342877765313, -176.61502916214059, 12.507343278686905,
+    -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7};
+  if (x < 0.5)
+    {
+    // Reflection formula
+    return std::log(vtkMath::Pi() / std::fabs(std::sin(vtkMath::Pi() * x))) - logGamma(1. - x);
+    }
+  x -= 1.;
+  double sum = coefficients[0];
+  for (int i = 1; i < 9; ++i)
+    {
+    sum += coefficients[i] / (x + i);
+    }
+  double t = x + 7.5;
+  return 0.5 * std::log(2. * vtkMath::Pi()) + (x + 0.5) * std::log(t) - t + std::log(sum);
+}
+
+//----------------------------------------------------------------------------
+double voStatisticsUtils::incompleteBeta(double a, double b, double x)
+{
+  return ::incompleteBeta(a, b, x, 1. - x);
+}
+
+//----------------------------------------------------------------------------
+double voStatisticsUtils::studentTCDF(double t, double degreesOfFreedom)
+{
+  if (vtkMath::IsNan(t) || vtkMath::IsNan(degreesOfFreedom) || degreesOfFreedom <= 0.)
+    {
+    return vtkMath::Nan();
+    }
+  if (vtkMath::IsInf(t))
+    {
+    return t < 0. ? 0. : 1.;
+    }
+  // P(|T| > |t|) = I_x(df / 2, 1 / 2) with x = df / (df + t^2)
+  double squaredT = t * t;
+  double x = degreesOfFreedom / (degreesOfFreedom + squaredT);
+  double y = squaredT / (degreesOfFreedom + squaredT);
+  double tail = 0.5 * ::incompleteBeta(0.5 * degreesOfFreedom, 0.5, x, y);
+  return t < 0. ? tail : 1. - tail;
+}
+
+//----------------------------------------------------------------------------
+bool voStatisticsUtils::tTest(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                              const std::vector<vtkIdType>& sample1Columns,
+                              const std::vector<vtkIdType>& sample2Columns,
+                              bool equalVariance, double* pValues, int* diagnostics)
+{
+  if (!data || !pValues || numberOfRows < 0 ||
+      !validColumns(sample1Columns, numberOfColumns) || !validColumns(sample2Columns, numberOfColumns))
+    {
+    return false;
+    }
+
+  std::vector<char> rowDiagnostics(numberOfRows, NoDiagnostic);
+
+  TTestFunctor functor;
+  functor.Data = data;
+  functor.NumberOfRows = numberOfRows;
+  functor.Sample1Columns = &sample1Columns;
+  functor.Sample2Columns = &sample2Columns;
+  functor.EqualVariance = equalVariance;
+  functor.PValues = pValues;
+  functor.RowDiagnostics = rowDiagnostics.empty() ? 0 : &rowDiagnostics[0];
+  voConcurrentUtils::parallelFor(numberOfRows, functor);
+
+  if (diagnostics)
+    {
+    *diagnostics = NoDiagnostic;
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      *diagnostics |= rowDiagnostics[r];
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double voStatisticsUtils::fisherFCDF(double f, double numeratorDegreesOfFreedom,
+                                     double denominatorDegreesOfFreedom)
+{
+  if (vtkMath::IsNan(f) || !(numeratorDegreesOfFreedom > 0.) || !(denominatorDegreesOfFreedom > 0.))
+    {
+    return vtkMath::Nan();
+    }
+  if (f <= 0.)
+    {
+    return 0.;
+    }
+  if (vtkMath::IsInf(f))
+    {
+    return 1.;
+    }
+  // P(F <= f) = I_y(d1 / 2, d2 / 2) with y = d1 f / (d1 f + d2)
+  double scaledF = numeratorDegreesOfFreedom * f;
+  double x = denominatorDegreesOfFreedom / (denominatorDegreesOfFreedom + scaledF);
+  double y = scaledF / (denominatorDegreesOfFreedom + scaledF);
+  return ::incompleteBeta(0.5 * numeratorDegreesOfFreedom, 0.5 * denominatorDegreesOfFreedom, y, x);
+}
+
+//----------------------------------------------------------------------------
+bool voStatisticsUtils::oneWayANOVA(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                    const std::vector<std::vector<vtkIdType> >& groups,
+                                    double* pValues, int* diagnostics)
+{
+  if (!data || !pValues || numberOfRows < 0 || groups.size() < 2)
+    {
+    return false;
+    }
+  for (size_t g = 0; g < groups.size(); ++g)
+    {
+    if (groups[g].empty() || !validColumns(groups[g], numberOfColumns))
+      {
+      return false;
+      }
+    }
+
+  std::vector<char> rowDiagnostics(numberOfRows, NoDiagnostic);
+
+  ANOVAFunctor functor;
+  functor.Data = data;
+  functor.NumberOfRows = numberOfRows;
+  functor.Groups = &groups;
+  functor.PValues = pValues;
+  functor.RowDiagnostics = rowDiagnostics.empty() ? 0 : &rowDiagnostics[0];
+  voConcurrentUtils::parallelFor(numberOfRows, functor);
+
+  if (diagnostics)
+    {
+    *diagnostics = NoDiagnostic;
+    for (vtkIdType r = 0; r < numberOfRows; ++r)
+      {
+      *diagnostics |= rowDiagnostics[r];
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool voStatisticsUtils::rowMeans(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                 const std::vector<vtkIdType>& columns, MeanMethod meanMethod, double* means)
+{
+  if (!data || !means || numberOfRows < 0 || !validColumns(columns, numberOfColumns))
+    {
+    return false;
+    }
+
+  MeanFunctor functor;
+  functor.Data = data;
+  functor.NumberOfRows = numberOfRows;
+  functor.Columns = &columns;
+  functor.Method = meanMethod;
+  functor.Means = means;
+  voConcurrentUtils::parallelFor(numberOfRows, functor);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void voStatisticsUtils::foldChangeFromMeans(const double* means1, const double* means2, vtkIdType count,
+                                            double* foldChanges, int* diagnostics)
+{
+  const double log2 = std::log(2.);
+  bool invalidFoldChange = false;
+  for (vtkIdType i = 0; i < count; ++i)
+    {
+    double log2FoldChange = std::log(means1[i]) / log2 - std::log(means2[i]) / log2;
+    if (vtkMath::IsNan(log2FoldChange) || vtkMath::IsInf(log2FoldChange))
+      {
+      foldChanges[i] = vtkMath::Nan();
+      invalidFoldChange = true;
+      }
+    else if (log2FoldChange < 0.)
+      {
+      foldChanges[i] = -1. / std::pow(2., log2FoldChange);
+      }
+    else
+      {
+      foldChanges[i] = std::pow(2., log2FoldChange);
+      }
+    }
+  if (diagnostics)
+    {
+    *diagnostics = invalidFoldChange ? InvalidFoldChange : NoDiagnostic;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool voStatisticsUtils::foldChange(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                                   const std::vector<vtkIdType>& sample1Columns,
+                                   const std::vector<vtkIdType>& sample2Columns,
+                                   double* foldChanges, int* diagnostics)
+{
+  if (!data || !foldChanges || numberOfRows < 0 ||
+      !validColumns(sample1Columns, numberOfColumns) || !validColumns(sample2Columns, numberOfColumns))
+    {
+    return false;
+    }
+  if (diagnostics)
+    {
+    *diagnostics = NoDiagnostic;
+    }
+  if (numberOfRows == 0)
+    {
+    return true;
+    }
+
+  std::vector<double> means1(numberOfRows);
+  std::vector<double> means2(numberOfRows);
+  rowMeans(data, numberOfRows, numberOfColumns, sample1Columns, ArithmeticMean, &means1[0]);
+  rowMeans(data, numberOfRows, numberOfColumns, sample2Columns, ArithmeticMean, &means2[0]);
+  foldChangeFromMeans(&means1[0], &means2[0], numberOfRows, foldChanges, diagnostics);
+  return true;
+}
@@ -0,0 +1,129 @@
+/*=========================================================================
+
+  Program: Visomics
+
+  Copyright (c) Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+#ifndef __voStatisticsUtils_h
+#define __voStatisticsUtils_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class QString;
+
+/// Native implementation of the statistical tests performed by the analyses.
+///
+/// Matrices are stored column-major, like vtkExtendedTable::GetDataBuffer(): the value
+/// at row \a r and column \a c of a matrix having \a numberOfRows rows is located at
+/// index c * numberOfRows + r. Each row (analyte) is tested independently, comparing
+/// groups of columns (experiments).
+namespace voStatisticsUtils
+{
+
+/// Conditions reported by the tests, combined using bitwise OR.
+/// They match the diagnostics reported by the R scripts of the analyses.
+enum Diagnostic
+  {
+  NoDiagnostic = 0x0,
+  /// The data of some rows are essentially constant, their p-value is set to 1
+  ConstantData = 0x1,
+  /// The fold change of some rows can't be computed from zero or negative means
+  InvalidFoldChange = 0x2,
+  /// Some rows have not enough (non-NaN) observations or groups, or infinite values, their p-value is NaN
+  InvalidData = 0x4
+  };
+
+/// Multiple testing corrections, see the R function "p.adjust"
+enum PValueAdjustment
+  {
+  NoAdjustment = 0,
+  Bonferroni,
+  Holm,
+  BenjaminiHochberg
+  };
+
+/// Convert "None", "Bonferroni", "Holm" or "Benjamini-Hochberg" into the associated adjustment.
+/// Return false if \a adjustmentName doesn't match any adjustment.
+bool adjustmentFromString(const QString& adjustmentName, PValueAdjustment& adjustment);
+
+/// Adjust the \a count p-values \a pValues for multiple comparisons into \a adjustedPValues,
+/// which may point to \a pValues. NaN p-values are left untouched and not counted as tests.
+/// Holm and Benjamini-Hochberg adjustments sort the p-values: O(n log n).
+void adjustPValues(const double* pValues, vtkIdType count, PValueAdjustment adjustment,
+                   double* adjustedPValues);
+
+/// Natural logarithm of the gamma function, \a x must be strictly positive.
+double logGamma(double x);
+
+/// Regularized incomplete beta function I_x(a, b).
+double incompleteBeta(double a, double b, double x);
+
+/// Cumulative distribution function of Student's t distribution: P(T <= t).
+double studentTCDF(double t, double degreesOfFreedom);
+
+/// Cumulative distribution function of Fisher's F distribution: P(F <= f).
+double fisherFCDF(double f, double numeratorDegreesOfFreedom, double denominatorDegreesOfFreedom);
+
+/// Two sided two sample t-test of each row, comparing the columns \a sample1Columns
+/// to the columns \a sample2Columns like the R function "t.test" does. NaN values are ignored.
+/// Welch's test is used unless \a equalVariance is true.
+/// \a pValues must be able to hold numberOfRows values.
+/// Return false if the columns are out of range.
+bool tTest(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+           const std::vector<vtkIdType>& sample1Columns, const std::vector<vtkIdType>& sample2Columns,
+           bool equalVariance, double* pValues, int* diagnostics = 0);
+
+/// One-way analysis of variance of each row, comparing the groups of columns \a groups like
+/// the R function "aov" does. Groups may have different sizes, NaN values are ignored.
+/// \a pValues must be able to hold numberOfRows values.
+/// Return false if there are less than 2 groups or if the columns are out of range.
+bool oneWayANOVA(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                 const std::vector<std::vector<vtkIdType> >& groups, double* pValues, int* diagnostics = 0);
+
+enum MeanMethod
+  {
+  ArithmeticMean = 0,
+  /// 2^mean(log2(x)), like the R script of voFoldChange
+  GeometricMean
+  };
+
+/// Mean of the columns \a columns of each row. NaN values are not ignored, like R's "rowMeans".
+/// \a means must be able to hold numberOfRows values.
+/// Return false if the columns are out of range.
+bool rowMeans(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+              const std::vector<vtkIdType>& columns, MeanMethod meanMethod, double* means);
+
+/// Fold changes computed like the analyses do in R: 2^x if the log2 ratio x = log2(means1 / means2)
+/// is positive, -1/2^x otherwise. Values whose log2 ratio is not finite get NaN and are
+/// reported as InvalidFoldChange.
+void foldChangeFromMeans(const double* means1, const double* means2, vtkIdType count,
+                         double* foldChanges, int* diagnostics = 0);
+
+/// Fold changes of the arithmetic means of the columns \a sample1Columns over the arithmetic
+/// means of the columns \a sample2Columns, see foldChangeFromMeans().
+/// \a foldChanges must be able to hold numberOfRows values.
+/// Return false if the columns are out of range.
+bool foldChange(const double* data, vtkIdType numberOfRows, vtkIdType numberOfColumns,
+                const std::vector<vtkIdType>& sample1Columns, const std::vector<vtkIdType>& sample2Columns,
+                double* foldChanges, int* diagnostics = 0);
+
+}
+
+#endif
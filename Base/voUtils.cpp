@@ -28,13 +28,18 @@
 #include <QSet>
 
 // Visomics includes
+#include "voConcurrentUtils.h"
+#include "voStatisticsUtils.h"
 #include "voUtils.h"
+#include "vtkExtendedTable.h"
 
 // VTK includes
 #include <vtkAdjacentVertexIterator.h>
 #include <vtkArray.h>
+#include <vtkArrayData.h>
 #include <vtkArrayToTable.h>
 #include <vtkDataSetAttributes.h>
+#include <vtkDenseArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkIntArray.h>
 #include <vtkNew.h>
@@ -45,6 +50,10 @@
 #include <vtkVariantArray.h>
 #include <vtkTree.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 namespace // helpers for bool voUtils::transposeTable(vtkTable*, vtkTable*, const TransposeOption&)
 {
 //----------------------------------------------------------------------------
@@ -106,6 +115,74 @@ bool transposeColumn(vtkTable* srcTable, vtkTable* destTable, int columnId,
     }
   return true;
 }
+
+//----------------------------------------------------------------------------
+// Copy source columns into destination columns by square blocks so that
+// both the values read and the values written stay in cache.
+template<typename ValueType>
+class TransposeBlockFunctor
+{
+public:
+  std::vector<const ValueType*> Sources;
+  std::vector<ValueType*> Destinations;
+
+  // Transpose source rows [begin, end) into destination columns [begin, end)
+  void operator()(vtkIdType begin, vtkIdType end)const
+    {
+    const vtkIdType blockSize = 64;
+    vtkIdType numberOfSources = static_cast<vtkIdType>(this->Sources.size());
+    for (vtkIdType sourceBegin = 0; sourceBegin < numberOfSources; sourceBegin += blockSize)
+      {
+      vtkIdType sourceEnd = qMin(sourceBegin + blockSize, numberOfSources);
+      for (vtkIdType rid = begin; rid < end; ++rid)
+        {
+        ValueType * destination = this->Destinations[rid];
+        for (vtkIdType cid = sourceBegin; cid < sourceEnd; ++cid)
+          {
+          destination[cid] = this->Sources[cid][rid];
+          }
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+// Transpose the columns [columnOffset, numberOfColumns) of a table only made of
+// single component ArrayType. Return false if the table doesn't match.
+template<typename ArrayType, typename ValueType>
+bool transposeNumericalTable(vtkTable* srcTable, vtkTable* destTable, int columnOffset)
+{
+  vtkIdType numberOfSources = srcTable->GetNumberOfColumns() - columnOffset;
+  vtkIdType numberOfRows = srcTable->GetNumberOfRows();
+  if (numberOfSources <= 0)
+    {
+    return false;
+    }
+
+  TransposeBlockFunctor<ValueType> functor;
+  functor.Sources.resize(numberOfSources);
+  for (vtkIdType cid = 0; cid < numberOfSources; ++cid)
+    {
+    ArrayType * column = ArrayType::SafeDownCast(srcTable->GetColumn(cid + columnOffset));
+    if (!column || column->GetNumberOfComponents() != 1 || column->GetNumberOfTuples() != numberOfRows)
+      {
+      return false;
+      }
+    functor.Sources[cid] = column->GetPointer(0);
+    }
+
+  functor.Destinations.resize(numberOfRows);
+  for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+    {
+    vtkSmartPointer<ArrayType> transposedColumn = vtkSmartPointer<ArrayType>::New();
+    transposedColumn->SetNumberOfValues(numberOfSources);
+    destTable->AddColumn(transposedColumn);
+    functor.Destinations[rid] = transposedColumn->GetPointer(0);
+    }
+
+  voConcurrentUtils::parallelFor(numberOfRows, functor, 64);
+  return true;
+}
 }
 
 //----------------------------------------------------------------------------
@@ -141,7 +218,13 @@ bool voUtils::transposeTable(vtkTable* srcTable, vtkTable* destTable, const Tran
       break;
       }
     }
-  for(int cid = cidOffset; cid < srcTable->GetNumberOfColumns(); ++cid)
+
+  // Homogeneous numerical tables are transposed by blocks
+  bool blockTransposed = !useVariant &&
+      (transposeNumericalTable<vtkDoubleArray, double>(srcTable, destTable, cidOffset) ||
+       transposeNumericalTable<vtkIntArray, int>(srcTable, destTable, cidOffset));
+
+  for(int cid = cidOffset; !blockTransposed && cid < srcTable->GetNumberOfColumns(); ++cid)
     {
     if (!useVariant)
       {
@@ -342,6 +425,49 @@ bool voUtils::insertColumnIntoTable(vtkTable * table, int position, vtkAbstractA
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool voUtils::insertAdjustedPValueColumn(vtkTable * table, const QString& pValueColumnName,
+                                         const QString& adjustmentName)
+{
+  voStatisticsUtils::PValueAdjustment adjustment;
+  if (!table || !voStatisticsUtils::adjustmentFromString(adjustmentName, adjustment))
+    {
+    return false;
+    }
+  if (adjustment == voStatisticsUtils::NoAdjustment)
+    {
+    return true;
+    }
+
+  int pValueColumnId = -1;
+  for (int cid = 0; cid < table->GetNumberOfColumns(); ++cid)
+    {
+    if (pValueColumnName == table->GetColumnName(cid))
+      {
+      pValueColumnId = cid;
+      break;
+      }
+    }
+  vtkDataArray * pValueColumn = pValueColumnId >= 0 ?
+        vtkDataArray::SafeDownCast(table->GetColumn(pValueColumnId)) : 0;
+  if (!pValueColumn)
+    {
+    return false;
+    }
+
+  vtkIdType numberOfRows = pValueColumn->GetNumberOfTuples();
+  vtkNew<vtkDoubleArray> adjustedColumn;
+  adjustedColumn->SetName(QString("Adjusted %1 (%2)").arg(pValueColumnName).arg(adjustmentName).toLatin1());
+  adjustedColumn->SetNumberOfValues(numberOfRows);
+  for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+    {
+    adjustedColumn->SetValue(rid, pValueColumn->GetTuple1(rid));
+    }
+  voStatisticsUtils::adjustPValues(adjustedColumn->GetPointer(0), numberOfRows, adjustment,
+                                   adjustedColumn->GetPointer(0));
+  return voUtils::insertColumnIntoTable(table, pValueColumnId + 1, adjustedColumn.GetPointer());
+}
+
 //----------------------------------------------------------------------------
 vtkStringArray* voUtils::tableColumnNames(vtkTable * table, int offset)
 {
@@ -539,6 +665,22 @@ bool voUtils::tableToArray(vtkTable* srcTable, vtkSmartPointer<vtkArray>& destAr
     return false;
     }
 
+  // vtkDenseArray is column-major: copy the data buffer at once
+  vtkExtendedTable * extendedTable = vtkExtendedTable::SafeDownCast(srcTable);
+  const double * data = extendedTable ? extendedTable->GetDataBuffer(vtkExtendedTable::ColumnMajor) : 0;
+  if (data)
+    {
+    vtkIdType numberOfRows = extendedTable->GetNumberOfRows();
+    vtkIdType numberOfColumns = extendedTable->GetNumberOfColumns();
+    vtkSmartPointer<vtkDenseArray<double> > array = vtkSmartPointer<vtkDenseArray<double> >::New();
+    array->Resize(numberOfRows, numberOfColumns);
+    array->SetDimensionLabel(0, "row");
+    array->SetDimensionLabel(1, "column");
+    std::copy(data, data + numberOfRows * numberOfColumns, array->GetStorage());
+    destArray = array;
+    return true;
+    }
+
   return voUtils::tableToArray(srcTable, destArray, voUtils::range(0, srcTable->GetNumberOfColumns()));
 }
 
@@ -586,6 +728,21 @@ void voUtils::arrayToTable(vtkArray* srcArray, vtkTable* destTable)
   destTable->ShallowCopy(arrToTab->GetOutput());
 }
 
+//----------------------------------------------------------------------------
+void voUtils::addValuesToArrayData(vtkArrayData* arrayData, const QString& name,
+                                   const double* values, vtkIdType count)
+{
+  if (!arrayData || (!values && count > 0))
+    {
+    return;
+    }
+  vtkNew<vtkDenseArray<double> > array;
+  array->Resize(count);
+  array->SetName(name.toLatin1());
+  std::copy(values, values + count, array->GetStorage());
+  arrayData->AddArray(array.GetPointer());
+}
+
 //----------------------------------------------------------------------------
 QList<int> voUtils::range(int start, int stop, int step)
 {
@@ -33,6 +33,7 @@ class QScriptEngine;
 class QScriptValue;
 class QString;
 class vtkArray;
+class vtkArrayData;
 template <class T> class vtkSmartPointer;
 
 namespace voUtils 
@@ -62,6 +63,11 @@ bool flipTable(vtkTable* table, const FlipOption& flipOption, int horizontalOffs
 
 bool insertColumnIntoTable(vtkTable * table, int position, vtkAbstractArray * column);
 
+/// Insert after the column \a pValueColumnName a column holding its p-values adjusted for
+/// multiple testing using \a adjustmentName ("Bonferroni", "Holm" or "Benjamini-Hochberg").
+/// The table is left unchanged if \a adjustmentName is "None".
+bool insertAdjustedPValueColumn(vtkTable * table, const QString& pValueColumnName, const QString& adjustmentName);
+
 vtkStringArray* tableColumnNames(vtkTable * table, int offset = 0);
 
 void setTableColumnNames(vtkTable * table, vtkStringArray * columnNames);
@@ -82,6 +88,9 @@ bool tableToArray(vtkTable* srcTable, vtkSmartPointer<vtkArray>& destArray, cons
 
 void arrayToTable(vtkArray* srcArray, vtkTable* destTable);
 
+/// Add to \a arrayData a one dimensional vtkDenseArray<double> named \a name holding \a values.
+void addValuesToArrayData(vtkArrayData* arrayData, const QString& name, const double* values, vtkIdType count);
+
 QList<int> range(int start, int stop, int step = 1);
 
 QString stringify(QScriptEngine* scriptEngine, const QScriptValue& scriptValue);
@@ -18,17 +18,149 @@
 
 =========================================================================*/
 
+// Qt includes
+#include <QDir>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QTemporaryFile>
+
 // Visomics includes
 #include "vtkExtendedTable.h"
 #include "voUtils.h"
 
 // VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationObjectBaseKey.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
 #include <vtkVariantArray.h>
 
+// STD includes
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Alignment, in bytes, of the data buffers
+const size_t DataBufferAlignment = 64;
+
+// Number of extra values allocated so that an aligned pointer can be found
+const vtkIdType DataBufferPadding = DataBufferAlignment / sizeof(double) - 1;
+
+// Approximate size, in bytes, of the tiles of out-of-core data
+const vtkTypeInt64 DataTileSize = 32 << 20;
+
+// See vtkExtendedTable::SetOutOfCoreThreshold()
+vtkTypeInt64 OutOfCoreThreshold = 0;
+std::string  OutOfCoreDirectory;
+
+//----------------------------------------------------------------------------
+double* alignedPointer(double* buffer)
+{
+  size_t misalignment = reinterpret_cast<size_t>(buffer) % DataBufferAlignment;
+  if (misalignment == 0)
+    {
+    return buffer;
+    }
+  return buffer + (DataBufferAlignment - misalignment) / sizeof(double);
+}
+
+//----------------------------------------------------------------------------
+// Return true if all the columns of the table are numerical and have one component
+bool hasNumericalColumns(vtkTable* table)
+{
+  for (vtkIdType cid = 0; cid < table->GetNumberOfColumns(); ++cid)
+    {
+    vtkDataArray * column = vtkDataArray::SafeDownCast(table->GetColumn(cid));
+    if (!column || column->GetNumberOfComponents() != 1)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Copy values [begin, end) of the column to destination[begin * stride], ..., destination[(end - 1) * stride]
+void copyColumn(vtkDataArray* column, vtkIdType begin, vtkIdType end, double* destination, vtkIdType stride)
+{
+  vtkDoubleArray * doubleColumn = vtkDoubleArray::SafeDownCast(column);
+  if (doubleColumn && stride == 1)
+    {
+    const double * source = doubleColumn->GetPointer(0);
+    std::copy(source + begin, source + end, destination + begin);
+    }
+  else if (doubleColumn)
+    {
+    const double * source = doubleColumn->GetPointer(0);
+    for (vtkIdType rid = begin; rid < end; ++rid)
+      {
+      destination[rid * stride] = source[rid];
+      }
+    }
+  else
+    {
+    for (vtkIdType rid = begin; rid < end; ++rid)
+      {
+      destination[rid * stride] = column->GetTuple1(rid);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Buffer whose values are stored in a memory-mapped temporary file, removed with the buffer
+class vtkMappedDoubleArray : public vtkDoubleArray
+{
+public:
+  static vtkMappedDoubleArray* New();
+  vtkTypeMacro(vtkMappedDoubleArray, vtkDoubleArray);
+
+  /// Create and map a file of \a numberOfValues values in \a directory
+  bool Map(const QString& directory, vtkIdType numberOfValues)
+    {
+    qint64 size = numberOfValues * static_cast<qint64>(sizeof(double));
+    this->File.setFileTemplate(QDir(directory).filePath("vtkExtendedTable.XXXXXX.data"));
+    if (!QDir().mkpath(directory) || !this->File.open() || !this->File.resize(size))
+      {
+      return false;
+      }
+    this->MappedData = this->File.map(0, size);
+    if (!this->MappedData)
+      {
+      return false;
+      }
+    this->SetArray(reinterpret_cast<double*>(this->MappedData), numberOfValues, /* save= */ 1);
+    return true;
+    }
+
+protected:
+  vtkMappedDoubleArray() : MappedData(0) {}
+  ~vtkMappedDoubleArray()
+    {
+    if (this->MappedData)
+      {
+      this->File.unmap(this->MappedData);
+      }
+    }
+
+private:
+  vtkMappedDoubleArray(const vtkMappedDoubleArray&); // Not implemented
+  void operator=(const vtkMappedDoubleArray&); // Not implemented
+
+  QTemporaryFile File;
+  uchar*         MappedData;
+};
+
+vtkStandardNewMacro(vtkMappedDoubleArray);
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 // vtkInternal
 
@@ -46,6 +178,30 @@ public:
 
   vtkSmartPointer<vtkStringArray> ColumnMetaDataLabels;
   vtkSmartPointer<vtkStringArray> RowMetaDataLabels;
+
+  /// Store the columns of \a table into a single column-major buffer
+  void ShareColumnStorage(vtkTable* table);
+  /// Replace the columns of \a table by unnamed views of a new uninitialized buffer
+  double* AllocateColumnStorage(vtkTable* table, vtkIdType numberOfRows, vtkIdType numberOfColumns);
+  bool IsColumnStorageShared(vtkTable* table)const;
+
+  /// Buffer shared by the data columns. Values start at StorageData.
+  vtkSmartPointer<vtkDoubleArray> Storage;
+  double*                         StorageData;
+
+  /// Buffer used when the data can't be accessed without copy
+  struct PackedBuffer
+    {
+    PackedBuffer() : Data(0){}
+    std::vector<double> Values;
+    double*             Data;
+    vtkTimeStamp        Time;
+    };
+  /// One packed buffer per layout, so that the callers requesting different layouts
+  /// don't overwrite each other's buffer. They are checked and filled while holding
+  /// PackedMutex, analyses may read the same table from several threads.
+  PackedBuffer PackedBuffers[2];
+  QMutex       PackedMutex;
 };
 
 //----------------------------------------------------------------------------
@@ -56,6 +212,115 @@ vtkExtendedTable::vtkInternal::vtkInternal()
 {
   this->ColumnMetaDataTypeOfInterest = -1;
   this->RowMetaDataTypeOfInterest = -1;
+  this->StorageData = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkExtendedTable::vtkInternal::ShareColumnStorage(vtkTable* table)
+{
+  this->Storage = 0;
+  this->StorageData = 0;
+
+  vtkIdType numberOfRows = table->GetNumberOfRows();
+  vtkIdType numberOfColumns = table->GetNumberOfColumns();
+  if (numberOfRows == 0 || numberOfColumns == 0 || !hasNumericalColumns(table))
+    {
+    return;
+    }
+
+  // The original columns may be referenced by another table, they are left untouched.
+  std::vector<vtkSmartPointer<vtkDataArray> > columns(numberOfColumns);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    columns[cid] = vtkDataArray::SafeDownCast(table->GetColumn(cid));
+    }
+
+  double * storageData = this->AllocateColumnStorage(table, numberOfRows, numberOfColumns);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    copyColumn(columns[cid], 0, numberOfRows, storageData + cid * numberOfRows, 1);
+    table->GetColumn(cid)->SetName(columns[cid]->GetName());
+    }
+}
+
+//----------------------------------------------------------------------------
+double* vtkExtendedTable::vtkInternal::AllocateColumnStorage(
+  vtkTable* table, vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  this->Storage = 0;
+  this->StorageData = 0;
+
+  while (table->GetNumberOfColumns() > 0)
+    {
+    table->RemoveColumn(table->GetNumberOfColumns() - 1);
+    }
+  if (numberOfRows <= 0 || numberOfColumns <= 0)
+    {
+    return 0;
+    }
+
+  vtkIdType numberOfValues = numberOfRows * numberOfColumns + DataBufferPadding;
+  vtkSmartPointer<vtkDoubleArray> storage;
+  if (OutOfCoreThreshold > 0 && !OutOfCoreDirectory.empty() &&
+      numberOfValues * static_cast<vtkTypeInt64>(sizeof(double)) >= OutOfCoreThreshold)
+    {
+    vtkSmartPointer<vtkMappedDoubleArray> mappedStorage = vtkSmartPointer<vtkMappedDoubleArray>::New();
+    if (mappedStorage->Map(QString::fromLocal8Bit(OutOfCoreDirectory.c_str()), numberOfValues))
+      {
+      storage = mappedStorage.GetPointer();
+      }
+    else
+      {
+      vtkGenericWarningMacro(<< "vtkExtendedTable - Failed to map data into "
+                             << OutOfCoreDirectory << ", data are kept in memory");
+      }
+    }
+  if (!storage)
+    {
+    storage = vtkSmartPointer<vtkDoubleArray>::New();
+    storage->SetNumberOfValues(numberOfValues);
+    }
+  double * storageData = alignedPointer(storage->GetPointer(0));
+
+  // Each column is a view of the shared buffer
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkSmartPointer<vtkDoubleArray> view = vtkSmartPointer<vtkDoubleArray>::New();
+    view->SetArray(storageData + cid * numberOfRows, numberOfRows, /* save= */ 1);
+    view->GetInformation()->Set(vtkExtendedTable::DATA_STORAGE(), storage);
+    table->AddColumn(view);
+    }
+
+  this->Storage = storage;
+  this->StorageData = storageData;
+  return storageData;
+}
+
+//----------------------------------------------------------------------------
+bool vtkExtendedTable::vtkInternal::IsColumnStorageShared(vtkTable* table)const
+{
+  if (!this->Storage)
+    {
+    return false;
+    }
+  vtkIdType numberOfRows = table->GetNumberOfRows();
+  vtkIdType numberOfColumns = table->GetNumberOfColumns();
+  if (numberOfRows == 0 ||
+      numberOfRows * numberOfColumns + DataBufferPadding > this->Storage->GetNumberOfTuples())
+    {
+    return false;
+    }
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkDoubleArray * column = vtkDoubleArray::SafeDownCast(table->GetColumn(cid));
+    if (!column || column->GetNumberOfComponents() != 1 ||
+        column->GetNumberOfTuples() != numberOfRows ||
+        column->GetPointer(0) != this->StorageData + cid * numberOfRows)
+      {
+      return false;
+      }
+    }
+  return true;
 }
   
 //----------------------------------------------------------------------------
@@ -63,6 +328,7 @@ vtkExtendedTable::vtkInternal::vtkInternal()
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkExtendedTable);
+vtkInformationKeyMacro(vtkExtendedTable, DATA_STORAGE, ObjectBase);
 
 //----------------------------------------------------------------------------
 vtkExtendedTable::vtkExtendedTable()
@@ -175,10 +441,18 @@ void vtkExtendedTable::SetData(vtkTable* data)
       {
       this->RemoveColumn(cid);
       }
+    this->Internal->ShareColumnStorage(this);
+    }
+  else if (hasNumericalColumns(data))
+    {
+    // Columns are copied into the shared buffer, a deep copy is not needed
+    this->ShallowCopy(data);
+    this->Internal->ShareColumnStorage(this);
     }
   else
     {
     this->DeepCopy(data);
+    this->Internal->ShareColumnStorage(this);
     }
 }
 
@@ -188,6 +462,170 @@ vtkTable* vtkExtendedTable::GetData()
   return this;
 }
 
+//----------------------------------------------------------------------------
+double* vtkExtendedTable::GetContiguousDataBuffer()
+{
+  if (!this->Internal->IsColumnStorageShared(this))
+    {
+    return 0;
+    }
+  return this->Internal->StorageData;
+}
+
+//----------------------------------------------------------------------------
+double* vtkExtendedTable::AllocateData(vtkIdType numberOfRows, vtkIdType numberOfColumns)
+{
+  double * storageData =
+      this->Internal->AllocateColumnStorage(this, numberOfRows, numberOfColumns);
+  this->Modified();
+  return storageData;
+}
+
+//----------------------------------------------------------------------------
+void vtkExtendedTable::SetOutOfCoreThreshold(vtkTypeInt64 size)
+{
+  OutOfCoreThreshold = size;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkExtendedTable::GetOutOfCoreThreshold()
+{
+  return OutOfCoreThreshold;
+}
+
+//----------------------------------------------------------------------------
+void vtkExtendedTable::SetOutOfCoreDirectory(const char* directory)
+{
+  OutOfCoreDirectory = directory ? directory : "";
+}
+
+//----------------------------------------------------------------------------
+const char* vtkExtendedTable::GetOutOfCoreDirectory()
+{
+  return OutOfCoreDirectory.c_str();
+}
+
+//----------------------------------------------------------------------------
+bool vtkExtendedTable::IsDataOutOfCore()
+{
+  return vtkMappedDoubleArray::SafeDownCast(this->Internal->Storage.GetPointer()) != 0 &&
+      this->Internal->IsColumnStorageShared(this);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkExtendedTable::GetDataTileNumberOfRows()
+{
+  vtkIdType numberOfRows = this->GetNumberOfRows();
+  vtkIdType numberOfColumns = this->GetNumberOfColumns();
+  if (!this->IsDataOutOfCore() || numberOfColumns == 0)
+    {
+    return numberOfRows;
+    }
+  vtkIdType tileNumberOfRows =
+      static_cast<vtkIdType>(DataTileSize / (numberOfColumns * static_cast<vtkTypeInt64>(sizeof(double))));
+  return std::max(static_cast<vtkIdType>(1), std::min(numberOfRows, tileNumberOfRows));
+}
+
+//----------------------------------------------------------------------------
+const double* vtkExtendedTable::GetDataTile(vtkIdType firstRow, vtkIdType numberOfRows,
+                                            std::vector<double>& buffer)
+{
+  vtkIdType numberOfColumns = this->GetNumberOfColumns();
+  if (firstRow < 0 || numberOfRows <= 0 || firstRow + numberOfRows > this->GetNumberOfRows() ||
+      numberOfColumns == 0 || !hasNumericalColumns(this))
+    {
+    return 0;
+    }
+  if (firstRow == 0 && numberOfRows == this->GetNumberOfRows())
+    {
+    return this->GetDataBuffer();
+    }
+
+  // Copying the rows column by column reads the mapped file sequentially
+  buffer.resize(numberOfRows * numberOfColumns);
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    vtkDataArray * column = vtkDataArray::SafeDownCast(this->GetColumn(cid));
+    double * destination = &buffer[cid * numberOfRows];
+    vtkDoubleArray * doubleColumn = vtkDoubleArray::SafeDownCast(column);
+    if (doubleColumn)
+      {
+      const double * source = doubleColumn->GetPointer(firstRow);
+      std::copy(source, source + numberOfRows, destination);
+      }
+    else
+      {
+      for (vtkIdType rid = 0; rid < numberOfRows; ++rid)
+        {
+        destination[rid] = column->GetTuple1(firstRow + rid);
+        }
+      }
+    }
+  return &buffer[0];
+}
+
+//----------------------------------------------------------------------------
+const double* vtkExtendedTable::GetDataBuffer(int layout)
+{
+  if (layout == vtkExtendedTable::ColumnMajor)
+    {
+    double * storageData = this->GetContiguousDataBuffer();
+    if (storageData)
+      {
+      return storageData;
+      }
+    }
+
+  vtkIdType numberOfRows = this->GetNumberOfRows();
+  vtkIdType numberOfColumns = this->GetNumberOfColumns();
+  if (numberOfRows == 0 || numberOfColumns == 0 || !hasNumericalColumns(this))
+    {
+    return 0;
+    }
+
+  // Reuse the packed buffer if neither the table nor its columns have been modified
+  unsigned long dataMTime = this->GetMTime();
+  for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+    {
+    dataMTime = std::max(dataMTime, this->GetColumn(cid)->GetMTime());
+    }
+  QMutexLocker locker(&this->Internal->PackedMutex);
+  vtkInternal::PackedBuffer& packed =
+      this->Internal->PackedBuffers[layout == vtkExtendedTable::RowMajor ? 1 : 0];
+  size_t packedSize = static_cast<size_t>(numberOfRows * numberOfColumns + DataBufferPadding);
+  if (packed.Data && packed.Values.size() == packedSize && packed.Time > dataMTime)
+    {
+    return packed.Data;
+    }
+
+  packed.Values.resize(packedSize);
+  packed.Data = alignedPointer(&packed.Values[0]);
+  if (layout == vtkExtendedTable::RowMajor)
+    {
+    // Copy blocks of rows so that the destination rows stay in cache
+    const vtkIdType rowBlockSize = 64;
+    for (vtkIdType rowBegin = 0; rowBegin < numberOfRows; rowBegin += rowBlockSize)
+      {
+      vtkIdType rowEnd = std::min(rowBegin + rowBlockSize, numberOfRows);
+      for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+        {
+        copyColumn(vtkDataArray::SafeDownCast(this->GetColumn(cid)), rowBegin, rowEnd,
+                   packed.Data + cid, numberOfColumns);
+        }
+      }
+    }
+  else
+    {
+    for (vtkIdType cid = 0; cid < numberOfColumns; ++cid)
+      {
+      copyColumn(vtkDataArray::SafeDownCast(this->GetColumn(cid)), 0, numberOfRows,
+                 packed.Data + cid * numberOfRows, 1);
+      }
+    }
+  packed.Time.Modified();
+  return packed.Data;
+}
+
 //----------------------------------------------------------------------------
 vtkTable* vtkExtendedTable::GetDataWithRowHeader()
 {
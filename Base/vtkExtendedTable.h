@@ -23,6 +23,9 @@
 // VTK includes
 #include <vtkTable.h>
 
+// STD includes
+#include <vector>
+
 ///
 /// This class allows to store numerical tabular data and their associated metadata.
 ///
@@ -52,8 +55,13 @@
 ///
 /// Note that the columns of the ColumnMetaData (CM) table are represented above as rows.
 ///
+/// The numerical data set using SetData() are stored in a single column-major buffer shared
+/// by all the data columns. GetDataBuffer() gives access to the data as a contiguous matrix.
+/// Large buffers may be stored out of core, see SetOutOfCoreThreshold().
+///
 
 class vtkAbstractArray;
+class vtkInformationObjectBaseKey;
 class vtkStringArray;
 class vtkTable;
 class vtkVariantArray;
@@ -81,6 +89,62 @@ public:
 
   vtkTable*   GetDataWithRowHeader();
 
+  enum DataBufferLayout
+    {
+    ColumnMajor = 0,
+    RowMajor
+    };
+
+  /// Return the data as a contiguous GetNumberOfRows() x GetNumberOfColumns() matrix
+  /// of doubles stored using \a layout. The returned pointer is 64-byte aligned.
+  /// The column-major matrix is returned without copy if the data columns still share
+  /// the buffer allocated by SetData(). Otherwise, the matrix is packed into a buffer
+  /// owned by the table and reused until the table or one of its columns is modified.
+  /// Return 0 if there is no data or if a column is not numerical.
+  /// It can be called from several threads at once as long as the table isn't modified.
+  /// \note Call Modified() after changing values in place.
+  const double* GetDataBuffer(int layout = ColumnMajor);
+
+  /// Return the column-major buffer shared by the data columns or 0 if the columns
+  /// have been replaced or resized since SetData(). Values written in that buffer
+  /// are seen by the data columns.
+  double*     GetContiguousDataBuffer();
+
+  /// Replace the data by \a numberOfColumns unnamed columns of \a numberOfRows values
+  /// stored in a new shared buffer and return that buffer, see GetContiguousDataBuffer().
+  /// Values are left uninitialized. Return 0 if the matrix is empty.
+  double*     AllocateData(vtkIdType numberOfRows, vtkIdType numberOfColumns);
+
+  /// Data buffers of at least \a size bytes allocated by SetData() or AllocateData() are
+  /// temporary files created in GetOutOfCoreDirectory() and memory mapped: their values are
+  /// read and written back by the system as needed, so that the data may exceed the physical
+  /// memory. Data are kept in memory if \a size is 0 (default), if the directory is empty
+  /// or if the file can't be mapped.
+  static void         SetOutOfCoreThreshold(vtkTypeInt64 size);
+  static vtkTypeInt64 GetOutOfCoreThreshold();
+  static void         SetOutOfCoreDirectory(const char* directory);
+  static const char*  GetOutOfCoreDirectory();
+
+  /// Return true if the shared buffer of the data is a memory-mapped file.
+  /// A row-major buffer of out-of-core data is still packed in memory, GetDataTile()
+  /// allows to process such data by blocks of rows.
+  bool        IsDataOutOfCore();
+
+  /// Number of rows of the tiles processing the data should use with GetDataTile():
+  /// all the rows if the data are in memory, otherwise a block of rows whose values
+  /// fit in a few tens of megabytes.
+  vtkIdType   GetDataTileNumberOfRows();
+
+  /// Return the rows [firstRow, firstRow + numberOfRows) of the data as a column-major
+  /// numberOfRows x GetNumberOfColumns() matrix. All the rows are returned like GetDataBuffer()
+  /// does, a block of rows is copied into \a buffer. Return 0 if the rows are out of range
+  /// or if a column is not numerical.
+  const double* GetDataTile(vtkIdType firstRow, vtkIdType numberOfRows, std::vector<double>& buffer);
+
+  /// Key associating a data column with the buffer it is a view of.
+  /// It ensures the buffer remains valid as long as one of the columns is referenced.
+  static vtkInformationObjectBaseKey* DATA_STORAGE();
+
   //
   // Column MetaData
   //